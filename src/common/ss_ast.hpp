@@ -551,6 +551,7 @@ struct FuncDeclStmt : Stmt {
     std::optional<TypeAnnotation> return_type;
     bool is_override{false};
     bool is_static{false};  // static functions belong to the type
+    bool is_final{false};   // final methods cannot be overridden
     std::optional<TypeAnnotation> expected_error_type;  // expected ErrorType
     AccessLevel access_level{AccessLevel::Internal};  // Default is internal
     FuncDeclStmt() : Stmt(StmtKind::FuncDecl) {}
@@ -566,6 +567,7 @@ struct ClassDeclStmt : Stmt {
     std::vector<std::unique_ptr<VarDeclStmt>> properties;
     std::unique_ptr<BlockStmt> deinit_body;  // Optional deinit
     AccessLevel access_level{AccessLevel::Internal};  // Default is internal
+    bool is_final{false};  // final classes cannot be subclassed
     ClassDeclStmt() : Stmt(StmtKind::ClassDecl) {}
 };
 
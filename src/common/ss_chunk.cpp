@@ -24,20 +24,87 @@ void Assembly::write_op(OpCode op, uint32_t line) {
     write(static_cast<uint8_t>(op), line);
 }
 
+bool Assembly::constant_key(const Value& value, ConstantKey& key) {
+    key.type = value.type();
+    switch (value.type()) {
+        case Value::Type::Null:
+        case Value::Type::Undefined:
+            key.bits = 0;
+            return true;
+        case Value::Type::Bool:
+            key.bits = value.as_bool() ? 1 : 0;
+            return true;
+        case Value::Type::Int:
+            key.bits = static_cast<uint64_t>(value.as_int());
+            return true;
+        case Value::Type::Float: {
+            // By bit pattern, so 0.0 and -0.0 stay distinct
+            Float number = value.as_float();
+            static_assert(sizeof(number) == sizeof(key.bits));
+            std::memcpy(&key.bits, &number, sizeof(number));
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
 size_t Assembly::add_constant(Value value) {
+    ConstantKey key;
+    if (!constant_key(value, key)) {
+        global_constant_pool.push_back(value);
+        return global_constant_pool.size() - 1;
+    }
+
+    if (constants_indexed_ > global_constant_pool.size()) {
+        constant_index_.clear();
+        constants_indexed_ = 0;
+    }
+    for (; constants_indexed_ < global_constant_pool.size(); ++constants_indexed_) {
+        ConstantKey existing;
+        if (constant_key(global_constant_pool[constants_indexed_], existing)) {
+            constant_index_.emplace(existing, static_cast<uint32_t>(constants_indexed_));
+        }
+    }
+
+    auto it = constant_index_.find(key);
+    ConstantKey found;
+    if (it != constant_index_.end() && it->second < global_constant_pool.size() &&
+        constant_key(global_constant_pool[it->second], found) && found == key) {
+        return it->second;
+    }
     global_constant_pool.push_back(value);
+    constant_index_[key] = static_cast<uint32_t>(global_constant_pool.size() - 1);
+    constants_indexed_ = global_constant_pool.size();
     return global_constant_pool.size() - 1;
 }
 
-size_t Assembly::add_string(const std::string& str) {
-    // �̹� �����ϴ� ���ڿ����� Ȯ��
-    for (size_t i = 0; i < string_table.size(); ++i) {
-        if (string_table[i] == str) {
-            return i;
-        }
+size_t Assembly::intern(std::vector<std::string>& table, std::unordered_map<std::string, uint32_t>& index,
+                        size_t& indexed, const std::string& str) {
+    if (indexed > table.size()) {
+        index.clear();
+        indexed = 0;
     }
-    string_table.push_back(str);
-    return string_table.size() - 1;
+    for (; indexed < table.size(); ++indexed) {
+        index.emplace(table[indexed], static_cast<uint32_t>(indexed));
+    }
+
+    auto it = index.find(str);
+    if (it != index.end() && it->second < table.size() && table[it->second] == str) {
+        return it->second;
+    }
+    table.push_back(str);
+    index[str] = static_cast<uint32_t>(table.size() - 1);
+    indexed = table.size();
+    return table.size() - 1;
+}
+
+size_t Assembly::add_string(const std::string& str) {
+    return intern(string_table, string_index_, strings_indexed_, str);
+}
+
+size_t Assembly::add_literal_string(const std::string& str) {
+    return intern(literal_strings, literal_index_, literals_indexed_, str);
 }
 
 size_t Assembly::add_function(FunctionPrototype proto) {
@@ -141,6 +208,10 @@ size_t Assembly::disassemble_instruction(size_t offset) const {
             return constant_instruction("OP_CONSTANT", offset);
         case OpCode::OP_STRING:
             return string_instruction("OP_STRING", offset);
+        case OpCode::OP_CONSTANT_LONG:
+            return constant_instruction("OP_CONSTANT_LONG", offset);
+        case OpCode::OP_STRING_LONG:
+            return string_instruction("OP_STRING_LONG", offset);
         case OpCode::OP_NIL:
             return simple_instruction("OP_NIL", offset);
         case OpCode::OP_TRUE:
@@ -151,6 +222,10 @@ size_t Assembly::disassemble_instruction(size_t offset) const {
             return simple_instruction("OP_POP", offset);
         case OpCode::OP_POP_N:
             return short_instruction("OP_POP_N", offset);
+        case OpCode::OP_PICK:
+            return short_instruction("OP_PICK", offset);
+        case OpCode::OP_POP_UNDER:
+            return short_instruction("OP_POP_UNDER", offset);
         case OpCode::OP_ADD:
             return simple_instruction("OP_ADD", offset);
         case OpCode::OP_SUBTRACT:
@@ -197,6 +272,8 @@ size_t Assembly::disassemble_instruction(size_t offset) const {
             return jump_instruction("OP_JUMP", 1, offset);
         case OpCode::OP_JUMP_IF_FALSE:
             return jump_instruction("OP_JUMP_IF_FALSE", 1, offset);
+        case OpCode::OP_JUMP_IF_TRUE:
+            return jump_instruction("OP_JUMP_IF_TRUE", 1, offset);
         case OpCode::OP_JUMP_IF_NIL:
             return jump_instruction("OP_JUMP_IF_NIL", 1, offset);
         case OpCode::OP_LOOP:
@@ -219,6 +296,31 @@ size_t Assembly::disassemble_instruction(size_t offset) const {
                       << std::setw(4) << arg_count << "\n";
             return offset + 3 + arg_count * 2;
         }
+        case OpCode::OP_TAIL_CALL: {
+            uint16_t arg_count = (code_view[offset + 1] << 8) | code_view[offset + 2];
+            std::cout << std::setw(16) << std::left << "OP_TAIL_CALL" << " "
+                      << std::setw(4) << arg_count << "\n";
+            return offset + 3 + arg_count * 2;
+        }
+        case OpCode::OP_CALL_DIRECT: {
+            uint16_t proto = (code_view[offset + 1] << 8) | code_view[offset + 2];
+            uint16_t arg_count = (code_view[offset + 3] << 8) | code_view[offset + 4];
+            std::cout << std::setw(16) << std::left << "OP_CALL_DIRECT" << " "
+                      << std::setw(4) << proto << " argc " << arg_count << "\n";
+            return offset + 5;
+        }
+        case OpCode::OP_CALL_METHOD_DIRECT:
+        case OpCode::OP_CALL_METHOD_GUARDED: {
+            uint16_t name = (code_view[offset + 1] << 8) | code_view[offset + 2];
+            uint16_t proto = (code_view[offset + 3] << 8) | code_view[offset + 4];
+            uint16_t arg_count = (code_view[offset + 5] << 8) | code_view[offset + 6];
+            uint16_t type = (code_view[offset + 7] << 8) | code_view[offset + 8];
+            std::cout << std::setw(16) << std::left
+                      << (instruction == OpCode::OP_CALL_METHOD_DIRECT ? "OP_CALL_METHOD_DIRECT" : "OP_CALL_METHOD_GUARDED") << " "
+                      << std::setw(4) << proto << " '" << (name < string_table.size() ? string_table[name] : "")
+                      << "' argc " << arg_count << " type " << type << "\n";
+            return offset + 9;
+        }
         case OpCode::OP_RETURN:
             return simple_instruction("OP_RETURN", offset);
         case OpCode::OP_GET_PROPERTY:
@@ -233,6 +335,14 @@ size_t Assembly::disassemble_instruction(size_t offset) const {
             return simple_instruction("OP_UNWRAP", offset);
         case OpCode::OP_UNWRAP_EXPECTED:
             return simple_instruction("OP_UNWRAP_EXPECTED", offset);
+        case OpCode::OP_TYPE_CHECK:
+            return short_instruction("OP_TYPE_CHECK", offset);
+        case OpCode::OP_TYPE_CAST:
+            return short_instruction("OP_TYPE_CAST", offset);
+        case OpCode::OP_TYPE_CAST_OPTIONAL:
+            return short_instruction("OP_TYPE_CAST_OPTIONAL", offset);
+        case OpCode::OP_TYPE_CAST_FORCED:
+            return short_instruction("OP_TYPE_CAST_FORCED", offset);
         case OpCode::OP_NIL_COALESCE:
             return simple_instruction("OP_NIL_COALESCE", offset);
         case OpCode::OP_RANGE_INCLUSIVE:
@@ -247,6 +357,40 @@ size_t Assembly::disassemble_instruction(size_t offset) const {
             return simple_instruction("OP_GET_SUBSCRIPT", offset);
         case OpCode::OP_SET_SUBSCRIPT:
             return simple_instruction("OP_SET_SUBSCRIPT", offset);
+        case OpCode::OP_SET_LITERAL:
+            return short_instruction("OP_SET_LITERAL", offset);
+        case OpCode::OP_CONTAINS:
+            return simple_instruction("OP_CONTAINS", offset);
+        case OpCode::OP_ITER_INIT:
+            return simple_instruction("OP_ITER_INIT", offset);
+        case OpCode::OP_FOR_ARRAY_NEXT: {
+            uint16_t slot = (code_view[offset + 1] << 8) | code_view[offset + 2];
+            uint16_t jump = (code_view[offset + 3] << 8) | code_view[offset + 4];
+            std::cout << std::setw(16) << std::left << "OP_FOR_ARRAY_NEXT" << " "
+                      << std::setw(4) << slot << " exit -> " << (offset + 5 + jump) << "\n";
+            return offset + 5;
+        }
+        case OpCode::OP_FOR_RANGE_NEXT: {
+            uint16_t slot = (code_view[offset + 1] << 8) | code_view[offset + 2];
+            bool inclusive = code_view[offset + 3] != 0;
+            uint16_t jump = (code_view[offset + 4] << 8) | code_view[offset + 5];
+            std::cout << std::setw(16) << std::left << "OP_FOR_RANGE_NEXT" << " "
+                      << std::setw(4) << slot << (inclusive ? " ... " : " ..< ")
+                      << "exit -> " << (offset + 6 + jump) << "\n";
+            return offset + 6;
+        }
+        case OpCode::OP_SWITCH_TABLE: {
+            uint8_t mode = code_view[offset + 1];
+            uint16_t count = (code_view[offset + 2] << 8) | code_view[offset + 3];
+            std::vector<size_t> operands = switch_table_target_operands(code_view, offset);
+            size_t end = offset + instruction_length(code_view, offset);
+            static const char* kinds[] = { "int", "enum", "string", "?" };
+            std::cout << std::setw(16) << std::left << "OP_SWITCH_TABLE" << " "
+                      << kinds[mode & SWITCH_KIND_MASK] << ((mode & SWITCH_DENSE) ? " dense" : "")
+                      << " (" << count << " entries) default -> "
+                      << (end + ((code_view[operands[0]] << 8) | code_view[operands[0] + 1])) << "\n";
+            return end;
+        }
         case OpCode::OP_GET_UPVALUE:
             return short_instruction("OP_GET_UPVALUE", offset);
         case OpCode::OP_SET_UPVALUE:
@@ -276,13 +420,15 @@ size_t Assembly::disassemble_instruction(size_t offset) const {
         case OpCode::OP_ENUM_CASE:
         {
             uint16_t str_idx = (code_view[offset + 1] << 8) | code_view[offset + 2];
-            uint8_t assoc_count = code_view[offset + 3];
+            uint16_t discriminant = (code_view[offset + 3] << 8) | code_view[offset + 4];
+            uint8_t assoc_count = code_view[offset + 5];
             std::cout << std::setw(16) << std::left << "OP_ENUM_CASE" << " "
-                      << std::setw(4) << str_idx << " (assoc " << static_cast<int>(assoc_count) << ")\n";
-            return offset + 4 + assoc_count * 2;
+                      << std::setw(4) << str_idx << " #" << discriminant
+                      << " (assoc " << static_cast<int>(assoc_count) << ")\n";
+            return offset + 6 + assoc_count * 2;
         }
         case OpCode::OP_MATCH_ENUM_CASE:
-            return string_instruction("OP_MATCH_ENUM_CASE", offset);
+            return short_instruction("OP_MATCH_ENUM_CASE", offset);
         case OpCode::OP_GET_ASSOCIATED:
             return short_instruction("OP_GET_ASSOCIATED", offset);
         case OpCode::OP_PROTOCOL:
@@ -310,6 +456,324 @@ size_t Assembly::disassemble_instruction(size_t offset) const {
     }
 }
 
+namespace {
+    uint16_t operand_short(const std::vector<uint8_t>& code, size_t offset) {
+        return static_cast<uint16_t>((code[offset] << 8) | code[offset + 1]);
+    }
+}
+
+size_t instruction_length(const std::vector<uint8_t>& code, size_t offset) {
+    switch (static_cast<OpCode>(code[offset])) {
+        // No operands
+        case OpCode::OP_NIL: case OpCode::OP_TRUE: case OpCode::OP_FALSE:
+        case OpCode::OP_POP: case OpCode::OP_DUP:
+        case OpCode::OP_ADD: case OpCode::OP_SUBTRACT: case OpCode::OP_MULTIPLY:
+        case OpCode::OP_DIVIDE: case OpCode::OP_MODULO: case OpCode::OP_NEGATE:
+        case OpCode::OP_BITWISE_NOT: case OpCode::OP_BITWISE_AND: case OpCode::OP_BITWISE_OR:
+        case OpCode::OP_BITWISE_XOR: case OpCode::OP_LEFT_SHIFT: case OpCode::OP_RIGHT_SHIFT:
+        case OpCode::OP_EQUAL: case OpCode::OP_NOT_EQUAL: case OpCode::OP_LESS:
+        case OpCode::OP_GREATER: case OpCode::OP_LESS_EQUAL: case OpCode::OP_GREATER_EQUAL:
+        case OpCode::OP_NOT: case OpCode::OP_AND: case OpCode::OP_OR:
+        case OpCode::OP_INHERIT: case OpCode::OP_RETURN: case OpCode::OP_CLOSE_UPVALUE:
+        case OpCode::OP_UNWRAP: case OpCode::OP_NIL_COALESCE:
+        case OpCode::OP_RANGE_INCLUSIVE: case OpCode::OP_RANGE_EXCLUSIVE:
+        case OpCode::OP_GET_SUBSCRIPT: case OpCode::OP_SET_SUBSCRIPT:
+        case OpCode::OP_CONTAINS: case OpCode::OP_ITER_INIT: case OpCode::OP_COPY_VALUE:
+        case OpCode::OP_UNWRAP_EXPECTED: case OpCode::OP_READ_LINE: case OpCode::OP_PRINT:
+        case OpCode::OP_HALT:
+            return 1;
+        case OpCode::OP_STRUCT_METHOD:
+            return 4;
+        case OpCode::OP_CONSTANT_LONG: case OpCode::OP_STRING_LONG:
+            return 4;  // One 24-bit operand
+        case OpCode::OP_NATIVE_CALL: case OpCode::OP_NATIVE_CONSTRUCT: case OpCode::OP_NATIVE_METHOD_CALL:
+            return 4;  // name, argc byte
+        case OpCode::OP_FOR_ARRAY_NEXT: case OpCode::OP_CALL_DIRECT:
+            return 5;
+        case OpCode::OP_FOR_RANGE_NEXT:
+            return 6;
+        case OpCode::OP_CALL_METHOD_DIRECT: case OpCode::OP_CALL_METHOD_GUARDED:
+            return 9;
+        case OpCode::OP_DEFINE_COMPUTED_PROPERTY:
+            return 7;
+        case OpCode::OP_DEFINE_PROPERTY_WITH_OBSERVERS:
+            return 8;
+        case OpCode::OP_DEFINE_PROPERTY:
+            return (code[offset + 3] & 0x8) ? 12 : 4;  // has_range adds min/max
+        case OpCode::OP_CALL_NAMED:
+        case OpCode::OP_TAIL_CALL:
+        case OpCode::OP_TUPLE:
+            return 3 + operand_short(code, offset + 1) * 2u;  // count, then a name per element
+        case OpCode::OP_ENUM_CASE:
+            return 6 + code[offset + 5] * 2u;  // name, discriminant, assoc count, labels
+        case OpCode::OP_SWITCH_TABLE:
+            return 6 + ((code[offset + 1] & SWITCH_DENSE) ? 8u : 0u) +
+                   operand_short(code, offset + 2) * switch_table_entry_size(code[offset + 1]);
+        default:
+            return 3;  // One 16-bit operand
+    }
+}
+
+StackEffect instruction_stack_effect(const std::vector<uint8_t>& code, size_t offset) {
+    switch (static_cast<OpCode>(code[offset])) {
+        case OpCode::OP_CONSTANT: case OpCode::OP_STRING: case OpCode::OP_NIL:
+        case OpCode::OP_CONSTANT_LONG: case OpCode::OP_STRING_LONG:
+        case OpCode::OP_TRUE: case OpCode::OP_FALSE: case OpCode::OP_DUP:
+        case OpCode::OP_GET_GLOBAL: case OpCode::OP_GET_LOCAL: case OpCode::OP_GET_LOCAL_MOVE:
+        case OpCode::OP_GET_UPVALUE: case OpCode::OP_FUNCTION: case OpCode::OP_CLOSURE:
+        case OpCode::OP_CLASS: case OpCode::OP_STRUCT: case OpCode::OP_ENUM:
+        case OpCode::OP_PROTOCOL: case OpCode::OP_READ_LINE: case OpCode::OP_PICK:
+            return { 0, 1 };
+        case OpCode::OP_POP: case OpCode::OP_CLOSE_UPVALUE: case OpCode::OP_METHOD:
+        case OpCode::OP_DEFINE_PROPERTY: case OpCode::OP_DEFINE_PROPERTY_WITH_OBSERVERS:
+        case OpCode::OP_INHERIT: case OpCode::OP_STRUCT_METHOD: case OpCode::OP_ENUM_CASE:
+        case OpCode::OP_DEFINE_GLOBAL: case OpCode::OP_PRINT: case OpCode::OP_RETURN:
+        case OpCode::OP_SWITCH_TABLE:
+            return { 1, 0 };
+        case OpCode::OP_POP_N:
+            return { operand_short(code, offset + 1), 0 };
+        case OpCode::OP_POP_UNDER:
+            return { operand_short(code, offset + 1) + 1u, 1 };
+        case OpCode::OP_ADD: case OpCode::OP_SUBTRACT: case OpCode::OP_MULTIPLY:
+        case OpCode::OP_DIVIDE: case OpCode::OP_MODULO:
+        case OpCode::OP_BITWISE_AND: case OpCode::OP_BITWISE_OR: case OpCode::OP_BITWISE_XOR:
+        case OpCode::OP_LEFT_SHIFT: case OpCode::OP_RIGHT_SHIFT:
+        case OpCode::OP_EQUAL: case OpCode::OP_NOT_EQUAL: case OpCode::OP_LESS:
+        case OpCode::OP_GREATER: case OpCode::OP_LESS_EQUAL: case OpCode::OP_GREATER_EQUAL:
+        case OpCode::OP_AND: case OpCode::OP_OR: case OpCode::OP_NIL_COALESCE:
+        case OpCode::OP_RANGE_INCLUSIVE: case OpCode::OP_RANGE_EXCLUSIVE:
+        case OpCode::OP_GET_SUBSCRIPT: case OpCode::OP_CONTAINS:
+        case OpCode::OP_SET_PROPERTY: case OpCode::OP_NATIVE_SET_PROPERTY:
+            return { 2, 1 };
+        case OpCode::OP_SET_SUBSCRIPT:
+            return { 3, 1 };
+        case OpCode::OP_CALL: case OpCode::OP_CALL_NAMED: case OpCode::OP_TAIL_CALL:
+            return { operand_short(code, offset + 1) + 1u, 1 };
+        case OpCode::OP_CALL_DIRECT:
+            return { operand_short(code, offset + 3), 1 };
+        case OpCode::OP_CALL_METHOD_DIRECT: case OpCode::OP_CALL_METHOD_GUARDED:
+            return { operand_short(code, offset + 5) + 1u, 1 };  // Receiver and arguments
+        case OpCode::OP_NATIVE_CALL: case OpCode::OP_NATIVE_CONSTRUCT:
+            return { code[offset + 3], 1 };
+        case OpCode::OP_NATIVE_METHOD_CALL:
+            return { code[offset + 3] + 1u, 1 };
+        case OpCode::OP_ARRAY: case OpCode::OP_SET_LITERAL: case OpCode::OP_TUPLE:
+            return { operand_short(code, offset + 1), 1 };
+        case OpCode::OP_DICT:
+            return { operand_short(code, offset + 1) * 2u, 1 };
+        case OpCode::OP_FOR_ARRAY_NEXT: case OpCode::OP_FOR_RANGE_NEXT:
+            return { 0, 0 };  // The loop variable is stored in its frame slot
+        default:
+            // Replaces the top value or only inspects it (unary ops, property
+            // reads, casts, setters of globals/locals/upvalues, jumps)
+            return { 0, 0 };
+    }
+}
+
+uint32_t compute_max_stack_depth(const std::vector<uint8_t>& code) {
+    // Forward jumps record the height at their target; code after an
+    // unconditional transfer continues from that recorded height.
+    std::unordered_map<size_t, uint32_t> target_depth;
+    auto record = [&](size_t target, uint32_t depth) {
+        auto [it, inserted] = target_depth.emplace(target, depth);
+        if (!inserted) it->second = std::max(it->second, depth);
+    };
+
+    uint32_t depth = 0;
+    uint32_t max_depth = 0;
+    bool reachable = true;
+    for (size_t offset = 0; offset < code.size();) {
+        auto it = target_depth.find(offset);
+        if (it != target_depth.end()) {
+            depth = reachable ? std::max(depth, it->second) : it->second;
+            reachable = true;
+        }
+
+        OpCode op = static_cast<OpCode>(code[offset]);
+        size_t length = instruction_length(code, offset);
+        StackEffect effect = instruction_stack_effect(code, offset);
+        depth = (depth > effect.pops ? depth - effect.pops : 0) + effect.pushes;
+        max_depth = std::max(max_depth, depth);
+
+        size_t next = offset + length;
+        switch (op) {
+            case OpCode::OP_JUMP:
+                record(next + operand_short(code, offset + 1), depth);
+                reachable = false;
+                break;
+            case OpCode::OP_JUMP_IF_FALSE:
+            case OpCode::OP_JUMP_IF_TRUE:
+                record(next + operand_short(code, offset + 1), depth);
+                break;
+            case OpCode::OP_JUMP_IF_NIL:
+                record(next + operand_short(code, offset + 1), depth > 0 ? depth - 1 : 0);
+                break;
+            case OpCode::OP_FOR_ARRAY_NEXT:
+                // Script iterators push their next() method above the loop
+                max_depth = std::max(max_depth, depth + 1);
+                record(next + operand_short(code, offset + 3), depth);
+                break;
+            case OpCode::OP_FOR_RANGE_NEXT:
+                record(next + operand_short(code, offset + 4), depth);
+                break;
+            case OpCode::OP_SWITCH_TABLE:
+                for (size_t operand : switch_table_target_operands(code, offset)) {
+                    record(next + operand_short(code, operand), depth);
+                }
+                reachable = false;
+                break;
+            case OpCode::OP_LOOP:
+            case OpCode::OP_RETURN:
+            case OpCode::OP_HALT:
+                reachable = false;
+                break;
+            default:
+                break;
+        }
+        offset = next;
+    }
+    return max_depth;
+}
+
+std::vector<size_t> switch_table_target_operands(const std::vector<uint8_t>& code, size_t offset) {
+    uint8_t mode = code[offset + 1];
+    uint16_t count = operand_short(code, offset + 2);
+    size_t entry_size = switch_table_entry_size(mode);
+    // Each entry ends with its target
+    size_t first = offset + 6 + ((mode & SWITCH_DENSE) ? 8 : 0) + entry_size - 2;
+
+    std::vector<size_t> operands;
+    operands.reserve(count + 1u);
+    operands.push_back(offset + 4);
+    for (size_t i = 0; i < count; ++i) {
+        operands.push_back(first + i * entry_size);
+    }
+    return operands;
+}
+
+std::vector<size_t> jump_operand_offsets(const std::vector<uint8_t>& code, size_t offset) {
+    switch (static_cast<OpCode>(code[offset])) {
+        case OpCode::OP_JUMP:
+        case OpCode::OP_JUMP_IF_FALSE:
+        case OpCode::OP_JUMP_IF_TRUE:
+        case OpCode::OP_JUMP_IF_NIL:
+        case OpCode::OP_LOOP:
+            return {offset + 1};
+        case OpCode::OP_FOR_ARRAY_NEXT:
+            return {offset + 3};
+        case OpCode::OP_FOR_RANGE_NEXT:
+            return {offset + 4};
+        case OpCode::OP_SWITCH_TABLE:
+            return switch_table_target_operands(code, offset);
+        default:
+            return {};
+    }
+}
+
+std::vector<size_t> table_operand_offsets(const std::vector<uint8_t>& code, size_t offset, OperandTable table) {
+    OpCode op = static_cast<OpCode>(code[offset]);
+    switch (table) {
+        case OperandTable::String:
+            switch (op) {
+                case OpCode::OP_STRING: case OpCode::OP_STRING_LONG:
+                case OpCode::OP_GET_GLOBAL: case OpCode::OP_SET_GLOBAL:
+                case OpCode::OP_DEFINE_GLOBAL: case OpCode::OP_GET_PROPERTY: case OpCode::OP_SET_PROPERTY:
+                case OpCode::OP_SUPER: case OpCode::OP_OPTIONAL_CHAIN: case OpCode::OP_GET_TUPLE_LABEL:
+                case OpCode::OP_CLASS: case OpCode::OP_METHOD: case OpCode::OP_STRUCT:
+                case OpCode::OP_STRUCT_METHOD: case OpCode::OP_ENUM:
+                case OpCode::OP_DEFINE_PROPERTY: case OpCode::OP_DEFINE_COMPUTED_PROPERTY:
+                case OpCode::OP_DEFINE_PROPERTY_WITH_OBSERVERS:
+                case OpCode::OP_NATIVE_CALL: case OpCode::OP_NATIVE_CONSTRUCT:
+                case OpCode::OP_NATIVE_GET_PROPERTY: case OpCode::OP_NATIVE_SET_PROPERTY:
+                case OpCode::OP_NATIVE_METHOD_CALL: case OpCode::OP_SET_NATIVE_TYPE:
+                case OpCode::OP_CALL_METHOD_DIRECT: case OpCode::OP_CALL_METHOD_GUARDED:
+                    return {offset + 1};
+                case OpCode::OP_CALL_NAMED: case OpCode::OP_TAIL_CALL: case OpCode::OP_TUPLE: {
+                    std::vector<size_t> operands;
+                    for (size_t i = 0; i < operand_short(code, offset + 1); ++i) {
+                        operands.push_back(offset + 3 + i * 2);
+                    }
+                    return operands;
+                }
+                case OpCode::OP_ENUM_CASE: {
+                    std::vector<size_t> operands{offset + 1};
+                    for (size_t i = 0; i < code[offset + 5]; ++i) {
+                        operands.push_back(offset + 6 + i * 2);
+                    }
+                    return operands;
+                }
+                case OpCode::OP_SWITCH_TABLE: {
+                    if ((code[offset + 1] & SWITCH_KIND_MASK) != SWITCH_STRING) return {};
+                    std::vector<size_t> operands;
+                    for (size_t target : switch_table_target_operands(code, offset)) {
+                        if (target != offset + 4) operands.push_back(target - 2);  // Precedes the target
+                    }
+                    return operands;
+                }
+                default:
+                    return {};
+            }
+        case OperandTable::Constant:
+            return op == OpCode::OP_CONSTANT || op == OpCode::OP_CONSTANT_LONG ? std::vector<size_t>{offset + 1}
+                                                                                : std::vector<size_t>{};
+        case OperandTable::Function:
+            switch (op) {
+                case OpCode::OP_FUNCTION: case OpCode::OP_CLOSURE:
+                    return {offset + 1};
+                case OpCode::OP_DEFINE_COMPUTED_PROPERTY:
+                    return {offset + 3, offset + 5};
+                case OpCode::OP_DEFINE_PROPERTY_WITH_OBSERVERS:
+                    return {offset + 4, offset + 6};
+                default:
+                    return {};
+            }
+        case OperandTable::ProgramFunction:
+            switch (op) {
+                case OpCode::OP_CALL_DIRECT:
+                    return {offset + 1};
+                case OpCode::OP_CALL_METHOD_DIRECT: case OpCode::OP_CALL_METHOD_GUARDED:
+                    return {offset + 3};
+                default:
+                    return {};
+            }
+        case OperandTable::Protocol:
+            return op == OpCode::OP_PROTOCOL ? std::vector<size_t>{offset + 1} : std::vector<size_t>{};
+    }
+    return {};
+}
+
+size_t table_operand_width(OpCode op) {
+    return op == OpCode::OP_CONSTANT_LONG || op == OpCode::OP_STRING_LONG ? 3 : 2;
+}
+
+uint32_t read_table_operand(const std::vector<uint8_t>& code, size_t offset, size_t operand) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < table_operand_width(static_cast<OpCode>(code[offset])); ++i) {
+        value = (value << 8) | code[operand + i];
+    }
+    return value;
+}
+
+void write_table_operand(std::vector<uint8_t>& code, size_t offset, size_t operand, uint32_t value) {
+    size_t width = table_operand_width(static_cast<OpCode>(code[offset]));
+    for (size_t i = 0; i < width; ++i) {
+        code[operand + i] = static_cast<uint8_t>((value >> (8 * (width - 1 - i))) & 0xFF);
+    }
+}
+
+bool is_block_terminator(OpCode op) {
+    switch (op) {
+        case OpCode::OP_JUMP:
+        case OpCode::OP_LOOP:
+        case OpCode::OP_RETURN:
+        case OpCode::OP_HALT:
+        case OpCode::OP_SWITCH_TABLE:
+            return true;
+        default:
+            return false;
+    }
+}
+
 size_t Assembly::simple_instruction(const char* name, size_t offset) const {
     std::cout << name << "\n";
     return offset + 1;
@@ -317,7 +781,11 @@ size_t Assembly::simple_instruction(const char* name, size_t offset) const {
 
 size_t Assembly::constant_instruction(const char* name, size_t offset) const {
     const auto& code_view = bytecode();
-    const uint16_t constant = static_cast<uint16_t>((code_view[offset + 1] << 8) | code_view[offset + 2]);
+    const size_t width = table_operand_width(static_cast<OpCode>(code_view[offset]));
+    uint32_t constant = 0;
+    for (size_t i = 1; i <= width; ++i) {
+        constant = (constant << 8) | code_view[offset + i];
+    }
     std::cout << std::setw(16) << std::left << name << " " 
               << std::setw(4) << constant << " '";
     
@@ -338,12 +806,16 @@ size_t Assembly::constant_instruction(const char* name, size_t offset) const {
     }
     
     std::cout << "'\n";
-    return offset + 3;
+    return offset + 1 + width;
 }
 
 size_t Assembly::string_instruction(const char* name, size_t offset) const {
     const auto& code_view = bytecode();
-    uint16_t str_idx = (code_view[offset + 1] << 8) | code_view[offset + 2];
+    const size_t width = table_operand_width(static_cast<OpCode>(code_view[offset]));
+    uint32_t str_idx = 0;
+    for (size_t i = 1; i <= width; ++i) {
+        str_idx = (str_idx << 8) | code_view[offset + i];
+    }
     std::cout << std::setw(16) << std::left << name << " " 
               << std::setw(4) << str_idx << " '";
     
@@ -352,7 +824,7 @@ size_t Assembly::string_instruction(const char* name, size_t offset) const {
     }
     
     std::cout << "'\n";
-    return offset + 3;
+    return offset + 1 + width;
 }
 
 size_t Assembly::short_instruction(const char* name, size_t offset) const {
@@ -537,9 +1009,8 @@ void Assembly::serialize(std::ostream& out) const
             WritePOD(out, (uint8_t)(fn.is_initializer ? 1 : 0));
             WritePOD(out, (uint8_t)(fn.is_override ? 1 : 0));
 
-            // nested chunk
-            WritePOD(out, (uint8_t)(fn.chunk ? 1 : 0));
-            if (fn.chunk) fn.chunk->serialize(out);
+            if (fn.chunk) throw std::runtime_error("Assembly::serialize function body not linked");
+            WritePOD(out, fn.body);
         }
     }
 
@@ -590,453 +1061,228 @@ Assembly Assembly::deserialize(std::istream& in)
         throw std::runtime_error("Assembly::deserialize version mismatch");
     if (h.verMinor > kVerMinor)
         throw std::runtime_error("Assembly::deserialize unsupported version");
+    // Version 4 renumbered the opcodes and stopped nesting an Assembly per
+    // prototype, so older files cannot be read back
+    if (h.verMinor < kVerMinor)
+        throw std::runtime_error("Assembly::deserialize: file was built by an older Swive (format " +
+                                 std::to_string(h.verMajor) + "." + std::to_string(h.verMinor) +
+                                 "), recompile it");
 
     Assembly c{};
 
-    if (h.verMinor < 3) {
-        std::vector<uint8_t> legacy_code = ReadVectorPOD<uint8_t>(in);
-        std::vector<uint32_t> legacy_lines = ReadVectorPOD<uint32_t>(in);
+    c.manifest.name = ReadString(in);
+    c.manifest.version_major = ReadPOD<uint16_t>(in);
+    c.manifest.version_minor = ReadPOD<uint16_t>(in);
 
-        std::vector<Value> legacy_constants;
-        {
-            uint32_t n = ReadPOD<uint32_t>(in);
-            legacy_constants.reserve(n);
-            for (uint32_t i = 0; i < n; ++i)
-            {
-                legacy_constants.push_back(Value::deserialize(in));
-            }
+    {
+        uint32_t n = ReadPOD<uint32_t>(in);
+        c.string_table.reserve(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            c.string_table.push_back(ReadString(in));
         }
+    }
 
+    {
+        uint32_t n = ReadPOD<uint32_t>(in);
+        c.type_definitions.reserve(n);
+        for (uint32_t i = 0; i < n; ++i)
         {
-            uint32_t n = ReadPOD<uint32_t>(in);
-            c.string_table.reserve(n);
-            for (uint32_t i = 0; i < n; ++i) c.string_table.push_back(ReadString(in));
+            TypeDef t{};
+            t.name = ReadPOD<string_idx>(in);
+            t.namespace_name = ReadPOD<string_idx>(in);
+            t.flags = ReadPOD<uint32_t>(in);
+            t.base_type = ReadPOD<type_idx>(in);
+            t.method_list.start = ReadPOD<uint32_t>(in);
+            t.method_list.count = ReadPOD<uint32_t>(in);
+            t.field_list.start = ReadPOD<uint32_t>(in);
+            t.field_list.count = ReadPOD<uint32_t>(in);
+            t.property_list.start = ReadPOD<uint32_t>(in);
+            t.property_list.count = ReadPOD<uint32_t>(in);
+            t.interfaces = ReadVectorPOD<type_idx>(in);
+            c.type_definitions.push_back(std::move(t));
         }
+    }
 
+    {
+        uint32_t n = ReadPOD<uint32_t>(in);
+        c.method_definitions.reserve(n);
+        for (uint32_t i = 0; i < n; ++i)
         {
-            uint32_t n = ReadPOD<uint32_t>(in);
-            c.function_prototypes.reserve(n);
-
-            for (uint32_t i = 0; i < n; ++i)
-            {
-                FunctionPrototype fn{};
-                fn.name = ReadString(in);
-
-                uint32_t pn = ReadPOD<uint32_t>(in);
-                fn.params.reserve(pn);
-                for (uint32_t k = 0; k < pn; ++k) fn.params.push_back(ReadString(in));
-
-                uint32_t ln = ReadPOD<uint32_t>(in);
-                fn.param_labels.reserve(ln);
-                for (uint32_t k = 0; k < ln; ++k) fn.param_labels.push_back(ReadString(in));
-
-                uint32_t dn = ReadPOD<uint32_t>(in);
-                fn.param_defaults.resize(dn);
-                for (uint32_t k = 0; k < dn; ++k)
-                {
-                    auto& d = fn.param_defaults[k];
-                    d.has_default = ReadPOD<uint8_t>(in) != 0;
-                    if (d.has_default)
-                    {
-                        d.value = Value::deserialize(in);
-
-                        bool hasStr = ReadPOD<uint8_t>(in) != 0;
-                        if (hasStr) d.string_value = ReadString(in);
-                    }
-                }
-
-                uint32_t uvn = ReadPOD<uint32_t>(in);
-                fn.upvalues.reserve(uvn);
-                for (uint32_t k = 0; k < uvn; ++k)
-                {
-                    UpvalueInfo u{};
-                    u.index = ReadPOD<uint16_t>(in);
-                    u.is_local = ReadPOD<uint8_t>(in) != 0;
-                    fn.upvalues.push_back(u);
-                }
-
-                fn.is_initializer = ReadPOD<uint8_t>(in) != 0;
-                fn.is_override = ReadPOD<uint8_t>(in) != 0;
-
-                bool hasAssembly = ReadPOD<uint8_t>(in) != 0;
-                if (hasAssembly)
-                {
-                    fn.chunk = std::make_shared<Assembly>(Assembly::deserialize(in));
-                }
-
-                c.function_prototypes.push_back(std::move(fn));
-            }
+            MethodDef m{};
+            m.name = ReadPOD<string_idx>(in);
+            m.flags = ReadPOD<uint32_t>(in);
+            m.signature = ReadPOD<signature_idx>(in);
+            m.body_ptr = ReadPOD<body_idx>(in);
+            c.method_definitions.push_back(std::move(m));
         }
+    }
 
+    {
+        uint32_t n = ReadPOD<uint32_t>(in);
+        c.field_definitions.reserve(n);
+        for (uint32_t i = 0; i < n; ++i)
         {
-            uint32_t n = ReadPOD<uint32_t>(in);
-            c.protocol_definitions.reserve(n);
-
-            for (uint32_t i = 0; i < n; ++i)
-            {
-                bool has = ReadPOD<uint8_t>(in) != 0;
-                if (!has) { c.protocol_definitions.push_back(nullptr); continue; }
-
-                auto pr = std::make_shared<Protocol>();
-                pr->name = ReadString(in);
-
-                uint32_t mn = ReadPOD<uint32_t>(in);
-                pr->method_requirements.reserve(mn);
-                for (uint32_t k = 0; k < mn; ++k)
-                {
-                    ProtocolMethodReq m{};
-                    m.name = ReadString(in);
-                    uint32_t pnn = ReadPOD<uint32_t>(in);
-                    m.param_names.reserve(pnn);
-                    for (uint32_t j = 0; j < pnn; ++j) m.param_names.push_back(ReadString(in));
-                    m.is_mutating = ReadPOD<uint8_t>(in) != 0;
-                    pr->method_requirements.push_back(std::move(m));
-                }
-
-                uint32_t pn = ReadPOD<uint32_t>(in);
-                pr->property_requirements.reserve(pn);
-                for (uint32_t k = 0; k < pn; ++k)
-                {
-                    ProtocolPropertyReq p{};
-                    p.name = ReadString(in);
-                    p.has_getter = ReadPOD<uint8_t>(in) != 0;
-                    p.has_setter = ReadPOD<uint8_t>(in) != 0;
-                    pr->property_requirements.push_back(std::move(p));
-                }
-
-                uint32_t inh = ReadPOD<uint32_t>(in);
-                pr->inherited_protocols.reserve(inh);
-                for (uint32_t k = 0; k < inh; ++k) pr->inherited_protocols.push_back(ReadString(in));
-
-                c.protocol_definitions.push_back(std::move(pr));
-            }
+            FieldDef f{};
+            f.name = ReadPOD<string_idx>(in);
+            f.flags = ReadPOD<uint32_t>(in);
+            f.type = ReadPOD<type_idx>(in);
+            c.field_definitions.push_back(std::move(f));
         }
+    }
 
-        if (h.verMinor >= 1)
+    {
+        uint32_t n = ReadPOD<uint32_t>(in);
+        c.property_definitions.reserve(n);
+        for (uint32_t i = 0; i < n; ++i)
         {
-            c.manifest.name = ReadString(in);
-            c.manifest.version_major = ReadPOD<uint16_t>(in);
-            c.manifest.version_minor = ReadPOD<uint16_t>(in);
-
-            {
-                uint32_t n = ReadPOD<uint32_t>(in);
-                c.type_definitions.reserve(n);
-                for (uint32_t i = 0; i < n; ++i)
-                {
-                    TypeDef t{};
-                    t.name = ReadPOD<string_idx>(in);
-                    t.namespace_name = ReadPOD<string_idx>(in);
-                    t.flags = ReadPOD<uint32_t>(in);
-                    t.base_type = ReadPOD<type_idx>(in);
-                    t.method_list.start = ReadPOD<uint32_t>(in);
-                    t.method_list.count = ReadPOD<uint32_t>(in);
-                    t.field_list.start = ReadPOD<uint32_t>(in);
-                    t.field_list.count = ReadPOD<uint32_t>(in);
-                    if (h.verMinor >= 2) {
-                        t.property_list.start = ReadPOD<uint32_t>(in);
-                        t.property_list.count = ReadPOD<uint32_t>(in);
-                    }
-                    t.interfaces = ReadVectorPOD<type_idx>(in);
-                    c.type_definitions.push_back(std::move(t));
-                }
-            }
-
-            {
-                uint32_t n = ReadPOD<uint32_t>(in);
-                c.method_definitions.reserve(n);
-                for (uint32_t i = 0; i < n; ++i)
-                {
-                    MethodDef m{};
-                    m.name = ReadPOD<string_idx>(in);
-                    m.flags = ReadPOD<uint32_t>(in);
-                    m.signature = ReadPOD<signature_idx>(in);
-                    m.body_ptr = ReadPOD<body_idx>(in);
-                    c.method_definitions.push_back(std::move(m));
-                }
-            }
-
-            {
-                uint32_t n = ReadPOD<uint32_t>(in);
-                c.field_definitions.reserve(n);
-                for (uint32_t i = 0; i < n; ++i)
-                {
-                    FieldDef f{};
-                    f.name = ReadPOD<string_idx>(in);
-                    f.flags = ReadPOD<uint32_t>(in);
-                    f.type = ReadPOD<type_idx>(in);
-                    c.field_definitions.push_back(std::move(f));
-                }
-            }
-
-            {
-                uint32_t n = ReadPOD<uint32_t>(in);
-                c.property_definitions.reserve(n);
-                for (uint32_t i = 0; i < n; ++i)
-                {
-                    PropertyDef p{};
-                    p.name = ReadPOD<string_idx>(in);
-                    p.flags = ReadPOD<uint32_t>(in);
-                    p.type = ReadPOD<type_idx>(in);
-                    p.getter = ReadPOD<method_idx>(in);
-                    p.setter = ReadPOD<method_idx>(in);
-                    c.property_definitions.push_back(std::move(p));
-                }
-            }
-
-            {
-                uint32_t n = ReadPOD<uint32_t>(in);
-                c.global_constant_pool.reserve(n);
-                for (uint32_t i = 0; i < n; ++i)
-                {
-                    c.global_constant_pool.push_back(Value::deserialize(in));
-                }
-            }
-
-            c.signature_blob = ReadVectorPOD<uint8_t>(in);
-
-            {
-                uint32_t n = ReadPOD<uint32_t>(in);
-                c.method_bodies.reserve(n);
-                for (uint32_t i = 0; i < n; ++i)
-                {
-                    MethodBody body{};
-                    body.bytecode = ReadVectorPOD<uint8_t>(in);
-                    body.line_info = ReadVectorPOD<uint32_t>(in);
-                    body.max_stack_depth = ReadPOD<uint32_t>(in);
-                    c.method_bodies.push_back(std::move(body));
-                }
-            }
+            PropertyDef p{};
+            p.name = ReadPOD<string_idx>(in);
+            p.flags = ReadPOD<uint32_t>(in);
+            p.type = ReadPOD<type_idx>(in);
+            p.getter = ReadPOD<method_idx>(in);
+            p.setter = ReadPOD<method_idx>(in);
+            c.property_definitions.push_back(std::move(p));
         }
+    }
 
-        if (c.global_constant_pool.empty())
+    {
+        uint32_t n = ReadPOD<uint32_t>(in);
+        c.global_constant_pool.reserve(n);
+        for (uint32_t i = 0; i < n; ++i)
         {
-            c.global_constant_pool = std::move(legacy_constants);
+            c.global_constant_pool.push_back(Value::deserialize(in));
         }
+    }
 
-        if (c.method_bodies.empty())
-        {
-            MethodBody body{};
-            body.bytecode = std::move(legacy_code);
-            body.line_info = std::move(legacy_lines);
-            c.method_bodies.push_back(std::move(body));
-        }
-    } else {
-        c.manifest.name = ReadString(in);
-        c.manifest.version_major = ReadPOD<uint16_t>(in);
-        c.manifest.version_minor = ReadPOD<uint16_t>(in);
+    c.signature_blob = ReadVectorPOD<uint8_t>(in);
 
+    {
+        uint32_t n = ReadPOD<uint32_t>(in);
+        c.method_bodies.reserve(n);
+        for (uint32_t i = 0; i < n; ++i)
         {
-            uint32_t n = ReadPOD<uint32_t>(in);
-            c.string_table.reserve(n);
-            for (uint32_t i = 0; i < n; ++i) {
-                c.string_table.push_back(ReadString(in));
-            }
-        }
+            MethodBody body{};
+            body.bytecode = ReadVectorPOD<uint8_t>(in);
+            body.line_info = ReadVectorPOD<uint32_t>(in);
+            body.max_stack_depth = ReadPOD<uint32_t>(in);
+            if (body.max_stack_depth == 0)
+                body.max_stack_depth = compute_max_stack_depth(body.bytecode);
 
-        {
-            uint32_t n = ReadPOD<uint32_t>(in);
-            c.type_definitions.reserve(n);
-            for (uint32_t i = 0; i < n; ++i)
-            {
-                TypeDef t{};
-                t.name = ReadPOD<string_idx>(in);
-                t.namespace_name = ReadPOD<string_idx>(in);
-                t.flags = ReadPOD<uint32_t>(in);
-                t.base_type = ReadPOD<type_idx>(in);
-                t.method_list.start = ReadPOD<uint32_t>(in);
-                t.method_list.count = ReadPOD<uint32_t>(in);
-                t.field_list.start = ReadPOD<uint32_t>(in);
-                t.field_list.count = ReadPOD<uint32_t>(in);
-                t.property_list.start = ReadPOD<uint32_t>(in);
-                t.property_list.count = ReadPOD<uint32_t>(in);
-                t.interfaces = ReadVectorPOD<type_idx>(in);
-                c.type_definitions.push_back(std::move(t));
+            // DebugInfo (optional)
+            uint8_t has_debug = ReadPOD<uint8_t>(in);
+            if (has_debug) {
+                body.debug_info = std::make_unique<DebugInfo>();
+                body.debug_info->function_name = ReadString(in);
+                body.debug_info->source_file = ReadString(in);
+                uint32_t lc = ReadPOD<uint32_t>(in);
+                body.debug_info->locals.reserve(lc);
+                for (uint32_t j = 0; j < lc; ++j) {
+                    DebugLocalInfo dl;
+                    dl.name = ReadString(in);
+                    dl.slot_index = ReadPOD<uint16_t>(in);
+                    dl.scope_start_offset = ReadPOD<uint32_t>(in);
+                    dl.scope_end_offset = ReadPOD<uint32_t>(in);
+                    dl.type_name = ReadString(in);
+                    body.debug_info->locals.push_back(std::move(dl));
+                }
             }
-        }
 
-        {
-            uint32_t n = ReadPOD<uint32_t>(in);
-            c.method_definitions.reserve(n);
-            for (uint32_t i = 0; i < n; ++i)
-            {
-                MethodDef m{};
-                m.name = ReadPOD<string_idx>(in);
-                m.flags = ReadPOD<uint32_t>(in);
-                m.signature = ReadPOD<signature_idx>(in);
-                m.body_ptr = ReadPOD<body_idx>(in);
-                c.method_definitions.push_back(std::move(m));
-            }
+            c.method_bodies.push_back(std::move(body));
         }
+    }
 
-        {
-            uint32_t n = ReadPOD<uint32_t>(in);
-            c.field_definitions.reserve(n);
-            for (uint32_t i = 0; i < n; ++i)
-            {
-                FieldDef f{};
-                f.name = ReadPOD<string_idx>(in);
-                f.flags = ReadPOD<uint32_t>(in);
-                f.type = ReadPOD<type_idx>(in);
-                c.field_definitions.push_back(std::move(f));
-            }
-        }
+    {
+        uint32_t n = ReadPOD<uint32_t>(in);
+        c.function_prototypes.reserve(n);
 
+        for (uint32_t i = 0; i < n; ++i)
         {
-            uint32_t n = ReadPOD<uint32_t>(in);
-            c.property_definitions.reserve(n);
-            for (uint32_t i = 0; i < n; ++i)
-            {
-                PropertyDef p{};
-                p.name = ReadPOD<string_idx>(in);
-                p.flags = ReadPOD<uint32_t>(in);
-                p.type = ReadPOD<type_idx>(in);
-                p.getter = ReadPOD<method_idx>(in);
-                p.setter = ReadPOD<method_idx>(in);
-                c.property_definitions.push_back(std::move(p));
-            }
-        }
+            FunctionPrototype fn{};
+            fn.name = ReadString(in);
 
-        {
-            uint32_t n = ReadPOD<uint32_t>(in);
-            c.global_constant_pool.reserve(n);
-            for (uint32_t i = 0; i < n; ++i)
-            {
-                c.global_constant_pool.push_back(Value::deserialize(in));
-            }
-        }
+            uint32_t pn = ReadPOD<uint32_t>(in);
+            fn.params.reserve(pn);
+            for (uint32_t k = 0; k < pn; ++k) fn.params.push_back(ReadString(in));
 
-        c.signature_blob = ReadVectorPOD<uint8_t>(in);
+            uint32_t ln = ReadPOD<uint32_t>(in);
+            fn.param_labels.reserve(ln);
+            for (uint32_t k = 0; k < ln; ++k) fn.param_labels.push_back(ReadString(in));
 
-        {
-            uint32_t n = ReadPOD<uint32_t>(in);
-            c.method_bodies.reserve(n);
-            for (uint32_t i = 0; i < n; ++i)
+            uint32_t dn = ReadPOD<uint32_t>(in);
+            fn.param_defaults.resize(dn);
+            for (uint32_t k = 0; k < dn; ++k)
             {
-                MethodBody body{};
-                body.bytecode = ReadVectorPOD<uint8_t>(in);
-                body.line_info = ReadVectorPOD<uint32_t>(in);
-                body.max_stack_depth = ReadPOD<uint32_t>(in);
-
-                // DebugInfo (optional)
-                uint8_t has_debug = ReadPOD<uint8_t>(in);
-                if (has_debug) {
-                    body.debug_info = std::make_unique<DebugInfo>();
-                    body.debug_info->function_name = ReadString(in);
-                    body.debug_info->source_file = ReadString(in);
-                    uint32_t lc = ReadPOD<uint32_t>(in);
-                    body.debug_info->locals.reserve(lc);
-                    for (uint32_t j = 0; j < lc; ++j) {
-                        DebugLocalInfo dl;
-                        dl.name = ReadString(in);
-                        dl.slot_index = ReadPOD<uint16_t>(in);
-                        dl.scope_start_offset = ReadPOD<uint32_t>(in);
-                        dl.scope_end_offset = ReadPOD<uint32_t>(in);
-                        dl.type_name = ReadString(in);
-                        body.debug_info->locals.push_back(std::move(dl));
-                    }
-                }
+                auto& d = fn.param_defaults[k];
+                d.has_default = ReadPOD<uint8_t>(in) != 0;
+                if (d.has_default)
+                {
+                    d.value = Value::deserialize(in);
 
-                c.method_bodies.push_back(std::move(body));
+                    bool hasStr = ReadPOD<uint8_t>(in) != 0;
+                    if (hasStr) d.string_value = ReadString(in);
+                }
             }
-        }
-
-        {
-            uint32_t n = ReadPOD<uint32_t>(in);
-            c.function_prototypes.reserve(n);
 
-            for (uint32_t i = 0; i < n; ++i)
+            uint32_t uvn = ReadPOD<uint32_t>(in);
+            fn.upvalues.reserve(uvn);
+            for (uint32_t k = 0; k < uvn; ++k)
             {
-                FunctionPrototype fn{};
-                fn.name = ReadString(in);
+                UpvalueInfo u{};
+                u.index = ReadPOD<uint16_t>(in);
+                u.is_local = ReadPOD<uint8_t>(in) != 0;
+                fn.upvalues.push_back(u);
+            }
 
-                uint32_t pn = ReadPOD<uint32_t>(in);
-                fn.params.reserve(pn);
-                for (uint32_t k = 0; k < pn; ++k) fn.params.push_back(ReadString(in));
+            fn.is_initializer = ReadPOD<uint8_t>(in) != 0;
+            fn.is_override = ReadPOD<uint8_t>(in) != 0;
 
-                uint32_t ln = ReadPOD<uint32_t>(in);
-                fn.param_labels.reserve(ln);
-                for (uint32_t k = 0; k < ln; ++k) fn.param_labels.push_back(ReadString(in));
+            fn.body = ReadPOD<body_idx>(in);
 
-                uint32_t dn = ReadPOD<uint32_t>(in);
-                fn.param_defaults.resize(dn);
-                for (uint32_t k = 0; k < dn; ++k)
-                {
-                    auto& d = fn.param_defaults[k];
-                    d.has_default = ReadPOD<uint8_t>(in) != 0;
-                    if (d.has_default)
-                    {
-                        d.value = Value::deserialize(in);
-
-                        bool hasStr = ReadPOD<uint8_t>(in) != 0;
-                        if (hasStr) d.string_value = ReadString(in);
-                    }
-                }
+            c.function_prototypes.push_back(std::move(fn));
+        }
+    }
 
-                uint32_t uvn = ReadPOD<uint32_t>(in);
-                fn.upvalues.reserve(uvn);
-                for (uint32_t k = 0; k < uvn; ++k)
-                {
-                    UpvalueInfo u{};
-                    u.index = ReadPOD<uint16_t>(in);
-                    u.is_local = ReadPOD<uint8_t>(in) != 0;
-                    fn.upvalues.push_back(u);
-                }
+    {
+        uint32_t n = ReadPOD<uint32_t>(in);
+        c.protocol_definitions.reserve(n);
 
-                fn.is_initializer = ReadPOD<uint8_t>(in) != 0;
-                fn.is_override = ReadPOD<uint8_t>(in) != 0;
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            bool has = ReadPOD<uint8_t>(in) != 0;
+            if (!has) { c.protocol_definitions.push_back(nullptr); continue; }
 
-                bool hasAssembly = ReadPOD<uint8_t>(in) != 0;
-                if (hasAssembly)
-                {
-                    fn.chunk = std::make_shared<Assembly>(Assembly::deserialize(in));
-                }
+            auto pr = std::make_shared<Protocol>();
+            pr->name = ReadString(in);
 
-                c.function_prototypes.push_back(std::move(fn));
+            uint32_t mn = ReadPOD<uint32_t>(in);
+            pr->method_requirements.reserve(mn);
+            for (uint32_t k = 0; k < mn; ++k)
+            {
+                ProtocolMethodReq m{};
+                m.name = ReadString(in);
+                uint32_t pnn = ReadPOD<uint32_t>(in);
+                m.param_names.reserve(pnn);
+                for (uint32_t j = 0; j < pnn; ++j) m.param_names.push_back(ReadString(in));
+                m.is_mutating = ReadPOD<uint8_t>(in) != 0;
+                pr->method_requirements.push_back(std::move(m));
             }
-        }
-
-        {
-            uint32_t n = ReadPOD<uint32_t>(in);
-            c.protocol_definitions.reserve(n);
 
-            for (uint32_t i = 0; i < n; ++i)
+            uint32_t pn = ReadPOD<uint32_t>(in);
+            pr->property_requirements.reserve(pn);
+            for (uint32_t k = 0; k < pn; ++k)
             {
-                bool has = ReadPOD<uint8_t>(in) != 0;
-                if (!has) { c.protocol_definitions.push_back(nullptr); continue; }
-
-                auto pr = std::make_shared<Protocol>();
-                pr->name = ReadString(in);
-
-                uint32_t mn = ReadPOD<uint32_t>(in);
-                pr->method_requirements.reserve(mn);
-                for (uint32_t k = 0; k < mn; ++k)
-                {
-                    ProtocolMethodReq m{};
-                    m.name = ReadString(in);
-                    uint32_t pnn = ReadPOD<uint32_t>(in);
-                    m.param_names.reserve(pnn);
-                    for (uint32_t j = 0; j < pnn; ++j) m.param_names.push_back(ReadString(in));
-                    m.is_mutating = ReadPOD<uint8_t>(in) != 0;
-                    pr->method_requirements.push_back(std::move(m));
-                }
-
-                uint32_t pn = ReadPOD<uint32_t>(in);
-                pr->property_requirements.reserve(pn);
-                for (uint32_t k = 0; k < pn; ++k)
-                {
-                    ProtocolPropertyReq p{};
-                    p.name = ReadString(in);
-                    p.has_getter = ReadPOD<uint8_t>(in) != 0;
-                    p.has_setter = ReadPOD<uint8_t>(in) != 0;
-                    pr->property_requirements.push_back(std::move(p));
-                }
+                ProtocolPropertyReq p{};
+                p.name = ReadString(in);
+                p.has_getter = ReadPOD<uint8_t>(in) != 0;
+                p.has_setter = ReadPOD<uint8_t>(in) != 0;
+                pr->property_requirements.push_back(std::move(p));
+            }
 
-                uint32_t inh = ReadPOD<uint32_t>(in);
-                pr->inherited_protocols.reserve(inh);
-                for (uint32_t k = 0; k < inh; ++k) pr->inherited_protocols.push_back(ReadString(in));
+            uint32_t inh = ReadPOD<uint32_t>(in);
+            pr->inherited_protocols.reserve(inh);
+            for (uint32_t k = 0; k < inh; ++k) pr->inherited_protocols.push_back(ReadString(in));
 
-                c.protocol_definitions.push_back(std::move(pr));
-            }
+            c.protocol_definitions.push_back(std::move(pr));
         }
     }
 
@@ -1052,6 +1298,10 @@ void Assembly::expand_to_assembly() {
         method_bodies.emplace_back();
     }
 
+    for (auto& body : method_bodies) {
+        body.max_stack_depth = compute_max_stack_depth(body.bytecode);
+    }
+
     if (method_definitions.empty()) {
         MethodDef entry{};
         entry.name = static_cast<string_idx>(add_string(manifest.name));
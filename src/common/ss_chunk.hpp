@@ -18,6 +18,15 @@ namespace swive {
 
 struct Assembly;
 
+using string_idx = uint32_t;
+using type_idx = uint32_t;
+using method_idx = uint32_t;
+using field_idx = uint32_t;
+using signature_idx = uint32_t;
+using body_idx = uint32_t;
+
+constexpr body_idx kInvalidBody = std::numeric_limits<body_idx>::max();
+
 // Upvalue descriptor for compilation
 struct UpvalueInfo {
     uint16_t index;    // Index in enclosing scope (local or upvalue)
@@ -37,7 +46,8 @@ struct FunctionPrototype {
 		ParamDefaultValue(std::nullopt_t) : has_default(false), value(Value::null()) {}
     };
     std::vector<ParamDefaultValue> param_defaults;
-    std::shared_ptr<Assembly> chunk;
+    std::shared_ptr<Assembly> chunk;  // Compiler output; null once linked into the module
+    body_idx body{kInvalidBody};      // Entry MethodBody in the module's method_bodies
     std::vector<UpvalueInfo> upvalues;  // Captured variables info
     bool is_initializer{false};
     bool is_override{false};
@@ -71,13 +81,6 @@ struct AssemblyManifest {
     uint16_t version_minor{0};
 };
 
-using string_idx = uint32_t;
-using type_idx = uint32_t;
-using method_idx = uint32_t;
-using field_idx = uint32_t;
-using signature_idx = uint32_t;
-using body_idx = uint32_t;
-
 struct Range {
     uint32_t start{0};
     uint32_t count{0};
@@ -98,7 +101,8 @@ enum class MethodFlags : uint32_t {
     Static = 1u << 0,
     Virtual = 1u << 1,
     Override = 1u << 2,
-    Mutating = 1u << 3
+    Mutating = 1u << 3,
+    Final = 1u << 4
 };
 
 enum class FieldFlags : uint32_t {
@@ -162,10 +166,87 @@ struct DebugInfo {
     std::string source_file;
 };
 
+// Values an instruction pops and pushes within its own frame. A call pops
+// the callee and its arguments and pushes the result once the callee returns.
+struct StackEffect {
+    uint32_t pops{0};
+    uint32_t pushes{0};
+};
+
+// Byte length of the instruction at offset (opcode plus operands)
+size_t instruction_length(const std::vector<uint8_t>& code, size_t offset);
+StackEffect instruction_stack_effect(const std::vector<uint8_t>& code, size_t offset);
+// Upper bound on the operand stack height a method body reaches above its
+// frame base, following forward jumps. Loops return to their entry height.
+uint32_t compute_max_stack_depth(const std::vector<uint8_t>& code);
+
+// OP_SWITCH_TABLE [mode][count][default] then the entries for the mode:
+//   dense:  [low:i64] and count targets, one per key low..low+count-1
+//   sparse: count x [key:i64][target], sorted by key
+//   string: count x [hash:u32][string index][target], sorted by hash
+// Every target is a forward offset from the end of the instruction.
+enum SwitchTableMode : uint8_t {
+    SWITCH_INT = 0,     // Int subject (integral Floats match as in OP_EQUAL)
+    SWITCH_ENUM = 1,    // Enum case subject, keyed by discriminant
+    SWITCH_STRING = 2,  // String subject, keyed by switch_string_hash()
+    SWITCH_KIND_MASK = 3,
+    SWITCH_DENSE = 4,   // Int/enum keys laid out as a jump table
+};
+
+inline size_t switch_table_entry_size(uint8_t mode) {
+    if (mode & SWITCH_DENSE) return 2;
+    return (mode & SWITCH_KIND_MASK) == SWITCH_STRING ? 8 : 10;
+}
+
+inline int64_t switch_table_key(const std::vector<uint8_t>& code, size_t offset) {
+    uint64_t key = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        key = (key << 8) | code[offset + i];
+    }
+    return static_cast<int64_t>(key);
+}
+
+// FNV-1a; the compiler sorts string cases by this and the VM searches by it
+inline uint32_t switch_string_hash(const std::string& text) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 16777619u;
+    }
+    return hash;
+}
+
+// Byte offsets of every target operand of the OP_SWITCH_TABLE at offset, default first
+std::vector<size_t> switch_table_target_operands(const std::vector<uint8_t>& code, size_t offset);
+// Byte offsets of every jump distance of the instruction at offset, in operand
+// order. OP_LOOP jumps backward; every other distance is forward.
+std::vector<size_t> jump_operand_offsets(const std::vector<uint8_t>& code, size_t offset);
+// Control never falls through to the next instruction
+bool is_block_terminator(OpCode op);
+
+// Table a 16-bit instruction operand indexes into. Once a module is linked
+// every body shares the root tables and Function equals ProgramFunction.
+enum class OperandTable : uint8_t {
+    String,           // The owning chunk's string_table
+    Constant,         // The owning chunk's constant pool
+    Function,         // The owning chunk's function_prototypes
+    ProgramFunction,  // The root Assembly's function_prototypes (OP_CALL_DIRECT, OP_CALL_METHOD_*)
+    Protocol,         // The owning chunk's protocol_definitions (OP_PROTOCOL)
+};
+// Byte offsets of every operand of the instruction at offset that indexes
+// table, in operand order. Optional operands hold 0xFFFF when absent.
+std::vector<size_t> table_operand_offsets(const std::vector<uint8_t>& code, size_t offset, OperandTable table);
+// Byte width of op's table operands: 3 for OP_CONSTANT_LONG and OP_STRING_LONG, else 2
+size_t table_operand_width(OpCode op);
+constexpr size_t kMaxLongOperand = 0xFFFFFF;
+// Table operand at operand of the instruction at offset, at that instruction's width
+uint32_t read_table_operand(const std::vector<uint8_t>& code, size_t offset, size_t operand);
+void write_table_operand(std::vector<uint8_t>& code, size_t offset, size_t operand, uint32_t value);
+
 struct MethodBody {
     std::vector<uint8_t> bytecode;
     std::vector<uint32_t> line_info;
-    uint32_t max_stack_depth{0};
+    uint32_t max_stack_depth{0};      // See compute_max_stack_depth()
+    uint32_t frame_slots{0};          // Parameter and self slots below the first push
     std::unique_ptr<DebugInfo> debug_info; // null when debug is disabled
 
     MethodBody() = default;
@@ -177,6 +258,7 @@ struct MethodBody {
         : bytecode(other.bytecode)
         , line_info(other.line_info)
         , max_stack_depth(other.max_stack_depth)
+        , frame_slots(other.frame_slots)
         , debug_info(other.debug_info
               ? std::make_unique<DebugInfo>(*other.debug_info)
               : nullptr) {}
@@ -186,6 +268,7 @@ struct MethodBody {
             bytecode = other.bytecode;
             line_info = other.line_info;
             max_stack_depth = other.max_stack_depth;
+            frame_slots = other.frame_slots;
             debug_info = other.debug_info
                 ? std::make_unique<DebugInfo>(*other.debug_info)
                 : nullptr;
@@ -203,6 +286,9 @@ struct Assembly {
     std::vector<PropertyDef> property_definitions;
     std::vector<Value> global_constant_pool;
     std::vector<std::string> string_table;
+    // Strings OP_STRING loads until the module is linked. Keeping them apart
+    // lets names take the low string_table rows; see ModuleLinker.
+    std::vector<std::string> literal_strings;
     std::vector<uint8_t> signature_blob;
     std::vector<MethodBody> method_bodies;
     std::vector<FunctionPrototype> function_prototypes;
@@ -211,8 +297,11 @@ struct Assembly {
     void write(uint8_t byte, uint32_t line);
     void write_op(OpCode op, uint32_t line);
 
+    // Both intern: equal strings, and scalars with the same type and bits,
+    // share one entry. Objects always get a new constant.
     size_t add_constant(Value value);
     size_t add_string(const std::string& str);
+    size_t add_literal_string(const std::string& str);
     size_t add_function(FunctionPrototype proto);
     size_t add_protocol(std::shared_ptr<Protocol> protocol);
 
@@ -228,12 +317,37 @@ struct Assembly {
     size_t disassemble_instruction(size_t offset) const;
 
 	void serialize(std::ostream& out) const;
+	// Rejects files written before the current format version
 	static Assembly deserialize(std::istream& in);
     void expand_to_assembly();
 
     MethodBody& ensure_primary_body();
 
 private:
+    struct ConstantKey {
+        Value::Type type{Value::Type::Null};
+        uint64_t bits{0};
+        bool operator==(const ConstantKey& other) const { return type == other.type && bits == other.bits; }
+    };
+    struct ConstantKeyHash {
+        size_t operator()(const ConstantKey& key) const {
+            return std::hash<uint64_t>{}(key.bits) ^ static_cast<size_t>(key.type);
+        }
+    };
+
+    // Lookup indexes over the tables above. Rows appended directly are
+    // indexed on the next add; a table that shrank is reindexed.
+    std::unordered_map<std::string, uint32_t> string_index_;
+    size_t strings_indexed_{0};
+    std::unordered_map<std::string, uint32_t> literal_index_;
+    size_t literals_indexed_{0};
+    std::unordered_map<ConstantKey, uint32_t, ConstantKeyHash> constant_index_;
+    size_t constants_indexed_{0};
+
+    static bool constant_key(const Value& value, ConstantKey& key);
+    static size_t intern(std::vector<std::string>& table, std::unordered_map<std::string, uint32_t>& index,
+                         size_t& indexed, const std::string& str);
+
     size_t simple_instruction(const char* name, size_t offset) const;
     size_t constant_instruction(const char* name, size_t offset) const;
     size_t string_instruction(const char* name, size_t offset) const;
@@ -326,6 +440,6 @@ namespace swive {
 
         constexpr uint32_t kMagicSSAS = 0x53415353; // 'SSAS' little-endian
         constexpr uint16_t kVerMajor = 1;
-        constexpr uint16_t kVerMinor = 3;
+        constexpr uint16_t kVerMinor = 4;  // 4: renumbered opcodes; prototypes name a module body. Older files are rejected
     }
 }
@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 29thnight
+
+/**
+ * @file ss_class_hierarchy.cpp
+ * @brief Whole-program class hierarchy analysis for devirtualizing method calls.
+ *
+ * Name lookup on an instance checks its fields before its class's methods,
+ * so a method is only resolved when no class on the receiver's chain
+ * declares a property or static member of the same name. Only top-level
+ * classes are recorded; the type checker rejects constructing a class
+ * declared in a nested scope, so no instance of one can reach a call site.
+ */
+
+#include "pch.h"
+#include "ss_class_hierarchy.hpp"
+
+namespace swive {
+
+    void DevirtualizationStats::print(std::ostream& out) const {
+        out << "\n=== Swive Devirtualization ===\n";
+        out << "Direct Calls:     " << std::setw(10) << direct_calls << "\n";
+        out << "Self Calls:       " << std::setw(10) << self_calls << "\n";
+        out << "Guarded Calls:    " << std::setw(10) << guarded_calls << "\n";
+        out << "Dynamic Calls:    " << std::setw(10) << dynamic_calls << "\n";
+        out << "==============================\n";
+    }
+
+    void ClassHierarchy::clear() {
+        classes_.clear();
+        protocols_.clear();
+        extension_members_.clear();
+    }
+
+    void ClassHierarchy::add_class(const ClassDeclStmt& decl, bool analyzable) {
+        if (decl.superclass_name.has_value()) {
+            classes_[decl.superclass_name.value()].subclasses.push_back(decl.name);
+        }
+
+        ClassInfo& info = classes_[decl.name];
+        if (info.decl) {
+            info.analyzable = false;  // Declared twice; the runtime binding depends on order
+            return;
+        }
+        info.decl = &decl;
+        info.superclass = decl.superclass_name.value_or(std::string{});
+        info.analyzable = analyzable && decl.generic_params.empty();
+        for (const auto& method : decl.methods) {
+            if (!method) {
+                continue;
+            }
+            if (method->is_static) {
+                info.members.insert(method->name);
+                continue;
+            }
+            auto [it, inserted] = info.methods.emplace(method->name, method.get());
+            if (!inserted) {
+                it->second = nullptr;  // Overloaded: resolved by arity at runtime
+            }
+        }
+        for (const auto& property : decl.properties) {
+            if (property) {
+                info.members.insert(property->name);
+            }
+        }
+    }
+
+    void ClassHierarchy::add_extension(const ExtensionDeclStmt& decl) {
+        // Extensions may target a protocol the class adopts, so their
+        // members are excluded whatever type they name
+        for (const auto& method : decl.methods) {
+            if (method) {
+                extension_members_.insert(method->name);
+            }
+        }
+    }
+
+    const ClassHierarchy::ClassInfo* ClassHierarchy::find(const std::string& name) const {
+        auto it = classes_.find(name);
+        return it != classes_.end() && it->second.decl ? &it->second : nullptr;
+    }
+
+    const ClassHierarchy::ClassInfo* ClassHierarchy::superclass_of(const ClassInfo& info, bool& complete) const {
+        if (info.superclass.empty() || protocols_.count(info.superclass)) {
+            return nullptr;
+        }
+        const ClassInfo* superclass = find(info.superclass);
+        if (!superclass) {
+            complete = false;
+        }
+        return superclass;
+    }
+
+    bool ClassHierarchy::is_class(const std::string& name) const {
+        return find(name) != nullptr;
+    }
+
+    bool ClassHierarchy::is_final_class(const std::string& name) const {
+        const ClassInfo* info = find(name);
+        return info && info->decl->is_final;
+    }
+
+    const FuncDeclStmt* ClassHierarchy::inherited_method(const ClassDeclStmt& decl, const std::string& name) const {
+        if (!decl.superclass_name.has_value()) {
+            return nullptr;
+        }
+        bool complete = true;
+        for (const ClassInfo* info = find(decl.superclass_name.value()); info; info = superclass_of(*info, complete)) {
+            auto it = info->methods.find(name);
+            if (it != info->methods.end()) {
+                return it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    bool ClassHierarchy::declared_below(const ClassInfo& info, const std::string& name) const {
+        for (const auto& subclass_name : info.subclasses) {
+            const ClassInfo* subclass = find(subclass_name);
+            if (!subclass) {
+                continue;
+            }
+            if (subclass->methods.count(name) || subclass->members.count(name) || declared_below(*subclass, name)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::optional<ClassHierarchy::Resolution> ClassHierarchy::resolve(const std::string& class_name,
+                                                                      const std::string& method) const {
+        const ClassInfo* receiver = find(class_name);
+        if (!receiver || method == "init" || method == "deinit" || extension_members_.count(method)) {
+            return std::nullopt;
+        }
+
+        Resolution resolution;
+        bool complete = true;
+        for (const ClassInfo* info = receiver; info; info = superclass_of(*info, complete)) {
+            if (!info->analyzable || info->members.count(method)) {
+                return std::nullopt;
+            }
+            auto it = info->methods.find(method);
+            if (it != info->methods.end() && !resolution.method) {
+                if (!it->second) {
+                    return std::nullopt;
+                }
+                resolution.method = it->second;
+                resolution.owner = info->decl->name;
+            }
+        }
+        const FuncDeclStmt* impl = resolution.method;
+        if (!complete || !impl || !impl->generic_params.empty() || !impl->attributes.empty()) {
+            return std::nullopt;
+        }
+
+        resolution.closed = receiver->decl->is_final || impl->is_final ||
+                            impl->access_level == AccessLevel::Private ||
+                            !declared_below(*receiver, method);
+        return resolution;
+    }
+
+} // namespace swive
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 29thnight
+
+/**
+ * @file ss_class_hierarchy.hpp
+ * @brief Whole-program class hierarchy analysis for devirtualizing method calls.
+ *
+ * Built from every top-level class, protocol and extension the compiler
+ * collects before it emits code. A call on a receiver of class C resolves to
+ * the one implementation C declares or inherits. The call is closed, and
+ * needs no guard, when nothing below C can replace that implementation: C or
+ * the method is final, the method is private, or no subclass declares a
+ * member of that name. Otherwise only receivers of exactly C may skip the
+ * lookup.
+ */
+
+#pragma once
+
+#include "ss_ast.hpp"
+
+namespace swive {
+
+struct DevirtualizationStats {
+    size_t direct_calls{0};   // Closed calls, checked only against the receiver's declared class
+    size_t self_calls{0};     // Closed calls on self, entered as OP_CALL_DIRECT (inlinable)
+    size_t guarded_calls{0};  // Calls that skip the lookup only for receivers of exactly the declared class
+    size_t dynamic_calls{0};  // Calls on a known class left to name lookup
+
+    void print(std::ostream& out) const;
+};
+
+class ClassHierarchy {
+public:
+    struct Resolution {
+        const FuncDeclStmt* method{nullptr};
+        std::string owner;    // Class declaring the implementation
+        bool closed{false};   // No subclass of the receiver's class can replace it
+    };
+
+    void clear();
+    // Native and generic classes are recorded so their subclasses see a
+    // complete chain, but calls on them are never resolved
+    void add_class(const ClassDeclStmt& decl, bool analyzable);
+    void add_protocol(const std::string& name) { protocols_.insert(name); }
+    void add_extension(const ExtensionDeclStmt& decl);
+
+    bool is_class(const std::string& name) const;
+    bool is_final_class(const std::string& name) const;
+    // Instance method the nearest ancestor of decl declares under name
+    const FuncDeclStmt* inherited_method(const ClassDeclStmt& decl, const std::string& name) const;
+    // Implementation a call of method on a receiver of class_name runs, when
+    // there is exactly one and no property or extension can shadow it
+    std::optional<Resolution> resolve(const std::string& class_name, const std::string& method) const;
+
+private:
+    struct ClassInfo {
+        const ClassDeclStmt* decl{nullptr};  // Null until the class itself is recorded
+        std::string superclass;
+        bool analyzable{false};
+        std::unordered_map<std::string, const FuncDeclStmt*> methods;  // Instance methods; nullptr when overloaded
+        std::unordered_set<std::string> members;                      // Properties and static methods
+        std::vector<std::string> subclasses;
+    };
+
+    std::unordered_map<std::string, ClassInfo> classes_;
+    std::unordered_set<std::string> protocols_;
+    std::unordered_set<std::string> extension_members_;
+
+    const ClassInfo* find(const std::string& name) const;
+    // Superclass record; sets complete to false when the chain leaves the recorded classes
+    const ClassInfo* superclass_of(const ClassInfo& info, bool& complete) const;
+    bool declared_below(const ClassInfo& info, const std::string& name) const;
+};
+
+} // namespace swive
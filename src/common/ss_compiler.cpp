@@ -12,6 +12,7 @@
 
 #include "pch.h"
 #include "ss_compiler.hpp"
+#include "ss_constant_folder.hpp"
 #include "ss_lexer.hpp"
 #include "ss_parser.hpp"
 #include "ss_type_checker.hpp"
@@ -24,11 +25,23 @@ namespace swive {
 
 namespace swive {
 
+namespace {
 
+// Name an optional declaration annotation gives, or "" when it has none
+std::string annotated_type_name(const std::optional<TypeAnnotation>& annotation) {
+    return annotation ? annotation->name : std::string{};
+}
+
+} // namespace
 
 
 
 Assembly Compiler::compile(const std::vector<StmtPtr>& program) {
+function_specializations_.clear();
+specialization_bodies_.clear();
+struct_specializations_.clear();
+specialization_stats_ = SpecializationStats{};
+
 // Step 1: Specialize generics (currently just passes through)
 auto specialized_program = specialize_generics(program);
     
@@ -38,19 +51,43 @@ checker.set_base_directory(base_directory_);
 checker.set_module_resolver(module_resolver_);
 checker.check(specialized_program);
 
+// Step 3: Fold constant expressions and propagate literal lets
+ConstantFolder{}.fold(specialized_program);
+
+// Step 4: Scalar-replace struct and tuple locals that never escape
+escape_stats_ = EscapeStats{};
+if (scalar_replacement_) {
+    EscapeAnalyzer analyzer;
+    analyzer.run(specialized_program);
+    escape_stats_ = analyzer.stats();
+}
+
 chunk_ = Assembly{};
-chunk_.ensure_primary_body();  // Reserve index 0 for root bytecode (before any store_method_body calls)
+chunk_.ensure_primary_body();  // Reserve index 0 for root bytecode (function bodies are linked after it)
 locals_.clear();
 scope_depth_ = 0;
 recursion_depth_ = 0;
 method_body_lookup_.clear();
-specialized_functions_.clear();
+call_signatures_.clear();
+initializer_arg_types_.clear();
+direct_call_slots_.clear();
+method_call_slots_.clear();
+class_hierarchy_.clear();
+devirtualization_stats_ = DevirtualizationStats{};
+pending_imports_ = static_cast<size_t>(std::count_if(specialized_program.begin(), specialized_program.end(),
+    [](const StmtPtr& stmt) { return stmt && stmt->kind == StmtKind::Import; }));
+program_ids_ = std::make_shared<ProgramIds>();
+global_type_names_.clear();
 imported_module_asts_.clear();
 
 // Emit built-in $Expected enum definition
 emit_expected_enum_definition();
 
-// Step 3: Compile statements (skip generic templates, they're handled by type checker)
+for (const auto& stmt : specialized_program) {
+    collect_call_signatures(stmt.get());
+}
+
+// Step 5: Compile statements (skip generic templates, they're handled by type checker)
 for (const auto& stmt : specialized_program) {
     if (!stmt) {
         throw CompilerError("Null statement in program");
@@ -72,7 +109,12 @@ for (const auto& stmt : specialized_program) {
         }
     }
 
-    compile_stmt(stmt.get());
+    if (!compile_specialization(stmt.get())) {
+        compile_stmt(stmt.get());
+    }
+    if (stmt->kind == StmtKind::Import && pending_imports_ > 0) {
+        --pending_imports_;
+    }
 
     // Compile any deferred generic specializations queued during this stmt
     compile_pending_specializations();
@@ -96,8 +138,33 @@ for (const auto& stmt : specialized_program) {
         primary.debug_info->locals = std::move(debug_locals_);
     }
 
+    if (inline_functions_) {
+        inline_direct_calls();
+    }
+    if (optimize_bytecode_) {
+        optimize_method_bodies();
+    }
+
     chunk_.expand_to_assembly();
+
+    // Fold every function Assembly into the module so all bodies share one set of tables
+    ModuleLinker linker;
+    linker.link(chunk_);
+    module_link_stats_ = linker.stats();
+    for (auto& [key, record] : method_body_lookup_) {
+        record.body = linker.body_of(record.chunk.get());
+        record.chunk.reset();
+    }
+
+    reserve_type_definitions();
     populate_metadata_tables(specialized_program);
+
+    tree_shake_stats_ = TreeShakeStats{};
+    if (tree_shaking_) {
+        TreeShaker shaker(collect_tree_shake_roots(specialized_program));
+        shaker.run(chunk_);
+        tree_shake_stats_ = shaker.stats();
+    }
     return chunk_;
 }
 
@@ -210,6 +277,30 @@ void Compiler::visit(ClassDeclStmt* stmt) {
     if (has_superclass && stmt->superclass_name.value() == stmt->name) {
         throw CompilerError("Class cannot inherit from itself", stmt->line);
     }
+    if (has_superclass) {
+        // Final and private members are bound statically, so nothing below may replace them
+        Compiler* root = this;
+        while (root->enclosing_) root = root->enclosing_;
+        const ClassHierarchy& hierarchy = root->class_hierarchy_;
+        if (hierarchy.is_final_class(stmt->superclass_name.value())) {
+            throw CompilerError("Cannot inherit from final class '" + stmt->superclass_name.value() + "'", stmt->line);
+        }
+        auto check_replaceable = [&](const std::string& name, uint32_t line) {
+            const FuncDeclStmt* inherited = hierarchy.inherited_method(*stmt, name);
+            if (inherited && (inherited->is_final || inherited->access_level == AccessLevel::Private)) {
+                throw CompilerError(std::string("Cannot override ") + (inherited->is_final ? "final" : "private") +
+                                    " method '" + name + "'", line);
+            }
+        };
+        for (const auto& method : stmt->methods) {
+            if (!method->is_static) {
+                check_replaceable(method->name, method->line);
+            }
+        }
+        for (const auto& property : stmt->properties) {
+            check_replaceable(property->name, property->line);
+        }
+    }
 
     if (has_superclass) {
         emit_variable_get(stmt->superclass_name.value(), stmt->line);
@@ -259,6 +350,7 @@ void Compiler::visit(ClassDeclStmt* stmt) {
             getter_compiler.current_class_properties_ = &property_lookup;
             getter_compiler.allow_implicit_self_property_ = true;
             getter_compiler.emit_debug_info_ = emit_debug_info_;
+            getter_compiler.program_ids_ = program_ids_;
             getter_compiler.current_source_file_ = current_source_file_;
 
             // Add 'self' as local
@@ -287,7 +379,7 @@ void Compiler::visit(ClassDeclStmt* stmt) {
             }
 
             getter_proto.chunk = finalize_function_chunk(std::move(getter_compiler.chunk_));
-            record_method_body(stmt->name, getter_proto.name, property->is_static, {}, *getter_proto.chunk);
+            record_method_body(stmt->name, getter_proto.name, property->is_static, {}, getter_proto.chunk);
             size_t getter_idx = chunk_.add_function(std::move(getter_proto));
             
             // Compile setter (if present)
@@ -311,6 +403,7 @@ void Compiler::visit(ClassDeclStmt* stmt) {
                 setter_compiler.current_class_properties_ = &property_lookup;
                 setter_compiler.allow_implicit_self_property_ = true;
                 setter_compiler.emit_debug_info_ = emit_debug_info_;
+                setter_compiler.program_ids_ = program_ids_;
                 setter_compiler.current_source_file_ = current_source_file_;
 
                 // Add 'self' and 'newValue' as locals
@@ -346,7 +439,7 @@ void Compiler::visit(ClassDeclStmt* stmt) {
                                    setter_proto.name,
                                    property->is_static,
                                    build_accessor_param_types(property->type_annotation),
-                                   *setter_proto.chunk);
+                                   setter_proto.chunk);
                 setter_idx = chunk_.add_function(std::move(setter_proto));
             }
             
@@ -358,7 +451,7 @@ void Compiler::visit(ClassDeclStmt* stmt) {
         } else if (property->will_set_body || property->did_set_body) {
             // Stored property with observers
             if (property->initializer) {
-                compile_expr(property->initializer.get());
+                compile_expr_as(property->initializer.get(), annotated_type_name(property->type_annotation));
             } else {
                 emit_op(OpCode::OP_NIL, property->line);
             }
@@ -388,6 +481,7 @@ void Compiler::visit(ClassDeclStmt* stmt) {
                 will_set_compiler.current_class_properties_ = &property_lookup;
                 will_set_compiler.allow_implicit_self_property_ = true;
                 will_set_compiler.emit_debug_info_ = emit_debug_info_;
+                will_set_compiler.program_ids_ = program_ids_;
                 will_set_compiler.current_source_file_ = current_source_file_;
 
                 // Add 'self' and 'newValue' as locals
@@ -440,6 +534,7 @@ void Compiler::visit(ClassDeclStmt* stmt) {
                 did_set_compiler.current_class_properties_ = &property_lookup;
                 did_set_compiler.allow_implicit_self_property_ = true;
                 did_set_compiler.emit_debug_info_ = emit_debug_info_;
+                did_set_compiler.program_ids_ = program_ids_;
                 did_set_compiler.current_source_file_ = current_source_file_;
 
                 // Add 'self' and 'oldValue' as locals
@@ -482,7 +577,7 @@ void Compiler::visit(ClassDeclStmt* stmt) {
         } else {
             // Stored property
             if (property->initializer) {
-                compile_expr(property->initializer.get());
+                compile_expr_as(property->initializer.get(), annotated_type_name(property->type_annotation));
             } else {
                 emit_op(OpCode::OP_NIL, property->line);
             }
@@ -564,7 +659,9 @@ void Compiler::visit(ClassDeclStmt* stmt) {
         proto.is_override = method->is_override;
 
         Compiler method_compiler;
+        method_compiler.return_type_name_ = annotated_type_name(method->return_type);
         method_compiler.enclosing_ = this;
+        method_compiler.in_initializer_ = proto.is_initializer;
         method_compiler.chunk_ = Assembly{};
         method_compiler.locals_.clear();
         method_compiler.scope_depth_ = 1;
@@ -572,6 +669,7 @@ void Compiler::visit(ClassDeclStmt* stmt) {
         method_compiler.current_class_properties_ = &property_lookup;
         method_compiler.current_class_has_super_ = has_superclass;
         method_compiler.emit_debug_info_ = emit_debug_info_;
+        method_compiler.program_ids_ = program_ids_;
         method_compiler.current_source_file_ = current_source_file_;
 
         // Static methods don't have 'self' access
@@ -579,6 +677,7 @@ void Compiler::visit(ClassDeclStmt* stmt) {
             method_compiler.allow_implicit_self_property_ = true;
             method_compiler.declare_local("self", false);
             method_compiler.mark_local_initialized();
+            method_compiler.locals_.back().type_name = stmt->name;
         } else {
             method_compiler.allow_implicit_self_property_ = false;
         }
@@ -610,18 +709,31 @@ void Compiler::visit(ClassDeclStmt* stmt) {
         }
 
         proto.chunk = finalize_function_chunk(std::move(method_compiler.chunk_));
-        record_method_body(stmt->name, proto.name, method->is_static, extract_param_types(method->params), *proto.chunk);
+        record_method_body(stmt->name, proto.name, method->is_static, extract_param_types(method->params), proto.chunk);
         proto.upvalues.reserve(method_compiler.upvalues_.size());
         for (const auto& uv : method_compiler.upvalues_) {
             proto.upvalues.push_back({uv.index, uv.is_local});
         }
 
-        size_t function_index = chunk_.add_function(std::move(proto));
+        bool has_captures = !method_compiler.upvalues_.empty();
+
+        // Fill the slot reserved for devirtualized call sites
+        size_t function_index = SIZE_MAX;
+        if (scope_depth_ == 0 && !enclosing_ && !has_captures && !method->is_static) {
+            auto slot = method_call_slots_.find(stmt->name + "." + method->name);
+            if (slot != method_call_slots_.end() && slot->second != SIZE_MAX &&
+                !chunk_.function_prototypes[slot->second].chunk) {
+                function_index = slot->second;
+                chunk_.function_prototypes[function_index] = std::move(proto);
+            }
+        }
+        if (function_index == SIZE_MAX) {
+            function_index = chunk_.add_function(std::move(proto));
+        }
         if (function_index > std::numeric_limits<uint16_t>::max()) {
             throw CompilerError("Too many functions in chunk", method->line);
         }
 
-        bool has_captures = !method_compiler.upvalues_.empty();
         emit_op(has_captures ? OpCode::OP_CLOSURE : OpCode::OP_FUNCTION, method->line);
         emit_short(static_cast<uint16_t>(function_index), method->line);
 
@@ -651,6 +763,7 @@ void Compiler::visit(ClassDeclStmt* stmt) {
         deinit_compiler.allow_implicit_self_property_ = true;
         deinit_compiler.current_class_has_super_ = has_superclass;
         deinit_compiler.emit_debug_info_ = emit_debug_info_;
+        deinit_compiler.program_ids_ = program_ids_;
         deinit_compiler.current_source_file_ = current_source_file_;
 
         // Implicit self
@@ -677,7 +790,7 @@ void Compiler::visit(ClassDeclStmt* stmt) {
         }
 
         proto.chunk = finalize_function_chunk(std::move(deinit_compiler.chunk_));
-        record_method_body(stmt->name, proto.name, false, {}, *proto.chunk);
+        record_method_body(stmt->name, proto.name, false, {}, proto.chunk);
         proto.upvalues.reserve(deinit_compiler.upvalues_.size());
         for (const auto& uv : deinit_compiler.upvalues_) {
             proto.upvalues.push_back({uv.index, uv.is_local});
@@ -750,7 +863,7 @@ if (scope_depth_ > 0) {
         if (property->will_set_body || property->did_set_body) {
             // Stored property with observers
             if (property->initializer) {
-                compile_expr(property->initializer.get());
+                compile_expr_as(property->initializer.get(), annotated_type_name(property->type_annotation));
             } else {
                 emit_op(OpCode::OP_NIL, property->line);
             }
@@ -780,6 +893,7 @@ if (scope_depth_ > 0) {
                 will_set_compiler.current_class_properties_ = &property_lookup;
                 will_set_compiler.allow_implicit_self_property_ = true;
                 will_set_compiler.emit_debug_info_ = emit_debug_info_;
+                will_set_compiler.program_ids_ = program_ids_;
                 will_set_compiler.current_source_file_ = current_source_file_;
 
                 // Add 'self' and 'newValue' as locals
@@ -832,6 +946,7 @@ if (scope_depth_ > 0) {
                 did_set_compiler.current_class_properties_ = &property_lookup;
                 did_set_compiler.allow_implicit_self_property_ = true;
                 did_set_compiler.emit_debug_info_ = emit_debug_info_;
+                did_set_compiler.program_ids_ = program_ids_;
                 did_set_compiler.current_source_file_ = current_source_file_;
 
                 // Add 'self' and 'oldValue' as locals
@@ -874,7 +989,7 @@ if (scope_depth_ > 0) {
         } else {
             // Regular stored property without observers
             if (property->initializer) {
-                compile_expr(property->initializer.get());
+                compile_expr_as(property->initializer.get(), annotated_type_name(property->type_annotation));
             } else {
                 emit_op(OpCode::OP_NIL, property->line);
             }
@@ -923,7 +1038,7 @@ if (scope_depth_ > 0) {
         
         // Compile initializer
         if (property->initializer) {
-            compile_expr(property->initializer.get());
+            compile_expr_as(property->initializer.get(), annotated_type_name(property->type_annotation));
         } else {
             emit_op(OpCode::OP_NIL, property->line);
         }
@@ -963,12 +1078,14 @@ if (scope_depth_ > 0) {
             proto.is_override = false;
 
             Compiler method_compiler;
+            method_compiler.return_type_name_ = annotated_type_name(method->return_type);
             method_compiler.enclosing_ = this;
             method_compiler.chunk_ = Assembly{};
             method_compiler.locals_.clear();
             method_compiler.scope_depth_ = 1;
             method_compiler.recursion_depth_ = 0;
             method_compiler.emit_debug_info_ = emit_debug_info_;
+            method_compiler.program_ids_ = program_ids_;
             method_compiler.current_source_file_ = current_source_file_;
 
             // No 'self' for static methods
@@ -999,7 +1116,7 @@ if (scope_depth_ > 0) {
             }
 
             proto.chunk = finalize_function_chunk(std::move(method_compiler.chunk_));
-            record_method_body(stmt->name, proto.name, true, extract_param_types(method->params), *proto.chunk);
+            record_method_body(stmt->name, proto.name, true, extract_param_types(method->params), proto.chunk);
             proto.upvalues.reserve(method_compiler.upvalues_.size());
             for (const auto& uv : method_compiler.upvalues_) {
                 proto.upvalues.push_back({uv.index, uv.is_local});
@@ -1043,6 +1160,7 @@ if (scope_depth_ > 0) {
         proto.is_override = false;
 
         Compiler method_compiler;
+        method_compiler.return_type_name_ = annotated_type_name(method->return_type);
         method_compiler.enclosing_ = this;
         method_compiler.chunk_ = Assembly{};
         method_compiler.locals_.clear();
@@ -1053,6 +1171,7 @@ if (scope_depth_ > 0) {
         method_compiler.in_struct_method_ = true;
         method_compiler.in_mutating_method_ = method->is_mutating;
         method_compiler.emit_debug_info_ = emit_debug_info_;
+        method_compiler.program_ids_ = program_ids_;
         method_compiler.current_source_file_ = current_source_file_;
 
         // Implicit self
@@ -1086,7 +1205,7 @@ if (scope_depth_ > 0) {
         }
 
         proto.chunk = finalize_function_chunk(std::move(method_compiler.chunk_));
-        record_method_body(stmt->name, proto.name, false, extract_param_types(method->params), *proto.chunk);
+        record_method_body(stmt->name, proto.name, false, extract_param_types(method->params), proto.chunk);
         proto.upvalues.reserve(method_compiler.upvalues_.size());
         for (const auto& uv : method_compiler.upvalues_) {
             proto.upvalues.push_back({uv.index, uv.is_local});
@@ -1132,6 +1251,7 @@ if (scope_depth_ > 0) {
 
         Compiler init_compiler;
         init_compiler.enclosing_ = this;
+        init_compiler.in_initializer_ = true;
         init_compiler.chunk_ = Assembly{};
         init_compiler.locals_.clear();
         init_compiler.scope_depth_ = 1;
@@ -1141,6 +1261,7 @@ if (scope_depth_ > 0) {
         init_compiler.in_struct_method_ = true;
         init_compiler.in_mutating_method_ = true;  // init can always modify self
         init_compiler.emit_debug_info_ = emit_debug_info_;
+        init_compiler.program_ids_ = program_ids_;
         init_compiler.current_source_file_ = current_source_file_;
 
         // Implicit self
@@ -1174,7 +1295,7 @@ if (scope_depth_ > 0) {
         }
 
         proto.chunk = finalize_function_chunk(std::move(init_compiler.chunk_));
-        record_method_body(stmt->name, proto.name, false, extract_param_types(init_method->params), *proto.chunk);
+        record_method_body(stmt->name, proto.name, false, extract_param_types(init_method->params), proto.chunk);
         proto.upvalues.reserve(init_compiler.upvalues_.size());
         for (const auto& uv : init_compiler.upvalues_) {
             proto.upvalues.push_back({uv.index, uv.is_local});
@@ -1242,6 +1363,7 @@ void Compiler::visit(EnumDeclStmt* stmt) {
         // Define the enum case
         emit_op(OpCode::OP_ENUM_CASE, stmt->line);
         emit_short(static_cast<uint16_t>(case_name_idx), stmt->line);
+        emit_short(enum_case_id(case_decl.name, stmt->line), stmt->line);
         
         // For associated values (if any), store their count
         emit_byte(static_cast<uint8_t>(case_decl.associated_values.size()), stmt->line);
@@ -1287,6 +1409,7 @@ void Compiler::visit(EnumDeclStmt* stmt) {
         getter_compiler.current_class_properties_ = &property_lookup;
         getter_compiler.allow_implicit_self_property_ = true;
         getter_compiler.emit_debug_info_ = emit_debug_info_;
+        getter_compiler.program_ids_ = program_ids_;
         getter_compiler.current_source_file_ = current_source_file_;
 
         // Add 'self' as local
@@ -1317,7 +1440,7 @@ void Compiler::visit(EnumDeclStmt* stmt) {
         }
 
         getter_proto.chunk = finalize_function_chunk(std::move(getter_compiler.chunk_));
-        record_method_body(stmt->name, getter_proto.name, method->is_static, {}, *getter_proto.chunk);
+        record_method_body(stmt->name, getter_proto.name, method->is_static, {}, getter_proto.chunk);
         getter_proto.upvalues.reserve(getter_compiler.upvalues_.size());
         for (const auto& uv : getter_compiler.upvalues_) {
             getter_proto.upvalues.push_back({uv.index, uv.is_local});
@@ -1357,6 +1480,7 @@ void Compiler::visit(EnumDeclStmt* stmt) {
         proto.is_override = false;
 
         Compiler method_compiler;
+        method_compiler.return_type_name_ = annotated_type_name(method->return_type);
         method_compiler.enclosing_ = this;
         method_compiler.chunk_ = Assembly{};
         method_compiler.locals_.clear();
@@ -1365,6 +1489,7 @@ void Compiler::visit(EnumDeclStmt* stmt) {
         method_compiler.current_class_properties_ = &property_lookup;
         method_compiler.allow_implicit_self_property_ = true;
         method_compiler.emit_debug_info_ = emit_debug_info_;
+        method_compiler.program_ids_ = program_ids_;
         method_compiler.current_source_file_ = current_source_file_;
 
         // Implicit self
@@ -1398,7 +1523,7 @@ void Compiler::visit(EnumDeclStmt* stmt) {
         }
 
         proto.chunk = finalize_function_chunk(std::move(method_compiler.chunk_));
-        record_method_body(stmt->name, proto.name, method->is_static, extract_param_types(method->params), *proto.chunk);
+        record_method_body(stmt->name, proto.name, method->is_static, extract_param_types(method->params), proto.chunk);
         proto.upvalues.reserve(method_compiler.upvalues_.size());
         for (const auto& uv : method_compiler.upvalues_) {
             proto.upvalues.push_back({uv.index, uv.is_local});
@@ -1516,6 +1641,23 @@ void Compiler::compile_expr(Expr* expr) {
     }
 }
 
+void Compiler::compile_expr_as(Expr* expr, const std::string& expected_type) {
+    if (expected_type != "Set" || expr->kind != ExprKind::ArrayLiteral) {
+        compile_expr(expr);
+        return;
+    }
+    // let s: Set = [1, 2, 3] -> set literal
+    auto* literal = static_cast<ArrayLiteralExpr*>(expr);
+    if (literal->elements.size() > std::numeric_limits<uint16_t>::max()) {
+        throw CompilerError("Too many elements in set literal", expr->line);
+    }
+    for (const auto& elem : literal->elements) {
+        compile_expr(elem.get());
+    }
+    emit_op(OpCode::OP_SET_LITERAL, expr->line);
+    emit_short(static_cast<uint16_t>(literal->elements.size()), expr->line);
+}
+
 
 void Compiler::visit(VarDeclStmt* stmt) {
     if (scope_depth_ > 0) {
@@ -1523,59 +1665,88 @@ void Compiler::visit(VarDeclStmt* stmt) {
     }
 
     if (stmt->initializer) {
-        compile_expr(stmt->initializer.get());
+        compile_expr_as(stmt->initializer.get(), annotated_type_name(stmt->type_annotation));
     } else {
         emit_op(OpCode::OP_NIL, stmt->line);
     }
     emit_op(OpCode::OP_COPY_VALUE, stmt->line);
 
+    // Record type info for generic inference and builtin fast paths
+    std::string type_name;
+    if (stmt->type_annotation.has_value() && !stmt->type_annotation->name.empty()) {
+        type_name = stmt->type_annotation->name;
+    } else if (stmt->initializer) {
+        // Infer type from initializer expression
+        if (stmt->initializer->kind == ExprKind::Literal) {
+            auto* lit = static_cast<const LiteralExpr*>(stmt->initializer.get());
+            if (lit->string_value.has_value()) type_name = "String";
+            else if (lit->value.is_int()) type_name = "Int";
+            else if (lit->value.is_float()) type_name = "Float";
+            else if (lit->value.is_bool()) type_name = "Bool";
+        } else if (stmt->initializer->kind == ExprKind::Range) {
+            type_name = "Range";
+        } else if (stmt->initializer->kind == ExprKind::Call) {
+            // Infer from function call return type
+            auto* call = static_cast<const CallExpr*>(stmt->initializer.get());
+            if (call->callee->kind == ExprKind::Identifier) {
+                auto* cid = static_cast<const IdentifierExpr*>(call->callee.get());
+                const FuncDeclStmt* ft = find_generic_function_template(cid->name);
+                if (ft && ft->return_type.has_value() && !cid->generic_args.empty()) {
+                    const std::string& rt = ft->return_type->name;
+                    for (size_t gi = 0; gi < ft->generic_params.size(); ++gi) {
+                        if (ft->generic_params[gi] == rt && gi < cid->generic_args.size()) {
+                            type_name = cid->generic_args[gi].name;
+                            break;
+                        }
+                    }
+                } else if (!ft) {
+                    // Not a generic template — could be a class constructor call
+                    // e.g., Vector3(1.0, 0.0, 0.0) → type is "Vector3"
+                    // Check if first char is uppercase (convention for class/struct names)
+                    if (!cid->name.empty() && std::isupper(cid->name[0])) {
+                        type_name = cid->name;
+                    }
+                }
+            }
+        }
+    }
+
     if (scope_depth_ == 0) {
         size_t name_idx = identifier_constant(stmt->name);
         if (name_idx > std::numeric_limits<uint16_t>::max()) {
-            throw CompilerError("Too many global variables", stmt->line);
+            throw CompilerError("Too many identifiers", stmt->line);
         }
         emit_op(OpCode::OP_SET_GLOBAL, stmt->line);
         emit_short(static_cast<uint16_t>(name_idx), stmt->line);
         emit_op(OpCode::OP_POP, stmt->line);
+        global_type_names_[stmt->name] = type_name;
     } else {
         mark_local_initialized();
-        // Record type info for generic inference
-        if (stmt->type_annotation.has_value() && !stmt->type_annotation->name.empty()) {
-            locals_.back().type_name = stmt->type_annotation->name;
-        } else if (stmt->initializer) {
-            // Infer type from initializer expression
-            if (stmt->initializer->kind == ExprKind::Literal) {
-                auto* lit = static_cast<const LiteralExpr*>(stmt->initializer.get());
-                if (lit->string_value.has_value()) locals_.back().type_name = "String";
-                else if (lit->value.is_int()) locals_.back().type_name = "Int";
-                else if (lit->value.is_float()) locals_.back().type_name = "Float";
-                else if (lit->value.is_bool()) locals_.back().type_name = "Bool";
-            } else if (stmt->initializer->kind == ExprKind::Call) {
-                // Infer from function call return type
-                auto* call = static_cast<const CallExpr*>(stmt->initializer.get());
-                if (call->callee->kind == ExprKind::Identifier) {
-                    auto* cid = static_cast<const IdentifierExpr*>(call->callee.get());
-                    const FuncDeclStmt* ft = find_generic_function_template(cid->name);
-                    if (ft && ft->return_type.has_value() && !cid->generic_args.empty()) {
-                        const std::string& rt = ft->return_type->name;
-                        for (size_t gi = 0; gi < ft->generic_params.size(); ++gi) {
-                            if (ft->generic_params[gi] == rt && gi < cid->generic_args.size()) {
-                                locals_.back().type_name = cid->generic_args[gi].name;
-                                break;
-                            }
-                        }
-                    } else if (!ft) {
-                        // Not a generic template — could be a class constructor call
-                        // e.g., Vector3(1.0, 0.0, 0.0) → type is "Vector3"
-                        // Check if first char is uppercase (convention for class/struct names)
-                        if (!cid->name.empty() && std::isupper(cid->name[0])) {
-                            locals_.back().type_name = cid->name;
-                        }
-                    }
-                }
+        locals_.back().type_name = type_name;
+    }
+}
+
+std::string Compiler::known_variable_type(const Expr* expr) const {
+    if (!expr || expr->kind != ExprKind::Identifier) {
+        return {};
+    }
+    return known_variable_type(static_cast<const IdentifierExpr*>(expr)->name);
+}
+
+std::string Compiler::known_variable_type(const std::string& name) const {
+    const Compiler* c = this;
+    for (; c; c = c->enclosing_) {
+        for (auto it = c->locals_.rbegin(); it != c->locals_.rend(); ++it) {
+            if (it->name == name) {
+                return it->type_name;
             }
         }
+        if (!c->enclosing_) {
+            break;
+        }
     }
+    auto it = c->global_type_names_.find(name);
+    return it != c->global_type_names_.end() ? it->second : std::string{};
 }
 
 void Compiler::visit(TupleDestructuringStmt* stmt) {
@@ -1621,7 +1792,7 @@ void Compiler::visit(TupleDestructuringStmt* stmt) {
         } else {
             size_t name_idx = identifier_constant(binding.name);
             if (name_idx > std::numeric_limits<uint16_t>::max()) {
-                throw CompilerError("Too many global variables", stmt->line);
+                throw CompilerError("Too many identifiers", stmt->line);
             }
             emit_op(OpCode::OP_SET_GLOBAL, stmt->line);
             emit_short(static_cast<uint16_t>(name_idx), stmt->line);
@@ -1687,7 +1858,7 @@ void Compiler::visit(GuardLetStmt* stmt) {
     if (scope_depth_ == 0) {
         size_t name_idx = identifier_constant(stmt->binding_name);
         if (name_idx > std::numeric_limits<uint16_t>::max()) {
-            throw CompilerError("Too many global variables", stmt->line);
+            throw CompilerError("Too many identifiers", stmt->line);
         }
         emit_op(OpCode::OP_SET_GLOBAL, stmt->line);
         emit_short(static_cast<uint16_t>(name_idx), stmt->line);
@@ -1778,42 +1949,36 @@ void Compiler::visit(RepeatWhileStmt* stmt) {
 void Compiler::visit(ForInStmt* stmt) {
     // Check if iterable is a Range expression
     if (stmt->iterable->kind == ExprKind::Range) {
-        // Range for-in loop: for i in 1...5 { }
-        compile_expr(stmt->iterable.get());  // Push start, end
-        
+        // Literal range for-in loop: for i in 1...5 { }
+        // Bounds stay on the stack as locals; no Range object is created.
         RangeExpr* range = static_cast<RangeExpr*>(stmt->iterable.get());
+        compile_expr(range->start.get());
+        compile_expr(range->end.get());
         
         begin_scope();
         
-        // Stack: [start, end]
-        // Loop variable (slot 0 = start)
-        declare_local(stmt->variable, false);
+        // Stack: [next, end, i] (see OP_FOR_RANGE_NEXT)
+        declare_local("$next", false);
         mark_local_initialized();
-        
-        // End value (slot 1 = end)
         declare_local("$end", false);
         mark_local_initialized();
+        declare_local(stmt->variable, false);
+        emit_op(OpCode::OP_NIL, stmt->line);
+        mark_local_initialized();
         
         loop_stack_.push_back({});
         size_t loop_start = chunk_.code_size();
         loop_stack_.back().loop_start = loop_start;
         loop_stack_.back().scope_depth_at_start = scope_depth_;
         
-        // Condition: i < end (exclusive) or i <= end (inclusive)
-        int loop_var_idx = resolve_local(stmt->variable);
-        int end_var_idx = resolve_local("$end");
-        
-        emit_op(OpCode::OP_GET_LOCAL, stmt->line);
-        emit_short(static_cast<uint16_t>(loop_var_idx), stmt->line);
-        
-        emit_op(OpCode::OP_GET_LOCAL, stmt->line);
-        emit_short(static_cast<uint16_t>(end_var_idx), stmt->line);
-        
-        
-        emit_op(range->inclusive ? OpCode::OP_LESS_EQUAL : OpCode::OP_LESS, stmt->line);
-        
-        size_t exit_jump = emit_jump(OpCode::OP_JUMP_IF_FALSE, stmt->line);
-        emit_op(OpCode::OP_POP, stmt->line);
+        // Store the counter in i and advance it, or leave the loop
+        int next_idx = resolve_local("$next");
+        emit_op(OpCode::OP_FOR_RANGE_NEXT, stmt->line);
+        emit_short(static_cast<uint16_t>(next_idx), stmt->line);
+        emit_byte(range->inclusive ? 1 : 0, stmt->line);
+        emit_byte(0xff, stmt->line);
+        emit_byte(0xff, stmt->line);
+        size_t exit_jump = chunk_.code_size() - 2;
         
         // where clause filtering
         size_t where_skip_jump = 0;
@@ -1840,21 +2005,10 @@ void Compiler::visit(ForInStmt* stmt) {
             patch_jump(jump);
         }
 
-        // Increment i
-        emit_op(OpCode::OP_GET_LOCAL, stmt->line);
-        emit_short(static_cast<uint16_t>(loop_var_idx), stmt->line);
-        emit_constant(Value::from_int(1), stmt->line);
-        emit_op(OpCode::OP_ADD, stmt->line);
-        emit_op(OpCode::OP_SET_LOCAL, stmt->line);
-        emit_short(static_cast<uint16_t>(loop_var_idx), stmt->line);
-        emit_op(OpCode::OP_POP, stmt->line);
-        
         emit_loop(loop_start, stmt->line);
         
+        // Exhaustion and break land here; end_scope() pops the loop locals
         patch_jump(exit_jump);
-        emit_op(OpCode::OP_POP, stmt->line);
-        
-        // Patch break jumps
         for (size_t jump : loop_stack_.back().break_jumps) {
             patch_jump(jump);
         }
@@ -1862,72 +2016,39 @@ void Compiler::visit(ForInStmt* stmt) {
         loop_stack_.pop_back();
         end_scope();
     } else {
-        // Array for-in loop: for item in array { }
-        // Evaluate iterable (push to stack)
+        // Sequence for-in loop: arrays, sets, dictionaries, strings, Range
+        // values and script types providing makeIterator()/next()
         compile_expr(stmt->iterable.get());
-        
+        emit_op(OpCode::OP_ITER_INIT, stmt->line);
+
         begin_scope();
-        
-        // Store array in local variable
-        declare_local("$array", false);
+
+        // Iterator, cursor and loop variable occupy adjacent slots (see OP_FOR_ARRAY_NEXT)
+        declare_local("$iter", false);
         mark_local_initialized();
-        
-        // Initialize index to 0
         emit_constant(Value::from_int(0), stmt->line);
-        declare_local("$index", false);
+        declare_local("$cursor", false);
         mark_local_initialized();
-        
-        // Declare loop variable
+
         declare_local(stmt->variable, false);
         emit_op(OpCode::OP_NIL, stmt->line);
         mark_local_initialized();
-        
+
         loop_stack_.push_back({});
-    size_t loop_start = chunk_.code_size();
+        size_t loop_start = chunk_.code_size();
         loop_stack_.back().loop_start = loop_start;
         loop_stack_.back().scope_depth_at_start = scope_depth_;
-        
-        int array_idx = resolve_local("$array");
-        int index_idx = resolve_local("$index");
-        int loop_var_idx = resolve_local(stmt->variable);
-        
-        // Condition: index < array.count
-        // Load array
-        emit_op(OpCode::OP_GET_LOCAL, stmt->line);
-        emit_short(static_cast<uint16_t>(array_idx), stmt->line);
-        
-        // Get array.count
-        size_t count_name_idx = identifier_constant("count");
-        emit_op(OpCode::OP_GET_PROPERTY, stmt->line);
-        emit_short(static_cast<uint16_t>(count_name_idx), stmt->line);
-        
-        // Load index
-        emit_op(OpCode::OP_GET_LOCAL, stmt->line);
-        emit_short(static_cast<uint16_t>(index_idx), stmt->line);
-        
-        // count > index
-        emit_op(OpCode::OP_GREATER, stmt->line);
-        
-        size_t exit_jump = emit_jump(OpCode::OP_JUMP_IF_FALSE, stmt->line);
-        emit_op(OpCode::OP_POP, stmt->line);
-        
-        // Assign loop_var = array[index]
-        // Load array
-        emit_op(OpCode::OP_GET_LOCAL, stmt->line);
-        emit_short(static_cast<uint16_t>(array_idx), stmt->line);
-        
-        // Load index
-        emit_op(OpCode::OP_GET_LOCAL, stmt->line);
-        emit_short(static_cast<uint16_t>(index_idx), stmt->line);
-        
-        // array[index]
-        emit_op(OpCode::OP_GET_SUBSCRIPT, stmt->line);
-        
-        // Store in loop variable
-        emit_op(OpCode::OP_SET_LOCAL, stmt->line);
-        emit_short(static_cast<uint16_t>(loop_var_idx), stmt->line);
-        emit_op(OpCode::OP_POP, stmt->line);
-        
+
+        int iter_idx = resolve_local("$iter");
+
+        // Store the next element in the loop variable, or jump to exit when
+        // the sequence is exhausted
+        emit_op(OpCode::OP_FOR_ARRAY_NEXT, stmt->line);
+        emit_short(static_cast<uint16_t>(iter_idx), stmt->line);
+        emit_byte(0xff, stmt->line);
+        emit_byte(0xff, stmt->line);
+        size_t exit_jump = chunk_.code_size() - 2;
+
         // where clause filtering
         size_t where_skip_jump = 0;
         if (stmt->where_condition) {
@@ -1935,7 +2056,7 @@ void Compiler::visit(ForInStmt* stmt) {
             where_skip_jump = emit_jump(OpCode::OP_JUMP_IF_FALSE, stmt->line);
             emit_op(OpCode::OP_POP, stmt->line);
         }
-        
+
         // Execute loop body
         compile_stmt(stmt->body.get());
 
@@ -1953,25 +2074,14 @@ void Compiler::visit(ForInStmt* stmt) {
             patch_jump(jump);
         }
 
-        // Increment index
-        emit_op(OpCode::OP_GET_LOCAL, stmt->line);
-        emit_short(static_cast<uint16_t>(index_idx), stmt->line);
-        emit_constant(Value::from_int(1), stmt->line);
-        emit_op(OpCode::OP_ADD, stmt->line);
-        emit_op(OpCode::OP_SET_LOCAL, stmt->line);
-        emit_short(static_cast<uint16_t>(index_idx), stmt->line);
-        emit_op(OpCode::OP_POP, stmt->line);
-        
         emit_loop(loop_start, stmt->line);
-        
+
+        // Exhaustion and break land here; end_scope() pops the loop locals
         patch_jump(exit_jump);
-        emit_op(OpCode::OP_POP, stmt->line);
-        
-        // Patch break jumps
         for (size_t jump : loop_stack_.back().break_jumps) {
             patch_jump(jump);
         }
-        
+
         loop_stack_.pop_back();
         end_scope();
     }
@@ -2022,6 +2132,10 @@ void Compiler::visit(SwitchStmt* stmt) {
     mark_local_initialized();
     
     int switch_var = resolve_local("$switch");
+    if (compile_switch_table(stmt, switch_var)) {
+        end_scope();  // Pops $switch value
+        return;
+    }
     std::vector<size_t> end_jumps;
     
     // Compile each case
@@ -2055,12 +2169,8 @@ void Compiler::visit(SwitchStmt* stmt) {
                     binding_pattern = enum_pattern;
                 }
 
-                size_t case_name_idx = identifier_constant(enum_pattern->case_name);
-                if (case_name_idx > std::numeric_limits<uint16_t>::max()) {
-                    throw CompilerError("Too many enum case identifiers", stmt->line);
-                }
                 emit_op(OpCode::OP_MATCH_ENUM_CASE, stmt->line);
-                emit_short(static_cast<uint16_t>(case_name_idx), stmt->line);
+                emit_short(enum_case_id(enum_pattern->case_name, stmt->line), stmt->line);
             } else {
                 auto* expr_pattern = static_cast<ExpressionPattern*>(pattern.get());
                 // Check if pattern is a range
@@ -2112,33 +2222,7 @@ void Compiler::visit(SwitchStmt* stmt) {
             patch_jump(jump);
         }
 
-        bool has_binding_scope = false;
-        if (binding_pattern && !binding_pattern->bindings.empty()) {
-            if (case_clause.patterns.size() > 1) {
-                throw CompilerError("Enum case bindings require a single pattern per case.", stmt->line);
-            }
-            begin_scope();
-            has_binding_scope = true;
-
-            for (size_t i = 0; i < binding_pattern->bindings.size(); ++i) {
-                const std::string& binding_name = binding_pattern->bindings[i];
-                declare_local(binding_name, false);
-                emit_op(OpCode::OP_GET_LOCAL, stmt->line);
-                emit_short(static_cast<uint16_t>(switch_var), stmt->line);
-                emit_op(OpCode::OP_GET_ASSOCIATED, stmt->line);
-                emit_short(static_cast<uint16_t>(i), stmt->line);
-                mark_local_initialized();
-            }
-        }
-        
-        // Execute case body
-        for (const auto& case_stmt : case_clause.statements) {
-            compile_stmt(case_stmt.get());
-        }
-
-        if (has_binding_scope) {
-            end_scope();
-        }
+        compile_case_body(case_clause, binding_pattern, switch_var, stmt->line);
         
         // Jump to end (no fall-through)
         size_t to_end = emit_jump(OpCode::OP_JUMP, stmt->line);
@@ -2156,6 +2240,213 @@ void Compiler::visit(SwitchStmt* stmt) {
     end_scope();  // Pops $switch value
 }
 
+void Compiler::compile_case_body(const CaseClause& clause, const EnumCasePattern* binding_pattern,
+                                 int switch_var, uint32_t line) {
+    bool has_binding_scope = false;
+    if (binding_pattern && !binding_pattern->bindings.empty()) {
+        if (clause.patterns.size() > 1) {
+            throw CompilerError("Enum case bindings require a single pattern per case.", line);
+        }
+        begin_scope();
+        has_binding_scope = true;
+
+        for (size_t i = 0; i < binding_pattern->bindings.size(); ++i) {
+            const std::string& binding_name = binding_pattern->bindings[i];
+            declare_local(binding_name, false);
+            emit_op(OpCode::OP_GET_LOCAL, line);
+            emit_short(static_cast<uint16_t>(switch_var), line);
+            emit_op(OpCode::OP_GET_ASSOCIATED, line);
+            emit_short(static_cast<uint16_t>(i), line);
+            mark_local_initialized();
+        }
+    }
+    
+    // Execute case body
+    for (const auto& case_stmt : clause.statements) {
+        compile_stmt(case_stmt.get());
+    }
+
+    if (has_binding_scope) {
+        end_scope();
+    }
+}
+
+bool Compiler::compile_switch_table(SwitchStmt* stmt, int switch_var) {
+    // Below this many keys the compare chain is as fast as a table lookup
+    constexpr size_t kMinSwitchTableKeys = 4;
+
+    struct Entry {
+        Int key{0};
+        std::string text;
+        uint32_t hash{0};
+        size_t clause{0};
+    };
+
+    std::optional<uint8_t> kind;
+    std::vector<Entry> entries;
+    std::unordered_set<Int> seen_keys;
+    std::unordered_set<std::string> seen_text;
+    std::vector<const EnumCasePattern*> binding_patterns(stmt->cases.size(), nullptr);
+    size_t clause_count = stmt->cases.size();
+
+    for (size_t c = 0; c < stmt->cases.size(); ++c) {
+        const auto& clause = stmt->cases[c];
+        if (clause.is_default) {
+            clause_count = c + 1;  // Default is always last
+            break;
+        }
+        for (const auto& pattern : clause.patterns) {
+            Entry entry;
+            entry.clause = c;
+            uint8_t pattern_kind = SWITCH_INT;
+            if (pattern->kind == PatternKind::EnumCase) {
+                auto* enum_pattern = static_cast<const EnumCasePattern*>(pattern.get());
+                if (!enum_pattern->bindings.empty()) {
+                    if (clause.patterns.size() > 1) {
+                        return false;  // The chain reports this
+                    }
+                    binding_patterns[c] = enum_pattern;
+                }
+                pattern_kind = SWITCH_ENUM;
+                entry.key = enum_case_id(enum_pattern->case_name, stmt->line);
+            } else {
+                const Expr* expr = static_cast<const ExpressionPattern*>(pattern.get())->expression.get();
+                bool negate = false;
+                if (expr->kind == ExprKind::Unary && static_cast<const UnaryExpr*>(expr)->op == TokenType::Minus) {
+                    negate = true;
+                    expr = static_cast<const UnaryExpr*>(expr)->operand.get();
+                }
+                if (!expr || expr->kind != ExprKind::Literal) {
+                    return false;  // Ranges and computed values need the chain
+                }
+                auto* literal = static_cast<const LiteralExpr*>(expr);
+                if (literal->string_value.has_value() && !negate) {
+                    pattern_kind = SWITCH_STRING;
+                    entry.text = *literal->string_value;
+                    entry.hash = switch_string_hash(entry.text);
+                } else if (!literal->string_value.has_value() && literal->value.is_int()) {
+                    entry.key = negate ? -literal->value.as_int() : literal->value.as_int();
+                } else {
+                    return false;
+                }
+            }
+
+            if (kind && *kind != pattern_kind) {
+                return false;
+            }
+            kind = pattern_kind;
+            // The first clause listing a key wins, as in the chain
+            bool first = pattern_kind == SWITCH_STRING ? seen_text.insert(entry.text).second
+                                                       : seen_keys.insert(entry.key).second;
+            if (first) {
+                entries.push_back(std::move(entry));
+            }
+        }
+    }
+    if (!kind || entries.size() < kMinSwitchTableKeys || entries.size() > std::numeric_limits<uint16_t>::max()) {
+        return false;
+    }
+
+    uint8_t mode = *kind;
+    Int low = 0;
+    size_t slot_count = entries.size();
+    if (mode == SWITCH_STRING) {
+        for (auto& entry : entries) {
+            size_t text_idx = identifier_constant(entry.text);
+            if (text_idx > std::numeric_limits<uint16_t>::max()) {
+                return false;
+            }
+            entry.key = static_cast<Int>(text_idx);
+        }
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const Entry& a, const Entry& b) { return a.hash < b.hash; });
+    } else {
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+        uint64_t span = static_cast<uint64_t>(entries.back().key) - static_cast<uint64_t>(entries.front().key) + 1;
+        // Dense when at least half the slots between the lowest and highest key are used
+        if (span <= entries.size() * 2) {
+            mode |= SWITCH_DENSE;
+            low = entries.front().key;
+            slot_count = static_cast<size_t>(span);
+        }
+    }
+
+    emit_op(OpCode::OP_GET_LOCAL, stmt->line);
+    emit_short(static_cast<uint16_t>(switch_var), stmt->line);
+    emit_op(OpCode::OP_SWITCH_TABLE, stmt->line);
+    emit_byte(mode, stmt->line);
+    emit_short(static_cast<uint16_t>(slot_count), stmt->line);
+
+    // Target operands to patch once the case bodies are laid out
+    constexpr size_t kDefaultTarget = SIZE_MAX;
+    std::vector<std::pair<size_t, size_t>> targets;  // operand offset, clause
+    targets.emplace_back(chunk_.code_size(), kDefaultTarget);
+    emit_short(0, stmt->line);
+
+    auto emit_key = [&](Int key) {
+        uint64_t bits = static_cast<uint64_t>(key);
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            emit_byte(static_cast<uint8_t>((bits >> shift) & 0xff), stmt->line);
+        }
+    };
+    if (mode & SWITCH_DENSE) {
+        emit_key(low);
+        std::vector<size_t> slots(slot_count, kDefaultTarget);
+        for (const auto& entry : entries) {
+            slots[static_cast<size_t>(static_cast<uint64_t>(entry.key) - static_cast<uint64_t>(low))] = entry.clause;
+        }
+        for (size_t clause : slots) {
+            targets.emplace_back(chunk_.code_size(), clause);
+            emit_short(0, stmt->line);
+        }
+    } else {
+        for (const auto& entry : entries) {
+            if (mode == SWITCH_STRING) {
+                emit_short(static_cast<uint16_t>(entry.hash >> 16), stmt->line);
+                emit_short(static_cast<uint16_t>(entry.hash & 0xffff), stmt->line);
+                emit_short(static_cast<uint16_t>(entry.key), stmt->line);  // String table index
+            } else {
+                emit_key(entry.key);
+            }
+            targets.emplace_back(chunk_.code_size(), entry.clause);
+            emit_short(0, stmt->line);
+        }
+    }
+    size_t table_end = chunk_.code_size();
+
+    std::vector<size_t> clause_start(clause_count, 0);
+    std::vector<size_t> end_jumps;
+    size_t default_start = 0;
+    for (size_t c = 0; c < clause_count; ++c) {
+        const auto& clause = stmt->cases[c];
+        if (clause.is_default) {
+            default_start = chunk_.code_size();
+            compile_case_body(clause, nullptr, switch_var, stmt->line);
+            break;
+        }
+        clause_start[c] = chunk_.code_size();
+        compile_case_body(clause, binding_patterns[c], switch_var, stmt->line);
+        end_jumps.push_back(emit_jump(OpCode::OP_JUMP, stmt->line));
+    }
+    if (clause_count == 0 || !stmt->cases[clause_count - 1].is_default) {
+        default_start = chunk_.code_size();  // No default: fall out of the switch
+    }
+    for (size_t jump : end_jumps) {
+        patch_jump(jump);
+    }
+
+    auto& code = chunk_.ensure_primary_body().bytecode;
+    for (const auto& [operand, clause] : targets) {
+        size_t distance = (clause == kDefaultTarget ? default_start : clause_start[clause]) - table_end;
+        if (distance > std::numeric_limits<uint16_t>::max()) {
+            throw CompilerError("Too much code to jump over", stmt->line);
+        }
+        code[operand] = static_cast<uint8_t>((distance >> 8) & 0xff);
+        code[operand + 1] = static_cast<uint8_t>(distance & 0xff);
+    }
+    return true;
+}
+
 void Compiler::visit(ImportStmt* stmt) {
     const std::string& module_key = stmt->module_path;
 
@@ -2217,6 +2508,10 @@ void Compiler::visit(ImportStmt* stmt) {
         std::unordered_set<std::string> seen_exports;
         module_exports.reserve(imported_program.size());
 
+        for (const auto& imported_stmt : imported_program) {
+            collect_call_signatures(imported_stmt.get());
+        }
+
         // Compile the imported module statements into current chunk
         for (const auto& imported_stmt : imported_program) {
             if (imported_stmt) {
@@ -2352,6 +2647,7 @@ void Compiler::visit(ExtensionDeclStmt* stmt) {
             method_compiler.enclosing_ = this;
             method_compiler.allow_implicit_self_property_ = true;
             method_compiler.emit_debug_info_ = emit_debug_info_;
+            method_compiler.program_ids_ = program_ids_;
             method_compiler.current_source_file_ = current_source_file_;
 
             // Allow access to 'self' in computed property getter
@@ -2381,7 +2677,7 @@ void Compiler::visit(ExtensionDeclStmt* stmt) {
             }
 
             getter_proto.chunk = finalize_function_chunk(std::move(method_compiler.chunk_));
-            record_method_body(stmt->extended_type, getter_proto.name, method->is_static, {}, *getter_proto.chunk);
+            record_method_body(stmt->extended_type, getter_proto.name, method->is_static, {}, getter_proto.chunk);
             size_t func_idx = chunk_.add_function(std::move(getter_proto));
             
             // Emit OP_DEFINE_COMPUTED_PROPERTY with indices
@@ -2399,10 +2695,12 @@ void Compiler::visit(ExtensionDeclStmt* stmt) {
 
             // Compile method body
             Compiler method_compiler;
+            method_compiler.return_type_name_ = annotated_type_name(method->return_type);
             method_compiler.enclosing_ = this;
             method_compiler.in_struct_method_ = method->is_mutating;
             method_compiler.in_mutating_method_ = method->is_mutating;
             method_compiler.emit_debug_info_ = emit_debug_info_;
+            method_compiler.program_ids_ = program_ids_;
             method_compiler.current_source_file_ = current_source_file_;
 
             method_compiler.begin_scope();
@@ -2450,7 +2748,7 @@ void Compiler::visit(ExtensionDeclStmt* stmt) {
             }
 
             func_proto.chunk = finalize_function_chunk(std::move(method_compiler.chunk_));
-            record_method_body(stmt->extended_type, func_proto.name, method->is_static, extract_param_types(method->params), *func_proto.chunk);
+            record_method_body(stmt->extended_type, func_proto.name, method->is_static, extract_param_types(method->params), func_proto.chunk);
             size_t func_idx = chunk_.add_function(std::move(func_proto));
 
             emit_op(OpCode::OP_FUNCTION, stmt->line);
@@ -2505,16 +2803,18 @@ void Compiler::visit(ReturnStmt* stmt) {
         emit_op(OpCode::OP_GET_PROPERTY, stmt->line);
         emit_short(static_cast<uint16_t>(name_idx), stmt->line);
         if (stmt->value) {
-            compile_expr(stmt->value.get());
+            compile_expr_as(stmt->value.get(), return_type_name_);
         } else {
             emit_op(OpCode::OP_NIL, stmt->line);
         }
         emit_op(OpCode::OP_CALL, stmt->line);
         emit_short(1, stmt->line);
     } else {
-        // Normal function return
+        // Normal function return; `return f(x)` reuses the current frame
         if (stmt->value) {
-            compile_expr(stmt->value.get());
+            tail_call_ = stmt->value->kind == ExprKind::Call && !in_initializer_ && !in_mutating_method_;
+            compile_expr_as(stmt->value.get(), return_type_name_);
+            tail_call_ = false;
         } else {
             emit_op(OpCode::OP_NIL, stmt->line);
         }
@@ -2544,12 +2844,14 @@ void Compiler::visit(FuncDeclStmt* stmt) {
     }
 
     Compiler function_compiler;
+    function_compiler.return_type_name_ = annotated_type_name(stmt->return_type);
     function_compiler.enclosing_ = this;
     function_compiler.chunk_ = Assembly{};
     function_compiler.locals_.clear();
     function_compiler.scope_depth_ = 1;
     function_compiler.recursion_depth_ = 0;
     function_compiler.emit_debug_info_ = emit_debug_info_;
+    function_compiler.program_ids_ = program_ids_;
     function_compiler.current_source_file_ = current_source_file_;
 
     for (const auto& param : stmt->params) {
@@ -2604,25 +2906,38 @@ void Compiler::visit(FuncDeclStmt* stmt) {
     }
 
     proto.chunk = finalize_function_chunk(std::move(function_compiler.chunk_));
-    record_method_body("", proto.name, false, extract_param_types(stmt->params), *proto.chunk);
+    record_method_body("", proto.name, false, extract_param_types(stmt->params), proto.chunk);
     proto.upvalues.reserve(function_compiler.upvalues_.size());
     for (const auto& uv : function_compiler.upvalues_) {
         proto.upvalues.push_back({uv.index, uv.is_local});
     }
 
-    size_t function_index = chunk_.add_function(std::move(proto));
+    bool has_captures = !function_compiler.upvalues_.empty();
+
+    // Fill the slot reserved for OP_CALL_DIRECT call sites
+    size_t function_index = SIZE_MAX;
+    if (scope_depth_ == 0 && !enclosing_ && !has_captures) {
+        auto slot = direct_call_slots_.find(stmt->name);
+        if (slot != direct_call_slots_.end() && slot->second != SIZE_MAX &&
+            !chunk_.function_prototypes[slot->second].chunk) {
+            function_index = slot->second;
+            chunk_.function_prototypes[function_index] = std::move(proto);
+        }
+    }
+    if (function_index == SIZE_MAX) {
+        function_index = chunk_.add_function(std::move(proto));
+    }
     if (function_index > std::numeric_limits<uint16_t>::max()) {
         throw CompilerError("Too many functions in chunk", stmt->line);
     }
 
-    bool has_captures = !function_compiler.upvalues_.empty();
     emit_op(has_captures ? OpCode::OP_CLOSURE : OpCode::OP_FUNCTION, stmt->line);
     emit_short(static_cast<uint16_t>(function_index), stmt->line);
 
     if (scope_depth_ == 0) {
         size_t name_idx = identifier_constant(stmt->name);
         if (name_idx > std::numeric_limits<uint16_t>::max()) {
-            throw CompilerError("Too many global variables", stmt->line);
+            throw CompilerError("Too many identifiers", stmt->line);
         }
         emit_op(OpCode::OP_SET_GLOBAL, stmt->line);
         emit_short(static_cast<uint16_t>(name_idx), stmt->line);
@@ -2693,24 +3008,40 @@ const FuncDeclStmt* Compiler::find_generic_function_template(const std::string&
     return nullptr;
 }
 
-void Compiler::try_specialize_generic_func(const std::string& name, const std::vector<TypeAnnotation>& type_args) {
-    std::string mangled = mangle_generic_name(name, type_args);
+namespace {
 
-    // Check if already specialized anywhere in the enclosing chain
-    for (const Compiler* c = this; c; c = c->enclosing_) {
-        if (c->specialized_functions_.count(mangled)) return;
+// Bytecode of a prototype's body and of every function nested in it
+size_t prototype_code_size(const FunctionPrototype& proto) {
+    if (!proto.chunk) {
+        return 0;
+    }
+    size_t size = proto.chunk->code_size();
+    for (const auto& nested : proto.chunk->function_prototypes) {
+        size += prototype_code_size(nested);
     }
+    return size;
+}
 
-    const FuncDeclStmt* tmpl = find_generic_function_template(name);
-    if (!tmpl) return;
+} // namespace
 
-    // Queue on the root compiler for deferred compilation
+void Compiler::try_specialize_generic_func(const std::string& name, const std::vector<TypeAnnotation>& type_args) {
+    // Specializations are cached on the root compiler for the whole build
     Compiler* root = this;
     while (root->enclosing_) root = root->enclosing_;
 
+    std::string mangled = mangle_generic_name(name, type_args);
+    if (root->function_specializations_.count(mangled)) {
+        ++root->specialization_stats_.cache_hits;
+        return;
+    }
+
+    const FuncDeclStmt* tmpl = find_generic_function_template(name);
+    if (!tmpl) return;
+
     try {
         StmtPtr specialized = root->create_specialized_func(tmpl, type_args);
-        root->specialized_functions_.insert(mangled);
+        root->function_specializations_[mangled] = FunctionSpecialization{tmpl, type_args, {}, {}};
+        ++root->specialization_stats_.function_specializations;
         root->pending_specializations_.push_back(std::move(specialized));
     } catch (...) {
         // Specialization failed — will be caught at call site
@@ -2723,34 +3054,105 @@ void Compiler::compile_pending_specializations() {
         std::vector<StmtPtr> batch = std::move(pending_specializations_);
         pending_specializations_.clear();
         for (auto& stmt : batch) {
-            compile_stmt(stmt.get());
+            if (!compile_specialization(stmt.get())) {
+                compile_stmt(stmt.get());
+            }
         }
     }
 }
 
-void Compiler::visit(IdentifierExpr* expr) {
-// Check if this is a generic type instantiation
-std::string actual_name = expr->name;
-if (!expr->generic_args.empty()) {
-    // Mangle the name: Box<Int> -> Box_Int
-    actual_name = mangle_generic_name(expr->name, expr->generic_args);
+std::string Compiler::specialization_body_name(const std::string& mangled) {
+    Compiler* root = this;
+    while (root->enclosing_) root = root->enclosing_;
 
-    // On-demand specialize generic function if not yet done
-    try_specialize_generic_func(expr->name, expr->generic_args);
-}
-    
-int local = resolve_local(actual_name);
-if (local != -1) {
-    emit_op(OpCode::OP_GET_LOCAL, expr->line);
-    emit_short(static_cast<uint16_t>(local), expr->line);
-    return;
+    auto it = root->function_specializations_.find(mangled);
+    if (it == root->function_specializations_.end()) {
+        return mangled;
+    }
+    FunctionSpecialization& spec = it->second;
+    if (spec.body_name.empty()) {
+        // Instances of every class are the same kind of value at runtime, so
+        // class arguments collapse into one body
+        std::vector<TypeAnnotation> body_args = spec.type_args;
+        for (size_t i = 0; i < body_args.size() && i < spec.template_decl->generic_params.size(); ++i) {
+            TypeAnnotation& arg = body_args[i];
+            if (arg.generic_args.empty() && !arg.is_function_type && root->class_hierarchy_.is_class(arg.name)) {
+                arg.name = "AnyObject";
+                spec.erased_params.insert(spec.template_decl->generic_params[i]);
+            }
+        }
+        spec.body_name = mangle_generic_name(spec.template_decl->name, body_args);
+    }
+    return spec.body_name;
 }
-    
-    
-    
-    int upvalue = resolve_upvalue(actual_name);
-    if (upvalue != -1) {
-        emit_op(OpCode::OP_GET_UPVALUE, expr->line);
+
+bool Compiler::compile_specialization(Stmt* stmt) {
+    if (stmt->kind == StmtKind::StructDecl) {
+        if (!struct_specializations_.count(static_cast<StructDeclStmt*>(stmt)->name)) {
+            return false;
+        }
+    } else if (stmt->kind == StmtKind::FuncDecl) {
+        auto* decl = static_cast<FuncDeclStmt*>(stmt);
+        auto it = function_specializations_.find(decl->name);
+        if (it == function_specializations_.end()) {
+            return false;
+        }
+        std::string body_name = specialization_body_name(decl->name);
+        if (!specialization_bodies_.insert(body_name).second) {
+            ++specialization_stats_.shared_specializations;
+            return true;
+        }
+        if (body_name != decl->name) {
+            // The body must not bind calls against any one of the classes it serves
+            const FunctionSpecialization& spec = it->second;
+            for (size_t i = 0; i < decl->params.size() && i < spec.template_decl->params.size(); ++i) {
+                if (spec.erased_params.count(spec.template_decl->params[i].type.name)) {
+                    decl->params[i].type.name = "Any";
+                }
+            }
+            if (decl->return_type.has_value() && spec.template_decl->return_type.has_value() &&
+                spec.erased_params.count(spec.template_decl->return_type->name)) {
+                decl->return_type->name = "Any";
+            }
+            decl->name = body_name;
+        }
+        ++specialization_stats_.function_bodies;
+    } else {
+        return false;
+    }
+
+    size_t first_function = chunk_.function_prototypes.size();
+    compile_stmt(stmt);
+    for (size_t i = first_function; i < chunk_.function_prototypes.size(); ++i) {
+        specialization_stats_.bytecode_bytes += prototype_code_size(chunk_.function_prototypes[i]);
+    }
+    return true;
+}
+
+void Compiler::visit(IdentifierExpr* expr) {
+// Check if this is a generic type instantiation
+std::string actual_name = expr->name;
+if (!expr->generic_args.empty()) {
+    // Mangle the name: Box<Int> -> Box_Int
+    actual_name = mangle_generic_name(expr->name, expr->generic_args);
+
+    // On-demand specialize generic function if not yet done
+    try_specialize_generic_func(expr->name, expr->generic_args);
+    actual_name = specialization_body_name(actual_name);
+}
+    
+int local = resolve_local(actual_name);
+if (local != -1) {
+    emit_op(OpCode::OP_GET_LOCAL, expr->line);
+    emit_short(static_cast<uint16_t>(local), expr->line);
+    return;
+}
+    
+    
+    
+    int upvalue = resolve_upvalue(actual_name);
+    if (upvalue != -1) {
+        emit_op(OpCode::OP_GET_UPVALUE, expr->line);
         emit_short(static_cast<uint16_t>(upvalue), expr->line);
         return;
     }
@@ -2997,7 +3399,7 @@ void Compiler::visit(AssignExpr* expr) {
             emit_short(static_cast<uint16_t>(name_idx), expr->line);
             return;
         }
-        compile_expr(expr->value.get());
+        compile_expr_as(expr->value.get(), known_variable_type(expr->name));
         emit_op(OpCode::OP_COPY_VALUE, expr->line);
     }
 
@@ -3076,6 +3478,9 @@ void Compiler::visit(SuperExpr* expr) {
 }
 
 void Compiler::visit(CallExpr* expr) {
+    const bool tail_call = tail_call_;
+    tail_call_ = false;
+
     if (expr->callee->kind == ExprKind::Identifier) {
         auto* identifier = static_cast<IdentifierExpr*>(expr->callee.get());
         if (identifier->name == "readLine" && expr->arguments.empty()) {
@@ -3241,30 +3646,73 @@ void Compiler::visit(CallExpr* expr) {
         }
     }
 
-    compile_expr(expr->callee.get());
+    // Set/Range/Array membership fast path: s.contains(x) -> OP_CONTAINS (no builtin method object)
+    if (expr->callee->kind == ExprKind::Member && expr->arguments.size() == 1 &&
+        expr->argument_names[0].empty()) {
+        auto* member = static_cast<MemberExpr*>(expr->callee.get());
+        std::string receiver_type = member->member == "contains" ? known_variable_type(member->object.get()) : std::string{};
+        if (receiver_type == "Set" || receiver_type == "Range" || receiver_type == "Array") {
+            compile_expr(member->object.get());
+            compile_expr(expr->arguments[0].get());
+            emit_op(OpCode::OP_CONTAINS, expr->line);
+            return;
+        }
+    }
 
     if (expr->arguments.size() > std::numeric_limits<uint16_t>::max()) {
         throw CompilerError("Too many arguments in function call", expr->line);
     }
 
+    if (!tail_call && expr->callee->kind == ExprKind::Member && emit_devirtualized_call(expr)) {
+        return;
+    }
+
+    // Known callee: evaluate arguments in parameter order, inline the
+    // defaults and let the VM skip label matching entirely.
+    std::vector<size_t> arg_for_param;
+    const std::vector<ParamDecl>* params = find_call_signature(expr);
+    bool bound = params && params->size() <= std::numeric_limits<uint16_t>::max() &&
+                 bind_call_arguments(expr, *params, arg_for_param);
+
+    // Top-level functions are entered by prototype index with no callee
+    // value on the stack. Tail calls keep OP_TAIL_CALL for frame reuse.
+    size_t direct_index = bound && !tail_call ? find_direct_call(expr) : SIZE_MAX;
+    if (direct_index == SIZE_MAX) {
+        compile_expr(expr->callee.get());
+    }
+
+    if (bound) {
+        for (size_t p = 0; p < arg_for_param.size(); ++p) {
+            compile_call_argument(arg_for_param[p] == SIZE_MAX ? (*params)[p].default_value.get()
+                                                               : expr->arguments[arg_for_param[p]].get(),
+                                  expr->line, (*params)[p].type.name);
+        }
+        if (direct_index != SIZE_MAX) {
+            emit_op(OpCode::OP_CALL_DIRECT, expr->line);
+            emit_short(static_cast<uint16_t>(direct_index), expr->line);
+            emit_short(static_cast<uint16_t>(arg_for_param.size()), expr->line);
+            return;
+        }
+        emit_op(tail_call ? OpCode::OP_TAIL_CALL : OpCode::OP_CALL, expr->line);
+        emit_short(static_cast<uint16_t>(arg_for_param.size()), expr->line);
+        if (tail_call) {
+            for (size_t p = 0; p < arg_for_param.size(); ++p) {
+                emit_short(std::numeric_limits<uint16_t>::max(), expr->line);
+            }
+        }
+        return;
+    }
+
     bool has_named_args = false;
     for (size_t i = 0; i < expr->arguments.size(); ++i) {
-        // Optimization: Use move semantics for simple identifiers in last use
-        if (can_use_move_semantics(expr->arguments[i].get())) {
-            auto* ident = static_cast<IdentifierExpr*>(expr->arguments[i].get());
-            emit_variable_get_move(ident->name, expr->line);
-        } else {
-            compile_expr(expr->arguments[i].get());
-        }
-        
-        emit_op(OpCode::OP_COPY_VALUE, expr->line);
+        compile_call_argument(expr->arguments[i].get(), expr->line, initializer_argument_type(expr, i));
         if (!expr->argument_names[i].empty()) {
             has_named_args = true;
         }
     }
 
-    if (has_named_args) {
-        emit_op(OpCode::OP_CALL_NAMED, expr->line);
+    if (has_named_args || tail_call) {
+        emit_op(tail_call ? OpCode::OP_TAIL_CALL : OpCode::OP_CALL_NAMED, expr->line);
         emit_short(static_cast<uint16_t>(expr->arguments.size()), expr->line);
         for (const auto& arg_name : expr->argument_names) {
             if (arg_name.empty()) {
@@ -3283,6 +3731,310 @@ void Compiler::visit(CallExpr* expr) {
     }
 }
 
+void Compiler::compile_call_argument(Expr* arg, uint32_t line, const std::string& expected_type) {
+    // Optimization: Use move semantics for simple identifiers in last use
+    if (can_use_move_semantics(arg)) {
+        auto* ident = static_cast<IdentifierExpr*>(arg);
+        emit_variable_get_move(ident->name, line);
+    } else {
+        compile_expr_as(arg, expected_type);
+    }
+
+    emit_op(OpCode::OP_COPY_VALUE, line);
+}
+
+void Compiler::collect_call_signatures(const Stmt* stmt) {
+    if (!stmt) {
+        return;
+    }
+    auto record = [this](const std::string& key, const std::vector<ParamDecl>& params) {
+        auto [it, inserted] = call_signatures_.emplace(key, &params);
+        if (!inserted && it->second != &params) {
+            it->second = nullptr;  // Overloaded: resolved by arity at runtime
+        }
+    };
+    auto record_init_arg = [this](const std::string& type, const std::string& label, const std::string& arg_type) {
+        auto [it, inserted] = initializer_arg_types_.emplace(type + "." + label, arg_type);
+        if (!inserted && it->second != arg_type) {
+            it->second.clear();
+        }
+    };
+    auto record_init_params = [&](const std::string& type, const FuncDeclStmt& init) {
+        for (const auto& param : init.params) {
+            if (!param.external_name.empty()) {
+                record_init_arg(type, param.external_name, param.type.name);
+            }
+        }
+    };
+
+    if (stmt->kind == StmtKind::FuncDecl) {
+        auto* func = static_cast<const FuncDeclStmt*>(stmt);
+        // Specializations are only reached through their generic name
+        if (func->generic_params.empty() && !function_specializations_.count(func->name)) {
+            record(func->name, func->params);
+            if (!extract_native_call_attribute(func->attributes).is_valid) {
+                auto [slot, inserted] = direct_call_slots_.emplace(func->name, SIZE_MAX);
+                if (inserted) {
+                    FunctionPrototype placeholder;
+                    placeholder.name = func->name;
+                    size_t index = chunk_.add_function(std::move(placeholder));
+                    slot->second = index <= std::numeric_limits<uint16_t>::max() ? index : SIZE_MAX;
+                } else {
+                    slot->second = SIZE_MAX;
+                }
+            }
+        }
+    } else if (stmt->kind == StmtKind::StructDecl) {
+        auto* decl = static_cast<const StructDeclStmt*>(stmt);
+        if (!decl->generic_params.empty()) {
+            return;
+        }
+        for (const auto& property : decl->properties) {
+            if (property && !property->is_static && !property->is_computed && property->type_annotation) {
+                record_init_arg(decl->name, property->name, property->type_annotation->name);
+            }
+        }
+        for (const auto& init : decl->initializers) {
+            if (init) {
+                record_init_params(decl->name, *init);
+            }
+        }
+        for (const auto& method : decl->methods) {
+            if (method && !method->is_static && !method->is_computed_property &&
+                method->generic_params.empty() && method->attributes.empty()) {
+                record(decl->name + "." + method->name, method->params);
+            }
+        }
+    } else if (stmt->kind == StmtKind::ClassDecl) {
+        auto* decl = static_cast<const ClassDeclStmt*>(stmt);
+        bool analyzable = !extract_native_type_attribute(decl->attributes).is_valid;
+        class_hierarchy_.add_class(*decl, analyzable);
+        for (const auto& method : decl->methods) {
+            if (method && method->name == "init" && decl->generic_params.empty()) {
+                record_init_params(decl->name, *method);
+            }
+        }
+        if (!devirtualize_ || !analyzable || !decl->generic_params.empty()) {
+            return;
+        }
+        for (const auto& method : decl->methods) {
+            if (!method || method->is_static || method->name == "init" ||
+                !method->generic_params.empty() || !method->attributes.empty()) {
+                continue;
+            }
+            auto [slot, inserted] = method_call_slots_.emplace(decl->name + "." + method->name, SIZE_MAX);
+            if (inserted) {
+                FunctionPrototype placeholder;
+                placeholder.name = method->name;
+                size_t index = chunk_.add_function(std::move(placeholder));
+                slot->second = index <= std::numeric_limits<uint16_t>::max() ? index : SIZE_MAX;
+            } else {
+                slot->second = SIZE_MAX;
+            }
+        }
+    } else if (stmt->kind == StmtKind::ProtocolDecl) {
+        class_hierarchy_.add_protocol(static_cast<const ProtocolDeclStmt*>(stmt)->name);
+    } else if (stmt->kind == StmtKind::ExtensionDecl) {
+        // Extension methods may overload or shadow; leave them dynamic
+        auto* ext = static_cast<const ExtensionDeclStmt*>(stmt);
+        class_hierarchy_.add_extension(*ext);
+        for (const auto& method : ext->methods) {
+            if (method) {
+                call_signatures_[ext->extended_type + "." + method->name] = nullptr;
+            }
+        }
+    }
+}
+
+const std::vector<ParamDecl>* Compiler::find_call_signature(const CallExpr* expr) const {
+    std::string key;
+    if (expr->callee->kind == ExprKind::Identifier) {
+        auto* identifier = static_cast<const IdentifierExpr*>(expr->callee.get());
+        if (!identifier->generic_args.empty() || is_implicit_property(identifier->name)) {
+            return nullptr;
+        }
+        for (const Compiler* c = this; c; c = c->enclosing_) {
+            if (c->resolve_local(identifier->name) != -1) {
+                return nullptr;  // Local function or closure shadows the global
+            }
+        }
+        key = identifier->name;
+    } else if (expr->callee->kind == ExprKind::Member) {
+        auto* member = static_cast<const MemberExpr*>(expr->callee.get());
+        std::string type_name = known_variable_type(member->object.get());
+        if (type_name.empty()) {
+            return nullptr;
+        }
+        key = type_name + "." + member->member;
+    } else {
+        return nullptr;
+    }
+
+    for (const Compiler* c = this; c; c = c->enclosing_) {
+        auto it = c->call_signatures_.find(key);
+        if (it != c->call_signatures_.end()) {
+            return it->second;
+        }
+    }
+    return nullptr;
+}
+
+std::string Compiler::initializer_argument_type(const CallExpr* expr, size_t arg) const {
+    if (expr->callee->kind != ExprKind::Identifier || arg >= expr->argument_names.size() ||
+        expr->argument_names[arg].empty()) {
+        return {};
+    }
+    auto* identifier = static_cast<const IdentifierExpr*>(expr->callee.get());
+    if (!identifier->generic_args.empty()) {
+        return {};
+    }
+    const std::string key = identifier->name + "." + expr->argument_names[arg];
+    for (const Compiler* c = this; c; c = c->enclosing_) {
+        if (c->resolve_local(identifier->name) != -1) {
+            return {};
+        }
+        auto it = c->initializer_arg_types_.find(key);
+        if (it != c->initializer_arg_types_.end()) {
+            return it->second;
+        }
+    }
+    return {};
+}
+
+size_t Compiler::find_direct_call(const CallExpr* expr) const {
+    // find_call_signature has already ruled out locals, generics and overloads
+    if (expr->callee->kind != ExprKind::Identifier) {
+        return SIZE_MAX;
+    }
+    const std::string& name = static_cast<const IdentifierExpr*>(expr->callee.get())->name;
+    for (const Compiler* c = this; c; c = c->enclosing_) {
+        auto it = c->direct_call_slots_.find(name);
+        if (it != c->direct_call_slots_.end()) {
+            return it->second;
+        }
+    }
+    return SIZE_MAX;
+}
+
+bool Compiler::emit_devirtualized_call(CallExpr* expr) {
+    Compiler* root = this;
+    while (root->enclosing_) root = root->enclosing_;
+    if (!root->devirtualize_ || root->pending_imports_ > 0) {
+        return false;
+    }
+
+    auto* member = static_cast<MemberExpr*>(expr->callee.get());
+    std::string class_name = known_variable_type(member->object.get());
+    if (class_name.empty() || !root->class_hierarchy_.is_class(class_name)) {
+        return false;
+    }
+    auto resolution = root->class_hierarchy_.resolve(class_name, member->member);
+    auto slot = resolution ? root->method_call_slots_.find(resolution->owner + "." + member->member)
+                           : root->method_call_slots_.end();
+    std::vector<size_t> arg_for_param;
+    if (slot == root->method_call_slots_.end() || slot->second == SIZE_MAX ||
+        resolution->method->params.size() >= std::numeric_limits<uint16_t>::max() ||
+        !bind_call_arguments(expr, resolution->method->params, arg_for_param)) {
+        ++root->devirtualization_stats_.dynamic_calls;
+        return false;
+    }
+
+    // self in one of the class's own methods is always an instance of it, so
+    // a closed call needs no check and is entered like a top-level function
+    bool on_self = resolution->closed && member->object->kind == ExprKind::Identifier &&
+                   static_cast<const IdentifierExpr*>(member->object.get())->name == "self" &&
+                   resolve_local("self") == 0;
+
+    compile_expr(member->object.get());
+    for (size_t p = 0; p < arg_for_param.size(); ++p) {
+        compile_call_argument(arg_for_param[p] == SIZE_MAX ? resolution->method->params[p].default_value.get()
+                                                           : expr->arguments[arg_for_param[p]].get(),
+                              expr->line, resolution->method->params[p].type.name);
+    }
+
+    if (on_self) {
+        emit_op(OpCode::OP_CALL_DIRECT, expr->line);
+        emit_short(static_cast<uint16_t>(slot->second), expr->line);
+        emit_short(static_cast<uint16_t>(arg_for_param.size() + 1), expr->line);
+        ++root->devirtualization_stats_.self_calls;
+        return true;
+    }
+
+    size_t name_idx = identifier_constant(member->member);
+    if (name_idx > std::numeric_limits<uint16_t>::max()) {
+        throw CompilerError("Too many property identifiers", expr->line);
+    }
+    emit_op(resolution->closed ? OpCode::OP_CALL_METHOD_DIRECT : OpCode::OP_CALL_METHOD_GUARDED, expr->line);
+    emit_short(static_cast<uint16_t>(name_idx), expr->line);
+    emit_short(static_cast<uint16_t>(slot->second), expr->line);
+    emit_short(static_cast<uint16_t>(arg_for_param.size()), expr->line);
+    emit_short(type_id(class_name, expr->line), expr->line);
+    ++(resolution->closed ? root->devirtualization_stats_.direct_calls : root->devirtualization_stats_.guarded_calls);
+    return true;
+}
+
+bool Compiler::bind_call_arguments(const CallExpr* expr,
+                                   const std::vector<ParamDecl>& params,
+                                   std::vector<size_t>& arg_for_param) const {
+    // Same matching rules as VM::apply_named_arguments; anything it would
+    // reject is left to the runtime so the error surfaces unchanged.
+    if (expr->arguments.size() > params.size()) {
+        return false;
+    }
+    arg_for_param.assign(params.size(), SIZE_MAX);
+    size_t next_pos = 0;
+    for (size_t i = 0; i < expr->arguments.size(); ++i) {
+        const std::string& name = expr->argument_names[i];
+        size_t target = params.size();
+        if (!name.empty()) {
+            for (size_t p = 0; p < params.size(); ++p) {
+                if (!params[p].external_name.empty() && params[p].external_name == name) {
+                    target = p;
+                    break;
+                }
+            }
+        } else {
+            while (next_pos < params.size() && arg_for_param[next_pos] != SIZE_MAX) {
+                ++next_pos;
+            }
+            target = next_pos++;
+        }
+        if (target >= params.size() || arg_for_param[target] != SIZE_MAX) {
+            return false;
+        }
+        arg_for_param[target] = i;
+    }
+
+    bool in_source_order = true;
+    size_t last_arg = 0;
+    bool first = true;
+    for (size_t p = 0; p < params.size(); ++p) {
+        size_t arg = arg_for_param[p];
+        if (arg == SIZE_MAX) {
+            if (!params[p].default_value) {
+                return false;
+            }
+            continue;
+        }
+        if (!first && arg < last_arg) {
+            in_source_order = false;
+        }
+        last_arg = arg;
+        first = false;
+    }
+    if (in_source_order) {
+        return true;
+    }
+
+    // Reordering changes evaluation order; only do it when that is unobservable
+    for (const auto& arg : expr->arguments) {
+        if (arg->kind != ExprKind::Literal && arg->kind != ExprKind::Identifier) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void Compiler::visit(RangeExpr* expr) {
     compile_expr(expr->start.get());
     compile_expr(expr->end.get());
@@ -3402,6 +4154,7 @@ void Compiler::visit(ClosureExpr* expr) {
     closure_compiler.scope_depth_ = 1;
     closure_compiler.recursion_depth_ = 0;
     closure_compiler.emit_debug_info_ = emit_debug_info_;
+    closure_compiler.program_ids_ = program_ids_;
     closure_compiler.current_source_file_ = current_source_file_;
 
     for (const auto& [param_name, param_type] : expr->params) {
@@ -3447,11 +4200,7 @@ void Compiler::visit(TypeCastExpr* expr) {
     // Compile the value expression
     compile_expr(expr->value.get());
     
-    // Store the target type name
-    size_t type_name_idx = identifier_constant(expr->target_type.name);
-    if (type_name_idx > std::numeric_limits<uint16_t>::max()) {
-        throw CompilerError("Type name index out of range", expr->line);
-    }
+    uint16_t target_type = type_id(expr->target_type.name, expr->line);
     
     // Emit appropriate OPCODE
     if (expr->is_optional) {
@@ -3461,21 +4210,15 @@ void Compiler::visit(TypeCastExpr* expr) {
     } else {
         emit_op(OpCode::OP_TYPE_CAST, expr->line);
     }
-    emit_short(static_cast<uint16_t>(type_name_idx), expr->line);
+    emit_short(target_type, expr->line);
 }
 
 void Compiler::visit(TypeCheckExpr* expr) {
     // Compile the value expression
     compile_expr(expr->value.get());
     
-    // Store the target type name
-    size_t type_name_idx = identifier_constant(expr->target_type.name);
-    if (type_name_idx > std::numeric_limits<uint16_t>::max()) {
-        throw CompilerError("Type name index out of range", expr->line);
-    }
-    
     emit_op(OpCode::OP_TYPE_CHECK, expr->line);
-    emit_short(static_cast<uint16_t>(type_name_idx), expr->line);
+    emit_short(type_id(expr->target_type.name, expr->line), expr->line);
 }
 
 void Compiler::begin_scope() {
@@ -3570,6 +4313,11 @@ void Compiler::mark_local_initialized() {
         return;
     }
     locals_.back().depth = scope_depth_;
+    // Parameters and self are initialized before the body emits any code
+    MethodBody& body = chunk_.ensure_primary_body();
+    if (body.bytecode.empty()) {
+        body.frame_slots = static_cast<uint32_t>(locals_.size());
+    }
 }
 
 int Compiler::resolve_local(const std::string& name) const {
@@ -3800,20 +4548,31 @@ void Compiler::emit_short(uint16_t value, uint32_t line) {
 
 void Compiler::emit_constant(Value val, uint32_t line) {
     size_t idx = chunk_.add_constant(val);
-    if (idx > std::numeric_limits<uint16_t>::max()) {
+    if (idx > kMaxLongOperand) {
         throw CompilerError("Too many constants", line);
     }
-    emit_op(OpCode::OP_CONSTANT, line);
-    emit_short(static_cast<uint16_t>(idx), line);
+    emit_table_load(OpCode::OP_CONSTANT, OpCode::OP_CONSTANT_LONG, idx, line);
 }
 
 void Compiler::emit_string(const std::string& val, uint32_t line) {
-    size_t idx = chunk_.add_string(val);
-    if (idx > std::numeric_limits<uint16_t>::max()) {
+    size_t idx = chunk_.add_literal_string(val);
+    if (idx > kMaxLongOperand) {
         throw CompilerError("Too many string constants", line);
     }
-    emit_op(OpCode::OP_STRING, line);
-    emit_short(static_cast<uint16_t>(idx), line);
+    emit_table_load(OpCode::OP_STRING, OpCode::OP_STRING_LONG, idx, line);
+}
+
+// Literal loads keep the short form for the first 65,536 table entries so
+// the peephole, IR and inlining passes still see them
+void Compiler::emit_table_load(OpCode op, OpCode long_op, size_t idx, uint32_t line) {
+    if (idx <= std::numeric_limits<uint16_t>::max()) {
+        emit_op(op, line);
+        emit_short(static_cast<uint16_t>(idx), line);
+        return;
+    }
+    emit_op(long_op, line);
+    emit_byte(static_cast<uint8_t>((idx >> 16) & 0xff), line);
+    emit_short(static_cast<uint16_t>(idx & 0xffff), line);
 }
 
 size_t Compiler::emit_jump(OpCode op, uint32_t line) {
@@ -3842,6 +4601,35 @@ size_t Compiler::identifier_constant(const std::string& name) {
     return chunk_.add_string(name);
 }
 
+uint16_t Compiler::enum_case_id(const std::string& case_name, uint32_t line) {
+    auto& ids = program_ids_->enum_cases;
+    auto [it, inserted] = ids.emplace(case_name, static_cast<uint16_t>(ids.size()));
+    if (inserted && ids.size() > std::numeric_limits<uint16_t>::max()) {
+        throw CompilerError("Too many enum case names", line);
+    }
+    return it->second;
+}
+
+uint16_t Compiler::type_id(const std::string& type_name, uint32_t line) {
+    auto& ids = *program_ids_;
+    auto [it, inserted] = ids.types.emplace(type_name, static_cast<uint16_t>(ids.type_names.size()));
+    if (inserted) {
+        if (ids.type_names.size() >= std::numeric_limits<uint16_t>::max()) {
+            throw CompilerError("Too many type names", line);
+        }
+        ids.type_names.push_back(type_name);
+    }
+    return it->second;
+}
+
+void Compiler::reserve_type_definitions() {
+    for (const auto& name : program_ids_->type_names) {
+        TypeDef def{};
+        def.name = static_cast<string_idx>(chunk_.add_string(name));
+        chunk_.type_definitions.push_back(std::move(def));
+    }
+}
+
 std::string Compiler::build_method_key(const std::string& type_name,
                                        const std::string& method_name,
                                        bool is_static,
@@ -3897,26 +4685,12 @@ std::vector<TypeAnnotation> Compiler::build_accessor_param_types(const std::opti
     return params;
 }
 
-body_idx Compiler::store_method_body(const Assembly& body_chunk) {
-    MethodBody body{};
-    body.bytecode = body_chunk.bytecode();
-    body.line_info = body_chunk.line_info();
-    body.max_stack_depth = 0;
-    // Transfer debug info if present
-    if (!body_chunk.method_bodies.empty() && body_chunk.method_bodies.front().debug_info) {
-        body.debug_info = std::make_unique<DebugInfo>(*body_chunk.method_bodies.front().debug_info);
-    }
-    chunk_.method_bodies.push_back(std::move(body));
-    return static_cast<body_idx>(chunk_.method_bodies.size() - 1);
-}
-
 void Compiler::record_method_body(const std::string& type_name,
                                   const std::string& method_name,
                                   bool is_static,
                                   const std::vector<TypeAnnotation>& param_types,
-                                  const Assembly& body_chunk) {
-    body_idx idx = store_method_body(body_chunk);
-    method_body_lookup_[build_method_key(type_name, method_name, is_static, param_types)] = {idx};
+                                  const std::shared_ptr<Assembly>& body_chunk) {
+    method_body_lookup_[build_method_key(type_name, method_name, is_static, param_types)] = {body_chunk};
 }
 
 std::shared_ptr<Assembly> Compiler::finalize_function_chunk(Assembly&& chunk) {
@@ -3926,11 +4700,13 @@ std::shared_ptr<Assembly> Compiler::finalize_function_chunk(Assembly&& chunk) {
 
 Assembly Compiler::compile_function_body(const FuncDeclStmt& stmt) {
     Compiler function_compiler;
+    function_compiler.return_type_name_ = annotated_type_name(stmt.return_type);
     function_compiler.chunk_ = Assembly{};
     function_compiler.locals_.clear();
     function_compiler.scope_depth_ = 1;
     function_compiler.recursion_depth_ = 0;
     function_compiler.emit_debug_info_ = emit_debug_info_;
+    function_compiler.program_ids_ = program_ids_;
     function_compiler.current_source_file_ = current_source_file_;
 
     if (stmt.expected_error_type.has_value()) {
@@ -3976,12 +4752,12 @@ Assembly Compiler::compile_function_body(const FuncDeclStmt& stmt) {
     }
 
     function_compiler.chunk_.expand_to_assembly();
-    record_method_body("", stmt.name, false, extract_param_types(stmt.params), function_compiler.chunk_);
     return std::move(function_compiler.chunk_);
 }
 
 Assembly Compiler::compile_struct_method_body(const StructMethodDecl& method, bool is_mutating) {
     Compiler method_compiler;
+    method_compiler.return_type_name_ = annotated_type_name(method.return_type);
     method_compiler.chunk_ = Assembly{};
     method_compiler.locals_.clear();
     method_compiler.scope_depth_ = 1;
@@ -3989,6 +4765,7 @@ Assembly Compiler::compile_struct_method_body(const StructMethodDecl& method, bo
     method_compiler.in_struct_method_ = true;
     method_compiler.in_mutating_method_ = is_mutating;
     method_compiler.emit_debug_info_ = emit_debug_info_;
+    method_compiler.program_ids_ = program_ids_;
     method_compiler.current_source_file_ = current_source_file_;
 
     if (method.expected_error_type.has_value()) {
@@ -4037,7 +4814,6 @@ Assembly Compiler::compile_struct_method_body(const StructMethodDecl& method, bo
     }
 
     method_compiler.chunk_.expand_to_assembly();
-    record_method_body("", method.name, method.is_static, extract_param_types(method.params), method_compiler.chunk_);
     return std::move(method_compiler.chunk_);
 }
 
@@ -4139,6 +4915,9 @@ void Compiler::populate_metadata_tables(const std::vector<StmtPtr>& program) {
             auto* class_decl = static_cast<ClassDeclStmt*>(stmt.get());
             auto& meta = ensure_pending_type(class_decl->name);
             meta.flags |= access_type_flags(class_decl->access_level) | static_cast<uint32_t>(TypeFlags::Class);
+            if (class_decl->is_final) {
+                meta.flags |= static_cast<uint32_t>(TypeFlags::Final);
+            }
             if (class_decl->superclass_name.has_value()) {
                 meta.base_type = class_decl->superclass_name.value();
             }
@@ -4211,6 +4990,9 @@ void Compiler::populate_metadata_tables(const std::vector<StmtPtr>& program) {
                 if (method->is_override) {
                     pending.flags |= static_cast<uint32_t>(MethodFlags::Override);
                 }
+                if (method->is_final) {
+                    pending.flags |= static_cast<uint32_t>(MethodFlags::Final);
+                }
                 pending.return_type = method->return_type;
                 pending.params.reserve(method->params.size());
                 for (const auto& param : method->params) {
@@ -4548,7 +5330,11 @@ void Compiler::populate_metadata_tables(const std::vector<StmtPtr>& program) {
         }
     }
 
+    // Types named by OP_TYPE_CHECK and the casts already have their definitions reserved
     std::unordered_map<std::string, type_idx> type_indices;
+    for (size_t i = 0; i < chunk_.type_definitions.size(); ++i) {
+        type_indices.emplace(chunk_.string_table[chunk_.type_definitions[i].name], static_cast<type_idx>(i));
+    }
 
     auto ensure_type_def = [&](const std::string& name, uint32_t flags) -> type_idx {
         auto it = type_indices.find(name);
@@ -4597,7 +5383,6 @@ void Compiler::populate_metadata_tables(const std::vector<StmtPtr>& program) {
         return offset;
     };
 
-    constexpr body_idx kInvalidBody = std::numeric_limits<body_idx>::max();
     constexpr method_idx kInvalidMethod = std::numeric_limits<method_idx>::max();
 
     for (const auto& type_name : type_order) {
@@ -4680,10 +5465,400 @@ void Compiler::populate_metadata_tables(const std::vector<StmtPtr>& program) {
     }
 }
 
+TreeShakeRoots Compiler::collect_tree_shake_roots(const std::vector<StmtPtr>& program) const {
+    TreeShakeRoots roots;
+    roots.keep_reflection = keep_reflection_symbols_;
+
+    auto declaration = [](const Stmt& stmt) -> std::pair<std::string, AccessLevel> {
+        switch (stmt.kind) {
+        case StmtKind::FuncDecl: {
+            const auto& decl = static_cast<const FuncDeclStmt&>(stmt);
+            return {decl.name, decl.access_level};
+        }
+        case StmtKind::ClassDecl: {
+            const auto& decl = static_cast<const ClassDeclStmt&>(stmt);
+            return {decl.name, decl.access_level};
+        }
+        case StmtKind::StructDecl: {
+            const auto& decl = static_cast<const StructDeclStmt&>(stmt);
+            return {decl.name, decl.access_level};
+        }
+        case StmtKind::EnumDecl: {
+            const auto& decl = static_cast<const EnumDeclStmt&>(stmt);
+            return {decl.name, decl.access_level};
+        }
+        case StmtKind::ProtocolDecl: {
+            const auto& decl = static_cast<const ProtocolDeclStmt&>(stmt);
+            return {decl.name, decl.access_level};
+        }
+        default:
+            return {std::string{}, AccessLevel::Internal};
+        }
+    };
+    auto is_native = [](const Stmt& stmt) {
+        return std::any_of(stmt.attributes.begin(), stmt.attributes.end(), [](const Attribute& attr) {
+            return attr.name.rfind("Native", 0) == 0 || attr.name == "InternalCall";
+        });
+    };
+
+    // Public declarations of the entry file are its exports; imported
+    // modules are reached through the code that uses them
+    for (const auto& stmt : program) {
+        if (!stmt) {
+            continue;
+        }
+        auto [name, access] = declaration(*stmt);
+        if (!name.empty() && (access == AccessLevel::Public || is_native(*stmt))) {
+            roots.names.insert(name);
+        }
+    }
+    for (const auto& module : imported_module_asts_) {
+        for (const auto& stmt : module) {
+            if (!stmt) {
+                continue;
+            }
+            std::string name = declaration(*stmt).first;
+            if (!name.empty() && is_native(*stmt)) {
+                roots.names.insert(std::move(name));
+            }
+        }
+    }
+    return roots;
+}
+
+// ============================================================================
+// Function Inlining
+// ============================================================================
+
+namespace {
+
+// Callee bytes (up to its first OP_RETURN) spliced in place of a call.
+constexpr size_t kInlineMaxBytes = 48;
+
+uint16_t read_operand(const std::vector<uint8_t>& code, size_t offset) {
+    return static_cast<uint16_t>((code[offset] << 8) | code[offset + 1]);
+}
+
+void write_operand(std::vector<uint8_t>& code, size_t offset, uint16_t value) {
+    code[offset] = static_cast<uint8_t>((value >> 8) & 0xFF);
+    code[offset + 1] = static_cast<uint8_t>(value & 0xFF);
+}
+
+// Straight-line callee body built only from instructions whose effect on the
+// operand stack is exact, so its frame slots can be addressed from the top.
+struct InlineCandidate {
+    const Assembly* chunk{nullptr};
+    std::vector<uint8_t> code;
+    std::vector<uint32_t> lines;
+    uint16_t arity{0};
+};
+
+bool is_inlinable_op(OpCode op) {
+    switch (op) {
+    case OpCode::OP_CONSTANT: case OpCode::OP_STRING: case OpCode::OP_NIL:
+    case OpCode::OP_TRUE: case OpCode::OP_FALSE: case OpCode::OP_POP:
+    case OpCode::OP_POP_N: case OpCode::OP_DUP:
+    case OpCode::OP_ADD: case OpCode::OP_SUBTRACT: case OpCode::OP_MULTIPLY:
+    case OpCode::OP_DIVIDE: case OpCode::OP_MODULO: case OpCode::OP_NEGATE:
+    case OpCode::OP_BITWISE_NOT: case OpCode::OP_BITWISE_AND: case OpCode::OP_BITWISE_OR:
+    case OpCode::OP_BITWISE_XOR: case OpCode::OP_LEFT_SHIFT: case OpCode::OP_RIGHT_SHIFT:
+    case OpCode::OP_EQUAL: case OpCode::OP_NOT_EQUAL: case OpCode::OP_LESS:
+    case OpCode::OP_GREATER: case OpCode::OP_LESS_EQUAL: case OpCode::OP_GREATER_EQUAL:
+    case OpCode::OP_NOT: case OpCode::OP_AND: case OpCode::OP_OR:
+    case OpCode::OP_NIL_COALESCE: case OpCode::OP_RANGE_INCLUSIVE: case OpCode::OP_RANGE_EXCLUSIVE:
+    case OpCode::OP_GET_SUBSCRIPT: case OpCode::OP_CONTAINS: case OpCode::OP_COPY_VALUE:
+    case OpCode::OP_UNWRAP: case OpCode::OP_GET_GLOBAL: case OpCode::OP_GET_PROPERTY:
+    case OpCode::OP_GET_LOCAL: case OpCode::OP_GET_LOCAL_MOVE: case OpCode::OP_CALL_DIRECT:
+    case OpCode::OP_RETURN:
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::optional<InlineCandidate> make_inline_candidate(const FunctionPrototype& proto) {
+    if (!proto.chunk || !proto.upvalues.empty() || proto.is_initializer ||
+        proto.chunk->method_bodies.empty() || proto.params.size() > std::numeric_limits<uint16_t>::max()) {
+        return std::nullopt;
+    }
+    const MethodBody& body = proto.chunk->method_bodies.front();
+    const auto& code = body.bytecode;
+    size_t height = proto.params.size();
+    for (size_t offset = 0; offset < code.size() && offset < kInlineMaxBytes;) {
+        OpCode op = static_cast<OpCode>(code[offset]);
+        if (!is_inlinable_op(op)) {
+            return std::nullopt;
+        }
+        if (op == OpCode::OP_RETURN) {
+            InlineCandidate candidate;
+            candidate.chunk = proto.chunk.get();
+            candidate.code.assign(code.begin(), code.begin() + static_cast<long>(offset) + 1);
+            candidate.lines.assign(body.line_info.begin(), body.line_info.begin() + static_cast<long>(offset) + 1);
+            candidate.arity = static_cast<uint16_t>(proto.params.size());
+            return candidate;
+        }
+        if ((op == OpCode::OP_GET_LOCAL || op == OpCode::OP_GET_LOCAL_MOVE) &&
+            read_operand(code, offset + 1) >= height) {
+            return std::nullopt;
+        }
+        StackEffect effect = instruction_stack_effect(code, offset);
+        if (effect.pops > height) {
+            return std::nullopt;
+        }
+        height = height - effect.pops + effect.pushes;
+        offset += instruction_length(code, offset);
+    }
+    return std::nullopt;
+}
+
+// Appends the callee body for one call site. Frame slots become depths below
+// the top of stack and pool indices are re-interned in the caller's tables;
+// OP_RETURN drops the arguments and locals from beneath the result.
+bool splice_inline_body(const InlineCandidate& callee, Assembly& caller,
+                        std::vector<uint8_t>& out, std::vector<uint32_t>& lines) {
+    const auto& code = callee.code;
+    size_t height = callee.arity;
+    for (size_t offset = 0; offset < code.size();) {
+        OpCode op = static_cast<OpCode>(code[offset]);
+        size_t length = instruction_length(code, offset);
+        uint32_t line = callee.lines[offset];
+        auto emit = [&](uint8_t byte) {
+            out.push_back(byte);
+            lines.push_back(line);
+        };
+        auto emit_with_operand = [&](OpCode emitted, size_t operand) {
+            if (operand > std::numeric_limits<uint16_t>::max()) {
+                return false;
+            }
+            emit(static_cast<uint8_t>(emitted));
+            emit(static_cast<uint8_t>((operand >> 8) & 0xFF));
+            emit(static_cast<uint8_t>(operand & 0xFF));
+            return true;
+        };
+
+        bool ok = true;
+        switch (op) {
+        case OpCode::OP_GET_LOCAL:
+        case OpCode::OP_GET_LOCAL_MOVE:
+            ok = emit_with_operand(OpCode::OP_PICK, height - 1 - read_operand(code, offset + 1));
+            break;
+        case OpCode::OP_CONSTANT:
+            ok = emit_with_operand(op, caller.add_constant(
+                callee.chunk->global_constant_pool.at(read_operand(code, offset + 1))));
+            break;
+        case OpCode::OP_STRING:
+            ok = emit_with_operand(op, caller.add_literal_string(
+                callee.chunk->literal_strings.at(read_operand(code, offset + 1))));
+            break;
+        case OpCode::OP_GET_GLOBAL:
+        case OpCode::OP_GET_PROPERTY:
+            ok = emit_with_operand(op, caller.add_string(
+                callee.chunk->string_table.at(read_operand(code, offset + 1))));
+            break;
+        case OpCode::OP_RETURN:
+            if (height > 1) {
+                ok = emit_with_operand(OpCode::OP_POP_UNDER, height - 1);
+            }
+            return ok;
+        default:
+            for (size_t i = 0; i < length; ++i) {
+                emit(code[offset + i]);
+            }
+            break;
+        }
+        if (!ok) {
+            return false;
+        }
+        StackEffect effect = instruction_stack_effect(code, offset);
+        height = height - effect.pops + effect.pushes;
+        offset += length;
+    }
+    return false;
+}
+
+// Rewrites one method body, replacing OP_CALL_DIRECT to candidates with the
+// callee code and re-targeting jumps, line info and debug scopes.
+void inline_calls_in_body(MethodBody& body, Assembly& owner,
+                          const std::vector<std::optional<InlineCandidate>>& candidates) {
+    const auto& code = body.bytecode;
+    bool any = false;
+    for (size_t offset = 0; offset < code.size() && !any; offset += instruction_length(code, offset)) {
+        if (static_cast<OpCode>(code[offset]) == OpCode::OP_CALL_DIRECT) {
+            uint16_t index = read_operand(code, offset + 1);
+            any = index < candidates.size() && candidates[index] &&
+                  candidates[index]->arity == read_operand(code, offset + 3);
+        }
+    }
+    if (!any) {
+        return;
+    }
+
+    std::vector<uint8_t> out;
+    std::vector<uint32_t> lines;
+    std::vector<size_t> new_offset(code.size() + 1, 0);
+    out.reserve(code.size());
+    lines.reserve(code.size());
+    for (size_t offset = 0; offset < code.size();) {
+        size_t length = instruction_length(code, offset);
+        for (size_t i = 0; i < length; ++i) {
+            new_offset[offset + i] = out.size();
+        }
+        if (static_cast<OpCode>(code[offset]) == OpCode::OP_CALL_DIRECT) {
+            uint16_t index = read_operand(code, offset + 1);
+            if (index < candidates.size() && candidates[index] &&
+                candidates[index]->arity == read_operand(code, offset + 3)) {
+                size_t mark = out.size();
+                if (splice_inline_body(*candidates[index], owner, out, lines)) {
+                    offset += length;
+                    continue;
+                }
+                out.resize(mark);
+                lines.resize(mark);
+            }
+        }
+        out.insert(out.end(), code.begin() + static_cast<long>(offset), code.begin() + static_cast<long>(offset + length));
+        lines.insert(lines.end(), body.line_info.begin() + static_cast<long>(offset),
+                     body.line_info.begin() + static_cast<long>(offset + length));
+        offset += length;
+    }
+    new_offset[code.size()] = out.size();
+
+    // Jumps were copied verbatim; recompute their distances in the new layout
+    for (size_t offset = 0; offset < code.size(); offset += instruction_length(code, offset)) {
+        OpCode op = static_cast<OpCode>(code[offset]);
+        size_t at = new_offset[offset];
+        size_t distance = 0;
+        size_t operand_at = 0;
+        if (op == OpCode::OP_SWITCH_TABLE) {
+            size_t end = offset + instruction_length(code, offset);
+            size_t new_end = at + (end - offset);
+            for (size_t operand : switch_table_target_operands(code, offset)) {
+                distance = new_offset[end + read_operand(code, operand)] - new_end;
+                if (distance > std::numeric_limits<uint16_t>::max()) {
+                    return;
+                }
+                write_operand(out, at + (operand - offset), static_cast<uint16_t>(distance));
+            }
+            continue;
+        }
+        switch (op) {
+        case OpCode::OP_JUMP:
+        case OpCode::OP_JUMP_IF_FALSE:
+        case OpCode::OP_JUMP_IF_TRUE:
+        case OpCode::OP_JUMP_IF_NIL:
+            distance = new_offset[offset + 3 + read_operand(code, offset + 1)] - (at + 3);
+            operand_at = at + 1;
+            break;
+        case OpCode::OP_LOOP:
+            distance = (at + 3) - new_offset[offset + 3 - read_operand(code, offset + 1)];
+            operand_at = at + 1;
+            break;
+        case OpCode::OP_FOR_ARRAY_NEXT:
+            distance = new_offset[offset + 5 + read_operand(code, offset + 3)] - (at + 5);
+            operand_at = at + 3;
+            break;
+        case OpCode::OP_FOR_RANGE_NEXT:
+            distance = new_offset[offset + 6 + read_operand(code, offset + 4)] - (at + 6);
+            operand_at = at + 4;
+            break;
+        default:
+            continue;
+        }
+        if (distance > std::numeric_limits<uint16_t>::max()) {
+            return;  // Too far for a 16-bit jump; keep the calls
+        }
+        write_operand(out, operand_at, static_cast<uint16_t>(distance));
+    }
+
+    if (body.debug_info) {
+        for (auto& local : body.debug_info->locals) {
+            local.scope_start_offset = static_cast<uint32_t>(new_offset[std::min<size_t>(local.scope_start_offset, code.size())]);
+            local.scope_end_offset = static_cast<uint32_t>(new_offset[std::min<size_t>(local.scope_end_offset, code.size())]);
+        }
+    }
+    body.bytecode = std::move(out);
+    body.line_info = std::move(lines);
+    body.max_stack_depth = compute_max_stack_depth(body.bytecode);
+}
+
+} // namespace
+
+void Compiler::inline_direct_calls() {
+    // Candidates are copied first so every call site sees the original callee
+    std::vector<std::optional<InlineCandidate>> candidates(chunk_.function_prototypes.size());
+    for (const auto* slots : { &direct_call_slots_, &method_call_slots_ }) {
+        for (const auto& [name, index] : *slots) {
+            if (index != SIZE_MAX) {
+                candidates[index] = make_inline_candidate(chunk_.function_prototypes[index]);
+            }
+        }
+    }
+
+    inline_calls_in_body(chunk_.ensure_primary_body(), chunk_, candidates);
+
+    std::unordered_set<const Assembly*> visited;
+    std::vector<Assembly*> pending;
+    auto enqueue = [&](const Assembly& owner) {
+        for (const auto& proto : owner.function_prototypes) {
+            if (proto.chunk && visited.insert(proto.chunk.get()).second) {
+                pending.push_back(proto.chunk.get());
+            }
+        }
+    };
+    enqueue(chunk_);
+    while (!pending.empty()) {
+        Assembly* function_chunk = pending.back();
+        pending.pop_back();
+        if (!function_chunk->method_bodies.empty()) {
+            inline_calls_in_body(function_chunk->method_bodies.front(), *function_chunk, candidates);
+        }
+        enqueue(*function_chunk);
+    }
+}
+
+void Compiler::optimize_method_bodies() {
+    peephole_stats_ = PeepholeStats{};
+    IRModuleFacts facts = IRModuleFacts::collect(chunk_);
+    IRPassManager ir_passes = IRPassManager::release_pipeline();
+
+    // The IR runs on each assembly's own body only; copies stored for
+    // metadata keep the string indices of the assembly they came from
+    std::unordered_set<const Assembly*> visited;
+    std::vector<std::pair<Assembly*, bool>> pending{{&chunk_, true}};
+    while (!pending.empty()) {
+        auto [owner, lift] = pending.back();
+        pending.pop_back();
+        if (lift && !owner->method_bodies.empty()) {
+            ir_passes.run(owner->method_bodies.front(), *owner, facts);
+        }
+        for (auto& body : owner->method_bodies) {
+            optimize_method_body(body, peephole_stats_);
+        }
+        for (const auto& proto : owner->function_prototypes) {
+            if (proto.chunk && visited.insert(proto.chunk.get()).second) {
+                // Deinit bodies run on the VM's reduced deinit interpreter
+                pending.emplace_back(proto.chunk.get(), proto.name != "deinit");
+            }
+        }
+    }
+    ir_stats_ = ir_passes.stats();
+}
+
 // ============================================================================
 // Generic Specialization Implementation
 // ============================================================================
 
+void SpecializationStats::print(std::ostream& out) const {
+    out << "\n=== Swive Specialization ===\n";
+    out << "Structs:          " << std::setw(10) << struct_specializations << "\n";
+    out << "Functions:        " << std::setw(10) << function_specializations << "\n";
+    out << "Function Bodies:  " << std::setw(10) << function_bodies << "\n";
+    out << "Shared:           " << std::setw(10) << shared_specializations << "\n";
+    out << "Cache Hits:       " << std::setw(10) << cache_hits << "\n";
+    out << "Bytecode Bytes:   " << std::setw(10) << bytecode_bytes << "\n";
+    out << "============================\n";
+}
+
 
 std::string Compiler::mangle_generic_name(const std::string& base_name, 
                                           const std::vector<TypeAnnotation>& type_args) {
@@ -5056,6 +6231,7 @@ StmtPtr Compiler::create_specialized_func(const FuncDeclStmt* template_decl,
     specialized->generic_constraints.clear();
     specialized->is_override = template_decl->is_override;
     specialized->is_static = template_decl->is_static;
+    specialized->is_final = template_decl->is_final;
     specialized->expected_error_type = template_decl->expected_error_type;
     specialized->access_level = template_decl->access_level;
 
@@ -5205,6 +6381,8 @@ result.reserve(program.size() + needed_specializations.size());
                     // Create specialized struct
                     try {
                         StmtPtr specialized = create_specialized_struct(template_it->second, type_args);
+                        struct_specializations_.insert(static_cast<StructDeclStmt*>(specialized.get())->name);
+                        ++specialization_stats_.struct_specializations;
                         result.push_back(std::move(specialized));
                     } catch (...) {
                         // Specialization failed
@@ -5278,7 +6456,8 @@ result.reserve(program.size() + needed_specializations.size());
                     try {
                         StmtPtr specialized = create_specialized_func(template_it->second, type_args);
                         auto* f = static_cast<FuncDeclStmt*>(specialized.get());
-                        specialized_functions_.insert(f->name);
+                        function_specializations_[f->name] = FunctionSpecialization{template_it->second, type_args, {}, {}};
+                        ++specialization_stats_.function_specializations;
                         result.push_back(std::move(specialized));
                     } catch (...) {
                         // Specialization failed
@@ -5449,6 +6628,7 @@ void Compiler::emit_native_function(const FuncDeclStmt& stmt, const NativeCallIn
     function_compiler.scope_depth_ = 1;
     function_compiler.recursion_depth_ = 0;
     function_compiler.emit_debug_info_ = emit_debug_info_;
+    function_compiler.program_ids_ = program_ids_;
     function_compiler.current_source_file_ = current_source_file_;
 
     // Declare local variables for parameters so the compiler's local table is consistent
@@ -5464,11 +6644,10 @@ void Compiler::emit_native_function(const FuncDeclStmt& stmt, const NativeCallIn
     }
 
     // Add the native function name to the function's chunk string table.
-    // When func->chunk is executed directly (for global functions),
-    // VM::read_string() reads from func->chunk's string_table.
+    // Linking re-interns it in the module table the wrapper body reads.
     size_t name_idx = function_compiler.chunk_.add_string(native_info.native_name);
     if (name_idx > std::numeric_limits<uint16_t>::max()) {
-        throw CompilerError("Too many string constants", stmt.line);
+        throw CompilerError("Too many identifiers", stmt.line);
     }
 
     // Emit OP_NATIVE_CALL with name index and argument count
@@ -5495,8 +6674,7 @@ void Compiler::emit_native_function(const FuncDeclStmt& stmt, const NativeCallIn
     // Finalize the function
     proto.chunk = finalize_function_chunk(std::move(function_compiler.chunk_));
     // NOTE: Do NOT call record_method_body for native functions.
-    // We want OP_CALL to use func->chunk directly, not invoke_method_def.
-    // This ensures read_string() uses the function's own string_table.
+    // The wrapper is reached only through its prototype, not a MethodDef.
 
     size_t function_index = chunk_.add_function(std::move(proto));
     if (function_index > std::numeric_limits<uint16_t>::max()) {
@@ -5516,7 +6694,7 @@ void Compiler::emit_native_function(const FuncDeclStmt& stmt, const NativeCallIn
     if (scope_depth_ == 0) {
         size_t name_idx = identifier_constant(stmt.name);
         if (name_idx > std::numeric_limits<uint16_t>::max()) {
-            throw CompilerError("Too many global variables", stmt.line);
+            throw CompilerError("Too many identifiers", stmt.line);
         }
         emit_op(OpCode::OP_SET_GLOBAL, stmt.line);
         emit_short(static_cast<uint16_t>(name_idx), stmt.line);
@@ -5601,6 +6779,7 @@ void Compiler::emit_expected_enum_definition() {
     size_t value_name_idx = identifier_constant("value");
     emit_op(OpCode::OP_ENUM_CASE, 0);
     emit_short(static_cast<uint16_t>(value_name_idx), 0);
+    emit_short(enum_case_id("value", 0), 0);
     emit_byte(1, 0);  // 1 associated value
     emit_short(std::numeric_limits<uint16_t>::max(), 0);  // no label for the associated value
 
@@ -5609,6 +6788,7 @@ void Compiler::emit_expected_enum_definition() {
     size_t error_name_idx = identifier_constant("error");
     emit_op(OpCode::OP_ENUM_CASE, 0);
     emit_short(static_cast<uint16_t>(error_name_idx), 0);
+    emit_short(enum_case_id("error", 0), 0);
     emit_byte(1, 0);  // 1 associated value
     emit_short(std::numeric_limits<uint16_t>::max(), 0);  // no label for the associated value
 
@@ -5673,6 +6853,7 @@ void Compiler::emit_native_class(const ClassDeclStmt& stmt, const NativeTypeBind
         getter_compiler.current_class_properties_ = &property_lookup;
         getter_compiler.allow_implicit_self_property_ = true;
         getter_compiler.emit_debug_info_ = emit_debug_info_;
+        getter_compiler.program_ids_ = program_ids_;
         getter_compiler.current_source_file_ = current_source_file_;
 
         getter_compiler.declare_local("self", false);
@@ -5698,7 +6879,7 @@ void Compiler::emit_native_class(const ClassDeclStmt& stmt, const NativeTypeBind
         }
 
         getter_proto.chunk = finalize_function_chunk(std::move(getter_compiler.chunk_));
-        record_method_body(stmt.name, getter_proto.name, property->is_static, {}, *getter_proto.chunk);
+        record_method_body(stmt.name, getter_proto.name, property->is_static, {}, getter_proto.chunk);
         size_t getter_idx = chunk_.add_function(std::move(getter_proto));
 
         // Compile setter (if present)
@@ -5722,6 +6903,7 @@ void Compiler::emit_native_class(const ClassDeclStmt& stmt, const NativeTypeBind
             setter_compiler.current_class_properties_ = &property_lookup;
             setter_compiler.allow_implicit_self_property_ = true;
             setter_compiler.emit_debug_info_ = emit_debug_info_;
+            setter_compiler.program_ids_ = program_ids_;
             setter_compiler.current_source_file_ = current_source_file_;
 
             setter_compiler.declare_local("self", false);
@@ -5754,7 +6936,7 @@ void Compiler::emit_native_class(const ClassDeclStmt& stmt, const NativeTypeBind
                                setter_proto.name,
                                property->is_static,
                                build_accessor_param_types(property->type_annotation),
-                               *setter_proto.chunk);
+                               setter_proto.chunk);
             setter_idx = chunk_.add_function(std::move(setter_proto));
         }
 
@@ -13,6 +13,12 @@
 
 #include "ss_ast.hpp"
 #include "ss_chunk.hpp"
+#include "ss_class_hierarchy.hpp"
+#include "ss_escape_analysis.hpp"
+#include "ss_ir.hpp"
+#include "ss_module_linker.hpp"
+#include "ss_peephole.hpp"
+#include "ss_tree_shaker.hpp"
 #include <optional>
 
 namespace swive {
@@ -61,6 +67,17 @@ struct IModuleResolver {
                                 std::string& out_error) = 0;
 };
 
+struct SpecializationStats {
+    size_t struct_specializations{0};    // Specialized struct declarations
+    size_t function_specializations{0};  // Distinct function type-argument lists
+    size_t function_bodies{0};           // Function bodies compiled for them
+    size_t shared_specializations{0};    // Lists served by a body compiled for another list
+    size_t cache_hits{0};                // Uses answered by an existing specialization
+    size_t bytecode_bytes{0};            // Bytecode of the compiled specializations
+
+    void print(std::ostream& out) const;
+};
+
 struct EntryMainInfo {
     enum class Kind { None, GlobalFunc, StaticMethod } kind{Kind::None};
     std::string type_name; // Used only when Kind is StaticMethod
@@ -75,6 +92,19 @@ public:
     void set_base_directory(const std::string& dir) { base_directory_ = dir; }
     void set_module_resolver(IModuleResolver* r) { module_resolver_ = r; }
     void set_emit_debug_info(bool enabled) { emit_debug_info_ = enabled; }
+    void set_inline_functions(bool enabled) { inline_functions_ = enabled; }
+    void set_optimize_bytecode(bool enabled) { optimize_bytecode_ = enabled; }
+    void set_scalar_replacement(bool enabled) { scalar_replacement_ = enabled; }
+    void set_devirtualize(bool enabled) { devirtualize_ = enabled; }
+    void set_tree_shaking(bool enabled) { tree_shaking_ = enabled; }
+    void set_keep_reflection_symbols(bool enabled) { keep_reflection_symbols_ = enabled; }
+    const EscapeStats& escape_stats() const { return escape_stats_; }
+    const DevirtualizationStats& devirtualization_stats() const { return devirtualization_stats_; }
+    const SpecializationStats& specialization_stats() const { return specialization_stats_; }
+    const TreeShakeStats& tree_shake_stats() const { return tree_shake_stats_; }
+    const ModuleLinkStats& module_link_stats() const { return module_link_stats_; }
+    const PeepholeStats& peephole_stats() const { return peephole_stats_; }
+    const IRStats& ir_stats() const { return ir_stats_; }
     void set_source_file(const std::string& path) { current_source_file_ = path; }
 
 private:
@@ -88,13 +118,74 @@ private:
     // Generic specialization
     std::unordered_map<std::string, const StructDeclStmt*> generic_struct_templates_;
     std::unordered_map<std::string, const FuncDeclStmt*> generic_function_templates_;
-    std::unordered_set<std::string> specialized_functions_;  // Track already-specialized functions
+    // Function specializations of this build by mangled name. Lists whose
+    // type arguments differ only in class types share one body, compiled
+    // with the parameters bound to a class erased to Any.
+    struct FunctionSpecialization {
+        const FuncDeclStmt* template_decl{nullptr};
+        std::vector<TypeAnnotation> type_args;
+        std::string body_name;                      // Global the body is defined under; empty until resolved
+        std::unordered_set<std::string> erased_params;  // Generic parameters bound to a class
+    };
+    std::unordered_map<std::string, FunctionSpecialization> function_specializations_;
+    std::unordered_set<std::string> specialization_bodies_;   // Body names already compiled
+    std::unordered_set<std::string> struct_specializations_;  // Mangled names of specialized structs
     std::vector<std::vector<StmtPtr>> imported_module_asts_;  // Keep imported ASTs alive
     std::vector<StmtPtr> pending_specializations_;  // Deferred specializations to compile
     // Method return type tracking: "ClassName.methodName" -> return type name
     std::unordered_map<std::string, std::string> method_return_types_;
+    // Global variable type tracking: "name" -> declared/inferred type name
+    std::unordered_map<std::string, std::string> global_type_names_;
+    // Parameter lists of non-generic global functions ("name") and struct
+    // methods ("Type.name"), nullptr when overloaded. Calls to these bind
+    // labels and defaults at compile time and emit a plain OP_CALL.
+    std::unordered_map<std::string, const std::vector<ParamDecl>*> call_signatures_;
+    // Declared types of labeled initializer arguments ("Type.label"), from init
+    // parameters and memberwise struct properties; "" when initializers disagree
+    std::unordered_map<std::string, std::string> initializer_arg_types_;
+    // Function prototype slots reserved up front for top-level functions so
+    // calls compiled before the declaration can still use OP_CALL_DIRECT.
+    // SIZE_MAX when the name is overloaded.
+    std::unordered_map<std::string, size_t> direct_call_slots_;
+    // Same for instance methods of top-level classes ("Class.method"), which
+    // devirtualized calls enter with the receiver as the first argument.
+    std::unordered_map<std::string, size_t> method_call_slots_;
+    ClassHierarchy class_hierarchy_;
+    // Top-level imports not compiled yet; a later one may still add subclasses
+    size_t pending_imports_{0};
+    // Program-wide ids handed out while compiling, shared with every nested
+    // compiler. Enum case discriminants are one per distinct case name so a
+    // pattern can be matched without knowing the subject's enum type. Type ids
+    // become the root TypeDef indices that OP_TYPE_CHECK and the casts name.
+    struct ProgramIds {
+        std::unordered_map<std::string, uint16_t> enum_cases;
+        std::unordered_map<std::string, uint16_t> types;
+        std::vector<std::string> type_names;  // By type id
+    };
+    std::shared_ptr<ProgramIds> program_ids_ = std::make_shared<ProgramIds>();
+    uint16_t enum_case_id(const std::string& case_name, uint32_t line);
+    uint16_t type_id(const std::string& type_name, uint32_t line);
+    void reserve_type_definitions();  // Root TypeDefs for every type id, in id order
+    void collect_call_signatures(const Stmt* stmt);
+    const std::vector<ParamDecl>* find_call_signature(const CallExpr* expr) const;
+    size_t find_direct_call(const CallExpr* expr) const;
+    // Emits recv.method(args) on a receiver of known class without a name
+    // lookup when the hierarchy resolves it; false leaves the call untouched
+    bool emit_devirtualized_call(CallExpr* expr);
+    bool bind_call_arguments(const CallExpr* expr,
+                             const std::vector<ParamDecl>& params,
+                             std::vector<size_t>& arg_for_param) const;
+    std::string known_variable_type(const Expr* expr) const;
+    std::string known_variable_type(const std::string& name) const;
+    // Declared type of argument arg of an initializer call Type(label: ...), or ""
+    std::string initializer_argument_type(const CallExpr* expr, size_t arg) const;
     void try_specialize_generic_func(const std::string& name, const std::vector<TypeAnnotation>& type_args);
     void compile_pending_specializations();
+    // Global the specialization named mangled is defined under
+    std::string specialization_body_name(const std::string& mangled);
+    // Compiles a specialized declaration, skipping functions whose shared
+    // body is already compiled; false when stmt is not a specialization
+    bool compile_specialization(Stmt* stmt);
     const FuncDeclStmt* find_generic_function_template(const std::string& name) const;
     std::vector<StmtPtr> specialize_generics(const std::vector<StmtPtr>& program);
     StmtPtr create_specialized_struct(const StructDeclStmt* template_decl,
@@ -118,7 +209,7 @@ private:
         bool is_captured{false};  // True if captured by closure
         int use_count{0};         // Number of times this local is used
         bool is_moved{false};     // True if ownership was moved
-        std::string type_name;    // Type name for generic inference (e.g. "Int", "Float")
+        std::string type_name{};  // Type name for generic inference (e.g. "Int", "Float")
     };
 
     struct Upvalue {
@@ -137,7 +228,23 @@ private:
     bool in_struct_method_{false};      // True when compiling struct method
     bool in_mutating_method_{false};    // True when compiling mutating method
     bool in_expected_function_{false};  // True when compiling function with expected error type
+    bool in_initializer_{false};        // True when compiling init (returns self, no tail calls)
+    bool tail_call_{false};             // Set by `return <call>`; consumed by the next CallExpr
+    std::string return_type_name_;      // Declared return type of the function being compiled
     bool emit_debug_info_{false};       // True when emitting debug symbol information
+    bool inline_functions_{false};      // True to splice small OP_CALL_DIRECT callees into callers
+    bool optimize_bytecode_{false};     // True to run the IR passes and the peephole pass over every method body
+    bool scalar_replacement_{false};    // True to split non-escaping struct/tuple locals into field locals
+    bool devirtualize_{false};          // True to resolve class method calls through the class hierarchy
+    bool tree_shaking_{false};          // True to drop declarations unreachable from the entry point and roots
+    bool keep_reflection_symbols_{false}; // True to keep types and methods reachable only through metadata
+    PeepholeStats peephole_stats_;
+    IRStats ir_stats_;
+    EscapeStats escape_stats_;
+    DevirtualizationStats devirtualization_stats_;
+    SpecializationStats specialization_stats_;
+    TreeShakeStats tree_shake_stats_;
+    ModuleLinkStats module_link_stats_;
     std::vector<DebugLocalInfo> debug_locals_; // Debug info for locals (only when emit_debug_info_)
     std::string current_source_file_;   // Source file path for debug info
 
@@ -157,6 +264,9 @@ private:
 
     void compile_stmt(Stmt* stmt);
     void compile_expr(Expr* expr);
+    // Compiles expr where a value of expected_type is wanted; an array
+    // literal written where a Set is expected builds the Set directly
+    void compile_expr_as(Expr* expr, const std::string& expected_type);
 
     void visit(VarDeclStmt* stmt);
     void visit(TupleDestructuringStmt* stmt);
@@ -169,6 +279,11 @@ private:
     void visit(BreakStmt* stmt);
     void visit(ContinueStmt* stmt);
     void visit(SwitchStmt* stmt);
+    // Lowers a switch over Int literals, enum cases or String literals to
+    // OP_SWITCH_TABLE; false leaves it to the compare-and-branch chain.
+    bool compile_switch_table(SwitchStmt* stmt, int switch_var);
+    void compile_case_body(const CaseClause& clause, const EnumCasePattern* binding_pattern,
+                           int switch_var, uint32_t line);
     void visit(BlockStmt* stmt);
     void visit(ClassDeclStmt* stmt);
     void visit(StructDeclStmt* stmt);  // Struct declaration
@@ -229,6 +344,7 @@ private:
     void emit_variable_get(const std::string& name, uint32_t line);
     void emit_variable_get_move(const std::string& name, uint32_t line);  // Move semantics variant
     bool can_use_move_semantics(const Expr* expr) const;
+    void compile_call_argument(Expr* arg, uint32_t line, const std::string& expected_type = {});
     FunctionPrototype::ParamDefaultValue build_param_default(const ParamDecl& param);
 
     void emit_op(OpCode op, uint32_t line);
@@ -236,6 +352,7 @@ private:
     void emit_short(uint16_t value, uint32_t line);
     void emit_constant(Value val, uint32_t line);
     void emit_string(const std::string& val, uint32_t line);
+    void emit_table_load(OpCode op, OpCode long_op, size_t idx, uint32_t line);
     size_t emit_jump(OpCode op, uint32_t line);
     void emit_loop(size_t loop_start, uint32_t line);
     void patch_jump(size_t offset);
@@ -243,7 +360,8 @@ private:
     size_t identifier_constant(const std::string& name);
 
     struct MethodBodyRecord {
-        body_idx body{0};
+        std::shared_ptr<Assembly> chunk;  // Function Assembly until the module is linked
+        body_idx body{kInvalidBody};
     };
 
     std::unordered_map<std::string, MethodBodyRecord> method_body_lookup_;
@@ -258,17 +376,19 @@ private:
                                  const std::vector<ParamDecl>& params) const;
     std::vector<TypeAnnotation> extract_param_types(const std::vector<ParamDecl>& params) const;
     std::vector<TypeAnnotation> build_accessor_param_types(const std::optional<TypeAnnotation>& type) const;
-    body_idx store_method_body(const Assembly& body_chunk);
     void record_method_body(const std::string& type_name,
                             const std::string& method_name,
                             bool is_static,
                             const std::vector<TypeAnnotation>& param_types,
-                            const Assembly& body_chunk);
+                            const std::shared_ptr<Assembly>& body_chunk);
 
     Assembly compile_function_body(const FuncDeclStmt& stmt);
     Assembly compile_struct_method_body(const StructMethodDecl& method, bool is_mutating);
     std::shared_ptr<Assembly> finalize_function_chunk(Assembly&& chunk);
     void populate_metadata_tables(const std::vector<StmtPtr>& program);
+    TreeShakeRoots collect_tree_shake_roots(const std::vector<StmtPtr>& program) const;
+    void inline_direct_calls();
+    void optimize_method_bodies();
 
     // Native binding support
     NativeCallInfo extract_native_call_attribute(const std::vector<Attribute>& attrs);
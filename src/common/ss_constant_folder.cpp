@@ -0,0 +1,607 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 29thnight
+
+/**
+ * @file ss_constant_folder.cpp
+ * @brief AST constant folding and let-constant propagation.
+ *
+ * Every fold reproduces the VM's own arithmetic: Int operations wrap, mixed
+ * Int/Float operands are widened to Float, comparisons go through Float and
+ * string concatenation uses Value::to_string().
+ */
+
+#include "pch.h"
+#include "ss_constant_folder.hpp"
+
+namespace swive {
+
+    namespace {
+        ExprPtr make_literal(Value value, uint32_t line) {
+            auto literal = std::make_unique<LiteralExpr>(value);
+            literal->line = line;
+            return literal;
+        }
+
+        ExprPtr make_string_literal(std::string text, uint32_t line) {
+            auto literal = std::make_unique<LiteralExpr>(std::move(text));
+            literal->line = line;
+            return literal;
+        }
+
+        const LiteralExpr* as_literal(const ExprPtr& expr) {
+            return expr && expr->kind == ExprKind::Literal ? static_cast<const LiteralExpr*>(expr.get()) : nullptr;
+        }
+
+        // Text the VM's string concatenation (OP_ADD) produces for a literal
+        std::string literal_text(const LiteralExpr* literal) {
+            return literal->string_value ? *literal->string_value : literal->value.to_string();
+        }
+
+        bool is_numeric(const LiteralExpr* literal) {
+            return !literal->string_value && (literal->value.is_int() || literal->value.is_float());
+        }
+
+        Float as_float(const Value& value) {
+            return value.is_int() ? static_cast<Float>(value.as_int()) : value.as_float();
+        }
+
+        // VM::is_truthy
+        bool literal_truthy(const LiteralExpr* literal) {
+            if (literal->string_value) return true;
+            if (literal->value.is_null()) return false;
+            if (literal->value.is_bool()) return literal->value.as_bool();
+            return true;
+        }
+
+        Int wrap(uint64_t bits) {
+            return static_cast<Int>(bits);
+        }
+    }
+
+    void ConstantFolder::fold(std::vector<StmtPtr>& program) {
+        scopes_.clear();
+        push_scope();
+        fold_body(program);
+        pop_scope();
+    }
+
+    void ConstantFolder::push_scope(bool barrier) {
+        scopes_.push_back(Scope{ {}, barrier });
+    }
+
+    void ConstantFolder::pop_scope() {
+        scopes_.pop_back();
+    }
+
+    void ConstantFolder::declare(const std::string& name, const LiteralExpr* constant) {
+        scopes_.back().names[name] = constant;
+    }
+
+    const LiteralExpr* ConstantFolder::lookup_constant(const std::string& name) const {
+        for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
+            auto found = it->names.find(name);
+            if (found != it->names.end()) {
+                return found->second;
+            }
+            if (it->barrier) {
+                break;
+            }
+        }
+        return nullptr;
+    }
+
+    // ============================================================================
+    // Statements
+    // ============================================================================
+
+    void ConstantFolder::fold_body(std::vector<StmtPtr>& statements) {
+        for (auto& stmt : statements) {
+            fold_stmt(stmt.get());
+        }
+    }
+
+    void ConstantFolder::fold_block(BlockStmt* block) {
+        if (!block) return;
+        push_scope();
+        fold_body(block->statements);
+        pop_scope();
+    }
+
+    void ConstantFolder::fold_function(const std::vector<ParamDecl>& params, BlockStmt* body) {
+        push_scope();
+        for (const auto& param : params) {
+            declare(param.internal_name);
+            declare(param.external_name);
+        }
+        fold_block(body);
+        pop_scope();
+    }
+
+    void ConstantFolder::fold_var_decl(VarDeclStmt* stmt, bool propagate) {
+        // Declared before the initializer is folded, as codegen declares the local first
+        declare(stmt->name);
+        fold_expr(stmt->initializer);
+
+        // Accessor and observer bodies see the implicit newValue/oldValue
+        for (BlockStmt* accessor : { stmt->getter_body.get(), stmt->setter_body.get(),
+                                     stmt->will_set_body.get(), stmt->did_set_body.get() }) {
+            if (!accessor) continue;
+            push_scope();
+            declare("newValue");
+            declare("oldValue");
+            fold_block(accessor);
+            pop_scope();
+        }
+
+        const LiteralExpr* literal = as_literal(stmt->initializer);
+        bool optional = stmt->type_annotation.has_value() && stmt->type_annotation->is_optional;
+        if (propagate && literal && stmt->is_let && !stmt->is_computed && !stmt->is_lazy && !optional) {
+            declare(stmt->name, literal);
+        }
+    }
+
+    void ConstantFolder::fold_type_members(const std::vector<std::unique_ptr<VarDeclStmt>>& properties,
+                                           const std::vector<std::unique_ptr<StructMethodDecl>>& methods) {
+        for (const auto& prop : properties) {
+            if (prop) fold_var_decl(prop.get(), false);
+        }
+        for (const auto& method : methods) {
+            if (!method) continue;
+            for (auto& param : method->params) {
+                fold_expr(param.default_value);
+            }
+            fold_function(method->params, method->body.get());
+        }
+    }
+
+    void ConstantFolder::fold_stmt(Stmt* stmt) {
+        if (!stmt) return;
+
+        switch (stmt->kind) {
+        case StmtKind::Expression:
+            fold_expr(static_cast<ExprStmt*>(stmt)->expression);
+            break;
+        case StmtKind::Print:
+            fold_expr(static_cast<PrintStmt*>(stmt)->expression);
+            break;
+        case StmtKind::Block:
+            fold_block(static_cast<BlockStmt*>(stmt));
+            break;
+        case StmtKind::VarDecl:
+            fold_var_decl(static_cast<VarDeclStmt*>(stmt));
+            break;
+        case StmtKind::TupleDestructuring: {
+            auto* destructure = static_cast<TupleDestructuringStmt*>(stmt);
+            fold_expr(destructure->initializer);
+            for (const auto& binding : destructure->bindings) {
+                declare(binding.name);
+            }
+            break;
+        }
+        case StmtKind::ClassDecl: {
+            // Bare names in member bodies may be implicit self properties, so
+            // outer constants stay out of reach behind a barrier scope
+            auto* class_decl = static_cast<ClassDeclStmt*>(stmt);
+            declare(class_decl->name);
+            push_scope(true);
+            for (const auto& prop : class_decl->properties) {
+                if (prop) fold_var_decl(prop.get(), false);
+            }
+            for (const auto& method : class_decl->methods) {
+                if (!method) continue;
+                for (auto& param : method->params) {
+                    fold_expr(param.default_value);
+                }
+                fold_function(method->params, method->body.get());
+            }
+            fold_block(class_decl->deinit_body.get());
+            pop_scope();
+            break;
+        }
+        case StmtKind::StructDecl: {
+            auto* struct_decl = static_cast<StructDeclStmt*>(stmt);
+            declare(struct_decl->name);
+            push_scope(true);
+            fold_type_members(struct_decl->properties, struct_decl->methods);
+            for (const auto& init : struct_decl->initializers) {
+                if (!init) continue;
+                for (auto& param : init->params) {
+                    fold_expr(param.default_value);
+                }
+                fold_function(init->params, init->body.get());
+            }
+            pop_scope();
+            break;
+        }
+        case StmtKind::EnumDecl: {
+            auto* enum_decl = static_cast<EnumDeclStmt*>(stmt);
+            declare(enum_decl->name);
+            push_scope(true);
+            fold_type_members({}, enum_decl->methods);
+            pop_scope();
+            break;
+        }
+        case StmtKind::ExtensionDecl: {
+            auto* ext_decl = static_cast<ExtensionDeclStmt*>(stmt);
+            push_scope(true);
+            fold_type_members({}, ext_decl->methods);
+            pop_scope();
+            break;
+        }
+        case StmtKind::ProtocolDecl:
+            declare(static_cast<ProtocolDeclStmt*>(stmt)->name);
+            break;
+        case StmtKind::If: {
+            auto* if_stmt = static_cast<IfStmt*>(stmt);
+            fold_expr(if_stmt->condition);
+            fold_stmt(if_stmt->then_branch.get());
+            fold_stmt(if_stmt->else_branch.get());
+            break;
+        }
+        case StmtKind::IfLet: {
+            auto* if_let = static_cast<IfLetStmt*>(stmt);
+            fold_expr(if_let->optional_expr);
+            push_scope();
+            declare(if_let->binding_name);
+            fold_stmt(if_let->then_branch.get());
+            pop_scope();
+            fold_stmt(if_let->else_branch.get());
+            break;
+        }
+        case StmtKind::GuardLet: {
+            auto* guard = static_cast<GuardLetStmt*>(stmt);
+            fold_expr(guard->optional_expr);
+            fold_stmt(guard->else_branch.get());
+            declare(guard->binding_name);
+            break;
+        }
+        case StmtKind::While: {
+            auto* while_stmt = static_cast<WhileStmt*>(stmt);
+            fold_expr(while_stmt->condition);
+            fold_stmt(while_stmt->body.get());
+            break;
+        }
+        case StmtKind::RepeatWhile: {
+            auto* repeat = static_cast<RepeatWhileStmt*>(stmt);
+            fold_stmt(repeat->body.get());
+            fold_expr(repeat->condition);
+            break;
+        }
+        case StmtKind::ForIn: {
+            auto* for_in = static_cast<ForInStmt*>(stmt);
+            fold_expr(for_in->iterable);
+            push_scope();
+            declare(for_in->variable);
+            fold_expr(for_in->where_condition);
+            fold_stmt(for_in->body.get());
+            pop_scope();
+            break;
+        }
+        case StmtKind::Switch: {
+            auto* switch_stmt = static_cast<SwitchStmt*>(stmt);
+            fold_expr(switch_stmt->value);
+            for (auto& clause : switch_stmt->cases) {
+                push_scope();
+                for (auto& pattern : clause.patterns) {
+                    if (!pattern) continue;
+                    if (pattern->kind == PatternKind::Expression) {
+                        fold_expr(static_cast<ExpressionPattern*>(pattern.get())->expression);
+                    } else {
+                        for (const auto& binding : static_cast<EnumCasePattern*>(pattern.get())->bindings) {
+                            declare(binding);
+                        }
+                    }
+                }
+                fold_body(clause.statements);
+                pop_scope();
+            }
+            break;
+        }
+        case StmtKind::Return:
+            fold_expr(static_cast<ReturnStmt*>(stmt)->value);
+            break;
+        case StmtKind::FuncDecl: {
+            auto* func = static_cast<FuncDeclStmt*>(stmt);
+            declare(func->name);
+            for (auto& param : func->params) {
+                fold_expr(param.default_value);
+            }
+            fold_function(func->params, func->body.get());
+            break;
+        }
+        case StmtKind::Break:
+        case StmtKind::Continue:
+        case StmtKind::Import:
+        case StmtKind::AttributeDecl:
+            break;
+        }
+    }
+
+    // ============================================================================
+    // Expressions
+    // ============================================================================
+
+    void ConstantFolder::fold_expr(ExprPtr& expr) {
+        if (!expr) return;
+
+        ExprPtr replacement;
+        switch (expr->kind) {
+        case ExprKind::Literal:
+        case ExprKind::Super:
+            break;
+        case ExprKind::Identifier: {
+            auto* id = static_cast<IdentifierExpr*>(expr.get());
+            if (id->generic_args.empty()) {
+                if (const LiteralExpr* constant = lookup_constant(id->name)) {
+                    replacement = constant->clone();
+                    replacement->line = id->line;
+                }
+            }
+            break;
+        }
+        case ExprKind::InterpolatedString: {
+            auto* interp = static_cast<InterpolatedStringExpr*>(expr.get());
+            for (auto& part : interp->parts) {
+                if (auto* part_expr = std::get_if<ExprPtr>(&part)) {
+                    fold_expr(*part_expr);
+                }
+            }
+            replacement = fold_interpolation(interp);
+            break;
+        }
+        case ExprKind::Unary: {
+            auto* unary = static_cast<UnaryExpr*>(expr.get());
+            fold_expr(unary->operand);
+            replacement = fold_unary(unary);
+            break;
+        }
+        case ExprKind::Binary: {
+            auto* binary = static_cast<BinaryExpr*>(expr.get());
+            if (binary->op != TokenType::Equal || binary->left->kind != ExprKind::Identifier) {
+                fold_expr(binary->left);
+            }
+            fold_expr(binary->right);
+            replacement = fold_binary(binary);
+            break;
+        }
+        case ExprKind::Assign:
+            fold_expr(static_cast<AssignExpr*>(expr.get())->value);
+            break;
+        case ExprKind::Call: {
+            auto* call = static_cast<CallExpr*>(expr.get());
+            if (call->callee && call->callee->kind != ExprKind::Identifier) {
+                fold_expr(call->callee);
+            }
+            for (auto& arg : call->arguments) {
+                fold_expr(arg);
+            }
+            break;
+        }
+        case ExprKind::Member:
+            fold_expr(static_cast<MemberExpr*>(expr.get())->object);
+            break;
+        case ExprKind::ForceUnwrap:
+            fold_expr(static_cast<ForceUnwrapExpr*>(expr.get())->operand);
+            break;
+        case ExprKind::OptionalChain:
+            fold_expr(static_cast<OptionalChainExpr*>(expr.get())->object);
+            break;
+        case ExprKind::NilCoalesce: {
+            auto* coalesce = static_cast<NilCoalesceExpr*>(expr.get());
+            fold_expr(coalesce->optional_expr);
+            fold_expr(coalesce->fallback);
+            break;
+        }
+        case ExprKind::Range: {
+            auto* range = static_cast<RangeExpr*>(expr.get());
+            fold_expr(range->start);
+            fold_expr(range->end);
+            break;
+        }
+        case ExprKind::Ternary: {
+            auto* ternary = static_cast<TernaryExpr*>(expr.get());
+            fold_expr(ternary->condition);
+            fold_expr(ternary->then_expr);
+            fold_expr(ternary->else_expr);
+            const LiteralExpr* condition = as_literal(ternary->condition);
+            if (condition && condition->value.is_bool() && !condition->string_value) {
+                replacement = std::move(condition->value.as_bool() ? ternary->then_expr : ternary->else_expr);
+            }
+            break;
+        }
+        case ExprKind::ArrayLiteral:
+            for (auto& element : static_cast<ArrayLiteralExpr*>(expr.get())->elements) {
+                fold_expr(element);
+            }
+            break;
+        case ExprKind::DictLiteral:
+            for (auto& [key, value] : static_cast<DictLiteralExpr*>(expr.get())->entries) {
+                fold_expr(key);
+                fold_expr(value);
+            }
+            break;
+        case ExprKind::Subscript: {
+            auto* subscript = static_cast<SubscriptExpr*>(expr.get());
+            fold_expr(subscript->object);
+            fold_expr(subscript->index);
+            break;
+        }
+        case ExprKind::Closure: {
+            auto* closure = static_cast<ClosureExpr*>(expr.get());
+            push_scope();
+            for (const auto& [name, type] : closure->params) {
+                declare(name);
+            }
+            fold_body(closure->body);
+            pop_scope();
+            break;
+        }
+        case ExprKind::TypeCast:
+            fold_expr(static_cast<TypeCastExpr*>(expr.get())->value);
+            break;
+        case ExprKind::TypeCheck:
+            fold_expr(static_cast<TypeCheckExpr*>(expr.get())->value);
+            break;
+        case ExprKind::TupleLiteral:
+            for (auto& element : static_cast<TupleLiteralExpr*>(expr.get())->elements) {
+                fold_expr(element.value);
+            }
+            break;
+        case ExprKind::TupleMember:
+            fold_expr(static_cast<TupleMemberExpr*>(expr.get())->tuple);
+            break;
+        }
+
+        if (replacement) {
+            expr = std::move(replacement);
+        }
+    }
+
+    ExprPtr ConstantFolder::fold_unary(UnaryExpr* expr) {
+        const LiteralExpr* operand = as_literal(expr->operand);
+        if (!operand || operand->string_value) {
+            return nullptr;
+        }
+        const Value& value = operand->value;
+
+        switch (expr->op) {
+        case TokenType::Minus:
+            if (value.is_int()) return make_literal(Value::from_int(wrap(0 - static_cast<uint64_t>(value.as_int()))), expr->line);
+            if (value.is_float()) return make_literal(Value::from_float(-value.as_float()), expr->line);
+            break;
+        case TokenType::Not:
+            if (value.is_bool()) return make_literal(Value::from_bool(!value.as_bool()), expr->line);
+            break;
+        case TokenType::BitwiseNot:
+            if (value.is_int()) return make_literal(Value::from_int(~value.as_int()), expr->line);
+            break;
+        default:
+            break;
+        }
+        return nullptr;
+    }
+
+    ExprPtr ConstantFolder::fold_binary(BinaryExpr* expr) {
+        const LiteralExpr* left = as_literal(expr->left);
+        const LiteralExpr* right = as_literal(expr->right);
+        if (!left || !right) {
+            return nullptr;
+        }
+        const uint32_t line = expr->line;
+
+        // OP_AND/OP_OR evaluate both sides, which are literals here
+        if (expr->op == TokenType::And) {
+            return make_literal(Value::from_bool(literal_truthy(left) && literal_truthy(right)), line);
+        }
+        if (expr->op == TokenType::Or) {
+            return make_literal(Value::from_bool(literal_truthy(left) || literal_truthy(right)), line);
+        }
+
+        if (left->string_value || right->string_value) {
+            switch (expr->op) {
+            case TokenType::Plus:
+                return make_string_literal(literal_text(left) + literal_text(right), line);
+            case TokenType::EqualEqual:
+            case TokenType::NotEqual:
+                if (left->string_value && right->string_value) {
+                    bool equal = *left->string_value == *right->string_value;
+                    return make_literal(Value::from_bool(expr->op == TokenType::EqualEqual ? equal : !equal), line);
+                }
+                return nullptr;
+            default:
+                return nullptr;
+            }
+        }
+
+        const Value& a = left->value;
+        const Value& b = right->value;
+        switch (expr->op) {
+        case TokenType::EqualEqual:
+            return make_literal(Value::from_bool(a.equals(b)), line);
+        case TokenType::NotEqual:
+            return make_literal(Value::from_bool(!a.equals(b)), line);
+        default:
+            break;
+        }
+
+        if (a.is_int() && b.is_int()) {
+            const Int x = a.as_int();
+            const Int y = b.as_int();
+            const uint64_t ux = static_cast<uint64_t>(x);
+            const uint64_t uy = static_cast<uint64_t>(y);
+            switch (expr->op) {
+            case TokenType::Plus: return make_literal(Value::from_int(wrap(ux + uy)), line);
+            case TokenType::Minus: return make_literal(Value::from_int(wrap(ux - uy)), line);
+            case TokenType::Star: return make_literal(Value::from_int(wrap(ux * uy)), line);
+            case TokenType::Slash:
+            case TokenType::Percent:
+                // The VM traps on these; leave them for runtime
+                if (y == 0 || (x == std::numeric_limits<Int>::min() && y == -1)) {
+                    return nullptr;
+                }
+                return make_literal(Value::from_int(expr->op == TokenType::Slash ? x / y : x % y), line);
+            case TokenType::BitwiseAnd: return make_literal(Value::from_int(x & y), line);
+            case TokenType::BitwiseOr: return make_literal(Value::from_int(x | y), line);
+            case TokenType::BitwiseXor: return make_literal(Value::from_int(x ^ y), line);
+            case TokenType::LeftShift:
+            case TokenType::RightShift:
+                if (y < 0 || y >= 64) {
+                    return nullptr;
+                }
+                return make_literal(Value::from_int(expr->op == TokenType::LeftShift ? wrap(ux << y) : x >> y), line);
+            default:
+                break;
+            }
+        }
+
+        if (!is_numeric(left) || !is_numeric(right)) {
+            return nullptr;
+        }
+
+        const Float fa = as_float(a);
+        const Float fb = as_float(b);
+        switch (expr->op) {
+        case TokenType::Plus: return make_literal(Value::from_float(fa + fb), line);
+        case TokenType::Minus: return make_literal(Value::from_float(fa - fb), line);
+        case TokenType::Star: return make_literal(Value::from_float(fa * fb), line);
+        case TokenType::Slash: return make_literal(Value::from_float(fa / fb), line);
+        case TokenType::Less: return make_literal(Value::from_bool(fa < fb), line);
+        case TokenType::Greater: return make_literal(Value::from_bool(fa > fb), line);
+        case TokenType::LessEqual: return make_literal(Value::from_bool(fa <= fb), line);
+        case TokenType::GreaterEqual: return make_literal(Value::from_bool(fa >= fb), line);
+        default:
+            return nullptr;
+        }
+    }
+
+    ExprPtr ConstantFolder::fold_interpolation(InterpolatedStringExpr* expr) {
+        // Merge runs of text and literal parts; a fully literal string becomes one literal
+        std::vector<std::variant<std::string, ExprPtr>> merged;
+        for (auto& part : expr->parts) {
+            std::string text;
+            if (auto* str = std::get_if<std::string>(&part)) {
+                text = std::move(*str);
+            } else if (const LiteralExpr* literal = as_literal(std::get<ExprPtr>(part))) {
+                text = literal_text(literal);
+            } else {
+                merged.push_back(std::move(part));
+                continue;
+            }
+            if (!merged.empty() && std::holds_alternative<std::string>(merged.back())) {
+                std::get<std::string>(merged.back()) += text;
+            } else {
+                merged.emplace_back(std::move(text));
+            }
+        }
+        expr->parts = std::move(merged);
+
+        if (expr->parts.empty()) {
+            return make_string_literal("", expr->line);
+        }
+        if (expr->parts.size() == 1 && std::holds_alternative<std::string>(expr->parts.front())) {
+            return make_string_literal(std::move(std::get<std::string>(expr->parts.front())), expr->line);
+        }
+        return nullptr;
+    }
+
+} // namespace swive
@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 29thnight
+
+/**
+ * @file ss_constant_folder.hpp
+ * @brief AST constant folding and let-constant propagation.
+ *
+ * Runs between the TypeChecker and code generation. Literal arithmetic,
+ * comparison, logical, bitwise and string operations are evaluated at compile
+ * time, and reads of `let` constants bound to literals are replaced with the
+ * literal. Results match what the VM would compute; operations the VM would
+ * trap on (integer division by zero, out-of-range shifts) are left alone.
+ */
+
+#pragma once
+
+#include "ss_ast.hpp"
+
+namespace swive {
+
+class ConstantFolder {
+public:
+    void fold(std::vector<StmtPtr>& program);
+
+private:
+    // One lexical scope. A name maps to its literal when it is a propagatable
+    // `let`, or to nullptr when it shadows outer constants. A barrier scope
+    // (type member bodies, where bare names may resolve to implicit self
+    // properties) stops lookups from reaching outer scopes.
+    struct Scope {
+        std::unordered_map<std::string, const LiteralExpr*> names;
+        bool barrier{false};
+    };
+    std::vector<Scope> scopes_;
+
+    void push_scope(bool barrier = false);
+    void pop_scope();
+    void declare(const std::string& name, const LiteralExpr* constant = nullptr);
+    const LiteralExpr* lookup_constant(const std::string& name) const;
+
+    void fold_stmt(Stmt* stmt);
+    void fold_block(BlockStmt* block);
+    void fold_body(std::vector<StmtPtr>& statements);
+    void fold_function(const std::vector<ParamDecl>& params, BlockStmt* body);
+    void fold_var_decl(VarDeclStmt* stmt, bool propagate = true);  // Stored properties pass false
+    void fold_type_members(const std::vector<std::unique_ptr<VarDeclStmt>>& properties,
+                           const std::vector<std::unique_ptr<StructMethodDecl>>& methods);
+    void fold_expr(ExprPtr& expr);
+
+    ExprPtr fold_unary(UnaryExpr* expr);
+    ExprPtr fold_binary(BinaryExpr* expr);
+    ExprPtr fold_interpolation(InterpolatedStringExpr* expr);
+};
+
+} // namespace swive
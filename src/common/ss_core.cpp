@@ -59,7 +59,11 @@ void RC::execute_deinit_if_needed(VM* vm, Object* obj) {
 void RC::release_children(VM* vm, Object* obj) {
     if (obj->type == ObjectType::List) {
         auto* list = static_cast<ListObject*>(obj);
-        for (auto& elem : list->elements) {
+        // A buffer still shared with another list keeps its references
+        if (!list->is_unique()) {
+            return;
+        }
+        for (auto& elem : list->buffer->elements) {
             if (elem.is_object() && elem.ref_type() == RefType::Strong) {
                 Object* child = elem.as_object();
                 if (child && !child->rc.is_dead) {
@@ -69,7 +73,10 @@ void RC::release_children(VM* vm, Object* obj) {
         }
     } else if (obj->type == ObjectType::Map) {
         auto* map = static_cast<MapObject*>(obj);
-        for (auto& [key, value] : map->entries) {
+        if (!map->is_unique()) {
+            return;
+        }
+        for (auto& [key, value] : map->buffer->entries) {
             if (value.is_object() && value.ref_type() == RefType::Strong) {
                 Object* child = value.as_object();
                 if (child && !child->rc.is_dead) {
@@ -77,6 +84,19 @@ void RC::release_children(VM* vm, Object* obj) {
                 }
             }
         }
+    } else if (obj->type == ObjectType::Set) {
+        auto* set = static_cast<SetObject*>(obj);
+        if (!set->is_unique()) {
+            return;
+        }
+        for (auto& elem : set->buffer->elements) {
+            if (elem.is_object() && elem.ref_type() == RefType::Strong) {
+                Object* child = elem.as_object();
+                if (child && !child->rc.is_dead) {
+                    RC::release(vm, child);
+                }
+            }
+        }
     } else if (obj->type == ObjectType::Class) {
         auto* klass = static_cast<ClassObject*>(obj);
         for (auto& [key, value] : klass->methods) {
@@ -30,6 +30,7 @@ enum class ObjectType : uint8_t {
     String,
     List,
     Map,
+    Set,             // Hash set (builtin Set collection)
     Function,
     Closure,
     Class,
@@ -55,6 +56,7 @@ inline const char* object_type_name(ObjectType t) {
         case ObjectType::String:   return "String";
         case ObjectType::List:     return "List";
         case ObjectType::Map:      return "Map";
+        case ObjectType::Set:      return "Set";
         case ObjectType::Function: return "Function";
         case ObjectType::Closure:  return "Closure";
         case ObjectType::Class:    return "Class";
@@ -249,7 +249,7 @@ std::vector<DebugFrame> DebugController::get_stack_trace(VM& vm) const {
     if (current_body) {
         DebugFrame top;
         if (!call_frames.empty()) {
-            top.function_name = call_frames.back().function_name;
+            top.function_name = call_frames.back().function_name();
             top.frame_index = call_frames.size() - 1;
         } else {
             // Top-level: use SIZE_MAX as sentinel so get_locals() takes the
@@ -274,7 +274,7 @@ std::vector<DebugFrame> DebugController::get_stack_trace(VM& vm) const {
     for (int i = static_cast<int>(call_frames.size()) - 2; i >= 0; --i) {
         const CallFrame& cf = call_frames[i];
         DebugFrame frame;
-        frame.function_name = cf.function_name;
+        frame.function_name = cf.function_name();
         frame.frame_index = static_cast<size_t>(i);
 
         // Get line from return address in the caller's chunk
@@ -385,7 +385,7 @@ DebugFrame DebugController::build_current_frame(VM& vm, size_t ip,
     const auto& call_frames = vm.call_frames();
 
     if (!call_frames.empty()) {
-        frame.function_name = call_frames.back().function_name;
+        frame.function_name = call_frames.back().function_name();
         frame.frame_index = call_frames.size() - 1;
     } else {
         frame.function_name = "<top-level>";
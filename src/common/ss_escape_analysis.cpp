@@ -0,0 +1,922 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 29thnight
+
+/**
+ * @file ss_escape_analysis.cpp
+ * @brief Escape analysis and scalar replacement of struct and tuple locals.
+ *
+ * A candidate escapes as soon as its name appears anywhere other than as the
+ * object of a field read or field assignment: passed, returned, copied,
+ * captured by a closure or nested declaration, called through, or shadowed.
+ * Hidden field locals are named "$<local>$<field>", which no source
+ * identifier can collide with.
+ */
+
+#include "pch.h"
+#include "ss_escape_analysis.hpp"
+
+namespace swive {
+
+    namespace {
+        ExprPtr make_identifier(const std::string& name, uint32_t line) {
+            auto identifier = std::make_unique<IdentifierExpr>(name);
+            identifier->line = line;
+            return identifier;
+        }
+
+        bool is_identifier(const ExprPtr& expr, const std::string& name) {
+            return expr && expr->kind == ExprKind::Identifier &&
+                   static_cast<const IdentifierExpr*>(expr.get())->name == name;
+        }
+
+        // The local being split and the hidden local of each field
+        struct Candidate {
+            std::string name;
+            std::vector<std::string> fields;  // Property names, or tuple labels ("" when unlabeled)
+            std::vector<std::string> hidden;
+            bool is_tuple{false};
+            bool is_mutable{false};
+
+            size_t field_index(const std::string& member) const {
+                for (size_t i = 0; i < fields.size(); ++i) {
+                    if (!member.empty() && fields[i] == member) return i;
+                }
+                return fields.size();
+            }
+        };
+
+        // Walks the candidate's scope. In check mode it only decides whether
+        // the candidate escapes; in rewrite mode it also turns field accesses
+        // into hidden locals.
+        class UseWalker {
+        public:
+            UseWalker(const Candidate& candidate, bool rewrite)
+                : candidate_(candidate), rewrite_(rewrite) {}
+
+            bool escaped() const { return escaped_; }
+
+            void walk_body(std::vector<StmtPtr>& statements, size_t first = 0) {
+                for (size_t i = first; i < statements.size() && !escaped_; ++i) {
+                    walk_stmt(statements[i].get());
+                }
+            }
+
+            void walk_expr(ExprPtr& expr) {
+                if (!expr || escaped_) return;
+
+                switch (expr->kind) {
+                case ExprKind::Literal:
+                case ExprKind::Super:
+                    break;
+                case ExprKind::Identifier:
+                    note_name(static_cast<IdentifierExpr*>(expr.get())->name);
+                    break;
+                case ExprKind::InterpolatedString:
+                    for (auto& part : static_cast<InterpolatedStringExpr*>(expr.get())->parts) {
+                        if (auto* part_expr = std::get_if<ExprPtr>(&part)) {
+                            walk_expr(*part_expr);
+                        }
+                    }
+                    break;
+                case ExprKind::Unary:
+                    walk_expr(static_cast<UnaryExpr*>(expr.get())->operand);
+                    break;
+                case ExprKind::Binary: {
+                    auto* binary = static_cast<BinaryExpr*>(expr.get());
+                    size_t field = member_field(binary->left);
+                    if (binary->op == TokenType::Equal && field < candidate_.fields.size()) {
+                        if (!candidate_.is_mutable || captured_ > 0) {
+                            escaped_ = true;
+                            return;
+                        }
+                        walk_expr(binary->right);
+                        if (rewrite_) {
+                            auto assign = std::make_unique<AssignExpr>(candidate_.hidden[field], std::move(binary->right));
+                            assign->line = binary->line;
+                            expr = std::move(assign);
+                        }
+                        return;
+                    }
+                    walk_expr(binary->left);
+                    walk_expr(binary->right);
+                    break;
+                }
+                case ExprKind::Assign: {
+                    auto* assign = static_cast<AssignExpr*>(expr.get());
+                    note_name(assign->name);
+                    walk_expr(assign->value);
+                    break;
+                }
+                case ExprKind::Call: {
+                    auto* call = static_cast<CallExpr*>(expr.get());
+                    // A field called as p.f() would dispatch as a method
+                    if (member_field(call->callee) < candidate_.fields.size()) {
+                        escaped_ = true;
+                        return;
+                    }
+                    walk_expr(call->callee);
+                    for (auto& arg : call->arguments) {
+                        walk_expr(arg);
+                    }
+                    break;
+                }
+                case ExprKind::Member:
+                case ExprKind::TupleMember: {
+                    size_t field = member_field(expr);
+                    if (field < candidate_.fields.size()) {
+                        if (captured_ > 0) {
+                            escaped_ = true;
+                        } else if (rewrite_) {
+                            expr = make_identifier(candidate_.hidden[field], expr->line);
+                        }
+                        return;
+                    }
+                    if (expr->kind == ExprKind::Member) {
+                        walk_expr(static_cast<MemberExpr*>(expr.get())->object);
+                    } else {
+                        walk_expr(static_cast<TupleMemberExpr*>(expr.get())->tuple);
+                    }
+                    break;
+                }
+                case ExprKind::ForceUnwrap:
+                    walk_expr(static_cast<ForceUnwrapExpr*>(expr.get())->operand);
+                    break;
+                case ExprKind::OptionalChain:
+                    walk_expr(static_cast<OptionalChainExpr*>(expr.get())->object);
+                    break;
+                case ExprKind::NilCoalesce: {
+                    auto* coalesce = static_cast<NilCoalesceExpr*>(expr.get());
+                    walk_expr(coalesce->optional_expr);
+                    walk_expr(coalesce->fallback);
+                    break;
+                }
+                case ExprKind::Range: {
+                    auto* range = static_cast<RangeExpr*>(expr.get());
+                    walk_expr(range->start);
+                    walk_expr(range->end);
+                    break;
+                }
+                case ExprKind::Ternary: {
+                    auto* ternary = static_cast<TernaryExpr*>(expr.get());
+                    walk_expr(ternary->condition);
+                    walk_expr(ternary->then_expr);
+                    walk_expr(ternary->else_expr);
+                    break;
+                }
+                case ExprKind::ArrayLiteral:
+                    for (auto& element : static_cast<ArrayLiteralExpr*>(expr.get())->elements) {
+                        walk_expr(element);
+                    }
+                    break;
+                case ExprKind::DictLiteral:
+                    for (auto& [key, value] : static_cast<DictLiteralExpr*>(expr.get())->entries) {
+                        walk_expr(key);
+                        walk_expr(value);
+                    }
+                    break;
+                case ExprKind::Subscript: {
+                    auto* subscript = static_cast<SubscriptExpr*>(expr.get());
+                    walk_expr(subscript->object);
+                    walk_expr(subscript->index);
+                    break;
+                }
+                case ExprKind::Closure: {
+                    auto* closure = static_cast<ClosureExpr*>(expr.get());
+                    for (const auto& [name, type] : closure->params) {
+                        note_name(name);
+                    }
+                    ++captured_;
+                    walk_body(closure->body);
+                    --captured_;
+                    break;
+                }
+                case ExprKind::TypeCast:
+                    walk_expr(static_cast<TypeCastExpr*>(expr.get())->value);
+                    break;
+                case ExprKind::TypeCheck:
+                    walk_expr(static_cast<TypeCheckExpr*>(expr.get())->value);
+                    break;
+                case ExprKind::TupleLiteral:
+                    for (auto& element : static_cast<TupleLiteralExpr*>(expr.get())->elements) {
+                        walk_expr(element.value);
+                    }
+                    break;
+                }
+            }
+
+        private:
+            const Candidate& candidate_;
+            bool rewrite_;
+            bool escaped_{false};
+            int captured_{0};  // Inside a closure or nested declaration
+
+            // Any other appearance of the name (use, assignment, shadowing)
+            void note_name(const std::string& name) {
+                if (name == candidate_.name) {
+                    escaped_ = true;
+                }
+            }
+
+            // Field of the candidate that expr reads, or fields.size()
+            size_t member_field(const ExprPtr& expr) const {
+                if (!expr) return candidate_.fields.size();
+                if (expr->kind == ExprKind::Member) {
+                    auto* member = static_cast<const MemberExpr*>(expr.get());
+                    if (is_identifier(member->object, candidate_.name)) {
+                        return candidate_.field_index(member->member);
+                    }
+                } else if (expr->kind == ExprKind::TupleMember && candidate_.is_tuple) {
+                    auto* member = static_cast<const TupleMemberExpr*>(expr.get());
+                    if (is_identifier(member->tuple, candidate_.name)) {
+                        if (const size_t* index = std::get_if<size_t>(&member->member)) {
+                            return std::min(*index, candidate_.fields.size());
+                        }
+                        return candidate_.field_index(std::get<std::string>(member->member));
+                    }
+                }
+                return candidate_.fields.size();
+            }
+
+            void walk_function(const std::vector<ParamDecl>& params, BlockStmt* body) {
+                for (const auto& param : params) {
+                    note_name(param.internal_name);
+                }
+                ++captured_;
+                walk_stmt(body);
+                --captured_;
+            }
+
+            void walk_var_decl(VarDeclStmt* decl) {
+                note_name(decl->name);
+                walk_expr(decl->initializer);
+                ++captured_;
+                for (BlockStmt* accessor : { decl->getter_body.get(), decl->setter_body.get(),
+                                             decl->will_set_body.get(), decl->did_set_body.get() }) {
+                    walk_stmt(accessor);
+                }
+                --captured_;
+            }
+
+            void walk_type_members(const std::vector<std::unique_ptr<VarDeclStmt>>& properties,
+                                   const std::vector<std::unique_ptr<StructMethodDecl>>& methods) {
+                ++captured_;
+                for (const auto& prop : properties) {
+                    if (prop) walk_var_decl(prop.get());
+                }
+                for (const auto& method : methods) {
+                    if (method) walk_function(method->params, method->body.get());
+                }
+                --captured_;
+            }
+
+            void walk_stmt(Stmt* stmt) {
+                if (!stmt || escaped_) return;
+
+                switch (stmt->kind) {
+                case StmtKind::Expression:
+                    walk_expr(static_cast<ExprStmt*>(stmt)->expression);
+                    break;
+                case StmtKind::Print:
+                    walk_expr(static_cast<PrintStmt*>(stmt)->expression);
+                    break;
+                case StmtKind::Block:
+                    walk_body(static_cast<BlockStmt*>(stmt)->statements);
+                    break;
+                case StmtKind::VarDecl:
+                    walk_var_decl(static_cast<VarDeclStmt*>(stmt));
+                    break;
+                case StmtKind::TupleDestructuring: {
+                    auto* destructure = static_cast<TupleDestructuringStmt*>(stmt);
+                    walk_expr(destructure->initializer);
+                    for (const auto& binding : destructure->bindings) {
+                        note_name(binding.name);
+                    }
+                    break;
+                }
+                case StmtKind::ClassDecl: {
+                    auto* class_decl = static_cast<ClassDeclStmt*>(stmt);
+                    note_name(class_decl->name);
+                    ++captured_;
+                    for (const auto& prop : class_decl->properties) {
+                        if (prop) walk_var_decl(prop.get());
+                    }
+                    for (const auto& method : class_decl->methods) {
+                        if (method) walk_function(method->params, method->body.get());
+                    }
+                    walk_stmt(class_decl->deinit_body.get());
+                    --captured_;
+                    break;
+                }
+                case StmtKind::StructDecl: {
+                    auto* struct_decl = static_cast<StructDeclStmt*>(stmt);
+                    note_name(struct_decl->name);
+                    walk_type_members(struct_decl->properties, struct_decl->methods);
+                    ++captured_;
+                    for (const auto& init : struct_decl->initializers) {
+                        if (init) walk_function(init->params, init->body.get());
+                    }
+                    --captured_;
+                    break;
+                }
+                case StmtKind::EnumDecl: {
+                    auto* enum_decl = static_cast<EnumDeclStmt*>(stmt);
+                    note_name(enum_decl->name);
+                    walk_type_members({}, enum_decl->methods);
+                    break;
+                }
+                case StmtKind::ExtensionDecl:
+                    walk_type_members({}, static_cast<ExtensionDeclStmt*>(stmt)->methods);
+                    break;
+                case StmtKind::ProtocolDecl:
+                    note_name(static_cast<ProtocolDeclStmt*>(stmt)->name);
+                    break;
+                case StmtKind::If: {
+                    auto* if_stmt = static_cast<IfStmt*>(stmt);
+                    walk_expr(if_stmt->condition);
+                    walk_stmt(if_stmt->then_branch.get());
+                    walk_stmt(if_stmt->else_branch.get());
+                    break;
+                }
+                case StmtKind::IfLet: {
+                    auto* if_let = static_cast<IfLetStmt*>(stmt);
+                    walk_expr(if_let->optional_expr);
+                    note_name(if_let->binding_name);
+                    walk_stmt(if_let->then_branch.get());
+                    walk_stmt(if_let->else_branch.get());
+                    break;
+                }
+                case StmtKind::GuardLet: {
+                    auto* guard = static_cast<GuardLetStmt*>(stmt);
+                    walk_expr(guard->optional_expr);
+                    note_name(guard->binding_name);
+                    walk_stmt(guard->else_branch.get());
+                    break;
+                }
+                case StmtKind::While: {
+                    auto* while_stmt = static_cast<WhileStmt*>(stmt);
+                    walk_expr(while_stmt->condition);
+                    walk_stmt(while_stmt->body.get());
+                    break;
+                }
+                case StmtKind::RepeatWhile: {
+                    auto* repeat = static_cast<RepeatWhileStmt*>(stmt);
+                    walk_stmt(repeat->body.get());
+                    walk_expr(repeat->condition);
+                    break;
+                }
+                case StmtKind::ForIn: {
+                    auto* for_in = static_cast<ForInStmt*>(stmt);
+                    walk_expr(for_in->iterable);
+                    note_name(for_in->variable);
+                    walk_expr(for_in->where_condition);
+                    walk_stmt(for_in->body.get());
+                    break;
+                }
+                case StmtKind::Switch: {
+                    auto* switch_stmt = static_cast<SwitchStmt*>(stmt);
+                    walk_expr(switch_stmt->value);
+                    for (auto& clause : switch_stmt->cases) {
+                        for (auto& pattern : clause.patterns) {
+                            if (!pattern) continue;
+                            if (pattern->kind == PatternKind::Expression) {
+                                walk_expr(static_cast<ExpressionPattern*>(pattern.get())->expression);
+                            } else {
+                                for (const auto& binding : static_cast<EnumCasePattern*>(pattern.get())->bindings) {
+                                    note_name(binding);
+                                }
+                            }
+                        }
+                        walk_body(clause.statements);
+                    }
+                    break;
+                }
+                case StmtKind::Return:
+                    walk_expr(static_cast<ReturnStmt*>(stmt)->value);
+                    break;
+                case StmtKind::FuncDecl: {
+                    auto* func = static_cast<FuncDeclStmt*>(stmt);
+                    note_name(func->name);
+                    walk_function(func->params, func->body.get());
+                    break;
+                }
+                case StmtKind::Break:
+                case StmtKind::Continue:
+                case StmtKind::Import:
+                case StmtKind::AttributeDecl:
+                    break;
+                }
+            }
+        };
+
+        bool mentions(ExprPtr& expr, const std::string& name) {
+            Candidate probe;
+            probe.name = name;
+            UseWalker walker(probe, false);
+            walker.walk_expr(expr);
+            return walker.escaped();
+        }
+
+        // Field stored by one statement of a trivial init, as (field, parameter)
+        std::optional<std::pair<std::string, std::string>> init_assignment(const Stmt* stmt) {
+            if (!stmt || stmt->kind != StmtKind::Expression) return std::nullopt;
+            const Expr* expr = static_cast<const ExprStmt*>(stmt)->expression.get();
+            if (!expr) return std::nullopt;
+            const ExprPtr* value = nullptr;
+            std::string field;
+            if (expr->kind == ExprKind::Binary) {
+                auto* binary = static_cast<const BinaryExpr*>(expr);
+                if (binary->op != TokenType::Equal || !binary->left || binary->left->kind != ExprKind::Member) {
+                    return std::nullopt;
+                }
+                auto* member = static_cast<const MemberExpr*>(binary->left.get());
+                if (!is_identifier(member->object, "self")) return std::nullopt;
+                field = member->member;
+                value = &binary->right;
+            } else if (expr->kind == ExprKind::Assign) {
+                auto* assign = static_cast<const AssignExpr*>(expr);
+                if (assign->op != TokenType::Equal) return std::nullopt;
+                field = assign->name;  // Implicit self property
+                value = &assign->value;
+            } else {
+                return std::nullopt;
+            }
+            if (!*value || (*value)->kind != ExprKind::Identifier) return std::nullopt;
+            auto* param = static_cast<const IdentifierExpr*>(value->get());
+            if (!param->generic_args.empty()) return std::nullopt;
+            return std::make_pair(field, param->name);
+        }
+    }
+
+    // ============================================================================
+    // Struct shapes
+    // ============================================================================
+
+    void EscapeAnalyzer::collect_structs(const std::vector<StmtPtr>& program) {
+        structs_.clear();
+        std::unordered_set<std::string> extended_inits;
+        for (const auto& stmt : program) {
+            if (!stmt || stmt->kind != StmtKind::ExtensionDecl) continue;
+            auto* ext = static_cast<const ExtensionDeclStmt*>(stmt.get());
+            for (const auto& method : ext->methods) {
+                if (method && method->name == "init") {
+                    extended_inits.insert(ext->extended_type);
+                }
+            }
+        }
+
+        for (const auto& stmt : program) {
+            if (!stmt || stmt->kind != StmtKind::StructDecl) continue;
+            auto* decl = static_cast<const StructDeclStmt*>(stmt.get());
+            if (!decl->generic_params.empty() || decl->initializers.size() > 1 ||
+                extended_inits.count(decl->name)) {
+                continue;
+            }
+
+            StructShape shape;
+            bool supported = true;
+            for (const auto& prop : decl->properties) {
+                if (!prop || prop->is_static || prop->is_computed) continue;
+                // Observers and lazy storage run code on stores and reads
+                if (prop->is_lazy || prop->will_set_body || prop->did_set_body) {
+                    supported = false;
+                    break;
+                }
+                const LiteralExpr* literal = prop->initializer && prop->initializer->kind == ExprKind::Literal
+                    ? static_cast<const LiteralExpr*>(prop->initializer.get())
+                    : nullptr;
+                shape.fields.push_back(prop->name);
+                shape.defaults.push_back(literal);
+                shape.has_default.push_back(!prop->initializer || literal);
+            }
+            if (!supported || shape.fields.empty()) continue;
+
+            if (!decl->initializers.empty()) {
+                const FuncDeclStmt* init = decl->initializers.front().get();
+                if (!init || !init->body || init->expected_error_type) continue;
+                std::unordered_map<std::string, size_t> param_index;
+                for (size_t i = 0; i < init->params.size(); ++i) {
+                    param_index[init->params[i].internal_name] = i;
+                }
+                constexpr size_t kUnassigned = std::numeric_limits<size_t>::max();
+                shape.init_field_of_param.assign(init->params.size(), kUnassigned);
+                std::vector<bool> assigned(shape.fields.size(), false);
+                for (const auto& body_stmt : init->body->statements) {
+                    auto assignment = init_assignment(body_stmt.get());
+                    auto param = assignment ? param_index.find(assignment->second) : param_index.end();
+                    size_t field = 0;
+                    while (assignment && field < shape.fields.size() && shape.fields[field] != assignment->first) {
+                        ++field;
+                    }
+                    // `x = x` names the parameter, not the implicit property
+                    bool implicit_self_shadowed = assignment && param_index.count(assignment->first) &&
+                        body_stmt->kind == StmtKind::Expression &&
+                        static_cast<const ExprStmt*>(body_stmt.get())->expression->kind == ExprKind::Assign;
+                    if (!assignment || param == param_index.end() || field == shape.fields.size() ||
+                        assigned[field] || shape.init_field_of_param[param->second] != kUnassigned ||
+                        implicit_self_shadowed) {
+                        supported = false;
+                        break;
+                    }
+                    assigned[field] = true;
+                    shape.init_field_of_param[param->second] = field;
+                }
+                for (size_t param = 0; supported && param < shape.init_field_of_param.size(); ++param) {
+                    supported = shape.init_field_of_param[param] != kUnassigned;
+                }
+                for (size_t field = 0; supported && field < shape.fields.size(); ++field) {
+                    supported = assigned[field] || shape.has_default[field];
+                }
+                if (!supported) continue;
+                shape.init = init;
+            }
+            structs_[decl->name] = std::move(shape);
+        }
+    }
+
+    // ============================================================================
+    // Candidates
+    // ============================================================================
+
+    void EscapeAnalyzer::run(std::vector<StmtPtr>& program) {
+        stats_ = EscapeStats{};
+        collect_structs(program);
+        // Top-level bindings are globals, visible to every function; only
+        // statements nested below them are searched for candidates
+        for (auto& stmt : program) {
+            process_stmt(stmt.get());
+        }
+    }
+
+    void EscapeAnalyzer::process_body(std::vector<StmtPtr>& statements) {
+        for (size_t i = 0; i < statements.size();) {
+            // A replaced local's first field may itself be a candidate
+            if (try_replace(statements, i) || try_replace_destructuring(statements, i)) {
+                continue;
+            }
+            process_stmt(statements[i].get());
+            ++i;
+        }
+    }
+
+    bool EscapeAnalyzer::try_replace(std::vector<StmtPtr>& statements, size_t index) {
+        Stmt* stmt = statements[index].get();
+        if (!stmt || stmt->kind != StmtKind::VarDecl) return false;
+        auto* decl = static_cast<VarDeclStmt*>(stmt);
+        if (!decl->initializer || decl->is_static || decl->is_computed || decl->is_lazy ||
+            decl->will_set_body || decl->did_set_body ||
+            (decl->type_annotation && decl->type_annotation->is_optional)) {
+            return false;
+        }
+
+        Candidate candidate;
+        candidate.name = decl->name;
+        candidate.is_mutable = !decl->is_let;
+        // Field values in evaluation order, as (field, expression)
+        std::vector<std::pair<size_t, ExprPtr*>> sources;
+        std::vector<ExprPtr> defaults;
+
+        if (decl->initializer->kind == ExprKind::TupleLiteral) {
+            auto* tuple = static_cast<TupleLiteralExpr*>(decl->initializer.get());
+            if (tuple->elements.empty()) return false;
+            candidate.is_tuple = true;
+            for (size_t i = 0; i < tuple->elements.size(); ++i) {
+                candidate.fields.push_back(tuple->elements[i].label.value_or(""));
+                sources.emplace_back(i, &tuple->elements[i].value);
+            }
+        } else if (decl->initializer->kind == ExprKind::Call) {
+            auto* call = static_cast<CallExpr*>(decl->initializer.get());
+            if (!call->callee || call->callee->kind != ExprKind::Identifier) return false;
+            auto* callee = static_cast<IdentifierExpr*>(call->callee.get());
+            auto found = structs_.find(callee->name);
+            if (!callee->generic_args.empty() || found == structs_.end()) return false;
+            const StructShape* shape = &found->second;
+            candidate.fields = shape->fields;
+            defaults.reserve(shape->fields.size());  // sources point into it
+
+            auto label = [&](size_t i) -> std::string {
+                return i < call->argument_names.size() ? call->argument_names[i] : std::string();
+            };
+            std::vector<bool> provided(shape->fields.size(), false);
+            if (shape->init) {
+                const auto& params = shape->init->params;
+                if (call->arguments.size() != params.size()) return false;
+                for (size_t i = 0; i < params.size(); ++i) {
+                    if (label(i) != params[i].external_name) return false;
+                    size_t field = shape->init_field_of_param[i];
+                    provided[field] = true;
+                    sources.emplace_back(field, &call->arguments[i]);
+                }
+            } else if (!call->arguments.empty()) {
+                // Memberwise: the VM binds arguments to properties by position
+                if (call->arguments.size() != shape->fields.size()) return false;
+                for (size_t i = 0; i < call->arguments.size(); ++i) {
+                    if (!label(i).empty() && label(i) != shape->fields[i]) return false;
+                    provided[i] = true;
+                    sources.emplace_back(i, &call->arguments[i]);
+                }
+            }
+            for (size_t field = 0; field < shape->fields.size(); ++field) {
+                if (provided[field]) continue;
+                if (!shape->has_default[field]) return false;
+                ExprPtr value = shape->defaults[field] ? shape->defaults[field]->clone()
+                                                       : std::make_unique<LiteralExpr>(Value::null());
+                value->line = decl->line;
+                defaults.push_back(std::move(value));
+                sources.emplace_back(field, &defaults.back());
+            }
+        } else {
+            return false;
+        }
+
+        for (size_t i = 0; i < candidate.fields.size(); ++i) {
+            std::string suffix = candidate.is_tuple ? std::to_string(i) : candidate.fields[i];
+            candidate.hidden.push_back("$" + candidate.name + "$" + suffix);
+        }
+
+        UseWalker check(candidate, false);
+        check.walk_body(statements, index + 1);
+        if (check.escaped()) return false;
+        UseWalker rewrite(candidate, true);
+        rewrite.walk_body(statements, index + 1);
+
+        std::vector<StmtPtr> fields;
+        fields.reserve(sources.size());
+        for (auto& [field, value] : sources) {
+            auto hidden = std::make_unique<VarDeclStmt>();
+            hidden->line = decl->line;
+            hidden->name = candidate.hidden[field];
+            hidden->is_let = decl->is_let;
+            hidden->initializer = std::move(*value);
+            fields.push_back(std::move(hidden));
+        }
+
+        ++(candidate.is_tuple ? stats_.tuples_replaced : stats_.structs_replaced);
+        stats_.fields += fields.size();
+        statements.erase(statements.begin() + static_cast<long>(index));
+        statements.insert(statements.begin() + static_cast<long>(index),
+                          std::make_move_iterator(fields.begin()), std::make_move_iterator(fields.end()));
+        return true;
+    }
+
+    bool EscapeAnalyzer::try_replace_destructuring(std::vector<StmtPtr>& statements, size_t index) {
+        Stmt* stmt = statements[index].get();
+        if (!stmt || stmt->kind != StmtKind::TupleDestructuring) return false;
+        auto* destructure = static_cast<TupleDestructuringStmt*>(stmt);
+        if (!destructure->initializer || destructure->initializer->kind != ExprKind::TupleLiteral) return false;
+        auto* tuple = static_cast<TupleLiteralExpr*>(destructure->initializer.get());
+        if (tuple->elements.size() != destructure->bindings.size()) return false;
+
+        for (size_t i = 0; i < tuple->elements.size(); ++i) {
+            const auto& binding = destructure->bindings[i];
+            if (binding.label && binding.label != tuple->elements[i].label) return false;
+            // Every element is evaluated before any binding exists: (a, b) = (b, a)
+            for (const auto& other : destructure->bindings) {
+                if (mentions(tuple->elements[i].value, other.name)) return false;
+            }
+        }
+
+        std::vector<StmtPtr> bindings;
+        for (size_t i = 0; i < tuple->elements.size(); ++i) {
+            auto binding = std::make_unique<VarDeclStmt>();
+            binding->line = destructure->line;
+            binding->name = destructure->bindings[i].name;
+            binding->is_let = destructure->is_let;
+            binding->initializer = std::move(tuple->elements[i].value);
+            bindings.push_back(std::move(binding));
+        }
+
+        ++stats_.destructures_replaced;
+        statements.erase(statements.begin() + static_cast<long>(index));
+        statements.insert(statements.begin() + static_cast<long>(index),
+                          std::make_move_iterator(bindings.begin()), std::make_move_iterator(bindings.end()));
+        return true;
+    }
+
+    // ============================================================================
+    // Traversal
+    // ============================================================================
+
+    void EscapeAnalyzer::process_stmt(Stmt* stmt) {
+        if (!stmt) return;
+
+        switch (stmt->kind) {
+        case StmtKind::Expression:
+            process_expr(static_cast<ExprStmt*>(stmt)->expression.get());
+            break;
+        case StmtKind::Print:
+            process_expr(static_cast<PrintStmt*>(stmt)->expression.get());
+            break;
+        case StmtKind::Block:
+            process_body(static_cast<BlockStmt*>(stmt)->statements);
+            break;
+        case StmtKind::VarDecl: {
+            auto* decl = static_cast<VarDeclStmt*>(stmt);
+            process_expr(decl->initializer.get());
+            for (BlockStmt* accessor : { decl->getter_body.get(), decl->setter_body.get(),
+                                         decl->will_set_body.get(), decl->did_set_body.get() }) {
+                process_stmt(accessor);
+            }
+            break;
+        }
+        case StmtKind::TupleDestructuring:
+            process_expr(static_cast<TupleDestructuringStmt*>(stmt)->initializer.get());
+            break;
+        case StmtKind::ClassDecl: {
+            auto* class_decl = static_cast<ClassDeclStmt*>(stmt);
+            for (const auto& prop : class_decl->properties) {
+                process_stmt(prop.get());
+            }
+            for (const auto& method : class_decl->methods) {
+                process_stmt(method.get());
+            }
+            process_stmt(class_decl->deinit_body.get());
+            break;
+        }
+        case StmtKind::StructDecl: {
+            auto* struct_decl = static_cast<StructDeclStmt*>(stmt);
+            for (const auto& prop : struct_decl->properties) {
+                process_stmt(prop.get());
+            }
+            for (const auto& method : struct_decl->methods) {
+                if (method) process_stmt(method->body.get());
+            }
+            for (const auto& init : struct_decl->initializers) {
+                process_stmt(init.get());
+            }
+            break;
+        }
+        case StmtKind::EnumDecl:
+            for (const auto& method : static_cast<EnumDeclStmt*>(stmt)->methods) {
+                if (method) process_stmt(method->body.get());
+            }
+            break;
+        case StmtKind::ExtensionDecl:
+            for (const auto& method : static_cast<ExtensionDeclStmt*>(stmt)->methods) {
+                if (method) process_stmt(method->body.get());
+            }
+            break;
+        case StmtKind::If: {
+            auto* if_stmt = static_cast<IfStmt*>(stmt);
+            process_expr(if_stmt->condition.get());
+            process_stmt(if_stmt->then_branch.get());
+            process_stmt(if_stmt->else_branch.get());
+            break;
+        }
+        case StmtKind::IfLet: {
+            auto* if_let = static_cast<IfLetStmt*>(stmt);
+            process_expr(if_let->optional_expr.get());
+            process_stmt(if_let->then_branch.get());
+            process_stmt(if_let->else_branch.get());
+            break;
+        }
+        case StmtKind::GuardLet: {
+            auto* guard = static_cast<GuardLetStmt*>(stmt);
+            process_expr(guard->optional_expr.get());
+            process_stmt(guard->else_branch.get());
+            break;
+        }
+        case StmtKind::While: {
+            auto* while_stmt = static_cast<WhileStmt*>(stmt);
+            process_expr(while_stmt->condition.get());
+            process_stmt(while_stmt->body.get());
+            break;
+        }
+        case StmtKind::RepeatWhile: {
+            auto* repeat = static_cast<RepeatWhileStmt*>(stmt);
+            process_stmt(repeat->body.get());
+            process_expr(repeat->condition.get());
+            break;
+        }
+        case StmtKind::ForIn: {
+            auto* for_in = static_cast<ForInStmt*>(stmt);
+            process_expr(for_in->iterable.get());
+            process_expr(for_in->where_condition.get());
+            process_stmt(for_in->body.get());
+            break;
+        }
+        case StmtKind::Switch: {
+            auto* switch_stmt = static_cast<SwitchStmt*>(stmt);
+            process_expr(switch_stmt->value.get());
+            for (auto& clause : switch_stmt->cases) {
+                process_body(clause.statements);
+            }
+            break;
+        }
+        case StmtKind::Return:
+            process_expr(static_cast<ReturnStmt*>(stmt)->value.get());
+            break;
+        case StmtKind::FuncDecl:
+            process_stmt(static_cast<FuncDeclStmt*>(stmt)->body.get());
+            break;
+        case StmtKind::Break:
+        case StmtKind::Continue:
+        case StmtKind::Import:
+        case StmtKind::ProtocolDecl:
+        case StmtKind::AttributeDecl:
+            break;
+        }
+    }
+
+    // Only closures hold statements inside an expression
+    void EscapeAnalyzer::process_expr(Expr* expr) {
+        if (!expr) return;
+
+        switch (expr->kind) {
+        case ExprKind::Literal:
+        case ExprKind::Identifier:
+        case ExprKind::Super:
+            break;
+        case ExprKind::InterpolatedString:
+            for (auto& part : static_cast<InterpolatedStringExpr*>(expr)->parts) {
+                if (auto* part_expr = std::get_if<ExprPtr>(&part)) {
+                    process_expr(part_expr->get());
+                }
+            }
+            break;
+        case ExprKind::Unary:
+            process_expr(static_cast<UnaryExpr*>(expr)->operand.get());
+            break;
+        case ExprKind::Binary:
+            process_expr(static_cast<BinaryExpr*>(expr)->left.get());
+            process_expr(static_cast<BinaryExpr*>(expr)->right.get());
+            break;
+        case ExprKind::Assign:
+            process_expr(static_cast<AssignExpr*>(expr)->value.get());
+            break;
+        case ExprKind::Call: {
+            auto* call = static_cast<CallExpr*>(expr);
+            process_expr(call->callee.get());
+            for (auto& arg : call->arguments) {
+                process_expr(arg.get());
+            }
+            break;
+        }
+        case ExprKind::Member:
+            process_expr(static_cast<MemberExpr*>(expr)->object.get());
+            break;
+        case ExprKind::ForceUnwrap:
+            process_expr(static_cast<ForceUnwrapExpr*>(expr)->operand.get());
+            break;
+        case ExprKind::OptionalChain:
+            process_expr(static_cast<OptionalChainExpr*>(expr)->object.get());
+            break;
+        case ExprKind::NilCoalesce:
+            process_expr(static_cast<NilCoalesceExpr*>(expr)->optional_expr.get());
+            process_expr(static_cast<NilCoalesceExpr*>(expr)->fallback.get());
+            break;
+        case ExprKind::Range:
+            process_expr(static_cast<RangeExpr*>(expr)->start.get());
+            process_expr(static_cast<RangeExpr*>(expr)->end.get());
+            break;
+        case ExprKind::Ternary: {
+            auto* ternary = static_cast<TernaryExpr*>(expr);
+            process_expr(ternary->condition.get());
+            process_expr(ternary->then_expr.get());
+            process_expr(ternary->else_expr.get());
+            break;
+        }
+        case ExprKind::ArrayLiteral:
+            for (auto& element : static_cast<ArrayLiteralExpr*>(expr)->elements) {
+                process_expr(element.get());
+            }
+            break;
+        case ExprKind::DictLiteral:
+            for (auto& [key, value] : static_cast<DictLiteralExpr*>(expr)->entries) {
+                process_expr(key.get());
+                process_expr(value.get());
+            }
+            break;
+        case ExprKind::Subscript:
+            process_expr(static_cast<SubscriptExpr*>(expr)->object.get());
+            process_expr(static_cast<SubscriptExpr*>(expr)->index.get());
+            break;
+        case ExprKind::Closure:
+            process_body(static_cast<ClosureExpr*>(expr)->body);
+            break;
+        case ExprKind::TypeCast:
+            process_expr(static_cast<TypeCastExpr*>(expr)->value.get());
+            break;
+        case ExprKind::TypeCheck:
+            process_expr(static_cast<TypeCheckExpr*>(expr)->value.get());
+            break;
+        case ExprKind::TupleLiteral:
+            for (auto& element : static_cast<TupleLiteralExpr*>(expr)->elements) {
+                process_expr(element.value.get());
+            }
+            break;
+        case ExprKind::TupleMember:
+            process_expr(static_cast<TupleMemberExpr*>(expr)->tuple.get());
+            break;
+        }
+    }
+
+    void EscapeStats::print(std::ostream& out) const {
+        out << "\n=== Swive Escape Analysis ===\n";
+        out << "Structs Replaced: " << std::setw(10) << structs_replaced << "\n";
+        out << "Tuples Replaced:  " << std::setw(10) << tuples_replaced << "\n";
+        out << "Destructures:     " << std::setw(10) << destructures_replaced << "\n";
+        out << "Field Locals:     " << std::setw(10) << fields << "\n";
+        out << "=============================\n";
+    }
+
+} // namespace swive
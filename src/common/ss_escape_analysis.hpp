@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 29thnight
+
+/**
+ * @file ss_escape_analysis.hpp
+ * @brief Escape analysis and scalar replacement of struct and tuple locals.
+ *
+ * Runs after constant folding in Release builds. A local bound to a struct
+ * construction or a tuple literal whose every later use is a read or write
+ * of one of its fields never escapes the function, so it is split into one
+ * hidden local per field and the heap object is never created.
+ */
+
+#pragma once
+
+#include "ss_ast.hpp"
+
+namespace swive {
+
+struct EscapeStats {
+    size_t structs_replaced{0};
+    size_t tuples_replaced{0};
+    size_t destructures_replaced{0};  // let (a, b) = (x, y)
+    size_t fields{0};                 // Hidden locals introduced
+
+    void print(std::ostream& out) const;
+};
+
+class EscapeAnalyzer {
+public:
+    void run(std::vector<StmtPtr>& program);
+    const EscapeStats& stats() const { return stats_; }
+
+private:
+    // Non-generic struct whose construction can be replayed field by field:
+    // the memberwise initializer, or a single init that only assigns
+    // parameters to stored properties.
+    struct StructShape {
+        std::vector<std::string> fields;               // Stored properties in declaration order
+        std::vector<const LiteralExpr*> defaults;      // Literal default per field, or null
+        std::vector<bool> has_default;                 // False when the default is not a literal
+        const FuncDeclStmt* init{nullptr};
+        std::vector<size_t> init_field_of_param;       // Field each init parameter is stored to
+    };
+    std::unordered_map<std::string, StructShape> structs_;
+    EscapeStats stats_;
+
+    void collect_structs(const std::vector<StmtPtr>& program);
+
+    void process_stmt(Stmt* stmt);
+    void process_body(std::vector<StmtPtr>& statements);
+    void process_expr(Expr* expr);
+
+    // Replaces statements[index] with per-field locals when it binds a
+    // non-escaping candidate; returns true when it did
+    bool try_replace(std::vector<StmtPtr>& statements, size_t index);
+    bool try_replace_destructuring(std::vector<StmtPtr>& statements, size_t index);
+};
+
+} // namespace swive
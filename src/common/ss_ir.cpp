@@ -0,0 +1,723 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 29thnight
+
+/**
+ * @file ss_ir.cpp
+ * @brief Lifting, analysis, lowering and pass management for the SSA mid-end.
+ *
+ * Blocks keep their instructions as encoded bytes; jumps refer to block
+ * indices until lowering recomputes every distance. analyze() replays the
+ * operand stack of each block and names every stack position with an SSA
+ * value, which is what the passes in ss_ir_passes.cpp reason about.
+ */
+
+#include "pch.h"
+#include "ss_ir.hpp"
+
+namespace swive {
+
+    namespace {
+        constexpr size_t kMaxRounds = 4;
+
+        uint16_t read_operand(const std::vector<uint8_t>& code, size_t offset) {
+            return static_cast<uint16_t>((code[offset] << 8) | code[offset + 1]);
+        }
+
+        void write_operand(std::vector<uint8_t>& code, size_t offset, uint16_t value) {
+            code[offset] = static_cast<uint8_t>((value >> 8) & 0xFF);
+            code[offset + 1] = static_cast<uint8_t>(value & 0xFF);
+        }
+
+        bool starts_with(const std::string& text, const char* prefix) {
+            return text.rfind(prefix, 0) == 0;
+        }
+
+        bool ends_with(const std::string& text, const std::string& suffix) {
+            return text.size() >= suffix.size() &&
+                   text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+        }
+
+        bool is_native_op(OpCode op) {
+            switch (op) {
+                case OpCode::OP_NATIVE_CALL:
+                case OpCode::OP_NATIVE_CONSTRUCT:
+                case OpCode::OP_NATIVE_GET_PROPERTY:
+                case OpCode::OP_NATIVE_SET_PROPERTY:
+                case OpCode::OP_NATIVE_METHOD_CALL:
+                case OpCode::OP_SET_NATIVE_TYPE:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // Ops that may dispatch to a user-defined operator method
+        bool is_overloadable_op(OpCode op) {
+            switch (op) {
+                case OpCode::OP_ADD: case OpCode::OP_SUBTRACT: case OpCode::OP_MULTIPLY:
+                case OpCode::OP_DIVIDE: case OpCode::OP_MODULO: case OpCode::OP_NEGATE:
+                case OpCode::OP_BITWISE_NOT: case OpCode::OP_BITWISE_AND: case OpCode::OP_BITWISE_OR:
+                case OpCode::OP_BITWISE_XOR: case OpCode::OP_LEFT_SHIFT: case OpCode::OP_RIGHT_SHIFT:
+                case OpCode::OP_EQUAL: case OpCode::OP_NOT_EQUAL: case OpCode::OP_LESS:
+                case OpCode::OP_GREATER: case OpCode::OP_LESS_EQUAL: case OpCode::OP_GREATER_EQUAL:
+                case OpCode::OP_NOT: case OpCode::OP_AND: case OpCode::OP_OR:
+                case OpCode::OP_CONTAINS:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+    }
+
+    IRInstruction IRInstruction::make(OpCode op, uint32_t line) {
+        IRInstruction instruction;
+        instruction.bytes = {static_cast<uint8_t>(op)};
+        instruction.lines = {line};
+        return instruction;
+    }
+
+    IRInstruction IRInstruction::make(OpCode op, uint16_t operand, uint32_t line) {
+        IRInstruction instruction;
+        instruction.bytes = {static_cast<uint8_t>(op), 0, 0};
+        instruction.set_operand(operand);
+        instruction.lines.assign(3, line);
+        return instruction;
+    }
+
+    // ------------------------------------------------------------------------
+    // Module facts
+    // ------------------------------------------------------------------------
+
+    IRModuleFacts IRModuleFacts::collect(const Assembly& root) {
+        IRModuleFacts facts;
+        auto note = [&facts](const std::string& name) {
+            if (name.empty()) return;
+            if (starts_with(name, "get:") || starts_with(name, "set:")) {
+                facts.accessors.insert(name.substr(4));
+            } else if (starts_with(name, "$get_") || starts_with(name, "$set_")) {
+                facts.accessors.insert(name.substr(5));
+            } else if (ends_with(name, "_willSet")) {
+                facts.accessors.insert(name.substr(0, name.size() - 8));
+            } else if (ends_with(name, "_didSet")) {
+                facts.accessors.insert(name.substr(0, name.size() - 7));
+            } else if (std::string_view("+-*/%=<>!&|^~").find(name[0]) != std::string_view::npos) {
+                facts.has_operator_overloads = true;
+            }
+        };
+
+        std::unordered_set<const Assembly*> visited{&root};
+        std::vector<const Assembly*> pending{&root};
+        while (!pending.empty()) {
+            const Assembly* assembly = pending.back();
+            pending.pop_back();
+            for (const auto& def : assembly->method_definitions) {
+                if (def.name < assembly->string_table.size()) {
+                    note(assembly->string_table[def.name]);
+                }
+            }
+            for (const auto& body : assembly->method_bodies) {
+                const auto& code = body.bytecode;
+                for (size_t offset = 0; offset < code.size() && !facts.has_natives;) {
+                    facts.has_natives = is_native_op(static_cast<OpCode>(code[offset]));
+                    size_t length = instruction_length(code, offset);
+                    if (length == 0) break;
+                    offset += length;
+                }
+            }
+            for (const auto& proto : assembly->function_prototypes) {
+                note(proto.name);
+                if (proto.chunk && visited.insert(proto.chunk.get()).second) {
+                    pending.push_back(proto.chunk.get());
+                }
+            }
+        }
+        return facts;
+    }
+
+    // ------------------------------------------------------------------------
+    // Lifting
+    // ------------------------------------------------------------------------
+
+    bool IRFunction::build(const MethodBody& body, const Assembly& owner_assembly,
+                           const IRModuleFacts& module_facts) {
+        owner = &owner_assembly;
+        facts = &module_facts;
+        frame_slots = body.frame_slots;
+        blocks.clear();
+        values.clear();
+
+        const auto& code = body.bytecode;
+        if (code.empty() || body.line_info.size() != code.size() || body.debug_info) {
+            return false;
+        }
+
+        constexpr size_t kNotInstruction = std::numeric_limits<size_t>::max();
+        std::vector<size_t> index_at(code.size() + 1, kNotInstruction);
+        std::vector<size_t> offsets;
+        for (size_t offset = 0; offset < code.size();) {
+            OpCode op = static_cast<OpCode>(code[offset]);
+            // Captured locals are aliased by upvalues, which the stack model
+            // cannot see
+            if (op == OpCode::OP_CLOSURE || op == OpCode::OP_CLOSE_UPVALUE) {
+                return false;
+            }
+            size_t length = instruction_length(code, offset);
+            if (length == 0 || offset + length > code.size()) {
+                return false;
+            }
+            index_at[offset] = offsets.size();
+            offsets.push_back(offset);
+            offset += length;
+        }
+        index_at[code.size()] = offsets.size();
+
+        // Leaders: the entry, every jump target and every instruction after a
+        // jump or terminator
+        std::vector<std::vector<size_t>> targets(offsets.size());
+        std::vector<bool> leader(offsets.size() + 1, false);
+        leader[0] = true;
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            size_t offset = offsets[i];
+            size_t next = i + 1 < offsets.size() ? offsets[i + 1] : code.size();
+            bool backward = static_cast<OpCode>(code[offset]) == OpCode::OP_LOOP;
+            for (size_t operand : jump_operand_offsets(code, offset)) {
+                size_t distance = read_operand(code, operand);
+                if (backward ? distance > next : next + distance > code.size()) {
+                    return false;
+                }
+                size_t target = backward ? next - distance : next + distance;
+                if (index_at[target] == kNotInstruction) {
+                    return false;
+                }
+                targets[i].push_back(index_at[target]);
+                leader[index_at[target]] = true;
+            }
+            if (!targets[i].empty() || is_block_terminator(static_cast<OpCode>(code[offset]))) {
+                leader[i + 1] = true;
+            }
+        }
+
+        std::vector<size_t> block_of(offsets.size() + 1);
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            if (leader[i]) {
+                blocks.emplace_back();
+            }
+            block_of[i] = blocks.size() - 1;
+        }
+        block_of[offsets.size()] = blocks.size();
+
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            size_t offset = offsets[i];
+            size_t next = i + 1 < offsets.size() ? offsets[i + 1] : code.size();
+            IRInstruction instruction;
+            instruction.bytes.assign(code.begin() + static_cast<long>(offset), code.begin() + static_cast<long>(next));
+            instruction.lines.assign(body.line_info.begin() + static_cast<long>(offset),
+                                     body.line_info.begin() + static_cast<long>(next));
+            for (size_t target : targets[i]) {
+                instruction.targets.push_back(block_of[target]);
+            }
+            blocks[block_of[i]].instructions.push_back(std::move(instruction));
+        }
+
+        return analyze();
+    }
+
+    // ------------------------------------------------------------------------
+    // Analysis
+    // ------------------------------------------------------------------------
+
+    IRValue IRFunction::new_value(IRValueKind kind, size_t block, size_t index, IRValue copy_of) {
+        IRValueInfo info;
+        info.kind = kind;
+        info.block = block;
+        info.index = index;
+        info.copy_of = copy_of;
+        values.push_back(info);
+        return static_cast<IRValue>(values.size() - 1);
+    }
+
+    bool IRFunction::simulate(size_t block_index, size_t index, std::vector<IRValue>& stack) {
+        IRInstruction& instruction = blocks[block_index].instructions[index];
+        instruction.stack = stack;
+        instruction.args.clear();
+        instruction.results.clear();
+        instruction.reads = kNoIRValue;
+
+        auto read = [&](IRValue value) {
+            instruction.reads = value;
+            ++values[value].uses;
+        };
+        auto copy = [&](IRValue source) {
+            read(source);
+            IRValue result = new_value(IRValueKind::Result, block_index, index, source);
+            instruction.results.push_back(result);
+            stack.push_back(result);
+        };
+
+        switch (instruction.op()) {
+            case OpCode::OP_GET_LOCAL: {
+                size_t slot = instruction.operand();
+                if (slot >= stack.size()) return false;
+                copy(stack[slot]);
+                return true;
+            }
+            case OpCode::OP_GET_LOCAL_MOVE: {
+                size_t slot = instruction.operand();
+                if (slot >= stack.size()) return false;
+                copy(stack[slot]);
+                // The slot no longer owns the value
+                stack[slot] = new_value(IRValueKind::Result, block_index, index);
+                return true;
+            }
+            case OpCode::OP_PICK: {
+                size_t depth = instruction.operand();
+                if (depth >= stack.size()) return false;
+                copy(stack[stack.size() - 1 - depth]);
+                return true;
+            }
+            case OpCode::OP_DUP:
+                if (stack.empty()) return false;
+                copy(stack.back());
+                return true;
+            case OpCode::OP_SET_LOCAL: {
+                size_t slot = instruction.operand();
+                if (stack.empty() || slot >= stack.size()) return false;
+                read(stack.back());
+                stack[slot] = stack.back();
+                return true;
+            }
+            case OpCode::OP_POP_UNDER: {
+                size_t count = instruction.operand();
+                if (count + 1 > stack.size()) return false;
+                auto first = stack.end() - 1 - static_cast<long>(count);
+                instruction.args.assign(first, stack.end() - 1);
+                for (IRValue value : instruction.args) {
+                    ++values[value].uses;
+                }
+                stack.erase(first, stack.end() - 1);
+                return true;
+            }
+            case OpCode::OP_FOR_ARRAY_NEXT:
+            case OpCode::OP_FOR_RANGE_NEXT: {
+                // Reads the sequence (or counter) and its cursor (or bound),
+                // then rewrites the stepped slot and the loop variable
+                size_t slot = instruction.operand();
+                if (slot + 2 >= stack.size()) return false;
+                ++values[stack[slot]].uses;
+                ++values[stack[slot + 1]].uses;
+                size_t stepped = instruction.op() == OpCode::OP_FOR_ARRAY_NEXT ? slot + 1 : slot;
+                stack[stepped] = new_value(IRValueKind::Result, block_index, index);
+                stack[slot + 2] = new_value(IRValueKind::Result, block_index, index);
+                return true;
+            }
+            case OpCode::OP_JUMP_IF_FALSE:
+            case OpCode::OP_JUMP_IF_TRUE:
+            case OpCode::OP_JUMP_IF_NIL:
+            case OpCode::OP_SET_GLOBAL:
+            case OpCode::OP_SET_UPVALUE:
+                // Inspect the top without popping (OP_JUMP_IF_NIL pops only on
+                // its taken edge; see edge_state)
+                if (stack.empty()) return false;
+                read(stack.back());
+                return true;
+            case OpCode::OP_JUMP:
+            case OpCode::OP_LOOP:
+            case OpCode::OP_HALT:
+                return true;
+            default:
+                break;
+        }
+
+        StackEffect effect = instruction_stack_effect(instruction.bytes, 0);
+        if (effect.pops == 0 && effect.pushes == 0) {
+            // Unary ops and property reads replace the top value
+            effect = {1, 1};
+        }
+        if (effect.pops > stack.size()) return false;
+        auto first = stack.end() - static_cast<long>(effect.pops);
+        instruction.args.assign(first, stack.end());
+        for (IRValue value : instruction.args) {
+            ++values[value].uses;
+        }
+        stack.erase(first, stack.end());
+        for (uint32_t i = 0; i < effect.pushes; ++i) {
+            IRValue result = new_value(IRValueKind::Result, block_index, index);
+            instruction.results.push_back(result);
+            stack.push_back(result);
+        }
+        return true;
+    }
+
+    bool IRFunction::analyze() {
+        values.clear();
+        const size_t count = blocks.size();
+        if (count == 0) return false;
+
+        for (auto& block : blocks) {
+            block.successors.clear();
+            block.predecessors.clear();
+            block.entry.clear();
+            block.exit.clear();
+            block.reachable = false;
+        }
+        for (size_t b = 0; b < count; ++b) {
+            auto& block = blocks[b];
+            auto link = [&](size_t successor) {
+                if (successor < count &&
+                    std::find(block.successors.begin(), block.successors.end(), successor) == block.successors.end()) {
+                    block.successors.push_back(successor);
+                }
+            };
+            bool falls_through = true;
+            for (size_t i = 0; i < block.instructions.size(); ++i) {
+                const auto& instruction = block.instructions[i];
+                bool last = i + 1 == block.instructions.size();
+                if (!last && (!instruction.targets.empty() || is_block_terminator(instruction.op()))) {
+                    return false;  // Control transfer inside a block
+                }
+                if (last) {
+                    for (size_t target : instruction.targets) {
+                        if (target > count) return false;
+                        link(target);
+                    }
+                    falls_through = !is_block_terminator(instruction.op());
+                }
+            }
+            if (falls_through) {
+                link(b + 1);
+            }
+            for (size_t successor : block.successors) {
+                blocks[successor].predecessors.push_back(b);
+            }
+        }
+
+        std::vector<size_t> worklist{0};
+        blocks[0].reachable = true;
+        while (!worklist.empty()) {
+            size_t b = worklist.back();
+            worklist.pop_back();
+            for (size_t successor : blocks[b].successors) {
+                if (!blocks[successor].reachable) {
+                    blocks[successor].reachable = true;
+                    worklist.push_back(successor);
+                }
+            }
+        }
+
+        // The stack a predecessor hands to a successor. OP_JUMP_IF_NIL leaves
+        // one value fewer on its taken edge.
+        auto edge_state = [&](size_t from, size_t to, std::vector<IRValue>& state) {
+            const auto& block = blocks[from];
+            state = block.exit;
+            if (block.instructions.empty()) return true;
+            const auto& last = block.instructions.back();
+            if (last.op() != OpCode::OP_JUMP_IF_NIL) return true;
+            bool taken = std::find(last.targets.begin(), last.targets.end(), to) != last.targets.end();
+            if (!taken) return true;
+            if (to == from + 1 || state.empty()) return false;
+            state.pop_back();
+            return true;
+        };
+
+        // Blocks are visited in layout order; one whose predecessors are not
+        // all visited yet (a loop header) starts from fresh phis
+        std::vector<bool> done(count, false);
+        std::vector<IRValue> state;
+        size_t remaining = 0;
+        for (const auto& block : blocks) {
+            remaining += block.reachable ? 1 : 0;
+        }
+        for (bool progress = true; remaining > 0 && progress;) {
+            progress = false;
+            for (size_t b = 0; b < count; ++b) {
+                auto& block = blocks[b];
+                if (!block.reachable || done[b]) continue;
+
+                std::vector<std::vector<IRValue>> incoming;
+                bool all_done = true;
+                if (b == 0) {
+                    std::vector<IRValue> params;
+                    for (uint32_t slot = 0; slot < frame_slots; ++slot) {
+                        params.push_back(new_value(IRValueKind::Param, 0, 0));
+                    }
+                    incoming.push_back(std::move(params));
+                }
+                for (size_t predecessor : block.predecessors) {
+                    if (!blocks[predecessor].reachable) continue;
+                    if (!done[predecessor]) {
+                        all_done = false;
+                        continue;
+                    }
+                    if (!edge_state(predecessor, b, state)) return false;
+                    incoming.push_back(state);
+                }
+                if (incoming.empty()) continue;
+
+                size_t depth = incoming.front().size();
+                for (const auto& other : incoming) {
+                    if (other.size() != depth) return false;
+                }
+                for (size_t position = 0; position < depth; ++position) {
+                    IRValue value = incoming.front()[position];
+                    bool agree = all_done;
+                    for (size_t k = 1; agree && k < incoming.size(); ++k) {
+                        agree = incoming[k][position] == value;
+                    }
+                    block.entry.push_back(agree ? value : new_value(IRValueKind::Phi, b, 0));
+                }
+
+                std::vector<IRValue> stack = block.entry;
+                for (size_t i = 0; i < block.instructions.size(); ++i) {
+                    if (!simulate(b, i, stack)) return false;
+                }
+                block.exit = std::move(stack);
+                done[b] = true;
+                --remaining;
+                progress = true;
+            }
+        }
+        if (remaining > 0) return false;
+
+        // Heights must agree on every edge, including back edges into phis
+        for (size_t b = 0; b < count; ++b) {
+            auto& block = blocks[b];
+            if (!block.reachable) continue;
+            for (size_t predecessor : block.predecessors) {
+                if (!blocks[predecessor].reachable) continue;
+                if (!edge_state(predecessor, b, state) || state.size() != block.entry.size()) return false;
+            }
+            if (!block.successors.empty()) {
+                for (IRValue value : block.exit) {
+                    ++values[value].uses;  // Live into a successor
+                }
+            }
+        }
+        return true;
+    }
+
+    IRValue IRFunction::resolve(IRValue value) const {
+        while (values[value].copy_of != kNoIRValue) {
+            value = values[value].copy_of;
+        }
+        return value;
+    }
+
+    size_t IRFunction::tree_start(size_t block, size_t index) const {
+        const auto& instruction = blocks[block].instructions[index];
+        if (instruction.results.size() != 1 || instruction.op() == OpCode::OP_GET_LOCAL_MOVE) {
+            return npos;
+        }
+        size_t start = index;
+        for (size_t k = instruction.args.size(); k-- > 0;) {
+            const auto& info = values[instruction.args[k]];
+            if (info.kind != IRValueKind::Result || info.block != block || start == 0 || info.index != start - 1) {
+                return npos;
+            }
+            start = tree_start(block, info.index);
+            if (start == npos) return npos;
+        }
+        return start;
+    }
+
+    IREffect IRFunction::effect(const IRInstruction& instruction) const {
+        OpCode op = instruction.op();
+        if (is_overloadable_op(op)) {
+            return facts->has_operator_overloads ? IREffect::Unknown : IREffect::Pure;
+        }
+        auto name = [&]() -> const std::string* {
+            uint16_t index = instruction.operand();
+            return index < owner->string_table.size() ? &owner->string_table[index] : nullptr;
+        };
+        auto is_accessor = [&]() {
+            const std::string* property = name();
+            return !property || facts->accessors.count(*property) > 0;
+        };
+
+        switch (op) {
+            case OpCode::OP_GET_LOCAL: case OpCode::OP_PICK: case OpCode::OP_DUP:
+            case OpCode::OP_POP: case OpCode::OP_POP_N: case OpCode::OP_POP_UNDER:
+            case OpCode::OP_JUMP: case OpCode::OP_JUMP_IF_FALSE: case OpCode::OP_JUMP_IF_TRUE:
+            case OpCode::OP_JUMP_IF_NIL: case OpCode::OP_LOOP: case OpCode::OP_SWITCH_TABLE:
+            case OpCode::OP_RETURN: case OpCode::OP_HALT:
+                return IREffect::None;
+            case OpCode::OP_CONSTANT: case OpCode::OP_STRING: case OpCode::OP_NIL:
+            case OpCode::OP_CONSTANT_LONG: case OpCode::OP_STRING_LONG:
+            case OpCode::OP_TRUE: case OpCode::OP_FALSE: case OpCode::OP_NIL_COALESCE:
+            case OpCode::OP_TYPE_CHECK: case OpCode::OP_MATCH_ENUM_CASE: case OpCode::OP_GET_ASSOCIATED:
+            case OpCode::OP_UNWRAP:
+                return IREffect::Pure;
+            case OpCode::OP_GET_PROPERTY:
+                return facts->has_natives || is_accessor() ? IREffect::Unknown : IREffect::HeapRead;
+            case OpCode::OP_GET_SUBSCRIPT: case OpCode::OP_GET_TUPLE_INDEX:
+            case OpCode::OP_GET_TUPLE_LABEL: case OpCode::OP_GET_UPVALUE:
+                return IREffect::HeapRead;
+            case OpCode::OP_GET_GLOBAL:
+                return is_accessor() ? IREffect::Unknown : IREffect::GlobalRead;
+            case OpCode::OP_SET_GLOBAL:
+                return is_accessor() ? IREffect::Unknown : IREffect::GlobalWrite;
+            case OpCode::OP_DEFINE_GLOBAL:
+                return IREffect::GlobalWrite;
+            case OpCode::OP_SET_LOCAL: case OpCode::OP_GET_LOCAL_MOVE: case OpCode::OP_FOR_RANGE_NEXT:
+                return IREffect::LocalWrite;
+            case OpCode::OP_SET_PROPERTY:
+                return facts->has_natives || is_accessor() ? IREffect::Unknown : IREffect::HeapWrite;
+            case OpCode::OP_SET_SUBSCRIPT: case OpCode::OP_SET_UPVALUE:
+                return IREffect::HeapWrite;
+            case OpCode::OP_PRINT:
+                return IREffect::Output;
+            case OpCode::OP_ARRAY: case OpCode::OP_DICT: case OpCode::OP_SET_LITERAL:
+            case OpCode::OP_TUPLE: case OpCode::OP_RANGE_INCLUSIVE: case OpCode::OP_RANGE_EXCLUSIVE:
+            case OpCode::OP_FUNCTION: case OpCode::OP_COPY_VALUE: case OpCode::OP_TYPE_CAST:
+            case OpCode::OP_TYPE_CAST_OPTIONAL: case OpCode::OP_TYPE_CAST_FORCED:
+                return IREffect::Alloc;
+            default:
+                return IREffect::Unknown;
+        }
+    }
+
+    void IRFunction::insert_block(size_t index) {
+        for (auto& block : blocks) {
+            for (auto& instruction : block.instructions) {
+                for (auto& target : instruction.targets) {
+                    if (target >= index) ++target;
+                }
+            }
+        }
+        blocks.insert(blocks.begin() + static_cast<long>(index), IRBlock{});
+    }
+
+    size_t IRFunction::instruction_count() const {
+        size_t total = 0;
+        for (const auto& block : blocks) {
+            total += block.instructions.size();
+        }
+        return total;
+    }
+
+    // ------------------------------------------------------------------------
+    // Lowering
+    // ------------------------------------------------------------------------
+
+    bool IRFunction::lower(MethodBody& body) const {
+        std::vector<size_t> block_offset(blocks.size() + 1);
+        size_t size = 0;
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            block_offset[b] = size;
+            for (const auto& instruction : blocks[b].instructions) {
+                size += instruction.bytes.size();
+            }
+        }
+        block_offset[blocks.size()] = size;
+
+        std::vector<uint8_t> out;
+        std::vector<uint32_t> lines;
+        out.reserve(size);
+        lines.reserve(size);
+        for (const auto& block : blocks) {
+            for (const auto& instruction : block.instructions) {
+                std::vector<uint8_t> bytes = instruction.bytes;
+                size_t next = out.size() + bytes.size();
+                std::vector<size_t> operands = jump_operand_offsets(bytes, 0);
+                if (operands.size() != instruction.targets.size()) {
+                    return false;
+                }
+                bool backward = instruction.op() == OpCode::OP_LOOP;
+                for (size_t k = 0; k < operands.size(); ++k) {
+                    size_t target = block_offset[instruction.targets[k]];
+                    size_t distance = backward ? next - target : target - next;
+                    if ((backward ? target > next : target < next) ||
+                        distance > std::numeric_limits<uint16_t>::max()) {
+                        return false;
+                    }
+                    write_operand(bytes, operands[k], static_cast<uint16_t>(distance));
+                }
+                out.insert(out.end(), bytes.begin(), bytes.end());
+                lines.insert(lines.end(), instruction.lines.begin(), instruction.lines.end());
+            }
+        }
+
+        body.bytecode = std::move(out);
+        body.line_info = std::move(lines);
+        body.max_stack_depth = compute_max_stack_depth(body.bytecode);
+        return true;
+    }
+
+    // ------------------------------------------------------------------------
+    // Pass manager
+    // ------------------------------------------------------------------------
+
+    void IRPassManager::add(std::unique_ptr<IRPass> pass) {
+        stats_.rewrites.emplace_back(pass->name(), 0);
+        passes_.push_back(std::move(pass));
+    }
+
+    bool IRPassManager::run(MethodBody& body, const Assembly& owner, const IRModuleFacts& facts) {
+        IRFunction function;
+        if (!function.build(body, owner, facts)) {
+            ++stats_.skipped;
+            return false;
+        }
+
+        size_t before = function.instruction_count();
+        std::vector<size_t> rewrites(passes_.size(), 0);
+        bool changed_any = false;
+        for (size_t round = 0; round < kMaxRounds; ++round) {
+            bool changed = false;
+            for (size_t k = 0; k < passes_.size(); ++k) {
+                size_t count = passes_[k]->run(function);
+                if (count == 0) continue;
+                if (!function.analyze()) {
+                    ++stats_.skipped;
+                    return false;
+                }
+                rewrites[k] += count;
+                changed = true;
+            }
+            changed_any |= changed;
+            if (!changed) break;
+        }
+
+        MethodBody lowered;
+        if (changed_any && !function.lower(lowered)) {
+            ++stats_.skipped;
+            return false;
+        }
+
+        ++stats_.functions;
+        stats_.instructions_before += before;
+        stats_.instructions_after += function.instruction_count();
+        for (size_t k = 0; k < passes_.size(); ++k) {
+            stats_.rewrites[k].second += rewrites[k];
+        }
+        if (changed_any) {
+            body.bytecode = std::move(lowered.bytecode);
+            body.line_info = std::move(lowered.line_info);
+            body.max_stack_depth = lowered.max_stack_depth;
+        }
+        return true;
+    }
+
+    IRPassManager IRPassManager::release_pipeline() {
+        IRPassManager manager;
+        manager.add(make_copy_propagation_pass());
+        manager.add(make_cse_pass());
+        manager.add(make_licm_pass());
+        manager.add(make_dce_pass());
+        return manager;
+    }
+
+    void IRStats::print(std::ostream& out) const {
+        out << "\n=== Swive IR Statistics ===\n";
+        out << "Functions:        " << std::setw(10) << functions << "\n";
+        out << "Skipped:          " << std::setw(10) << skipped << "\n";
+        out << "Instructions:     " << std::setw(10) << instructions_before
+            << " -> " << instructions_after << "\n";
+        for (const auto& [name, count] : rewrites) {
+            std::string label = name + ":";
+            label.resize(std::max<size_t>(label.size(), 18), ' ');
+            out << label << std::setw(10) << count << "\n";
+        }
+        out << "===========================\n";
+    }
+
+} // namespace swive
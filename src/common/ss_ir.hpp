@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 29thnight
+
+/**
+ * @file ss_ir.hpp
+ * @brief SSA mid-end over finalized method bodies.
+ *
+ * A primary method body is lifted into basic blocks whose operand stack is
+ * modelled as SSA values: every push defines a value, frame slots start out
+ * as parameter values and merge points receive phis. Passes rewrite the
+ * block instructions using those facts and the function is lowered back to
+ * bytecode. Bodies the lifter cannot model (closures, debug info,
+ * inconsistent stack heights) are left untouched.
+ */
+
+#pragma once
+
+#include "ss_chunk.hpp"
+
+namespace swive {
+
+using IRValue = uint32_t;
+constexpr IRValue kNoIRValue = std::numeric_limits<IRValue>::max();
+
+enum class IRValueKind : uint8_t {
+    Param,   // Frame slot on entry
+    Phi,     // Stack position at a block with several predecessors
+    Result,  // Pushed by an instruction
+};
+
+struct IRValueInfo {
+    IRValueKind kind{IRValueKind::Result};
+    size_t block{0};
+    size_t index{0};                 // Defining instruction within block (Result only)
+    IRValue copy_of{kNoIRValue};     // Source of an OP_GET_LOCAL/OP_PICK/OP_DUP copy
+    uint32_t uses{0};                // Reads, pops, stores and live-out positions
+};
+
+struct IRInstruction {
+    std::vector<uint8_t> bytes;
+    std::vector<uint32_t> lines;
+    std::vector<size_t> targets;     // Jump targets as block indices, in operand order
+
+    // Filled by IRFunction::analyze()
+    std::vector<IRValue> stack;      // Operand stack before the instruction, frame slots first
+    std::vector<IRValue> args;       // Values popped, bottom first
+    std::vector<IRValue> results;    // Values pushed, bottom first
+    IRValue reads{kNoIRValue};       // Value copied or inspected without popping
+
+    OpCode op() const { return static_cast<OpCode>(bytes[0]); }
+    uint16_t operand(size_t at = 1) const {
+        return static_cast<uint16_t>((bytes[at] << 8) | bytes[at + 1]);
+    }
+    void set_operand(uint16_t value, size_t at = 1) {
+        bytes[at] = static_cast<uint8_t>((value >> 8) & 0xFF);
+        bytes[at + 1] = static_cast<uint8_t>(value & 0xFF);
+    }
+    size_t depth() const { return stack.size(); }
+
+    static IRInstruction make(OpCode op, uint32_t line);
+    static IRInstruction make(OpCode op, uint16_t operand, uint32_t line);
+};
+
+struct IRBlock {
+    std::vector<IRInstruction> instructions;
+
+    // Filled by IRFunction::analyze()
+    std::vector<size_t> successors;
+    std::vector<size_t> predecessors;
+    std::vector<IRValue> entry;
+    std::vector<IRValue> exit;
+    bool reachable{false};
+};
+
+// Facts gathered once per compilation unit that decide which instructions
+// may run user code
+struct IRModuleFacts {
+    std::unordered_set<std::string> accessors;  // Computed properties and observed names
+    bool has_operator_overloads{false};
+    bool has_natives{false};
+
+    static IRModuleFacts collect(const Assembly& root);
+};
+
+enum class IREffect : uint8_t {
+    None,        // Stack shuffles, copies and jumps
+    Pure,        // Result depends only on its operands
+    HeapRead,    // Reads object or upvalue state
+    GlobalRead,  // Reads the global named by its operand
+    Alloc,       // Creates a fresh object; never merged with another
+    LocalWrite,
+    GlobalWrite,
+    HeapWrite,
+    Output,
+    Unknown,     // May run arbitrary user code
+};
+
+class IRFunction {
+public:
+    std::vector<IRBlock> blocks;
+    std::vector<IRValueInfo> values;
+    uint32_t frame_slots{0};
+    const Assembly* owner{nullptr};
+    const IRModuleFacts* facts{nullptr};
+
+    // Lifts body into blocks; false when it contains unsupported code
+    bool build(const MethodBody& body, const Assembly& owner, const IRModuleFacts& facts);
+    // Recomputes edges, reachability and SSA stack values. False when stack
+    // heights disagree at a merge or an instruction underflows its frame.
+    bool analyze();
+    // Re-encodes the blocks into body. False when a jump no longer fits.
+    bool lower(MethodBody& body) const;
+
+    IREffect effect(const IRInstruction& instruction) const;
+    // Follows copies back to the value they duplicate
+    IRValue resolve(IRValue value) const;
+    // First instruction of the expression tree whose root is the instruction
+    // at index: a contiguous run that computes exactly its operands. npos when
+    // an operand comes from outside the block or from a multi-value push.
+    size_t tree_start(size_t block, size_t index) const;
+    // Inserts an empty block at index, renumbering jump targets at or after it
+    void insert_block(size_t index);
+    size_t instruction_count() const;
+
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+private:
+    IRValue new_value(IRValueKind kind, size_t block, size_t index, IRValue copy_of = kNoIRValue);
+    bool simulate(size_t block_index, size_t index, std::vector<IRValue>& stack);
+};
+
+class IRPass {
+public:
+    virtual ~IRPass() = default;
+    virtual const char* name() const = 0;
+    // Runs on an analyzed function and returns the number of rewrites. The
+    // function is re-analyzed after a pass that reports any.
+    virtual size_t run(IRFunction& function) = 0;
+};
+
+struct IRStats {
+    size_t functions{0};
+    size_t skipped{0};
+    size_t instructions_before{0};
+    size_t instructions_after{0};
+    std::vector<std::pair<std::string, size_t>> rewrites;  // Per pass, in pipeline order
+
+    void print(std::ostream& out) const;
+};
+
+class IRPassManager {
+public:
+    void add(std::unique_ptr<IRPass> pass);
+    // Lifts body, runs every pass until none reports a rewrite (or the round
+    // limit is hit) and lowers the result. Returns false and leaves body
+    // untouched when the body cannot be lifted or lowered.
+    bool run(MethodBody& body, const Assembly& owner, const IRModuleFacts& facts);
+    const IRStats& stats() const { return stats_; }
+
+    // Copy propagation, common subexpression elimination, loop-invariant code
+    // motion and dead code elimination
+    static IRPassManager release_pipeline();
+
+private:
+    std::vector<std::unique_ptr<IRPass>> passes_;
+    IRStats stats_;
+};
+
+std::unique_ptr<IRPass> make_copy_propagation_pass();
+std::unique_ptr<IRPass> make_cse_pass();
+std::unique_ptr<IRPass> make_licm_pass();
+std::unique_ptr<IRPass> make_dce_pass();
+
+} // namespace swive
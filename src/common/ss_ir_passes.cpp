@@ -0,0 +1,605 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 29thnight
+
+/**
+ * @file ss_ir_passes.cpp
+ * @brief Optimization passes over the SSA mid-end.
+ *
+ * Every pass works on an analyzed IRFunction. Frame slots and temporaries are
+ * both plain stack positions, so any rewrite that adds or removes a value
+ * shifts the slot and OP_PICK operands that reach across it.
+ */
+
+#include "pch.h"
+#include "ss_ir.hpp"
+#include <map>
+
+namespace swive {
+
+    namespace {
+        constexpr size_t kMaxRewritesPerRun = 256;
+        constexpr size_t kMaxHoistsPerRun = 32;
+
+        bool is_copy(OpCode op) {
+            return op == OpCode::OP_GET_LOCAL || op == OpCode::OP_PICK || op == OpCode::OP_DUP;
+        }
+
+        bool is_literal(OpCode op) {
+            switch (op) {
+                case OpCode::OP_CONSTANT: case OpCode::OP_STRING: case OpCode::OP_NIL:
+                case OpCode::OP_CONSTANT_LONG: case OpCode::OP_STRING_LONG:
+                case OpCode::OP_TRUE: case OpCode::OP_FALSE:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // Ops that name a frame slot in their first operand
+        bool is_slot_op(OpCode op) {
+            switch (op) {
+                case OpCode::OP_GET_LOCAL: case OpCode::OP_GET_LOCAL_MOVE: case OpCode::OP_SET_LOCAL:
+                case OpCode::OP_FOR_ARRAY_NEXT: case OpCode::OP_FOR_RANGE_NEXT:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // Number of frame slots, from the first operand up, the op may write.
+        // Loop steps update their cursor and the loop variable two above it.
+        size_t slots_written(OpCode op) {
+            switch (op) {
+                case OpCode::OP_SET_LOCAL: case OpCode::OP_GET_LOCAL_MOVE:
+                    return 1;
+                case OpCode::OP_FOR_ARRAY_NEXT: case OpCode::OP_FOR_RANGE_NEXT:
+                    return 3;
+                default:
+                    return 0;
+            }
+        }
+
+        bool writes_slot(const IRInstruction& instruction, size_t slot) {
+            size_t count = slots_written(instruction.op());
+            return count > 0 && slot >= instruction.operand() && slot < instruction.operand() + count;
+        }
+
+        bool is_discard(OpCode op) {
+            return op == OpCode::OP_POP || op == OpCode::OP_POP_N || op == OpCode::OP_POP_UNDER;
+        }
+
+        // Stack position an OP_PICK or OP_DUP copies from
+        size_t copied_position(const IRInstruction& instruction) {
+            size_t depth = instruction.op() == OpCode::OP_DUP ? 0 : instruction.operand();
+            return instruction.depth() - 1 - depth;
+        }
+
+        // Lowest stack position the instruction pops or overwrites from the top
+        size_t lowest_popped(const IRInstruction& instruction) {
+            size_t popped = instruction.args.size() + (instruction.op() == OpCode::OP_POP_UNDER ? 1 : 0);
+            return instruction.depth() - std::min(popped, instruction.depth());
+        }
+
+        // Worth replacing with a single copy: anything but a lone literal or copy
+        bool is_worth_replacing(const IRInstruction& root, size_t length) {
+            if (length >= 2) return true;
+            return root.op() == OpCode::OP_GET_GLOBAL || root.op() == OpCode::OP_GET_UPVALUE;
+        }
+
+        IRInstruction make_copy(size_t position, size_t depth, uint32_t line) {
+            if (position + 1 == depth) {
+                return IRInstruction::make(OpCode::OP_DUP, line);
+            }
+            return IRInstruction::make(OpCode::OP_GET_LOCAL, static_cast<uint16_t>(position), line);
+        }
+
+        // Drops the value `above` positions below the top
+        IRInstruction make_drop(size_t above, uint32_t line) {
+            if (above == 0) {
+                return IRInstruction::make(OpCode::OP_POP, line);
+            }
+            return IRInstruction::make(OpCode::OP_POP_UNDER, static_cast<uint16_t>(above), line);
+        }
+
+        // --------------------------------------------------------------------
+        // Copy propagation: reads of a copy go to the lowest position holding
+        // the original, which leaves the copy dead when nothing else reads it
+        // (arguments of inlined calls, re-read temporaries)
+        // --------------------------------------------------------------------
+
+        class CopyPropagationPass final : public IRPass {
+        public:
+            const char* name() const override { return "Copy Propagation"; }
+
+            size_t run(IRFunction& function) override {
+                size_t rewrites = 0;
+                for (auto& block : function.blocks) {
+                    if (!block.reachable) continue;
+                    for (auto& instruction : block.instructions) {
+                        OpCode op = instruction.op();
+                        if (op != OpCode::OP_GET_LOCAL && op != OpCode::OP_PICK) continue;
+
+                        size_t position = op == OpCode::OP_GET_LOCAL ? instruction.operand()
+                                                                     : copied_position(instruction);
+                        IRValue original = function.resolve(instruction.reads);
+                        for (size_t lower = 0; lower < position; ++lower) {
+                            if (function.resolve(instruction.stack[lower]) != original) continue;
+                            instruction.bytes[0] = static_cast<uint8_t>(OpCode::OP_GET_LOCAL);
+                            instruction.set_operand(static_cast<uint16_t>(lower));
+                            ++rewrites;
+                            break;
+                        }
+                    }
+                }
+                return rewrites;
+            }
+        };
+
+        // --------------------------------------------------------------------
+        // Common subexpression elimination: value numbering over extended
+        // basic blocks. A tree whose value is already on the stack becomes a
+        // copy of it. Heap and global reads are keyed by a memory version that
+        // writes and unknown calls advance; merge points start a new version.
+        // --------------------------------------------------------------------
+
+        class CSEPass final : public IRPass {
+        public:
+            const char* name() const override { return "CSE"; }
+
+            size_t run(IRFunction& function) override {
+                struct Memory {
+                    uint32_t heap{0};
+                    uint32_t globals{0};
+                    std::unordered_map<uint16_t, uint32_t> global_versions;
+                };
+                struct Candidate {
+                    size_t start;
+                    size_t end;
+                    size_t position;
+                };
+
+                std::vector<uint32_t> numbers(function.values.size(), 0);
+                uint32_t next_number = 1;
+                uint32_t next_version = 1;
+                auto number = [&](IRValue value) {
+                    if (numbers[value] == 0) {
+                        IRValue source = function.values[value].copy_of;
+                        numbers[value] = source != kNoIRValue && numbers[source] != 0 ? numbers[source] : next_number++;
+                    }
+                    return numbers[value];
+                };
+                std::map<std::vector<uint32_t>, uint32_t> table;
+                std::vector<Memory> exits(function.blocks.size());
+
+                size_t rewrites = 0;
+                for (size_t b = 0; b < function.blocks.size(); ++b) {
+                    auto& block = function.blocks[b];
+                    if (!block.reachable) continue;
+
+                    Memory memory;
+                    if (block.predecessors.size() == 1 && block.predecessors.front() < b) {
+                        memory = exits[block.predecessors.front()];
+                    } else {
+                        memory.heap = next_version++;
+                        memory.globals = next_version++;
+                    }
+
+                    std::vector<Candidate> candidates;
+                    for (size_t i = 0; i < block.instructions.size(); ++i) {
+                        const auto& instruction = block.instructions[i];
+                        IREffect effect = function.effect(instruction);
+                        OpCode op = instruction.op();
+
+                        if (is_copy(op)) {
+                            number(instruction.reads);
+                            number(instruction.results.front());
+                        } else if (instruction.results.size() == 1 &&
+                                   (effect == IREffect::Pure || effect == IREffect::HeapRead ||
+                                    effect == IREffect::GlobalRead)) {
+                            std::vector<uint32_t> key(instruction.bytes.begin(), instruction.bytes.end());
+                            for (IRValue arg : instruction.args) {
+                                key.push_back(number(arg));
+                            }
+                            if (effect == IREffect::HeapRead) {
+                                key.push_back(memory.heap);
+                            } else if (effect == IREffect::GlobalRead) {
+                                key.push_back(memory.globals);
+                                key.push_back(memory.global_versions[instruction.operand()]);
+                            }
+                            auto [it, inserted] = table.emplace(std::move(key), next_number);
+                            if (inserted) ++next_number;
+                            numbers[instruction.results.front()] = it->second;
+
+                            size_t start = function.tree_start(b, i);
+                            if (start != IRFunction::npos && is_worth_replacing(instruction, i - start + 1) &&
+                                is_mergeable_tree(function, block, start, i)) {
+                                const auto& before = block.instructions[start].stack;
+                                for (size_t position = before.size(); position-- > 0;) {
+                                    if (number(before[position]) == it->second) {
+                                        candidates.push_back({start, i, position});
+                                        break;
+                                    }
+                                }
+                            }
+                        }
+
+                        switch (effect) {
+                            case IREffect::HeapWrite:
+                                memory.heap = next_version++;
+                                break;
+                            case IREffect::GlobalWrite:
+                                memory.global_versions[instruction.operand()] = next_version++;
+                                break;
+                            case IREffect::Unknown:
+                                memory.heap = next_version++;
+                                memory.globals = next_version++;
+                                memory.global_versions.clear();
+                                break;
+                            default:
+                                break;
+                        }
+                    }
+                    exits[b] = memory;
+
+                    // Later trees first so earlier indices stay valid; a tree
+                    // nested in one already replaced is skipped
+                    size_t limit = block.instructions.size();
+                    for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+                        if (it->end >= limit) continue;
+                        const auto& root = block.instructions[it->end];
+                        IRInstruction copy = make_copy(it->position, block.instructions[it->start].depth(), root.lines[0]);
+                        block.instructions.erase(block.instructions.begin() + static_cast<long>(it->start),
+                                                 block.instructions.begin() + static_cast<long>(it->end) + 1);
+                        block.instructions.insert(block.instructions.begin() + static_cast<long>(it->start), std::move(copy));
+                        limit = it->start;
+                        ++rewrites;
+                    }
+                }
+                return rewrites;
+            }
+
+        private:
+            static bool is_mergeable_tree(const IRFunction& function, const IRBlock& block, size_t start, size_t end) {
+                for (size_t i = start; i <= end; ++i) {
+                    const auto& instruction = block.instructions[i];
+                    IREffect effect = function.effect(instruction);
+                    if (!is_copy(instruction.op()) && effect != IREffect::Pure &&
+                        effect != IREffect::HeapRead && effect != IREffect::GlobalRead) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+        };
+
+        // --------------------------------------------------------------------
+        // Loop-invariant code motion. A loop is the run of blocks from a
+        // header to the last OP_LOOP back to it, entered only through the
+        // header. An invariant tree in the header (array.count, a property of
+        // an unmodified local, a global the loop never stores) is computed
+        // once in a new block before the header and kept in a hidden slot at
+        // the header's stack height. Every exit drops that slot again.
+        // --------------------------------------------------------------------
+
+        class LICMPass final : public IRPass {
+        public:
+            const char* name() const override { return "LICM"; }
+
+            size_t run(IRFunction& function) override {
+                size_t hoisted = 0;
+                while (hoisted < kMaxHoistsPerRun) {
+                    bool changed = false;
+                    for (const auto& [header, latch] : find_loops(function)) {
+                        if (hoist(function, header, latch)) {
+                            changed = true;
+                            break;
+                        }
+                    }
+                    if (!changed) break;
+                    ++hoisted;
+                    if (!function.analyze()) break;
+                }
+                return hoisted;
+            }
+
+        private:
+            struct Exit {
+                size_t block;
+                size_t operand;    // Index into the last instruction's targets
+                size_t above;      // Values above the hidden slot on this edge
+                bool conditional;
+            };
+
+            // Header -> last block that loops back to it
+            static std::map<size_t, size_t> find_loops(const IRFunction& function) {
+                std::map<size_t, size_t> loops;
+                for (size_t b = 0; b < function.blocks.size(); ++b) {
+                    const auto& block = function.blocks[b];
+                    if (!block.reachable || block.instructions.empty()) continue;
+                    const auto& last = block.instructions.back();
+                    if (last.op() != OpCode::OP_LOOP || last.targets.front() > b) continue;
+                    size_t& latch = loops[last.targets.front()];
+                    latch = std::max(latch, b);
+                }
+                return loops;
+            }
+
+            static bool hoist(IRFunction& function, size_t header, size_t latch) {
+                auto& blocks = function.blocks;
+                const size_t height = blocks[header].entry.size();
+                auto inside = [&](size_t b) { return b >= header && b <= latch; };
+
+                for (size_t b = header + 1; b <= latch; ++b) {
+                    for (size_t predecessor : blocks[b].predecessors) {
+                        if (!inside(predecessor)) return false;
+                    }
+                }
+
+                // What the loop writes, and whether it ever digs below the header height
+                bool writes_heap = false;
+                bool writes_unknown = false;
+                std::unordered_set<uint16_t> written_globals;
+                std::vector<bool> written_slots(height, false);
+                std::vector<Exit> exits;
+                for (size_t b = header; b <= latch; ++b) {
+                    const auto& block = blocks[b];
+                    if (!block.reachable) continue;
+                    if (block.entry.size() < height) return false;
+                    for (const auto& instruction : block.instructions) {
+                        OpCode op = instruction.op();
+                        switch (function.effect(instruction)) {
+                            case IREffect::HeapWrite: writes_heap = true; break;
+                            case IREffect::Unknown: writes_unknown = true; break;
+                            case IREffect::GlobalWrite: written_globals.insert(instruction.operand()); break;
+                            default: break;
+                        }
+                        for (size_t k = 0; k < slots_written(op); ++k) {
+                            if (instruction.operand() + k < height) {
+                                written_slots[instruction.operand() + k] = true;
+                            }
+                        }
+                        bool leaves = op == OpCode::OP_RETURN || op == OpCode::OP_HALT || op == OpCode::OP_TAIL_CALL;
+                        if (!leaves && lowest_popped(instruction) < height) return false;
+                    }
+                    if (block.instructions.empty()) continue;
+
+                    const auto& last = block.instructions.back();
+                    bool drops_on_jump = last.op() == OpCode::OP_JUMP_IF_NIL;
+                    for (size_t k = 0; k < last.targets.size(); ++k) {
+                        if (inside(last.targets[k])) continue;
+                        size_t depth = block.exit.size() - (drops_on_jump ? 1 : 0);
+                        if (depth < height || depth - height > 1) return false;
+                        bool conditional = last.op() != OpCode::OP_JUMP && last.op() != OpCode::OP_LOOP;
+                        exits.push_back({b, k, depth - height, conditional});
+                    }
+                }
+
+                // Largest invariant tree whose header prefix has no effects
+                const auto& code = blocks[header].instructions;
+                size_t best_start = IRFunction::npos;
+                size_t best_end = 0;
+                for (size_t i = 0; i < code.size(); ++i) {
+                    size_t start = function.tree_start(header, i);
+                    if (start == IRFunction::npos || !is_worth_replacing(code[i], i - start + 1)) continue;
+                    if (best_start != IRFunction::npos && i - start <= best_end - best_start) continue;
+
+                    bool prefix_quiet = true;
+                    for (size_t p = 0; p < start && prefix_quiet; ++p) {
+                        prefix_quiet = is_copy(code[p].op()) || is_literal(code[p].op());
+                    }
+                    if (!prefix_quiet) continue;
+
+                    bool invariant = true;
+                    const size_t tree_base = code[start].depth();
+                    for (size_t t = start; t <= i && invariant; ++t) {
+                        const auto& instruction = code[t];
+                        OpCode op = instruction.op();
+                        if (op == OpCode::OP_GET_LOCAL) {
+                            invariant = instruction.operand() < height && !written_slots[instruction.operand()];
+                        } else if (op == OpCode::OP_PICK || op == OpCode::OP_DUP) {
+                            size_t position = copied_position(instruction);
+                            invariant = position >= tree_base || (position < height && !written_slots[position]);
+                        } else {
+                            switch (function.effect(instruction)) {
+                                case IREffect::Pure:
+                                    break;
+                                case IREffect::HeapRead:
+                                    invariant = !writes_heap && !writes_unknown;
+                                    break;
+                                case IREffect::GlobalRead:
+                                    invariant = !writes_unknown && !written_globals.count(instruction.operand());
+                                    break;
+                                default:
+                                    invariant = false;
+                                    break;
+                            }
+                        }
+                    }
+                    if (invariant) {
+                        best_start = start;
+                        best_end = i;
+                    }
+                }
+                if (best_start == IRFunction::npos) return false;
+
+                // Detach the tree; copies from below the header height become
+                // plain slot reads since the preheader runs at that height
+                auto& header_code = blocks[header].instructions;
+                const size_t tree_base = header_code[best_start].depth();
+                const uint32_t line = header_code[best_end].lines[0];
+                std::vector<IRInstruction> tree;
+                for (size_t t = best_start; t <= best_end; ++t) {
+                    IRInstruction instruction = header_code[t];
+                    if ((instruction.op() == OpCode::OP_PICK || instruction.op() == OpCode::OP_DUP) &&
+                        copied_position(instruction) < tree_base) {
+                        instruction = IRInstruction::make(OpCode::OP_GET_LOCAL,
+                                                          static_cast<uint16_t>(copied_position(instruction)),
+                                                          instruction.lines[0]);
+                    }
+                    tree.push_back(std::move(instruction));
+                }
+
+                // Make room for the hidden slot inside the loop
+                for (size_t b = header; b <= latch; ++b) {
+                    auto& block = blocks[b];
+                    for (size_t i = 0; i < block.instructions.size(); ++i) {
+                        if (b == header && i >= best_start && i <= best_end) continue;
+                        auto& instruction = block.instructions[i];
+                        OpCode op = instruction.op();
+                        if (is_slot_op(op) && instruction.operand() >= height) {
+                            instruction.set_operand(static_cast<uint16_t>(instruction.operand() + 1));
+                        } else if (op == OpCode::OP_PICK && block.reachable && copied_position(instruction) < height) {
+                            instruction.set_operand(static_cast<uint16_t>(instruction.operand() + 1));
+                        }
+                    }
+                }
+                header_code.erase(header_code.begin() + static_cast<long>(best_start),
+                                  header_code.begin() + static_cast<long>(best_end) + 1);
+                header_code.insert(header_code.begin() + static_cast<long>(best_start),
+                                   IRInstruction::make(OpCode::OP_GET_LOCAL, static_cast<uint16_t>(height), line));
+
+                // Unconditional exits drop the slot in place; conditional ones
+                // go through a block after the loop that drops it and jumps on
+                size_t pads = 0;
+                for (const auto& exit : exits) {
+                    auto& code_at_exit = blocks[exit.block].instructions;
+                    uint32_t exit_line = code_at_exit.back().lines[0];
+                    if (!exit.conditional) {
+                        code_at_exit.insert(code_at_exit.end() - 1, make_drop(exit.above, exit_line));
+                        continue;
+                    }
+                    size_t pad = latch + 1 + pads++;
+                    function.insert_block(pad);
+                    size_t target = blocks[exit.block].instructions.back().targets[exit.operand];
+                    IRInstruction jump = IRInstruction::make(OpCode::OP_JUMP, 0, exit_line);
+                    jump.targets.push_back(target);
+                    blocks[pad].instructions.push_back(make_drop(exit.above, exit_line));
+                    blocks[pad].instructions.push_back(std::move(jump));
+                    blocks[exit.block].instructions.back().targets[exit.operand] = pad;
+                }
+
+                // Preheader; entries from outside the loop now land on it
+                function.insert_block(header);
+                blocks[header].instructions = std::move(tree);
+                for (size_t b = 0; b < blocks.size(); ++b) {
+                    if (b >= header && b <= latch + 1 + pads) continue;
+                    for (auto& instruction : blocks[b].instructions) {
+                        for (auto& target : instruction.targets) {
+                            if (target == header + 1) target = header;
+                        }
+                    }
+                }
+                return true;
+            }
+        };
+
+        // --------------------------------------------------------------------
+        // Dead code elimination: unreachable blocks, and side-effect-free
+        // trees whose value is only ever discarded
+        // --------------------------------------------------------------------
+
+        class DCEPass final : public IRPass {
+        public:
+            const char* name() const override { return "DCE"; }
+
+            size_t run(IRFunction& function) override {
+                size_t removed = 0;
+                for (auto& block : function.blocks) {
+                    if (!block.reachable && !block.instructions.empty()) {
+                        removed += block.instructions.size();
+                        block.instructions.clear();
+                    }
+                }
+                if (removed > 0) return removed;
+
+                for (size_t rewrites = 0; rewrites < kMaxRewritesPerRun; ++rewrites) {
+                    size_t count = remove_dead_tree(function);
+                    if (count == 0) break;
+                    removed += count;
+                    if (!function.analyze()) break;
+                }
+                return removed;
+            }
+
+        private:
+            static bool is_removable(const IRFunction& function, const IRInstruction& instruction) {
+                OpCode op = instruction.op();
+                if (is_copy(op) || is_literal(op)) return true;
+                return op == OpCode::OP_NOT && function.effect(instruction) == IREffect::Pure;
+            }
+
+            // Removes one dead tree and its discard; returns the number of
+            // instructions removed
+            static size_t remove_dead_tree(IRFunction& function) {
+                for (size_t b = 0; b < function.blocks.size(); ++b) {
+                    auto& code = function.blocks[b].instructions;
+                    if (!function.blocks[b].reachable) continue;
+                    for (size_t c = 0; c < code.size(); ++c) {
+                        if (!is_discard(code[c].op())) continue;
+                        for (IRValue value : code[c].args) {
+                            const auto& info = function.values[value];
+                            if (info.kind != IRValueKind::Result || info.block != b || info.uses != 1) continue;
+                            size_t end = info.index;
+                            if (code[end].results.size() != 1 || code[end].results.front() != value) continue;
+                            size_t start = function.tree_start(b, end);
+                            if (start == IRFunction::npos) continue;
+
+                            bool removable = true;
+                            for (size_t t = start; t <= end && removable; ++t) {
+                                removable = is_removable(function, code[t]);
+                            }
+                            const size_t position = code[start].depth();
+                            for (size_t j = end + 1; j < c && removable; ++j) {
+                                removable = !writes_slot(code[j], position);
+                            }
+                            if (!removable) continue;
+
+                            for (size_t j = end + 1; j < c; ++j) {
+                                auto& instruction = code[j];
+                                OpCode op = instruction.op();
+                                if (is_slot_op(op) && instruction.operand() > position) {
+                                    instruction.set_operand(static_cast<uint16_t>(instruction.operand() - 1));
+                                } else if (op == OpCode::OP_PICK && copied_position(instruction) < position) {
+                                    instruction.set_operand(static_cast<uint16_t>(instruction.operand() - 1));
+                                }
+                            }
+
+                            size_t removed = end - start + 1;
+                            auto& discard = code[c];
+                            size_t remaining = discard.op() == OpCode::OP_POP ? 0 : discard.operand() - 1u;
+                            if (remaining == 0) {
+                                code.erase(code.begin() + static_cast<long>(c));
+                                ++removed;
+                            } else if (remaining == 1 && discard.op() == OpCode::OP_POP_N) {
+                                discard = IRInstruction::make(OpCode::OP_POP, discard.lines[0]);
+                            } else {
+                                discard.set_operand(static_cast<uint16_t>(remaining));
+                            }
+                            code.erase(code.begin() + static_cast<long>(start),
+                                       code.begin() + static_cast<long>(end) + 1);
+                            return removed;
+                        }
+                    }
+                }
+                return 0;
+            }
+        };
+    }
+
+    std::unique_ptr<IRPass> make_copy_propagation_pass() {
+        return std::make_unique<CopyPropagationPass>();
+    }
+
+    std::unique_ptr<IRPass> make_cse_pass() {
+        return std::make_unique<CSEPass>();
+    }
+
+    std::unique_ptr<IRPass> make_licm_pass() {
+        return std::make_unique<LICMPass>();
+    }
+
+    std::unique_ptr<IRPass> make_dce_pass() {
+        return std::make_unique<DCEPass>();
+    }
+
+} // namespace swive
@@ -0,0 +1,211 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 29thnight
+
+/**
+ * @file ss_module_linker.cpp
+ * @brief Folds the per-function Assemblies the compiler builds into one module.
+ *
+ * Only the entry body of a function's Assembly is linked; its metadata rows
+ * describe nothing but that entry. 16-bit operands that read 0xFFFF mark an
+ * absent name or function and are left as they are.
+ *
+ * The module string table is rebuilt once every body is in place. Strings
+ * named by 16-bit operands are interned first and the literal_strings
+ * OP_STRING loads after them, so identifiers keep fitting their operands
+ * however many literals the program holds. A literal load whose new index
+ * passes 0xFFFF is widened to its long form.
+ */
+
+#include "pch.h"
+#include "ss_module_linker.hpp"
+#include "ss_peephole.hpp"
+
+namespace swive {
+
+    namespace {
+        constexpr uint32_t kAbsentOperand = 0xFFFF;
+
+        uint32_t checked_operand(size_t index, size_t width, const char* table) {
+            size_t limit = width == 2 ? std::numeric_limits<uint16_t>::max() : kMaxLongOperand;
+            if (index > limit) {
+                throw std::runtime_error(std::string("Too many ") + table + " in module");
+            }
+            return static_cast<uint32_t>(index);
+        }
+
+        bool is_literal_load(OpCode op) {
+            switch (op) {
+                case OpCode::OP_STRING: case OpCode::OP_STRING_LONG:
+                case OpCode::OP_CONSTANT: case OpCode::OP_CONSTANT_LONG:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        OpCode long_load(OpCode op) {
+            return op == OpCode::OP_STRING ? OpCode::OP_STRING_LONG : OpCode::OP_CONSTANT_LONG;
+        }
+    }
+
+    void ModuleLinkStats::print(std::ostream& out) const {
+        out << "\n=== Swive Module Linking ===\n";
+        out << "Function Bodies:  " << std::setw(10) << bodies_linked << "\n";
+        out << "Strings:          " << std::setw(10) << strings_before
+            << " -> " << strings_after << "\n";
+        out << "Constants:        " << std::setw(10) << constants_before
+            << " -> " << constants_after << "\n";
+        out << "============================\n";
+    }
+
+    void ModuleLinker::link(Assembly& module) {
+        stats_ = ModuleLinkStats{};
+        bodies_.clear();
+        sources_.assign(module.method_bodies.size(), nullptr);
+        module_ = &module;
+        stats_.strings_before = module.string_table.size() + module.literal_strings.size();
+        stats_.constants_before = module.global_constant_pool.size();
+
+        // Prototypes appended while linking are reached by the same loop. The
+        // Assemblies stay alive until the end so their addresses stay unique.
+        std::vector<std::shared_ptr<Assembly>> linked;
+        for (size_t i = 0; i < module.function_prototypes.size(); ++i) {
+            std::shared_ptr<Assembly> chunk = module.function_prototypes[i].chunk;
+            if (!chunk) {
+                continue;
+            }
+            auto it = bodies_.find(chunk.get());
+            body_idx body = it != bodies_.end() ? it->second : link_chunk(*chunk);
+            module.function_prototypes[i].body = body;
+            linked.push_back(std::move(chunk));
+        }
+        intern_tables();
+        for (auto& proto : module.function_prototypes) {
+            proto.chunk.reset();
+        }
+        sources_.clear();
+
+        stats_.strings_after = module.string_table.size();
+        stats_.constants_after = module.global_constant_pool.size();
+        module_ = nullptr;
+    }
+
+    body_idx ModuleLinker::body_of(const Assembly* chunk) const {
+        auto it = bodies_.find(chunk);
+        return it != bodies_.end() ? it->second : kInvalidBody;
+    }
+
+    body_idx ModuleLinker::link_chunk(Assembly& chunk) {
+        Assembly& module = *module_;
+        stats_.strings_before += chunk.string_table.size() + chunk.literal_strings.size();
+        stats_.constants_before += chunk.global_constant_pool.size();
+
+        size_t first_function = module.function_prototypes.size();
+        module.function_prototypes.insert(module.function_prototypes.end(),
+                                          chunk.function_prototypes.begin(), chunk.function_prototypes.end());
+        size_t first_protocol = module.protocol_definitions.size();
+        module.protocol_definitions.insert(module.protocol_definitions.end(),
+                                           chunk.protocol_definitions.begin(), chunk.protocol_definitions.end());
+
+        body_idx entry = 0;
+        if (!chunk.method_definitions.empty() && chunk.method_definitions.front().body_ptr < chunk.method_bodies.size()) {
+            entry = chunk.method_definitions.front().body_ptr;
+        }
+        MethodBody body = entry < chunk.method_bodies.size() ? std::move(chunk.method_bodies[entry]) : MethodBody{};
+
+        // Strings and constants are re-interned by intern_tables()
+        auto& code = body.bytecode;
+        for (size_t offset = 0; offset < code.size(); offset += instruction_length(code, offset)) {
+            auto relink = [&](OperandTable table, const char* name, auto remap) {
+                for (size_t operand : table_operand_offsets(code, offset, table)) {
+                    uint32_t index = read_table_operand(code, offset, operand);
+                    if (index == kAbsentOperand) {
+                        continue;
+                    }
+                    write_table_operand(code, offset, operand, checked_operand(remap(index), 2, name));
+                }
+            };
+            relink(OperandTable::Function, "functions", [&](uint32_t index) {
+                return first_function + index;
+            });
+            relink(OperandTable::Protocol, "protocols", [&](uint32_t index) {
+                return first_protocol + index;
+            });
+        }
+
+        module.method_bodies.push_back(std::move(body));
+        sources_.push_back(&chunk);
+        body_idx linked = static_cast<body_idx>(module.method_bodies.size() - 1);
+        bodies_.emplace(&chunk, linked);
+        ++stats_.bodies_linked;
+        return linked;
+    }
+
+    void ModuleLinker::intern_tables() {
+        Assembly& module = *module_;
+        // The module's own bodies and rows index the table it was compiled with
+        std::vector<std::string> own_strings = std::move(module.string_table);
+        std::vector<std::string> own_literals = std::move(module.literal_strings);
+        module.string_table.clear();
+        module.literal_strings.clear();
+        auto strings_of = [&](size_t body) -> const std::vector<std::string>& {
+            return sources_[body] ? sources_[body]->string_table : own_strings;
+        };
+        auto literals_of = [&](size_t body) -> const std::vector<std::string>& {
+            return sources_[body] ? sources_[body]->literal_strings : own_literals;
+        };
+
+        for (size_t b = 0; b < module.method_bodies.size(); ++b) {
+            auto& code = module.method_bodies[b].bytecode;
+            for (size_t offset = 0; offset < code.size(); offset += instruction_length(code, offset)) {
+                if (is_literal_load(static_cast<OpCode>(code[offset]))) continue;
+                for (size_t operand : table_operand_offsets(code, offset, OperandTable::String)) {
+                    uint32_t index = read_table_operand(code, offset, operand);
+                    if (index == kAbsentOperand) continue;
+                    size_t name = module.add_string(strings_of(b).at(index));
+                    write_table_operand(code, offset, operand, checked_operand(name, 2, "identifier names"));
+                }
+            }
+        }
+
+        for (size_t b = 0; b < module.method_bodies.size(); ++b) {
+            auto& body = module.method_bodies[b];
+            auto& code = body.bytecode;
+            std::vector<std::pair<size_t, std::vector<uint8_t>>> widened;
+            for (size_t offset = 0; offset < code.size(); offset += instruction_length(code, offset)) {
+                OpCode op = static_cast<OpCode>(code[offset]);
+                if (!is_literal_load(op)) continue;
+                bool is_string = op == OpCode::OP_STRING || op == OpCode::OP_STRING_LONG;
+                if (!is_string && !sources_[b]) continue;  // Already indexes the module pool
+
+                uint32_t index = read_table_operand(code, offset, offset + 1);
+                size_t linked = is_string ? module.add_string(literals_of(b).at(index))
+                                          : module.add_constant(sources_[b]->global_constant_pool.at(index));
+                uint32_t operand = checked_operand(linked, 3, is_string ? "strings" : "constants");
+                if (table_operand_width(op) == 2 && operand > std::numeric_limits<uint16_t>::max()) {
+                    std::vector<uint8_t> bytes(4, 0);
+                    bytes[0] = static_cast<uint8_t>(long_load(op));
+                    write_table_operand(bytes, 0, 1, operand);
+                    widened.emplace_back(offset, std::move(bytes));
+                } else {
+                    write_table_operand(code, offset, offset + 1, operand);
+                }
+            }
+            if (!widened.empty() && !replace_instructions(body, widened)) {
+                throw std::runtime_error("Function body too large to widen its literal loads");
+            }
+        }
+
+        auto remap = [&](string_idx index) {
+            return index < own_strings.size() ? static_cast<string_idx>(module.add_string(own_strings[index])) : index;
+        };
+        for (auto& type : module.type_definitions) {
+            type.name = remap(type.name);
+            type.namespace_name = remap(type.namespace_name);
+        }
+        for (auto& method : module.method_definitions) method.name = remap(method.name);
+        for (auto& field : module.field_definitions) field.name = remap(field.name);
+        for (auto& property : module.property_definitions) property.name = remap(property.name);
+    }
+
+} // namespace swive
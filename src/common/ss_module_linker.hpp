@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 29thnight
+
+/**
+ * @file ss_module_linker.hpp
+ * @brief Folds the per-function Assemblies the compiler builds into one module.
+ *
+ * Every function is compiled into an Assembly of its own. Linking moves the
+ * entry body of each prototype's Assembly into the module's method_bodies,
+ * re-interns the strings and constants it names in the module tables and
+ * appends its nested prototypes to the module's, so that every body shares
+ * one set of tables and a prototype names its code by body index. The
+ * module's own prototypes keep their positions, which direct calls address
+ * from every body.
+ */
+
+#pragma once
+
+#include "ss_chunk.hpp"
+
+namespace swive {
+
+struct ModuleLinkStats {
+    size_t bodies_linked{0};
+    size_t strings_before{0};    // Summed over the module and every linked Assembly
+    size_t strings_after{0};
+    size_t constants_before{0};
+    size_t constants_after{0};
+
+    void print(std::ostream& out) const;
+};
+
+class ModuleLinker {
+public:
+    // Links every prototype that still holds an Assembly; prototypes sharing
+    // one Assembly share its body
+    void link(Assembly& module);
+    // Body linked from chunk, or kInvalidBody when no prototype held it
+    body_idx body_of(const Assembly* chunk) const;
+    const ModuleLinkStats& stats() const { return stats_; }
+
+private:
+    ModuleLinkStats stats_;
+    Assembly* module_{nullptr};
+    std::unordered_map<const Assembly*, body_idx> bodies_;
+    // Assembly whose tables each module body still indexes; null for the
+    // module's own bodies
+    std::vector<const Assembly*> sources_;
+
+    body_idx link_chunk(Assembly& chunk);
+    // Rebuilds the module string table names-first and re-interns every
+    // body's strings and constants in the module tables
+    void intern_tables();
+};
+
+} // namespace swive
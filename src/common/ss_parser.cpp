@@ -159,6 +159,7 @@ namespace swive {
         case TokenType::Fileprivate:
         case TokenType::Static:
         case TokenType::Override:
+        case TokenType::Final:
         case TokenType::Mutating:
         case TokenType::Init:
         case TokenType::Deinit:
@@ -450,6 +451,11 @@ namespace swive {
             has_access_modifier = true;
         }
 
+        bool is_final = match(TokenType::Final);
+        if (is_final && !check(TokenType::Class)) {
+            error(previous(), "'final' can only be applied to a class or a class member.");
+        }
+
         if (check(TokenType::Import)) {
             if (has_access_modifier) {
                 error(peek(), "Access control modifiers cannot be applied to import statements.");
@@ -481,6 +487,7 @@ namespace swive {
         if (check(TokenType::Class)) {
             auto stmt = class_declaration(access_level);
             if (auto* decl = dynamic_cast<ClassDeclStmt*>(stmt.get())) {
+                decl->is_final = is_final;
             }
             stmt->attributes = std::move(attributes);
             return stmt;
@@ -854,6 +861,7 @@ namespace swive {
                 is_static = true;
             }
 
+            bool is_final = match(TokenType::Final);
             bool is_override = false;
             if (match(TokenType::Override)) {
                 is_override = true;
@@ -861,6 +869,15 @@ namespace swive {
                     error(previous(), "'static' cannot be combined with 'override'.");
                 }
             }
+            if (!is_final && match(TokenType::Final)) {
+                is_final = true;  // override final func
+            }
+            if (is_final && is_static) {
+                error(previous(), "'static' cannot be combined with 'final'.");
+            }
+            if (is_final && !check(TokenType::Func)) {
+                error(previous(), "'final' must precede a method declaration.");
+            }
 
             if (check(TokenType::Deinit)) {
                 if (is_override) {
@@ -918,6 +935,7 @@ namespace swive {
                 auto method = std::unique_ptr<FuncDeclStmt>(static_cast<FuncDeclStmt*>(func_declaration(attributes).release()));
                 method->is_override = is_override;
                 method->is_static = is_static;
+                method->is_final = is_final;
                 method->access_level = access_level;
                 // attributes already passed to func_declaration, just copy them to method
                 method->attributes = std::move(attributes);
@@ -2256,8 +2274,8 @@ namespace swive {
 
                 if (!check(TokenType::RightParen)) {
                     do {
-                        // Check for named parameter: identifier:
-                        if (check(TokenType::Identifier)) {
+                        // Check for named parameter: identifier: (or where:, as in removeAll(where:))
+                        if (check(TokenType::Identifier) || check(TokenType::Where)) {
                             size_t saved_pos = current_;
                             Token potential_name = advance();
 
@@ -0,0 +1,423 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 29thnight
+
+/**
+ * @file ss_peephole.cpp
+ * @brief Peephole optimization and jump threading over finalized method bodies.
+ *
+ * The body is decoded into an instruction list whose jumps refer to
+ * instruction indices instead of byte distances. Rewrites run to a fixed point
+ * by marking instructions removed; the list is then re-encoded and every jump
+ * distance recomputed.
+ */
+
+#include "pch.h"
+#include "ss_peephole.hpp"
+
+namespace swive {
+
+    namespace {
+        constexpr size_t kMaxPasses = 8;
+
+        uint16_t read_operand(const std::vector<uint8_t>& code, size_t offset) {
+            return static_cast<uint16_t>((code[offset] << 8) | code[offset + 1]);
+        }
+
+        void write_operand(std::vector<uint8_t>& code, size_t offset, uint16_t value) {
+            code[offset] = static_cast<uint8_t>((value >> 8) & 0xFF);
+            code[offset + 1] = static_cast<uint8_t>(value & 0xFF);
+        }
+
+        struct Instruction {
+            std::vector<uint8_t> bytes;
+            std::vector<uint32_t> lines;
+            // Jump targets as instruction indices (the instruction count means
+            // end of code), in the order of their operands
+            std::vector<size_t> targets;
+            bool removed{false};
+
+            OpCode op() const { return static_cast<OpCode>(bytes[0]); }
+            uint16_t operand() const { return read_operand(bytes, 1); }
+        };
+
+        bool is_pop(OpCode op) {
+            return op == OpCode::OP_POP || op == OpCode::OP_POP_N;
+        }
+
+        size_t pop_count(const Instruction& instruction) {
+            return instruction.op() == OpCode::OP_POP ? 1 : instruction.operand();
+        }
+
+        class PeepholePass {
+        public:
+            PeepholePass(std::vector<Instruction>& code, PeepholeStats& stats)
+                : code_(code), stats_(stats) {}
+
+            void run() {
+                using Rule = bool (PeepholePass::*)();
+                static constexpr Rule rules[] = {
+                    &PeepholePass::thread_jumps,
+                    &PeepholePass::invert_branches,
+                    &PeepholePass::remove_reloads,
+                    &PeepholePass::merge_pops,
+                    &PeepholePass::remove_dead_code,
+                };
+                for (size_t pass = 0; pass < kMaxPasses; ++pass) {
+                    bool changed = false;
+                    for (Rule rule : rules) {
+                        // Threading adds targets, so every rule sees fresh ones
+                        refresh_targets();
+                        changed |= (this->*rule)();
+                    }
+                    if (!changed) {
+                        break;
+                    }
+                }
+                refresh_targets();
+            }
+
+        private:
+            std::vector<Instruction>& code_;
+            PeepholeStats& stats_;
+            std::vector<bool> is_target_;
+
+            size_t end() const { return code_.size(); }
+
+            // First live instruction at or after index
+            size_t live_from(size_t index) const {
+                while (index < end() && code_[index].removed) {
+                    ++index;
+                }
+                return index;
+            }
+
+            size_t next_live(size_t index) const { return live_from(index + 1); }
+
+            void remove(size_t index) {
+                code_[index].removed = true;
+            }
+
+            // A removed instruction falls through to the next live one, so
+            // jumps into it land there instead
+            void normalize_targets() {
+                for (auto& instruction : code_) {
+                    if (instruction.removed) continue;
+                    for (auto& target : instruction.targets) {
+                        target = live_from(target);
+                    }
+                }
+            }
+
+            void refresh_targets() {
+                normalize_targets();
+                is_target_.assign(end() + 1, false);
+                for (const auto& instruction : code_) {
+                    if (instruction.removed) continue;
+                    for (size_t target : instruction.targets) {
+                        is_target_[target] = true;
+                    }
+                }
+            }
+
+            bool thread_jumps() {
+                bool changed = false;
+                for (size_t i = 0; i < end(); ++i) {
+                    auto& instruction = code_[i];
+                    if (instruction.removed || instruction.op() == OpCode::OP_LOOP) continue;
+                    for (auto& target : instruction.targets) {
+                        // Chains of OP_JUMP are forward only, so this terminates
+                        while (target < end() && target != i && code_[target].op() == OpCode::OP_JUMP) {
+                            target = live_from(code_[target].targets[0]);
+                            ++stats_.jumps_threaded;
+                            changed = true;
+                        }
+                    }
+                    if (instruction.op() == OpCode::OP_JUMP && instruction.targets[0] == next_live(i)) {
+                        remove(i);
+                        ++stats_.jumps_removed;
+                        changed = true;
+                    }
+                }
+                return changed;
+            }
+
+            // OP_NOT; OP_JUMP_IF_FALSE L becomes OP_JUMP_IF_TRUE L when both
+            // successors pop the condition, so nobody observes the un-negated value
+            bool invert_branches() {
+                bool changed = false;
+                for (size_t i = 0; i < end(); ++i) {
+                    if (code_[i].removed || code_[i].op() != OpCode::OP_NOT) continue;
+                    size_t branch = next_live(i);
+                    if (branch >= end() || is_target_[branch] ||
+                        code_[branch].op() != OpCode::OP_JUMP_IF_FALSE) continue;
+                    size_t fallthrough = next_live(branch);
+                    size_t taken = code_[branch].targets[0];
+                    if (fallthrough >= end() || taken >= end() ||
+                        code_[fallthrough].op() != OpCode::OP_POP ||
+                        code_[taken].op() != OpCode::OP_POP) continue;
+
+                    remove(i);
+                    code_[branch].bytes[0] = static_cast<uint8_t>(OpCode::OP_JUMP_IF_TRUE);
+                    ++stats_.branches_inverted;
+                    changed = true;
+                }
+                return changed;
+            }
+
+            // OP_SET_LOCAL leaves the value on the stack, so popping it and
+            // reading the same slot back is a no-op. Globals are left alone
+            // because their stores may notify observers.
+            bool remove_reloads() {
+                bool changed = false;
+                for (size_t i = 0; i < end(); ++i) {
+                    if (code_[i].removed || code_[i].op() != OpCode::OP_SET_LOCAL) continue;
+                    size_t pop = next_live(i);
+                    if (pop >= end() || is_target_[pop] || code_[pop].op() != OpCode::OP_POP) continue;
+                    size_t load = next_live(pop);
+                    if (load >= end() || is_target_[load] ||
+                        code_[load].op() != OpCode::OP_GET_LOCAL ||
+                        code_[load].operand() != code_[i].operand()) continue;
+
+                    remove(pop);
+                    remove(load);
+                    ++stats_.reloads_removed;
+                    changed = true;
+                }
+                return changed;
+            }
+
+            bool merge_pops() {
+                bool changed = false;
+                for (size_t i = 0; i < end(); ++i) {
+                    if (code_[i].removed || !is_pop(code_[i].op())) continue;
+                    for (size_t next = next_live(i);
+                         next < end() && !is_target_[next] && is_pop(code_[next].op());
+                         next = next_live(i)) {
+                        size_t count = pop_count(code_[i]) + pop_count(code_[next]);
+                        if (count > std::numeric_limits<uint16_t>::max()) break;
+
+                        // Keep the first pop's line for the merged instruction
+                        uint32_t line = code_[i].lines[0];
+                        code_[i].bytes = {static_cast<uint8_t>(OpCode::OP_POP_N), 0, 0};
+                        write_operand(code_[i].bytes, 1, static_cast<uint16_t>(count));
+                        code_[i].lines.assign(3, line);
+                        remove(next);
+                        ++stats_.pops_merged;
+                        changed = true;
+                    }
+                }
+                return changed;
+            }
+
+            bool remove_dead_code() {
+                bool changed = false;
+                for (size_t i = 0; i < end(); ++i) {
+                    if (code_[i].removed || !is_block_terminator(code_[i].op())) continue;
+                    for (size_t next = next_live(i); next < end() && !is_target_[next]; next = next_live(next)) {
+                        remove(next);
+                        ++stats_.dead_removed;
+                        changed = true;
+                    }
+                }
+                return changed;
+            }
+        };
+    }
+
+    namespace {
+        constexpr size_t kNotInstruction = std::numeric_limits<size_t>::max();
+
+        // Decodes body into instructions with index-based jump targets;
+        // index_at maps each instruction's first byte (and the end of code)
+        // to its index. Returns false when the body cannot be decoded.
+        bool decode_body(const MethodBody& body, std::vector<Instruction>& instructions, std::vector<size_t>& index_at) {
+            const auto& code = body.bytecode;
+            if (code.empty() || body.line_info.size() != code.size()) {
+                return false;
+            }
+
+            index_at.assign(code.size() + 1, kNotInstruction);
+            std::vector<size_t> offsets;
+            for (size_t offset = 0; offset < code.size();) {
+                size_t length = instruction_length(code, offset);
+                if (length == 0 || offset + length > code.size()) {
+                    return false;
+                }
+                index_at[offset] = offsets.size();
+                offsets.push_back(offset);
+                offset += length;
+            }
+            index_at[code.size()] = offsets.size();
+
+            instructions.assign(offsets.size(), Instruction{});
+            for (size_t i = 0; i < offsets.size(); ++i) {
+                size_t offset = offsets[i];
+                size_t next = i + 1 < offsets.size() ? offsets[i + 1] : code.size();
+                auto& instruction = instructions[i];
+                instruction.bytes.assign(code.begin() + static_cast<long>(offset), code.begin() + static_cast<long>(next));
+                instruction.lines.assign(body.line_info.begin() + static_cast<long>(offset),
+                                         body.line_info.begin() + static_cast<long>(next));
+                bool backward = instruction.op() == OpCode::OP_LOOP;
+                for (size_t operand : jump_operand_offsets(code, offset)) {
+                    size_t distance = read_operand(code, operand);
+                    if (backward ? distance > next : next + distance > code.size()) {
+                        return false;
+                    }
+                    size_t target = backward ? next - distance : next + distance;
+                    if (index_at[target] == kNotInstruction) {
+                        return false;
+                    }
+                    instruction.targets.push_back(index_at[target]);
+                }
+            }
+            return true;
+        }
+
+        // Re-encodes the live instructions into body, recomputing every jump
+        // distance; a jump into a removed instruction lands on the next live
+        // one. Returns false and leaves body untouched when a distance no
+        // longer fits its 16-bit operand.
+        bool encode_body(MethodBody& body, std::vector<Instruction>& instructions, const std::vector<size_t>& index_at) {
+            // new_index_offset[i] is where instruction i (or, once removed,
+            // the next live instruction) starts in the new layout
+            std::vector<size_t> new_index_offset(instructions.size() + 1);
+            size_t size = 0;
+            for (size_t i = 0; i < instructions.size(); ++i) {
+                new_index_offset[i] = size;
+                if (!instructions[i].removed) {
+                    size += instructions[i].bytes.size();
+                }
+            }
+            new_index_offset[instructions.size()] = size;
+
+            std::vector<uint8_t> out;
+            std::vector<uint32_t> lines;
+            out.reserve(size);
+            lines.reserve(size);
+            for (size_t i = 0; i < instructions.size(); ++i) {
+                auto& instruction = instructions[i];
+                if (instruction.removed) continue;
+
+                size_t at = new_index_offset[i];
+                size_t next = at + instruction.bytes.size();
+                std::vector<size_t> operands = jump_operand_offsets(instruction.bytes, 0);
+                for (size_t k = 0; k < operands.size(); ++k) {
+                    size_t target = new_index_offset[instruction.targets[k]];
+                    bool backward = instruction.op() == OpCode::OP_LOOP;
+                    size_t distance = backward ? next - target : target - next;
+                    if ((backward ? target > next : target < next) ||
+                        distance > std::numeric_limits<uint16_t>::max()) {
+                        return false;
+                    }
+                    write_operand(instruction.bytes, operands[k], static_cast<uint16_t>(distance));
+                }
+                out.insert(out.end(), instruction.bytes.begin(), instruction.bytes.end());
+                lines.insert(lines.end(), instruction.lines.begin(), instruction.lines.end());
+            }
+
+            if (body.debug_info) {
+                const size_t old_size = body.bytecode.size();
+                auto remap = [&](uint32_t offset) {
+                    size_t clamped = std::min<size_t>(offset, old_size);
+                    // Scope offsets sit on instruction boundaries; fall back to
+                    // the enclosing instruction otherwise
+                    while (index_at[clamped] == kNotInstruction) {
+                        --clamped;
+                    }
+                    return static_cast<uint32_t>(new_index_offset[index_at[clamped]]);
+                };
+                for (auto& local_info : body.debug_info->locals) {
+                    local_info.scope_start_offset = remap(local_info.scope_start_offset);
+                    local_info.scope_end_offset = remap(local_info.scope_end_offset);
+                }
+            }
+
+            body.bytecode = std::move(out);
+            body.line_info = std::move(lines);
+            body.max_stack_depth = compute_max_stack_depth(body.bytecode);
+            return true;
+        }
+    }
+
+    bool optimize_method_body(MethodBody& body, PeepholeStats& stats) {
+        std::vector<Instruction> instructions;
+        std::vector<size_t> index_at;
+        if (!decode_body(body, instructions, index_at)) {
+            return false;
+        }
+
+        PeepholeStats local{};
+        PeepholePass(instructions, local).run();
+
+        const size_t bytes_before = body.bytecode.size();
+        if (!encode_body(body, instructions, index_at)) {
+            return false;
+        }
+
+        ++stats.bodies;
+        stats.instructions_before += instructions.size();
+        stats.instructions_after += static_cast<size_t>(
+            std::count_if(instructions.begin(), instructions.end(), [](const Instruction& i) { return !i.removed; }));
+        stats.bytes_before += bytes_before;
+        stats.bytes_after += body.bytecode.size();
+        stats.jumps_threaded += local.jumps_threaded;
+        stats.jumps_removed += local.jumps_removed;
+        stats.branches_inverted += local.branches_inverted;
+        stats.reloads_removed += local.reloads_removed;
+        stats.pops_merged += local.pops_merged;
+        stats.dead_removed += local.dead_removed;
+        return true;
+    }
+
+    bool remove_instructions(MethodBody& body, const std::vector<size_t>& offsets) {
+        std::vector<Instruction> instructions;
+        std::vector<size_t> index_at;
+        if (!decode_body(body, instructions, index_at)) {
+            return false;
+        }
+        for (size_t offset : offsets) {
+            if (offset >= body.bytecode.size() || index_at[offset] == kNotInstruction) {
+                return false;
+            }
+            instructions[index_at[offset]].removed = true;
+        }
+        return encode_body(body, instructions, index_at);
+    }
+
+    bool replace_instructions(MethodBody& body, const std::vector<std::pair<size_t, std::vector<uint8_t>>>& replacements) {
+        std::vector<Instruction> instructions;
+        std::vector<size_t> index_at;
+        if (!decode_body(body, instructions, index_at)) {
+            return false;
+        }
+        for (const auto& [offset, bytes] : replacements) {
+            if (offset >= body.bytecode.size() || index_at[offset] == kNotInstruction || bytes.empty()) {
+                return false;
+            }
+            auto& instruction = instructions[index_at[offset]];
+            if (!instruction.targets.empty() || !jump_operand_offsets(bytes, 0).empty()) {
+                return false;
+            }
+            instruction.lines.assign(bytes.size(), instruction.lines[0]);
+            instruction.bytes = bytes;
+        }
+        return encode_body(body, instructions, index_at);
+    }
+
+    void PeepholeStats::print(std::ostream& out) const {
+        out << "\n=== Swive Peephole Statistics ===\n";
+        out << "Method Bodies:    " << std::setw(10) << bodies << "\n";
+        out << "Instructions:     " << std::setw(10) << instructions_before
+            << " -> " << instructions_after << "\n";
+        out << "Bytecode Size:    " << std::setw(10) << bytes_before
+            << " -> " << bytes_after << " bytes\n";
+        out << "Jumps Threaded:   " << std::setw(10) << jumps_threaded << "\n";
+        out << "Jumps Removed:    " << std::setw(10) << jumps_removed << "\n";
+        out << "Branches Inverted:" << std::setw(10) << branches_inverted << "\n";
+        out << "Reloads Removed:  " << std::setw(10) << reloads_removed << "\n";
+        out << "Pops Merged:      " << std::setw(10) << pops_merged << "\n";
+        out << "Dead Instructions:" << std::setw(10) << dead_removed << "\n";
+        out << "=================================\n";
+    }
+
+} // namespace swive
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 29thnight
+
+/**
+ * @file ss_peephole.hpp
+ * @brief Peephole optimization and jump threading over finalized method bodies.
+ *
+ * Runs after code generation (and inlining) on each MethodBody. Rewrites are
+ * local and never cross a jump target; line_info, debug local scopes and the
+ * body's max stack depth are rebuilt for the new layout.
+ */
+
+#pragma once
+
+#include "ss_chunk.hpp"
+
+namespace swive {
+
+struct PeepholeStats {
+    size_t bodies{0};
+    size_t instructions_before{0};
+    size_t instructions_after{0};
+    size_t bytes_before{0};
+    size_t bytes_after{0};
+    size_t jumps_threaded{0};     // Jump targets moved past an OP_JUMP
+    size_t jumps_removed{0};      // OP_JUMP to the next instruction
+    size_t branches_inverted{0};  // OP_NOT; OP_JUMP_IF_FALSE -> OP_JUMP_IF_TRUE
+    size_t reloads_removed{0};    // OP_SET_LOCAL s; OP_POP; OP_GET_LOCAL s
+    size_t pops_merged{0};        // OP_POP/OP_POP_N folded into a neighbour
+    size_t dead_removed{0};       // Unreachable instructions after a jump or return
+
+    void print(std::ostream& out) const;
+};
+
+// Optimizes body in place. Returns false and leaves body untouched when it
+// cannot be decoded or a rewritten jump no longer fits its 16-bit operand.
+bool optimize_method_body(MethodBody& body, PeepholeStats& stats);
+
+// Deletes the instructions starting at the given offsets; jumps into a
+// deleted instruction land on the next one kept. Returns false and leaves
+// body untouched under the same conditions as optimize_method_body.
+bool remove_instructions(MethodBody& body, const std::vector<size_t>& offsets);
+
+// Replaces the instruction at each offset with new bytes, which may be longer
+// or shorter; jumps, line_info and debug scopes follow the new layout. Jumps
+// cannot be replaced. Returns false and leaves body untouched under the same
+// conditions as optimize_method_body.
+bool replace_instructions(MethodBody& body, const std::vector<std::pair<size_t, std::vector<uint8_t>>>& replacements);
+
+} // namespace swive
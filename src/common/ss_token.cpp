@@ -195,6 +195,7 @@ TokenType TokenUtils::keyword_type(std::string_view str) {
         {"fileprivate", TokenType::Fileprivate},
         {"static", TokenType::Static},
         {"override", TokenType::Override},
+        {"final", TokenType::Final},
         {"init", TokenType::Init},
         {"deinit", TokenType::Deinit},
         {"self", TokenType::Self},
@@ -69,6 +69,7 @@ enum class TokenType {
     Fileprivate,  // fileprivate keyword
     Static,
     Override,
+    Final,
     Init,
     Deinit,
     Self,
@@ -0,0 +1,639 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 29thnight
+
+/**
+ * @file ss_tree_shaker.cpp
+ * @brief Whole-program elimination of unreachable declarations from a compiled Assembly.
+ *
+ * The root body is split into statements at the points where the operand
+ * stack is empty. A statement made only of declaration instructions that
+ * binds a global (or adds methods to a type declared that way) runs only for
+ * its side effect on that name, so it is kept only once the name is read.
+ * Methods are kept by name: a method survives when any live code names it
+ * as a member, which over-approximates dynamic dispatch without type
+ * information.
+ */
+
+#include "pch.h"
+#include "ss_tree_shaker.hpp"
+#include "ss_peephole.hpp"
+
+namespace swive {
+
+    namespace {
+        constexpr uint16_t kNoFunction = 0xFFFF;
+
+        uint16_t read_operand(const std::vector<uint8_t>& code, size_t offset) {
+            return static_cast<uint16_t>((code[offset] << 8) | code[offset + 1]);
+        }
+
+        void write_operand(std::vector<uint8_t>& code, size_t offset, uint16_t value) {
+            code[offset] = static_cast<uint8_t>((value >> 8) & 0xFF);
+            code[offset + 1] = static_cast<uint8_t>(value & 0xFF);
+        }
+
+        // Instructions that only build and bind a declaration
+        bool is_declaration_op(OpCode op) {
+            switch (op) {
+                case OpCode::OP_CLASS: case OpCode::OP_STRUCT: case OpCode::OP_ENUM:
+                case OpCode::OP_ENUM_CASE: case OpCode::OP_FUNCTION: case OpCode::OP_METHOD:
+                case OpCode::OP_STRUCT_METHOD: case OpCode::OP_DEFINE_PROPERTY:
+                case OpCode::OP_DEFINE_COMPUTED_PROPERTY: case OpCode::OP_DEFINE_PROPERTY_WITH_OBSERVERS:
+                case OpCode::OP_INHERIT: case OpCode::OP_GET_GLOBAL: case OpCode::OP_DUP:
+                case OpCode::OP_CONSTANT: case OpCode::OP_STRING: case OpCode::OP_NIL:
+                case OpCode::OP_CONSTANT_LONG: case OpCode::OP_STRING_LONG:
+                case OpCode::OP_TRUE: case OpCode::OP_FALSE: case OpCode::OP_SET_GLOBAL:
+                case OpCode::OP_POP: case OpCode::OP_POP_N:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        bool is_method_op(OpCode op) {
+            return op == OpCode::OP_METHOD || op == OpCode::OP_STRUCT_METHOD;
+        }
+
+        // Methods the VM calls by name rather than through a member access
+        bool is_implicit_method(const std::string& name) {
+            return name == "init" || name == "deinit" || name == "makeIterator" || name == "next";
+        }
+
+        std::vector<size_t> instruction_offsets(const std::vector<uint8_t>& code) {
+            std::vector<size_t> offsets;
+            for (size_t offset = 0; offset < code.size(); offset += instruction_length(code, offset)) {
+                offsets.push_back(offset);
+            }
+            return offsets;
+        }
+
+        template <typename Remap>
+        void remap_operands(std::vector<uint8_t>& code, OperandTable table, Remap remap) {
+            for (size_t offset : instruction_offsets(code)) {
+                for (size_t operand : table_operand_offsets(code, offset, table)) {
+                    write_table_operand(code, offset, operand, remap(read_table_operand(code, offset, operand)));
+                }
+            }
+        }
+
+        // Index of each kept row after compaction; dropped rows map to their
+        // successor so that range starts stay valid
+        std::vector<uint32_t> compacted_indices(const std::vector<bool>& keep) {
+            std::vector<uint32_t> indices(keep.size() + 1);
+            uint32_t next = 0;
+            for (size_t i = 0; i < keep.size(); ++i) {
+                indices[i] = next;
+                if (keep[i]) {
+                    ++next;
+                }
+            }
+            indices[keep.size()] = next;
+            return indices;
+        }
+
+        template <typename T>
+        size_t erase_unkept(std::vector<T>& rows, const std::vector<bool>& keep) {
+            size_t next = 0;
+            for (size_t i = 0; i < rows.size(); ++i) {
+                if (keep[i]) {
+                    if (next != i) {
+                        rows[next] = std::move(rows[i]);
+                    }
+                    ++next;
+                }
+            }
+            size_t removed = rows.size() - next;
+            rows.erase(rows.begin() + static_cast<std::ptrdiff_t>(next), rows.end());
+            return removed;
+        }
+
+        Range compact_range(const Range& range, const std::vector<uint32_t>& indices) {
+            size_t end = std::min<size_t>(static_cast<size_t>(range.start) + range.count, indices.size() - 1);
+            size_t start = std::min<size_t>(range.start, end);
+            return Range{indices[start], indices[end] - indices[start]};
+        }
+    }
+
+    void TreeShaker::run(Assembly& program) {
+        stats_ = TreeShakeStats{};
+        if (program.method_bodies.empty()) {
+            return;
+        }
+        program_ = &program;
+        live_functions_.assign(program.function_prototypes.size(), false);
+        live_method_defs_.assign(program.method_definitions.size(), true);
+
+        split_root_body();
+        for (size_t i = 0; i < segments_.size(); ++i) {
+            if (!segments_[i].candidate) {
+                segments_[i].live = true;
+                segment_worklist_.push_back(i);
+            }
+        }
+        for (const auto& name : roots_.names) {
+            mark_name(name);
+        }
+        if (roots_.keep_reflection) {
+            // Reflection resolves types by name from the metadata tables
+            for (const auto& name : declared_types_) {
+                mark_name(name);
+            }
+        }
+        do {
+            drain();
+        } while (mark_method_defs());
+
+        stats_.functions_before = program.function_prototypes.size();
+        stats_.strings_before = program.string_table.size();
+        stats_.constants_before = program.global_constant_pool.size();
+        if (rewrite_root_body()) {
+            if (!roots_.keep_reflection) {
+                compact_metadata();
+            }
+            compact_functions();
+            compact_bodies();
+            compact_strings();
+            compact_constants();
+        }
+        stats_.functions_after = program.function_prototypes.size();
+        stats_.strings_after = program.string_table.size();
+        stats_.constants_after = program.global_constant_pool.size();
+        program_ = nullptr;
+    }
+
+    void TreeShaker::split_root_body() {
+        const auto& code = program_->method_bodies.front().bytecode;
+
+        // Heights are tracked as in compute_max_stack_depth so that the
+        // statement after an if/else or a ternary still starts at zero
+        std::unordered_set<size_t> targets;
+        std::unordered_map<size_t, uint32_t> target_depth;
+        std::vector<std::vector<size_t>> statements(1);
+        uint32_t depth = 0;
+        bool reachable = true;
+        for (size_t offset = 0; offset < code.size();) {
+            auto it = target_depth.find(offset);
+            if (it != target_depth.end()) {
+                depth = reachable ? std::max(depth, it->second) : it->second;
+                reachable = true;
+            }
+            statements.back().push_back(offset);
+
+            OpCode op = static_cast<OpCode>(code[offset]);
+            StackEffect effect = instruction_stack_effect(code, offset);
+            depth = (depth > effect.pops ? depth - effect.pops : 0) + effect.pushes;
+            size_t next = offset + instruction_length(code, offset);
+            for (size_t operand : jump_operand_offsets(code, offset)) {
+                size_t distance = read_operand(code, operand);
+                if (op == OpCode::OP_LOOP) {
+                    targets.insert(next - distance);
+                    continue;
+                }
+                uint32_t target_height = op == OpCode::OP_JUMP_IF_NIL && depth > 0 ? depth - 1 : depth;
+                auto [target, inserted] = target_depth.emplace(next + distance, target_height);
+                if (!inserted) target->second = std::max(target->second, target_height);
+                targets.insert(next + distance);
+            }
+            if (is_block_terminator(op)) {
+                reachable = false;
+            }
+            if (reachable && depth == 0) {
+                statements.emplace_back();
+            }
+            offset = next;
+        }
+        if (statements.back().empty()) {
+            statements.pop_back();
+        }
+
+        std::unordered_map<std::string, std::vector<size_t>> extensions;
+        auto string_at = [&](size_t operand) -> std::string {
+            uint16_t index = read_operand(code, operand);
+            return index < program_->string_table.size() ? program_->string_table[index] : std::string{};
+        };
+
+        for (const auto& statement : statements) {
+            Segment segment;
+            segment.start = statement.front();
+            segment.end = statement.back() + instruction_length(code, statement.back());
+
+            bool pure = true;
+            bool declares_type = false;
+            bool declares_function = false;
+            bool binds_members = false;
+            size_t set_globals = 0;
+            for (size_t i = 0; i < statement.size() && pure; ++i) {
+                size_t offset = statement[i];
+                OpCode op = static_cast<OpCode>(code[offset]);
+                pure = is_declaration_op(op) && (i == 0 || !targets.count(offset));
+                switch (op) {
+                    case OpCode::OP_CLASS: case OpCode::OP_STRUCT: case OpCode::OP_ENUM:
+                        declares_type = true;
+                        break;
+                    case OpCode::OP_FUNCTION:
+                        declares_function = true;
+                        if (i + 1 < statement.size() && is_method_op(static_cast<OpCode>(code[statement[i + 1]]))) {
+                            segment.method_offsets.push_back(offset);
+                            binds_members = true;
+                        }
+                        break;
+                    case OpCode::OP_DEFINE_COMPUTED_PROPERTY:
+                    case OpCode::OP_DEFINE_PROPERTY_WITH_OBSERVERS:
+                        binds_members = true;
+                        break;
+                    case OpCode::OP_SET_GLOBAL:
+                        ++set_globals;
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            if (pure && set_globals == 1 && statement.size() >= 2 &&
+                static_cast<OpCode>(code[statement[statement.size() - 2]]) == OpCode::OP_SET_GLOBAL &&
+                static_cast<OpCode>(code[statement.back()]) == OpCode::OP_POP &&
+                (declares_type || declares_function)) {
+                // `...; OP_SET_GLOBAL name; OP_POP` binds a function or type
+                std::string name = string_at(statement[statement.size() - 2] + 1);
+                segment.candidate = !name.empty();
+                if (declares_type) {
+                    segment.type_name = name;
+                    declared_types_.insert(name);
+                }
+                segments_by_name_[name].push_back(segments_.size());
+            } else if (pure && set_globals == 0 && binds_members &&
+                       static_cast<OpCode>(code[segment.start]) == OpCode::OP_GET_GLOBAL) {
+                // `OP_GET_GLOBAL type; ...` with no binding extends that type
+                segment.type_name = string_at(segment.start + 1);
+                extensions[segment.type_name].push_back(segments_.size());
+            } else {
+                segment.method_offsets.clear();
+            }
+            segments_.push_back(std::move(segment));
+        }
+
+        // Extending a builtin or an imported native type always runs
+        for (auto& [type_name, indices] : extensions) {
+            bool droppable = segments_by_name_.count(type_name) != 0;
+            for (size_t index : indices) {
+                segments_[index].candidate = droppable;
+                if (droppable) {
+                    segments_by_name_[type_name].push_back(index);
+                }
+            }
+        }
+    }
+
+    void TreeShaker::mark_name(const std::string& name) {
+        if (!live_names_.insert(name).second) {
+            return;
+        }
+        auto segments = segments_by_name_.find(name);
+        if (segments != segments_by_name_.end()) {
+            for (size_t index : segments->second) {
+                if (!segments_[index].live) {
+                    segments_[index].live = true;
+                    segment_worklist_.push_back(index);
+                }
+            }
+        }
+        auto pending = pending_methods_.find(name);
+        if (pending != pending_methods_.end()) {
+            std::vector<size_t> offsets = std::move(pending->second);
+            pending_methods_.erase(pending);
+            for (size_t offset : offsets) {
+                keep_method(offset);
+            }
+        }
+    }
+
+    void TreeShaker::mark_function(size_t index) {
+        if (index >= live_functions_.size() || live_functions_[index]) {
+            return;
+        }
+        live_functions_[index] = true;
+        mark_body(program_->function_prototypes[index].body);
+    }
+
+    bool TreeShaker::mark_body(body_idx body) {
+        if (body == 0 || body >= program_->method_bodies.size() || !scanned_bodies_.insert(body).second) {
+            return false;
+        }
+        body_worklist_.push_back(body);
+        return true;
+    }
+
+    void TreeShaker::keep_method(size_t function_offset) {
+        if (kept_methods_.insert(function_offset).second) {
+            mark_function(read_operand(program_->method_bodies.front().bytecode, function_offset + 1));
+        }
+    }
+
+    void TreeShaker::scan_instruction(const std::vector<uint8_t>& code, size_t offset) {
+        // Any name the code mentions may be a global read or a member lookup
+        for (size_t operand : table_operand_offsets(code, offset, OperandTable::String)) {
+            uint32_t index = read_table_operand(code, offset, operand);
+            if (index < program_->string_table.size()) {
+                mark_name(program_->string_table[index]);
+            }
+        }
+        for (size_t operand : table_operand_offsets(code, offset, OperandTable::Function)) {
+            uint16_t index = read_operand(code, operand);
+            if (index != kNoFunction) {
+                mark_function(index);
+            }
+        }
+        for (size_t operand : table_operand_offsets(code, offset, OperandTable::ProgramFunction)) {
+            mark_function(read_operand(code, operand));
+        }
+    }
+
+    void TreeShaker::scan_segment(const Segment& segment) {
+        const auto& code = program_->method_bodies.front().bytecode;
+        bool keep_all_methods = roots_.keep_reflection || roots_.names.count(segment.type_name) != 0;
+        size_t next_method = 0;
+        for (size_t offset = segment.start; offset < segment.end;) {
+            size_t length = instruction_length(code, offset);
+            if (next_method < segment.method_offsets.size() && segment.method_offsets[next_method] == offset) {
+                ++next_method;
+                size_t method_offset = offset + length;
+                uint16_t name_index = read_operand(code, method_offset + 1);
+                std::string name = name_index < program_->string_table.size() ? program_->string_table[name_index] : std::string{};
+                if (keep_all_methods || is_implicit_method(name) || live_names_.count(name)) {
+                    keep_method(offset);
+                } else {
+                    pending_methods_[name].push_back(offset);
+                }
+                offset = method_offset + instruction_length(code, method_offset);
+                continue;
+            }
+            scan_instruction(code, offset);
+            offset += length;
+        }
+    }
+
+    void TreeShaker::drain() {
+        while (!segment_worklist_.empty() || !body_worklist_.empty()) {
+            if (!segment_worklist_.empty()) {
+                size_t index = segment_worklist_.back();
+                segment_worklist_.pop_back();
+                scan_segment(segments_[index]);
+                continue;
+            }
+            body_idx body = body_worklist_.back();
+            body_worklist_.pop_back();
+            const auto& code = program_->method_bodies[body].bytecode;
+            for (size_t offset : instruction_offsets(code)) {
+                scan_instruction(code, offset);
+            }
+        }
+    }
+
+    bool TreeShaker::mark_method_defs() {
+        const auto& strings = program_->string_table;
+        auto name_of = [&](string_idx index) -> const std::string& {
+            static const std::string empty;
+            return index < strings.size() ? strings[index] : empty;
+        };
+
+        // Rows outside every type (the entry point) always stay
+        live_method_defs_.assign(program_->method_definitions.size(), true);
+        for (size_t t = 0; !roots_.keep_reflection && t < program_->type_definitions.size(); ++t) {
+            const TypeDef& type = program_->type_definitions[t];
+            const std::string& type_name = name_of(type.name);
+            bool type_live = !declared_types_.count(type_name) || live_names_.count(type_name);
+            bool keep_all = roots_.names.count(type_name) != 0;
+
+            std::unordered_set<method_idx> accessors;
+            for (uint32_t i = 0; type_live && i < type.property_list.count; ++i) {
+                size_t index = static_cast<size_t>(type.property_list.start) + i;
+                if (index < program_->property_definitions.size()) {
+                    accessors.insert(program_->property_definitions[index].getter);
+                    accessors.insert(program_->property_definitions[index].setter);
+                }
+            }
+            for (uint32_t i = 0; i < type.method_list.count; ++i) {
+                size_t index = static_cast<size_t>(type.method_list.start) + i;
+                if (index >= live_method_defs_.size()) {
+                    break;
+                }
+                const std::string& name = name_of(program_->method_definitions[index].name);
+                live_method_defs_[index] = type_live &&
+                    (keep_all || is_implicit_method(name) || live_names_.count(name) ||
+                     accessors.count(static_cast<method_idx>(index)));
+            }
+        }
+
+        // The VM may run a kept row's body without loading its prototype
+        bool reached = false;
+        for (size_t i = 0; i < live_method_defs_.size(); ++i) {
+            if (live_method_defs_[i] && mark_body(program_->method_definitions[i].body_ptr)) {
+                reached = true;
+            }
+        }
+        return reached;
+    }
+
+    bool TreeShaker::rewrite_root_body() {
+        auto& body = program_->method_bodies.front();
+        std::vector<size_t> removed;
+        size_t declarations = 0;
+        size_t methods = 0;
+        for (const auto& segment : segments_) {
+            std::vector<size_t> dead_methods;
+            for (size_t offset : segment.method_offsets) {
+                if (!kept_methods_.count(offset)) {
+                    dead_methods.push_back(offset);
+                }
+            }
+
+            // An extension left with nothing to bind only loads its type
+            bool empty = !dead_methods.empty() && !segment.type_name.empty() &&
+                         dead_methods.size() == segment.method_offsets.size();
+            for (size_t offset = segment.start; empty && offset < segment.end;
+                 offset += instruction_length(body.bytecode, offset)) {
+                OpCode op = static_cast<OpCode>(body.bytecode[offset]);
+                if (op == OpCode::OP_FUNCTION || is_method_op(op)) {
+                    continue;
+                }
+                empty = op == OpCode::OP_GET_GLOBAL || op == OpCode::OP_DUP ||
+                        op == OpCode::OP_POP || op == OpCode::OP_POP_N;
+            }
+
+            if (!segment.live || empty) {
+                ++declarations;
+                methods += segment.live ? dead_methods.size() : 0;
+                for (size_t offset = segment.start; offset < segment.end;
+                     offset += instruction_length(body.bytecode, offset)) {
+                    removed.push_back(offset);
+                }
+                continue;
+            }
+            methods += dead_methods.size();
+            for (size_t offset : dead_methods) {
+                removed.push_back(offset);
+                removed.push_back(offset + instruction_length(body.bytecode, offset));
+            }
+        }
+        if (!removed.empty() && !remove_instructions(body, removed)) {
+            return false;
+        }
+        stats_.declarations_removed = declarations;
+        stats_.methods_removed = methods;
+        return true;
+    }
+
+    void TreeShaker::compact_metadata() {
+        auto& methods = program_->method_definitions;
+        auto& fields = program_->field_definitions;
+        auto& properties = program_->property_definitions;
+
+        std::vector<bool> keep_fields(fields.size(), true);
+        std::vector<bool> keep_properties(properties.size(), true);
+        for (const auto& type : program_->type_definitions) {
+            const std::string& type_name = type.name < program_->string_table.size()
+                ? program_->string_table[type.name] : std::string{};
+            if (!declared_types_.count(type_name) || live_names_.count(type_name)) {
+                continue;
+            }
+            for (uint32_t i = 0; i < type.field_list.count && type.field_list.start + i < fields.size(); ++i) {
+                keep_fields[type.field_list.start + i] = false;
+            }
+            for (uint32_t i = 0; i < type.property_list.count && type.property_list.start + i < properties.size(); ++i) {
+                keep_properties[type.property_list.start + i] = false;
+            }
+        }
+
+        auto method_indices = compacted_indices(live_method_defs_);
+        auto field_indices = compacted_indices(keep_fields);
+        auto property_indices = compacted_indices(keep_properties);
+        for (auto& type : program_->type_definitions) {
+            type.method_list = compact_range(type.method_list, method_indices);
+            type.field_list = compact_range(type.field_list, field_indices);
+            type.property_list = compact_range(type.property_list, property_indices);
+        }
+        constexpr method_idx kInvalidMethod = std::numeric_limits<method_idx>::max();
+        for (auto& property : properties) {
+            if (property.getter != kInvalidMethod && property.getter < live_method_defs_.size()) {
+                property.getter = method_indices[property.getter];
+            }
+            if (property.setter != kInvalidMethod && property.setter < live_method_defs_.size()) {
+                property.setter = method_indices[property.setter];
+            }
+        }
+        stats_.metadata_removed = erase_unkept(methods, live_method_defs_) +
+                                  erase_unkept(fields, keep_fields) +
+                                  erase_unkept(properties, keep_properties);
+    }
+
+    void TreeShaker::compact_functions() {
+        auto indices = compacted_indices(live_functions_);
+        auto remap = [&](uint16_t index) -> uint16_t {
+            return index < live_functions_.size() ? static_cast<uint16_t>(indices[index]) : index;
+        };
+
+        for (auto& body : program_->method_bodies) {
+            remap_operands(body.bytecode, OperandTable::ProgramFunction, remap);
+            remap_operands(body.bytecode, OperandTable::Function, [&](uint16_t index) {
+                return index == kNoFunction ? index : remap(index);
+            });
+        }
+        erase_unkept(program_->function_prototypes, live_functions_);
+    }
+
+    void TreeShaker::compact_bodies() {
+        // The root body stays at index 0; other bodies survive with a prototype or MethodDef
+        auto& bodies = program_->method_bodies;
+        std::vector<bool> keep(bodies.size(), false);
+        keep[0] = true;
+        for (const auto& proto : program_->function_prototypes) {
+            if (proto.body < bodies.size()) keep[proto.body] = true;
+        }
+        for (const auto& method : program_->method_definitions) {
+            if (method.body_ptr < bodies.size()) keep[method.body_ptr] = true;
+        }
+        auto indices = compacted_indices(keep);
+        for (auto& proto : program_->function_prototypes) {
+            if (proto.body < bodies.size()) proto.body = indices[proto.body];
+        }
+        for (auto& method : program_->method_definitions) {
+            if (method.body_ptr < bodies.size()) method.body_ptr = indices[method.body_ptr];
+        }
+        stats_.bodies_removed = erase_unkept(bodies, keep);
+    }
+
+    void TreeShaker::compact_strings() {
+        auto& strings = program_->string_table;
+        std::vector<bool> keep(strings.size(), false);
+        auto use = [&](uint32_t index) {
+            if (index < keep.size()) keep[index] = true;
+        };
+
+        for (const auto& body : program_->method_bodies) {
+            const auto& code = body.bytecode;
+            for (size_t offset : instruction_offsets(code)) {
+                for (size_t operand : table_operand_offsets(code, offset, OperandTable::String)) {
+                    use(read_table_operand(code, offset, operand));
+                }
+            }
+        }
+        for (const auto& type : program_->type_definitions) {
+            use(type.name);
+            use(type.namespace_name);
+        }
+        for (const auto& method : program_->method_definitions) use(method.name);
+        for (const auto& field : program_->field_definitions) use(field.name);
+        for (const auto& property : program_->property_definitions) use(property.name);
+
+        auto indices = compacted_indices(keep);
+        auto remap = [&](uint32_t index) { return index < keep.size() ? indices[index] : index; };
+        for (auto& body : program_->method_bodies) {
+            remap_operands(body.bytecode, OperandTable::String, remap);
+        }
+        for (auto& type : program_->type_definitions) {
+            type.name = remap(type.name);
+            type.namespace_name = remap(type.namespace_name);
+        }
+        for (auto& method : program_->method_definitions) method.name = remap(method.name);
+        for (auto& field : program_->field_definitions) field.name = remap(field.name);
+        for (auto& property : program_->property_definitions) property.name = remap(property.name);
+        erase_unkept(strings, keep);
+    }
+
+    void TreeShaker::compact_constants() {
+        auto& constants = program_->global_constant_pool;
+        std::vector<bool> keep(constants.size(), false);
+        for (const auto& body : program_->method_bodies) {
+            const auto& code = body.bytecode;
+            for (size_t offset : instruction_offsets(code)) {
+                for (size_t operand : table_operand_offsets(code, offset, OperandTable::Constant)) {
+                    uint32_t index = read_table_operand(code, offset, operand);
+                    if (index < keep.size()) keep[index] = true;
+                }
+            }
+        }
+        auto indices = compacted_indices(keep);
+        for (auto& body : program_->method_bodies) {
+            remap_operands(body.bytecode, OperandTable::Constant, [&](uint32_t index) {
+                return index < keep.size() ? indices[index] : index;
+            });
+        }
+        erase_unkept(constants, keep);
+    }
+
+    void TreeShakeStats::print(std::ostream& out) const {
+        out << "\n=== Swive Tree Shaking ===\n";
+        out << "Declarations:     " << std::setw(10) << declarations_removed << " removed\n";
+        out << "Methods:          " << std::setw(10) << methods_removed << " removed\n";
+        out << "Functions:        " << std::setw(10) << functions_before
+            << " -> " << functions_after << "\n";
+        out << "Metadata Rows:    " << std::setw(10) << metadata_removed << " removed\n";
+        out << "Method Bodies:    " << std::setw(10) << bodies_removed << " removed\n";
+        out << "Strings:          " << std::setw(10) << strings_before
+            << " -> " << strings_after << "\n";
+        out << "Constants:        " << std::setw(10) << constants_before
+            << " -> " << constants_after << "\n";
+        out << "==========================\n";
+    }
+
+} // namespace swive
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 29thnight
+
+/**
+ * @file ss_tree_shaker.hpp
+ * @brief Whole-program elimination of unreachable declarations from a compiled Assembly.
+ *
+ * Runs last in Release builds, once the metadata tables exist. Reachability
+ * starts from the root body's executable statements and the given root names
+ * and follows global and member names, function prototypes and OP_CALL_DIRECT
+ * targets into the bodies of the linked module. Declarations nothing reaches
+ * are deleted from the root body, and the prototype, body, metadata, string
+ * and constant tables are compacted. Rows of the type table are kept because
+ * type ids are positional.
+ */
+
+#pragma once
+
+#include "ss_chunk.hpp"
+
+namespace swive {
+
+struct TreeShakeStats {
+    size_t declarations_removed{0};  // Top-level functions, types and extensions
+    size_t methods_removed{0};
+    size_t functions_before{0};      // Function prototypes, nested ones included
+    size_t functions_after{0};
+    size_t metadata_removed{0};      // Method, field and property rows
+    size_t bodies_removed{0};
+    size_t strings_before{0};
+    size_t strings_after{0};
+    size_t constants_before{0};
+    size_t constants_after{0};
+
+    void print(std::ostream& out) const;
+};
+
+struct TreeShakeRoots {
+    std::unordered_set<std::string> names;  // Exported and [Native] declarations; their methods are all kept
+    bool keep_reflection{false};            // Keep every type and method, and leave the metadata tables whole
+};
+
+class TreeShaker {
+public:
+    explicit TreeShaker(TreeShakeRoots roots) : roots_(std::move(roots)) {}
+
+    // Leaves program untouched when the root body cannot be rewritten
+    void run(Assembly& program);
+    const TreeShakeStats& stats() const { return stats_; }
+
+private:
+    // Statement of the root body that leaves the stack as it found it. Only
+    // declarations are candidates for removal; anything else always runs.
+    struct Segment {
+        size_t start{0};
+        size_t end{0};
+        bool candidate{false};
+        bool live{false};
+        std::string type_name;              // Type whose methods the segment binds, if any
+        std::vector<size_t> method_offsets;  // OP_FUNCTION of each OP_FUNCTION; OP_(STRUCT_)METHOD pair
+    };
+
+    TreeShakeRoots roots_;
+    TreeShakeStats stats_;
+    Assembly* program_{nullptr};
+
+    std::vector<Segment> segments_;
+    std::unordered_map<std::string, std::vector<size_t>> segments_by_name_;  // Defining and extension segments
+    std::unordered_set<std::string> declared_types_;                        // Types some candidate defines
+
+    std::unordered_set<std::string> live_names_;
+    std::unordered_map<std::string, std::vector<size_t>> pending_methods_;  // Method name -> OP_FUNCTION offsets
+    std::unordered_set<size_t> kept_methods_;
+    std::vector<bool> live_functions_;
+    std::vector<bool> live_method_defs_;
+    std::unordered_set<body_idx> scanned_bodies_;
+
+    std::vector<size_t> segment_worklist_;
+    std::vector<body_idx> body_worklist_;
+
+    void split_root_body();
+    void mark_name(const std::string& name);
+    void mark_function(size_t index);
+    // Queues body for scanning; returns false when it was already queued
+    bool mark_body(body_idx body);
+    void keep_method(size_t function_offset);
+    void scan_instruction(const std::vector<uint8_t>& code, size_t offset);
+    void scan_segment(const Segment& segment);
+    void drain();
+    // Recomputes live_method_defs_; returns true when a kept row reached a new body
+    bool mark_method_defs();
+
+    bool rewrite_root_body();
+    void compact_metadata();
+    void compact_functions();
+    void compact_bodies();
+    void compact_strings();
+    void compact_constants();
+};
+
+} // namespace swive
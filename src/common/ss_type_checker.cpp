@@ -39,6 +39,18 @@ TypeChecker::TypeInfo TypeChecker::TypeInfo::function(std::vector<TypeInfo> para
     return info;
 }
 
+TypeChecker::TypeInfo TypeChecker::TypeInfo::function(std::vector<TypeInfo> params, TypeInfo result,
+                                                     const std::vector<ParamDecl>& decls) {
+    TypeInfo info = function(std::move(params), std::move(result));
+    info.param_labels.reserve(decls.size());
+    info.param_has_default.reserve(decls.size());
+    for (const auto& decl : decls) {
+        info.param_labels.push_back(decl.external_name);
+        info.param_has_default.push_back(decl.default_value != nullptr);
+    }
+    return info;
+}
+
 TypeChecker::TypeInfo TypeChecker::TypeInfo::generic(std::string name, bool optional) {
     return TypeInfo{std::move(name), optional, TypeKind::GenericParameter, {}, nullptr, {}};
 }
@@ -52,6 +64,14 @@ TypeChecker::TypeInfo TypeChecker::TypeInfo::tuple(std::vector<TupleElementInfo>
     return info;
 }
 
+TypeChecker::TypeInfo TypeChecker::TypeInfo::array(const TypeInfo& element) {
+    TypeInfo info = builtin("Array");
+    if (element.kind != TypeKind::Unknown) {
+        info.element_type = std::make_shared<TypeInfo>(element);
+    }
+    return info;
+}
+
 void TypeChecker::check(const std::vector<StmtPtr>& program) {
 known_types_.clear();
 type_properties_.clear();
@@ -100,6 +120,7 @@ known_attributes_.clear();
     declare_symbol("Float", TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Float")), 0);
     declare_symbol("Bool", TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Bool")), 0);
     declare_symbol("String", TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("String")), 0);
+    declare_symbol("Set", TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Set")), 0);
     for (const auto* module_program : imported_programs) {
         declare_functions(*module_program);
     }
@@ -175,6 +196,7 @@ void TypeChecker::check_no_throw(const std::vector<StmtPtr>& program) {
     declare_symbol("Float", TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Float")), 0);
     declare_symbol("Bool", TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Bool")), 0);
     declare_symbol("String", TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("String")), 0);
+    declare_symbol("Set", TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Set")), 0);
     for (const auto* module_program : imported_programs) {
         declare_functions(*module_program);
     }
@@ -207,6 +229,8 @@ void TypeChecker::add_builtin_types() {
     known_types_.emplace("String", TypeKind::Builtin);
     known_types_.emplace("Array", TypeKind::Builtin);
     known_types_.emplace("Dictionary", TypeKind::Builtin);
+    known_types_.emplace("Set", TypeKind::Builtin);
+    known_types_.emplace("Range", TypeKind::Builtin);
     known_types_.emplace("Void", TypeKind::Builtin);
     known_types_.emplace("Any", TypeKind::Builtin);
 
@@ -215,6 +239,73 @@ void TypeChecker::add_builtin_types() {
     type_methods_["Array"].emplace(
         "append",
         TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Void")));
+    type_methods_["Array"].emplace(
+        "map",
+        TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Array")));
+    type_methods_["Array"].emplace(
+        "filter",
+        TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Array")));
+    type_methods_["Array"].emplace(
+        "reduce",
+        TypeInfo::function({ TypeInfo::builtin("Any"), TypeInfo::builtin("Any") }, TypeInfo::builtin("Any")));
+    type_methods_["Array"].emplace(
+        "contains",
+        TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Bool")));
+    type_methods_["Array"].emplace(
+        "firstIndex",
+        TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Int", true)));
+    type_methods_["Array"].emplace(
+        "reserveCapacity",
+        TypeInfo::function({ TypeInfo::builtin("Int") }, TypeInfo::builtin("Void")));
+    // sorted() / sorted(by:) and removeAll() / removeAll(where:); arity checked in check_call_expr
+    type_methods_["Array"].emplace(
+        "sorted",
+        TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Array")));
+    type_methods_["Array"].emplace(
+        "removeAll",
+        TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Void")));
+    // Bulk numeric methods over Int/Float arrays
+    for (const char* reduce_op : { "sum", "min", "max" }) {
+        type_methods_["Array"].emplace(
+            reduce_op,
+            TypeInfo::function({}, TypeInfo::builtin("Any")));
+    }
+    type_methods_["Array"].emplace(
+        "dot",
+        TypeInfo::function({ TypeInfo::builtin("Array") }, TypeInfo::builtin("Any")));
+    for (const char* elementwise_op : { "adding", "subtracting", "multiplied", "divided" }) {
+        type_methods_["Array"].emplace(
+            elementwise_op,
+            TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Array")));
+    }
+
+    type_properties_["Set"].emplace("count", TypeInfo::builtin("Int"));
+    type_properties_["Set"].emplace("isEmpty", TypeInfo::builtin("Bool"));
+    type_methods_["Set"].emplace(
+        "insert",
+        TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Bool")));
+    type_methods_["Set"].emplace(
+        "remove",
+        TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Any", true)));
+    type_methods_["Set"].emplace(
+        "removeAll",
+        TypeInfo::function({}, TypeInfo::builtin("Void")));
+    type_methods_["Set"].emplace(
+        "contains",
+        TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Bool")));
+    for (const char* set_op : { "union", "intersection", "subtracting" }) {
+        type_methods_["Set"].emplace(
+            set_op,
+            TypeInfo::function({ TypeInfo::builtin("Any") }, TypeInfo::builtin("Set")));
+    }
+
+    type_properties_["Range"].emplace("lowerBound", TypeInfo::builtin("Int"));
+    type_properties_["Range"].emplace("upperBound", TypeInfo::builtin("Int"));
+    type_properties_["Range"].emplace("count", TypeInfo::builtin("Int"));
+    type_properties_["Range"].emplace("isEmpty", TypeInfo::builtin("Bool"));
+    type_methods_["Range"].emplace(
+        "contains",
+        TypeInfo::function({ TypeInfo::builtin("Int") }, TypeInfo::builtin("Bool")));
     
     // Register standard library protocols
     add_known_type("Equatable", TypeKind::Protocol, 0);
@@ -223,6 +314,8 @@ void TypeChecker::add_builtin_types() {
     add_known_type("Numeric", TypeKind::Protocol, 0);
     add_known_type("SignedNumeric", TypeKind::Protocol, 0);
     add_known_type("CustomStringConvertible", TypeKind::Protocol, 0);
+    add_known_type("Sequence", TypeKind::Protocol, 0);          // makeIterator() or next()
+    add_known_type("IteratorProtocol", TypeKind::Protocol, 0);  // mutating next() -> Element?
     
     // Protocol inheritance hierarchy
     // Comparable inherits from Equatable
@@ -265,6 +358,11 @@ void TypeChecker::add_builtin_types() {
     protocol_conformers_["Comparable"].insert("String");
     protocol_conformers_["Hashable"].insert("String");
     protocol_conformers_["CustomStringConvertible"].insert("String");
+
+    // Builtin collections are iterable by for-in
+    for (const char* sequence : { "String", "Array", "Dictionary", "Set", "Range" }) {
+        protocol_conformers_["Sequence"].insert(sequence);
+    }
 }
 
 void TypeChecker::add_builtin_attributes() {
@@ -410,7 +508,7 @@ void TypeChecker::collect_type_declarations(const std::vector<StmtPtr>& program)
                     }
                     type_methods_[decl->name].emplace(
                         method->name,
-                        TypeInfo::function(params, return_type));
+                        TypeInfo::function(params, return_type, method->params));
                     // Track access level
                     member_access_levels_[decl->name][method->name] = method->access_level;
                     exit_generic_params();
@@ -493,7 +591,7 @@ void TypeChecker::collect_type_declarations(const std::vector<StmtPtr>& program)
                     }
                     type_methods_[decl->name].emplace(
                         method->name,
-                        TypeInfo::function(params, return_type));
+                        TypeInfo::function(params, return_type, method->params));
                     // Track access level
                     member_access_levels_[decl->name][method->name] = method->access_level;
                     // Track mutating methods
@@ -551,7 +649,7 @@ void TypeChecker::collect_type_declarations(const std::vector<StmtPtr>& program)
                     }
                     type_methods_[decl->name].emplace(
                         method->name,
-                        TypeInfo::function(params, return_type));
+                        TypeInfo::function(params, return_type, method->params));
                     exit_generic_params();
                 }
                 exit_generic_params();
@@ -583,7 +681,7 @@ void TypeChecker::collect_type_declarations(const std::vector<StmtPtr>& program)
                         }
                         type_methods_[decl->extended_type].emplace(
                             method->name,
-                            TypeInfo::function(params, return_type));
+                            TypeInfo::function(params, return_type, method->params));
                         // Track access level for extension methods
                         member_access_levels_[decl->extended_type][method->name] = method->access_level;
                         // Track mutating methods for extensions
@@ -694,7 +792,7 @@ void TypeChecker::declare_functions(const std::vector<StmtPtr>& program) {
             if (func->return_type.has_value()) {
                 return_type = type_from_annotation(func->return_type.value(), func->line);
             }
-            declare_symbol(func->name, TypeInfo::function(params, return_type), func->line);
+            declare_symbol(func->name, TypeInfo::function(params, return_type, func->params), func->line);
             exit_generic_params();
         }
     }
@@ -902,7 +1000,7 @@ void TypeChecker::check_var_decl(const VarDeclStmt* stmt) {
     }
 
     if (stmt->initializer) {
-        TypeInfo init_type = check_expr(stmt->initializer.get());
+        TypeInfo init_type = converted_type(declared, stmt->initializer.get(), check_expr(stmt->initializer.get()));
         if (declared.kind != TypeKind::Unknown) {
             if (!is_assignable(declared, init_type)) {
                 error("Cannot assign '" + init_type.name + "' to variable of type '" + declared.name + "'", stmt->line);
@@ -1098,7 +1196,7 @@ void TypeChecker::check_return_stmt(const ReturnStmt* stmt) {
         return;
     }
 
-    TypeInfo actual = check_expr(stmt->value.get());
+    TypeInfo actual = converted_type(expected, stmt->value.get(), check_expr(stmt->value.get()));
     if (!is_unknown(expected) && !is_assignable(expected, actual)) {
         error("Return type mismatch: expected '" + expected.name + "'", stmt->line);
     }
@@ -1128,7 +1226,7 @@ if (stmt->return_type.has_value()) {
     return_type = type_from_annotation(stmt->return_type.value(), stmt->line);
 }
 
-TypeInfo function_type = TypeInfo::function(params, return_type);
+TypeInfo function_type = TypeInfo::function(params, return_type, stmt->params);
 if (!has_symbol(stmt->name)) {
     declare_symbol(stmt->name, function_type, stmt->line);
 }
@@ -1652,7 +1750,7 @@ TypeChecker::TypeInfo TypeChecker::check_assign_expr(const AssignExpr* expr) {
     }
     
     TypeInfo expected = lookup_symbol(expr->name, expr->line);
-    TypeInfo actual = check_expr(expr->value.get());
+    TypeInfo actual = converted_type(expected, expr->value.get(), check_expr(expr->value.get()));
     if (!is_assignable(expected, actual)) {
         error("Cannot assign '" + actual.name + "' to '" + expected.name + "'", expr->line);
     }
@@ -1690,13 +1788,94 @@ TypeChecker::TypeInfo TypeChecker::check_call_expr(const CallExpr* expr) {
         }
     }
     
+    // Set() and Set(sequence) initializers
+    if (callee.kind == TypeKind::Function && expr->callee->kind == ExprKind::Identifier &&
+        static_cast<const IdentifierExpr*>(expr->callee.get())->name == "Set" &&
+        callee.return_type && callee.return_type->name == "Set") {
+        if (expr->arguments.size() > 1) {
+            error("Set initializer takes at most one argument", expr->line);
+        }
+        return *callee.return_type;
+    }
+
+    // Array methods whose result follows their closure or operand
+    if (callee.kind == TypeKind::Function && expr->callee->kind == ExprKind::Member) {
+        auto* member_expr = static_cast<const MemberExpr*>(expr->callee.get());
+        if (callee.element_type && callee.return_type) {
+            callee.return_type = std::make_shared<TypeInfo>(array_method_result(
+                TypeInfo::array(*callee.element_type), member_expr->member, *callee.return_type, arg_types));
+        }
+    }
+
+    // Array methods whose single argument is optional
+    if (callee.kind == TypeKind::Function && expr->callee->kind == ExprKind::Member) {
+        auto* member_expr = static_cast<const MemberExpr*>(expr->callee.get());
+        if ((member_expr->member == "sorted" || member_expr->member == "removeAll") &&
+            check_expr(member_expr->object.get()).name == "Array") {
+            if (expr->arguments.size() > 1) {
+                error("'" + member_expr->member + "' takes at most one argument", expr->line);
+            }
+            return *callee.return_type;
+        }
+    }
+
+    if (callee.kind == TypeKind::Function && callee.param_labels.size() == callee.param_types.size() &&
+        !callee.param_labels.empty()) {
+        // Declared function: bind labels and defaults like the compiler/VM do
+        const size_t param_count = callee.param_types.size();
+        std::vector<bool> filled(param_count, false);
+        size_t next_pos = 0;
+        for (size_t i = 0; i < arg_types.size(); ++i) {
+            const std::string& label = i < expr->argument_names.size() ? expr->argument_names[i] : std::string{};
+            size_t target = param_count;
+            if (!label.empty()) {
+                for (size_t p = 0; p < param_count; ++p) {
+                    if (!callee.param_labels[p].empty() && callee.param_labels[p] == label) {
+                        target = p;
+                        break;
+                    }
+                }
+                if (target == param_count) {
+                    error("Unknown argument label '" + label + "'", expr->line);
+                    continue;
+                }
+            } else {
+                while (next_pos < param_count && filled[next_pos]) {
+                    ++next_pos;
+                }
+                target = next_pos++;
+                if (target >= param_count) {
+                    error("Function argument count mismatch", expr->line);
+                    break;
+                }
+            }
+            if (filled[target]) {
+                error("Duplicate argument for parameter '" + callee.param_labels[target] + "'", expr->line);
+                continue;
+            }
+            filled[target] = true;
+            const TypeInfo& param_type = callee.param_types[target];
+            if (!is_assignable(param_type, converted_type(param_type, expr->arguments[i].get(), arg_types[i]))) {
+                error("Function argument type mismatch", expr->line);
+            }
+        }
+        for (size_t p = 0; p < param_count; ++p) {
+            if (!filled[p] && !callee.param_has_default[p]) {
+                error("Function argument count mismatch", expr->line);
+                break;
+            }
+        }
+        return *callee.return_type;
+    }
+
     if (callee.kind == TypeKind::Function) {
         if (callee.param_types.size() != expr->arguments.size()) {
             error("Function argument count mismatch", expr->line);
         }
         size_t param_count = std::min(callee.param_types.size(), arg_types.size());
         for (size_t i = 0; i < param_count; ++i) {
-            if (!is_assignable(callee.param_types[i], arg_types[i])) {
+            const TypeInfo& param_type = callee.param_types[i];
+            if (!is_assignable(param_type, converted_type(param_type, expr->arguments[i].get(), arg_types[i]))) {
                 error("Function argument type mismatch", expr->line);
             }
         }
@@ -1830,6 +2009,13 @@ TypeChecker::TypeInfo TypeChecker::check_member_expr(const MemberExpr* expr) {
     }
 
     if (auto member = lookup_member(object.name)) {
+        if (object.name == "Array" && member->kind == TypeKind::Function) {
+            // The call refines the result again once its arguments are known
+            member->return_type = std::make_shared<TypeInfo>(
+                array_method_result(object, expr->member, *member->return_type, {}));
+            member->element_type = std::make_shared<TypeInfo>(
+                object.element_type ? *object.element_type : TypeInfo::unknown());
+        }
         return *member;
     }
 
@@ -1903,8 +2089,12 @@ TypeChecker::TypeInfo TypeChecker::check_force_unwrap_expr(const ForceUnwrapExpr
 }
 
 TypeChecker::TypeInfo TypeChecker::check_range_expr(const RangeExpr* expr) {
-    check_expr(expr->start.get());
-    check_expr(expr->end.get());
+    TypeInfo start = check_expr(expr->start.get());
+    TypeInfo end = check_expr(expr->end.get());
+    // Only Int bounds produce a Range value; other bounds are still valid as switch patterns
+    if (start.name == "Int" && end.name == "Int") {
+        return TypeInfo::builtin("Range");
+    }
     return TypeInfo::unknown();
 }
 
@@ -1914,11 +2104,13 @@ TypeChecker::TypeInfo TypeChecker::check_array_literal_expr(const ArrayLiteralEx
         TypeInfo current = check_expr(elem.get());
         if (is_unknown(element_type)) {
             element_type = current;
+        } else if (is_numeric(element_type) && is_numeric(current) && element_type.name != current.name) {
+            element_type = TypeInfo::builtin("Float");  // [1.5, 2] is stored as Floats
         } else if (!is_unknown(current) && !is_assignable(element_type, current)) {
             element_type = TypeInfo::builtin("Any");
         }
     }
-    return TypeInfo::builtin("Array");
+    return TypeInfo::array(element_type);
 }
 
 TypeChecker::TypeInfo TypeChecker::check_dict_literal_expr(const DictLiteralExpr* expr) {
@@ -2093,9 +2285,68 @@ TypeChecker::TypeInfo TypeChecker::type_from_annotation(const TypeAnnotation& an
     info.name = annotation.name;
     info.is_optional = annotation.is_optional;
     info.kind = it->second;
+    if (annotation.name == "Array" && annotation.generic_args.size() == 1) {
+        info.element_type = std::make_shared<TypeInfo>(type_from_annotation(annotation.generic_args[0], line));
+    }
     return info;
 }
 
+TypeChecker::TypeInfo TypeChecker::converted_type(const TypeInfo& expected, const Expr* expr,
+                                                  const TypeInfo& actual) const {
+    // let s: Set = [1, 2, 3]; the compiler emits a set literal in the same places
+    if (base_type(expected).name == "Set" && expr && expr->kind == ExprKind::ArrayLiteral) {
+        return expected;
+    }
+    return actual;
+}
+
+TypeChecker::TypeInfo TypeChecker::array_method_result(const TypeInfo& receiver, const std::string& method,
+                                                       const TypeInfo& declared,
+                                                       const std::vector<TypeInfo>& arg_types) const {
+    TypeInfo element = receiver.element_type ? *receiver.element_type : TypeInfo::unknown();
+    auto closure_result = [&](size_t index) -> std::optional<TypeInfo> {
+        if (index < arg_types.size() && arg_types[index].kind == TypeKind::Function &&
+            arg_types[index].return_type && !is_unknown(*arg_types[index].return_type)) {
+            return *arg_types[index].return_type;
+        }
+        return std::nullopt;
+    };
+
+    if (method == "sum") {
+        return element;
+    }
+    if (method == "min" || method == "max") {
+        return is_unknown(element) ? element : make_optional(element);
+    }
+    if (method == "filter" || method == "sorted") {
+        return TypeInfo::array(element);
+    }
+    if (method == "map") {
+        return TypeInfo::array(closure_result(0).value_or(TypeInfo::unknown()));
+    }
+    if (method == "reduce") {
+        // reduce(initial, combine): the closure's result, else the initial value's type
+        if (auto result = closure_result(1)) {
+            return *result;
+        }
+        return !arg_types.empty() ? arg_types[0] : TypeInfo::unknown();
+    }
+    if (method == "dot" || method == "adding" || method == "subtracting" || method == "multiplied" ||
+        method == "divided") {
+        // Int elements with a Float operand (scalar or array) produce Floats
+        TypeInfo result = element;
+        if (element.name == "Int" && !arg_types.empty()) {
+            const TypeInfo& operand = arg_types[0];
+            const TypeInfo* operand_element = operand.element_type ? operand.element_type.get() : &operand;
+            if (operand_element->name == "Float") {
+                result = TypeInfo::builtin("Float");
+            }
+        }
+        return method == "dot" ? result : TypeInfo::array(result);
+    }
+    return declared;
+}
+
 bool TypeChecker::is_assignable(const TypeInfo& expected, const TypeInfo& actual) const {
     if (is_unknown(expected) || is_unknown(actual)) {
         return true;
@@ -2317,7 +2568,7 @@ for (size_t i = 0; i < template_decl->generic_params.size(); ++i) {
         
         type_methods_[specialized_name].emplace(
             method->name,
-            TypeInfo::function(params, return_type));
+            TypeInfo::function(params, return_type, method->params));
         member_access_levels_[specialized_name][method->name] = method->access_level;
         
         if (method->is_mutating) {
@@ -78,14 +78,19 @@ private:
         std::vector<TypeInfo> param_types;
         std::shared_ptr<TypeInfo> return_type;
         std::vector<TupleElementInfo> tuple_elements;  // For tuple types
+        std::vector<std::string> param_labels{};    // Declared functions: external labels ("" = unlabeled)
+        std::vector<bool> param_has_default{};      // Declared functions: parameter has a default value
+        std::shared_ptr<TypeInfo> element_type{};   // Arrays: element type when known; Array methods: the receiver's
 
         static TypeInfo unknown();
         static TypeInfo builtin(std::string name, bool optional = false);
         static TypeInfo user(std::string name, bool optional = false);
         static TypeInfo protocol(std::string name, bool optional = false);
         static TypeInfo function(std::vector<TypeInfo> params, TypeInfo result);
+        static TypeInfo function(std::vector<TypeInfo> params, TypeInfo result, const std::vector<ParamDecl>& decls);
         static TypeInfo generic(std::string name, bool optional = false);
         static TypeInfo tuple(std::vector<TupleElementInfo> elements);
+        static TypeInfo array(const TypeInfo& element);
     };
 
     struct FunctionContext {
@@ -198,6 +203,12 @@ private:
 
     TypeInfo type_from_annotation(const TypeAnnotation& annotation, uint32_t line);
     bool is_assignable(const TypeInfo& expected, const TypeInfo& actual) const;
+    // Type expr takes where expected is wanted: an array literal becomes a Set
+    TypeInfo converted_type(const TypeInfo& expected, const Expr* expr, const TypeInfo& actual) const;
+    // Result of an Array method on receiver, given the method's declared type
+    // and the argument types; refines the declared Any/Array by element type
+    TypeInfo array_method_result(const TypeInfo& receiver, const std::string& method,
+                                 const TypeInfo& declared, const std::vector<TypeInfo>& arg_types) const;
     bool is_numeric(const TypeInfo& type) const;
     bool is_bool(const TypeInfo& type) const;
     bool is_string(const TypeInfo& type) const;
@@ -167,9 +167,9 @@ bool Value::equals(const Value& other) const {
                 auto* case_a = static_cast<EnumCaseObject*>(data_.object_val);
                 auto* case_b = static_cast<EnumCaseObject*>(other.data_.object_val);
                 
-                // Same enum type and same case name
+                // Same enum type and same case
                 return case_a->enum_type == case_b->enum_type &&
-                       case_a->case_name == case_b->case_name;
+                       case_a->discriminant == case_b->discriminant;
             }
             
             return false;
@@ -181,14 +181,15 @@ bool Value::equals(const Value& other) const {
 std::string ListObject::to_string() const {
     std::ostringstream oss;
     oss << "[";
-    for (size_t i = 0; i < elements.size(); ++i) {
+    for (size_t i = 0; i < size(); ++i) {
         if (i > 0) oss << ", ";
+        Value elem = at(i);
         // Wrap string values in quotes for display
-        if (elements[i].is_object() && elements[i].as_object() &&
-            elements[i].as_object()->type == ObjectType::String) {
-            oss << "\"" << elements[i].to_string() << "\"";
+        if (elem.is_object() && elem.as_object() &&
+            elem.as_object()->type == ObjectType::String) {
+            oss << "\"" << elem.to_string() << "\"";
         } else {
-            oss << elements[i].to_string();
+            oss << elem.to_string();
         }
     }
     oss << "]";
@@ -199,7 +200,7 @@ std::string MapObject::to_string() const {
     std::ostringstream oss;
     oss << "[";
     size_t count = 0;
-    for (const auto& [key, value] : entries) {
+    for (const auto& [key, value] : buffer->entries) {
         if (count++ > 0) oss << ", ";
         oss << "\"" << key << "\": ";
         // Wrap string values in quotes for display
@@ -214,12 +215,82 @@ std::string MapObject::to_string() const {
     return oss.str();
 }
 
+size_t ValueKeyHash::operator()(const Value& value) const {
+    switch (value.type()) {
+        case Value::Type::Null:
+        case Value::Type::Undefined:
+            return 0;
+        case Value::Type::Bool:
+            return std::hash<bool>{}(value.as_bool());
+        case Value::Type::Int:
+            return std::hash<Int>{}(value.as_int());
+        case Value::Type::Float: {
+            Float f = value.as_float();
+            return std::hash<Float>{}(f == 0.0 ? 0.0 : f);  // +0.0 and -0.0 hash alike
+        }
+        case Value::Type::Object: {
+            Object* obj = value.as_object();
+            if (!obj) {
+                return 0;
+            }
+            if (obj->type == ObjectType::String) {
+                return std::hash<std::string>{}(static_cast<StringObject*>(obj)->data);
+            }
+            if (obj->type == ObjectType::EnumCase) {
+                auto* enum_case = static_cast<EnumCaseObject*>(obj);
+                return std::hash<uint16_t>{}(enum_case->discriminant) ^
+                       (std::hash<const void*>{}(enum_case->enum_type) << 1);
+            }
+            return std::hash<const void*>{}(obj);
+        }
+    }
+    return 0;
+}
+
+bool ValueKeyEqual::operator()(const Value& a, const Value& b) const {
+    if (a.type() != b.type()) {
+        return false;
+    }
+    switch (a.type()) {
+        case Value::Type::Null:
+        case Value::Type::Undefined:
+            return true;
+        case Value::Type::Bool:
+            return a.as_bool() == b.as_bool();
+        case Value::Type::Int:
+            return a.as_int() == b.as_int();
+        case Value::Type::Float:
+            return a.as_float() == b.as_float();
+        case Value::Type::Object:
+            return a.equals(b);
+    }
+    return false;
+}
+
+std::string SetObject::to_string() const {
+    std::ostringstream oss;
+    const auto& elements = buffer->elements;
+    oss << "Set([";
+    for (size_t i = 0; i < elements.size(); ++i) {
+        if (i > 0) oss << ", ";
+        // Wrap string values in quotes for display
+        if (elements[i].is_object() && elements[i].as_object() &&
+            elements[i].as_object()->type == ObjectType::String) {
+            oss << "\"" << elements[i].to_string() << "\"";
+        } else {
+            oss << elements[i].to_string();
+        }
+    }
+    oss << "])";
+    return oss.str();
+}
+
 FunctionObject::FunctionObject(std::string function_name,
                            std::vector<std::string> function_params,
                            std::vector<std::string> function_param_labels,
                            std::vector<Value> function_param_defaults,
                            std::vector<bool> function_param_has_default,
-                           std::shared_ptr<Assembly> function_chunk,
+                           uint32_t function_body,
                            bool initializer,
                            bool override_flag)
 : Object(ObjectType::Function),
@@ -228,7 +299,7 @@ FunctionObject::FunctionObject(std::string function_name,
   param_labels(std::move(function_param_labels)),
   param_defaults(std::move(function_param_defaults)),
   param_has_default(std::move(function_param_has_default)),
-  chunk(std::move(function_chunk)),
+  body(function_body),
   is_initializer(initializer),
   is_override(override_flag) {}
 
@@ -250,15 +321,6 @@ size_t FunctionObject::memory_size() const {
     }
     total += param_defaults.capacity() * sizeof(Value);
     total += param_has_default.capacity() * sizeof(bool);
-    if (chunk) {
-        total += chunk->global_constant_pool.capacity() * sizeof(Value);
-        total += chunk->string_table.capacity() * sizeof(std::string);
-        total += chunk->function_prototypes.capacity() * sizeof(FunctionPrototype);
-        for (const auto& body : chunk->method_bodies) {
-            total += body.bytecode.capacity() * sizeof(uint8_t);
-            total += body.line_info.capacity() * sizeof(uint32_t);
-        }
-    }
     return total;
 }
 
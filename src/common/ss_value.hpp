@@ -191,39 +191,262 @@ public:
     }
 };
 
+// Array element storage. Numeric arrays keep raw payloads in a packed buffer
+// (8 bytes per element, no type tags): Int storage widens to Float when a
+// Float arrives and Float storage converts the Ints it is given. The first
+// non-numeric element converts the array to boxed Values for good.
+enum class ListStorage : uint8_t {
+    Boxed,
+    Int,
+    Float
+};
+
+// Array element storage, shared copy-on-write by the ListObjects that were
+// handed off by value from one another (see ListObject::share). The buffer
+// owns the element references; it is copied on the first mutation made
+// through a ListObject while refs > 1.
+struct ListBuffer {
+    uint32_t refs{1};
+    ListStorage storage{ListStorage::Boxed};
+    std::vector<Value> elements;  // Boxed storage (owns object references)
+    std::vector<Int> ints;        // Packed storage when storage == Int
+    std::vector<Float> floats;    // Packed storage when storage == Float
+};
+
 class ListObject : public Object {
 public:
-    std::vector<Value> elements;
-    
-    ListObject() : Object(ObjectType::List) {}
+    ListBuffer* buffer;
     
+    ListObject() : Object(ObjectType::List), buffer(new ListBuffer()) {}
+    explicit ListObject(ListBuffer* shared) : Object(ObjectType::List), buffer(shared) {
+        ++buffer->refs;
+    }
+    ~ListObject() override {
+        if (--buffer->refs == 0) {
+            delete buffer;
+        }
+    }
+
+    ListStorage storage() const { return buffer->storage; }
+    bool is_packed() const { return buffer->storage != ListStorage::Boxed; }
+    bool is_unique() const { return buffer->refs == 1; }
+
+    size_t size() const {
+        switch (buffer->storage) {
+            case ListStorage::Int:   return buffer->ints.size();
+            case ListStorage::Float: return buffer->floats.size();
+            default:                 return buffer->elements.size();
+        }
+    }
+    bool empty() const { return size() == 0; }
+
+    // Borrowed element (packed elements are scalars)
+    Value at(size_t index) const {
+        switch (buffer->storage) {
+            case ListStorage::Int:   return Value::from_int(buffer->ints[index]);
+            case ListStorage::Float: return Value::from_float(buffer->floats[index]);
+            default:                 return buffer->elements[index];
+        }
+    }
+
+    // Appends a value whose reference (if any) the list takes over.
+    // For lists still being built: neither unshares nor records stats; see append().
+    void push(Value value) {
+        ListBuffer& buf = *buffer;
+        if (buf.storage == ListStorage::Boxed && buf.elements.empty()) {
+            if (value.is_int()) buf.storage = ListStorage::Int;
+            else if (value.is_float()) buf.storage = ListStorage::Float;
+        }
+        if (buf.storage == ListStorage::Int && value.is_float()) {
+            widen_to_float();
+        }
+        if (buf.storage == ListStorage::Int && value.is_int()) {
+            buf.ints.push_back(value.as_int());
+            return;
+        }
+        if (buf.storage == ListStorage::Float && value.is_number()) {
+            buf.floats.push_back(value.is_int() ? static_cast<Float>(value.as_int()) : value.as_float());
+            return;
+        }
+        box();
+        buf.elements.push_back(value);
+    }
+
+    void reserve(size_t count) {
+        switch (buffer->storage) {
+            case ListStorage::Int:   buffer->ints.reserve(count); break;
+            case ListStorage::Float: buffer->floats.reserve(count); break;
+            default:                 buffer->elements.reserve(count); break;
+        }
+    }
+
+    // Converts packed storage to boxed Values (no-op when already boxed)
+    void box();
+    // Converts Int storage to Float storage (no-op for any other storage)
+    void widen_to_float();
+    // Truncates to count elements; removed boxed references are not released.
+    void truncate(size_t count);
+
+    // New ListObject sharing this list's buffer (O(1) value copy)
+    ListObject* share(VM& vm);
+    // Copies the buffer if it is shared; call before any in-place mutation
+    void make_unique(VM& vm);
+
     void append(VM& vm, Value value);
+    // Replaces element at index: releases the old reference, retains the new one
+    void assign(VM& vm, size_t index, Value value);
     std::string to_string() const override;
     size_t memory_size() const override {
-        return sizeof(ListObject) + elements.capacity() * sizeof(Value);
+        return sizeof(ListObject) + sizeof(ListBuffer) +
+               buffer->elements.capacity() * sizeof(Value) +
+               buffer->ints.capacity() * sizeof(Int) +
+               buffer->floats.capacity() * sizeof(Float);
     }
 };
 
+// Dictionary entries, shared copy-on-write like ListBuffer.
+struct MapBuffer {
+    uint32_t refs{1};
+    std::unordered_map<std::string, Value> entries;
+};
+
 class MapObject : public Object {
 public:
-    std::unordered_map<std::string, Value> entries;
-    
-    MapObject() : Object(ObjectType::Map) {}
+    MapBuffer* buffer;
     
+    MapObject() : Object(ObjectType::Map), buffer(new MapBuffer()) {}
+    explicit MapObject(MapBuffer* shared) : Object(ObjectType::Map), buffer(shared) {
+        ++buffer->refs;
+    }
+    ~MapObject() override {
+        if (--buffer->refs == 0) {
+            delete buffer;
+        }
+    }
+
+    // Read access; mutate through insert() or after make_unique()
+    const std::unordered_map<std::string, Value>& entries() const { return buffer->entries; }
+    bool is_unique() const { return buffer->refs == 1; }
+
+    MapObject* share(VM& vm);
+    void make_unique(VM& vm);
+
+    // Stores value under key, taking over its reference and releasing any
+    // replaced one. Unshares the buffer first.
     void insert(VM& vm, std::string key, Value value);
     std::string to_string() const override;
     size_t memory_size() const override {
-        size_t total = sizeof(MapObject);
-        for (const auto& [key, value] : entries) {
+        size_t total = sizeof(MapObject) + sizeof(MapBuffer);
+        for (const auto& [key, value] : buffer->entries) {
             total += sizeof(std::string) + sizeof(Value);
             total += key.capacity();
         }
         // Approximate unordered_map bucket overhead.
-        total += entries.bucket_count() * sizeof(void*);
+        total += buffer->entries.bucket_count() * sizeof(void*);
+        return total;
+    }
+};
+
+// Hashing for Set elements. Strings hash by content (same std::hash<std::string>
+// as MapObject keys); scalars hash by payload; other objects by identity.
+struct ValueKeyHash {
+    size_t operator()(const Value& value) const;
+};
+
+// Strict key equality: no Int/Float coercion and no epsilon compare,
+// so that equal keys always produce equal hashes.
+struct ValueKeyEqual {
+    bool operator()(const Value& a, const Value& b) const;
+};
+
+// Set elements, shared copy-on-write like ListBuffer. Dense storage in
+// insertion order; removal swaps with the last element. Keeps iteration by
+// ordinal position O(1) without materializing a list.
+struct SetBuffer {
+    uint32_t refs{1};
+    std::vector<Value> elements;
+    std::unordered_map<Value, size_t, ValueKeyHash, ValueKeyEqual> index;
+};
+
+class SetObject : public Object {
+public:
+    SetBuffer* buffer;
+
+    SetObject() : Object(ObjectType::Set), buffer(new SetBuffer()) {}
+    explicit SetObject(SetBuffer* shared) : Object(ObjectType::Set), buffer(shared) {
+        ++buffer->refs;
+    }
+    ~SetObject() override {
+        if (--buffer->refs == 0) {
+            delete buffer;
+        }
+    }
+
+    // Read access; mutate through insert()/remove()/remove_all()
+    const std::vector<Value>& elements() const { return buffer->elements; }
+    bool is_unique() const { return buffer->refs == 1; }
+
+    bool contains(const Value& value) const {
+        return buffer->index.find(value) != buffer->index.end();
+    }
+
+    // For sets still being built: does not unshare
+    void reserve(size_t count) {
+        buffer->elements.reserve(count);
+        buffer->index.reserve(count);
+    }
+
+    SetObject* share(VM& vm);
+    void make_unique(VM& vm);
+
+    // Returns true if the value was not already present (retains on insert).
+    bool insert(VM& vm, Value value);
+    // Removes value; ownership of the stored element is moved into *removed
+    // when provided, otherwise it is released. Returns false if absent.
+    bool remove(VM& vm, const Value& value, Value* removed = nullptr);
+    // Removes and releases every element
+    void remove_all(VM& vm);
+
+    std::string to_string() const override;
+    size_t memory_size() const override {
+        size_t total = sizeof(SetObject) + sizeof(SetBuffer);
+        total += buffer->elements.capacity() * sizeof(Value);
+        total += buffer->index.size() * (sizeof(Value) + sizeof(size_t));
+        // Approximate unordered_map bucket overhead.
+        total += buffer->index.bucket_count() * sizeof(void*);
         return total;
     }
 };
 
+// Arrays, dictionaries and sets are values: a copy shares the buffer and the
+// first mutation through either object copies it.
+inline bool is_value_collection(ObjectType type) {
+    return type == ObjectType::List || type == ObjectType::Map || type == ObjectType::Set;
+}
+// New List/Map/Set object sharing collection's buffer (rc:0 result)
+Object* share_collection(VM& vm, Object* collection);
+
+// Integer range (a...b / a..<b). Bounds only; elements are never materialized.
+class RangeObject : public Object {
+public:
+    Int lower{0};
+    Int upper{0};
+    bool inclusive{false};
+
+    RangeObject(Int lower_bound, Int upper_bound, bool is_inclusive)
+        : Object(ObjectType::Range), lower(lower_bound), upper(upper_bound), inclusive(is_inclusive) {}
+
+    // One past the last element
+    Int end() const { return inclusive ? upper + 1 : upper; }
+    Int count() const { return end() > lower ? end() - lower : 0; }
+    bool contains(Int value) const { return value >= lower && value < end(); }
+
+    std::string to_string() const override {
+        return std::to_string(lower) + (inclusive ? "..." : "..<") + std::to_string(upper);
+    }
+    size_t memory_size() const override { return sizeof(RangeObject); }
+};
+
 class FunctionObject : public Object {
 public:
     std::string name;
@@ -231,7 +454,7 @@ public:
     std::vector<std::string> param_labels;
     std::vector<Value> param_defaults;
     std::vector<bool> param_has_default;
-    std::shared_ptr<Assembly> chunk;
+    uint32_t body;  // Entry MethodBody of the module; kInvalidBody for builtins
     bool is_initializer{false};
     bool is_override{false};
 
@@ -240,7 +463,7 @@ public:
                    std::vector<std::string> function_param_labels,
                    std::vector<Value> function_param_defaults,
                    std::vector<bool> function_param_has_default,
-                   std::shared_ptr<Assembly> function_chunk,
+                   uint32_t function_body,
                    bool initializer,
                    bool override_flag = false);
 
@@ -275,6 +498,8 @@ public:
     std::vector<PropertyInfo> properties;
     std::vector<ComputedPropertyInfo> computed_properties;
     ClassObject* superclass{nullptr};
+    uint16_t type_id{0xFFFF};       // VM runtime type id
+    std::vector<uint16_t> display;  // Type ids from the root class down to this one
 
     explicit ClassObject(std::string n)
         : Object(ObjectType::Class), name(std::move(n)) {}
@@ -402,6 +627,7 @@ public:
     std::vector<PropertyInfo> properties;
     std::vector<ComputedPropertyInfo> computed_properties;
     std::unordered_map<std::string, bool> mutating_methods;  // method_name -> is_mutating
+    uint16_t type_id{0xFFFF};  // VM runtime type id
 
     explicit StructObject(std::string n)
         : Object(ObjectType::Struct), name(std::move(n)) {}
@@ -475,6 +701,7 @@ public:
     std::unordered_map<std::string, Value> methods;  // closures
     std::unordered_map<std::string, Value> cases;    // case_name -> EnumCaseObject
     std::vector<ComputedPropertyInfo> computed_properties;
+    uint16_t type_id{0xFFFF};  // VM runtime type id
 
     explicit EnumObject(std::string n)
         : Object(ObjectType::Enum), name(std::move(n)) {}
@@ -501,24 +728,36 @@ public:
     }
 };
 
-// Enum case instance
+// Immutable per-case metadata, shared by the template case and every value built from it
+struct EnumCaseInfo {
+    std::string name;
+    uint16_t discriminant{0};  // Program-wide id of the case name, assigned by the compiler
+    std::vector<std::string> associated_labels;  // Labels for associated values
+};
+
+// Enum case instance. Payload-less cases are the single template object stored in
+// EnumObject::cases; payload cases add only their associated values.
 class EnumCaseObject : public Object {
 public:
     EnumObject* enum_type;
-    std::string case_name;
+    std::shared_ptr<const EnumCaseInfo> info;
+    uint16_t discriminant;  // Copy of info->discriminant, compared when matching
     Value raw_value;  // Optional raw value (Int, String, etc.)
     std::vector<Value> associated_values;  // For associated values
-    std::vector<std::string> associated_labels;  // Labels for associated values
 
-    EnumCaseObject(EnumObject* e, std::string name)
-        : Object(ObjectType::EnumCase), enum_type(e), case_name(std::move(name)), raw_value(Value::null()) {}
+    EnumCaseObject(EnumObject* e, std::shared_ptr<const EnumCaseInfo> case_info)
+        : Object(ObjectType::EnumCase), enum_type(e), info(std::move(case_info)),
+          discriminant(info->discriminant), raw_value(Value::null()) {}
+
+    const std::string& case_name() const { return info->name; }
+    const std::vector<std::string>& associated_labels() const { return info->associated_labels; }
 
     std::string to_string() const override {
         std::string result;
         if (enum_type) {
-            result = enum_type->name + "." + case_name;
+            result = enum_type->name + "." + case_name();
         } else {
-            result = case_name;
+            result = case_name();
         }
         
         // Include associated values if present
@@ -535,12 +774,7 @@ public:
     }
 
     size_t memory_size() const override {
-        size_t total = sizeof(EnumCaseObject) + case_name.capacity();
-        total += associated_values.capacity() * sizeof(Value);
-        for (const auto& label : associated_labels) {
-            total += label.capacity();
-        }
-        return total;
+        return sizeof(EnumCaseObject) + associated_values.capacity() * sizeof(Value);
     }
 };
 
@@ -5,8 +5,10 @@
  * @file ss_value_vm.cpp
  * @brief VM-dependent object operations.
  *
- * Implements object methods requiring VM access: ListObject::append,
- * DictObject operations, and StructInstanceObject::copy_with_property.
+ * Implements object methods requiring VM access: ListObject storage
+ * (append/assign with packed Int/Float buffers), copy-on-write sharing for
+ * ListObject/MapObject/SetObject buffers, SetObject insert/remove, and
+ * StructInstanceObject::deep_copy.
  */
 
 #include "pch.h"
@@ -15,17 +17,227 @@
 
 namespace swive {
 
+namespace {
+    void retain_elements(const std::vector<Value>& values) {
+        for (const auto& value : values) {
+            if (value.is_object() && value.ref_type() == RefType::Strong && value.as_object()) {
+                RC::retain(value.as_object());
+            }
+        }
+    }
+} // namespace
+
+void ListObject::box() {
+    ListBuffer& buf = *buffer;
+    if (buf.storage == ListStorage::Int) {
+        buf.elements.reserve(buf.elements.size() + buf.ints.size());
+        for (Int v : buf.ints) buf.elements.push_back(Value::from_int(v));
+        buf.ints.clear();
+        buf.ints.shrink_to_fit();
+    } else if (buf.storage == ListStorage::Float) {
+        buf.elements.reserve(buf.elements.size() + buf.floats.size());
+        for (Float v : buf.floats) buf.elements.push_back(Value::from_float(v));
+        buf.floats.clear();
+        buf.floats.shrink_to_fit();
+    }
+    buf.storage = ListStorage::Boxed;
+}
+
+void ListObject::widen_to_float() {
+    ListBuffer& buf = *buffer;
+    if (buf.storage != ListStorage::Int) {
+        return;
+    }
+    buf.floats.assign(buf.ints.begin(), buf.ints.end());
+    buf.ints.clear();
+    buf.ints.shrink_to_fit();
+    buf.storage = ListStorage::Float;
+}
+
+void ListObject::truncate(size_t count) {
+    ListBuffer& buf = *buffer;
+    switch (buf.storage) {
+        case ListStorage::Int:   buf.ints.resize(std::min(count, buf.ints.size())); break;
+        case ListStorage::Float: buf.floats.resize(std::min(count, buf.floats.size())); break;
+        default:                 buf.elements.resize(std::min(count, buf.elements.size())); break;
+    }
+}
+
+ListObject* ListObject::share(VM& vm) {
+    return vm.allocate_object<ListObject>(buffer);
+}
+
+void ListObject::make_unique(VM& vm) {
+    if (buffer->refs == 1) {
+        return;
+    }
+    // The copy takes its own reference to every boxed element
+    auto* copy = new ListBuffer(*buffer);
+    copy->refs = 1;
+    retain_elements(copy->elements);
+    --buffer->refs;
+    buffer = copy;
+    vm.record_allocation_delta(*this, memory_size());
+}
+
 void ListObject::append(VM& vm, Value value) {
-    elements.push_back(value);
+    make_unique(vm);
+    push(value);
+    vm.record_allocation_delta(*this, memory_size());
+}
+
+void ListObject::assign(VM& vm, size_t index, Value value) {
+    make_unique(vm);
+    ListBuffer& buf = *buffer;
+    if (buf.storage == ListStorage::Int && value.is_float()) {
+        widen_to_float();
+    }
+    if (buf.storage == ListStorage::Int && value.is_int()) {
+        buf.ints[index] = value.as_int();
+        return;
+    }
+    if (buf.storage == ListStorage::Float && value.is_number()) {
+        buf.floats[index] = value.is_int() ? static_cast<Float>(value.as_int()) : value.as_float();
+        return;
+    }
+    if (is_packed()) {
+        box();
+        vm.record_allocation_delta(*this, memory_size());
+    }
+    Value& slot = buf.elements[index];
+    if (value.is_object() && value.ref_type() == RefType::Strong && value.as_object()) {
+        RC::retain(value.as_object());
+    }
+    Value old = slot;
+    slot = value;
+    if (old.is_object() && old.ref_type() == RefType::Strong && old.as_object()) {
+        RC::release(&vm, old.as_object());
+    }
+}
+
+MapObject* MapObject::share(VM& vm) {
+    return vm.allocate_object<MapObject>(buffer);
+}
+
+void MapObject::make_unique(VM& vm) {
+    if (buffer->refs == 1) {
+        return;
+    }
+    auto* copy = new MapBuffer(*buffer);
+    copy->refs = 1;
+    for (const auto& [key, value] : copy->entries) {
+        if (value.is_object() && value.ref_type() == RefType::Strong && value.as_object()) {
+            RC::retain(value.as_object());
+        }
+    }
+    --buffer->refs;
+    buffer = copy;
     vm.record_allocation_delta(*this, memory_size());
 }
 
 void MapObject::insert(VM& vm, std::string key, Value value) {
-    auto [it, inserted] = entries.emplace(std::move(key), value);
+    make_unique(vm);
+    if (value.is_object() && value.ref_type() == RefType::Strong && value.as_object()) {
+        RC::retain(value.as_object());
+    }
+    auto [it, inserted] = buffer->entries.emplace(std::move(key), value);
     if (!inserted) {
+        Value old = it->second;
         it->second = value;
+        if (old.is_object() && old.ref_type() == RefType::Strong && old.as_object()) {
+            RC::release(&vm, old.as_object());
+        }
+    }
+    vm.record_allocation_delta(*this, memory_size());
+}
+
+SetObject* SetObject::share(VM& vm) {
+    return vm.allocate_object<SetObject>(buffer);
+}
+
+void SetObject::make_unique(VM& vm) {
+    if (buffer->refs == 1) {
+        return;
+    }
+    auto* copy = new SetBuffer(*buffer);
+    copy->refs = 1;
+    retain_elements(copy->elements);
+    --buffer->refs;
+    buffer = copy;
+    vm.record_allocation_delta(*this, memory_size());
+}
+
+bool SetObject::insert(VM& vm, Value value) {
+    if (contains(value)) {
+        return false;
+    }
+    make_unique(vm);
+    buffer->index.emplace(value, buffer->elements.size());
+    if (value.is_object() && value.ref_type() == RefType::Strong && value.as_object()) {
+        RC::retain(value.as_object());
+    }
+    buffer->elements.push_back(value);
+    vm.record_allocation_delta(*this, memory_size());
+    return true;
+}
+
+bool SetObject::remove(VM& vm, const Value& value, Value* removed) {
+    if (!contains(value)) {
+        return false;
+    }
+    make_unique(vm);
+    auto& elements = buffer->elements;
+    auto& index = buffer->index;
+    auto it = index.find(value);
+    size_t slot = it->second;
+    Value stored = elements[slot];
+    index.erase(it);
+
+    // Swap-remove keeps storage dense
+    size_t last = elements.size() - 1;
+    if (slot != last) {
+        elements[slot] = elements[last];
+        index[elements[slot]] = slot;
+    }
+    elements.pop_back();
+
+    if (removed) {
+        *removed = stored;  // Transfer the set's reference to the caller
+    } else if (stored.is_object() && stored.ref_type() == RefType::Strong && stored.as_object()) {
+        RC::release(&vm, stored.as_object());
     }
     vm.record_allocation_delta(*this, memory_size());
+    return true;
+}
+
+void SetObject::remove_all(VM& vm) {
+    if (buffer->elements.empty()) {
+        return;
+    }
+    if (!is_unique()) {
+        // Other sets keep the old buffer and its references
+        --buffer->refs;
+        buffer = new SetBuffer();
+        vm.record_allocation_delta(*this, memory_size());
+        return;
+    }
+    std::vector<Value> old;
+    old.swap(buffer->elements);
+    buffer->index.clear();
+    for (const Value& elem : old) {
+        if (elem.is_object() && elem.ref_type() == RefType::Strong && elem.as_object()) {
+            RC::release(&vm, elem.as_object());
+        }
+    }
+    vm.record_allocation_delta(*this, memory_size());
+}
+
+Object* share_collection(VM& vm, Object* collection) {
+    switch (collection->type) {
+        case ObjectType::List: return static_cast<ListObject*>(collection)->share(vm);
+        case ObjectType::Map:  return static_cast<MapObject*>(collection)->share(vm);
+        default:               return static_cast<SetObject*>(collection)->share(vm);
+    }
 }
 
 // StructInstanceObject deep copy for value semantics
@@ -44,6 +256,13 @@ StructInstanceObject* StructInstanceObject::deep_copy(VM& vm) const {
             auto* nested_copy = nested->deep_copy(vm);
             // No retain - allocate's rc:1 is transferred to field ownership
             copy->fields[name] = Value::from_object(nested_copy);
+        } else if (value.is_object() && value.as_object() &&
+                   value.ref_type() == RefType::Strong &&
+                   is_value_collection(value.as_object()->type)) {
+            // Collections are values too: share the buffer copy-on-write
+            Object* shared = share_collection(vm, value.as_object());
+            RC::retain(shared);
+            copy->fields[name] = Value::from_object(shared);
         } else {
             // Retain object values for storage in the copy (shared reference)
             if (value.is_object() && value.ref_type() == RefType::Strong && value.as_object()) {
@@ -30,8 +30,9 @@ namespace swive {
     } fast_io_init;
 
     VM::VM(VMConfig config)
-        : config_(config) {
-        stack_.reserve(config_.initial_stack_size);
+        : config_(config),
+          stack_(config.max_stack_size),
+          call_frames_(config.max_call_depth) {
     }
 
     VM::~VM() {
@@ -44,7 +45,10 @@ namespace swive {
             }
         }
 
-        // 2. Clean up globals (release all references)
+        // 2. Drop the function cache's references
+        release_function_cache();
+
+        // 3. Clean up globals (release all references)
         for (auto& [name, val] : globals_) {
             if (val.is_object() && val.ref_type() == RefType::Strong && val.as_object() && !val.as_object()->rc.is_dead) {
                 RC::release(this, val.as_object());
@@ -52,7 +56,7 @@ namespace swive {
         }
         globals_.clear();
 
-        // 3. Clean up any remaining objects in the linked list
+        // 4. Clean up any remaining objects in the linked list
         // These are objects with reference cycles or other leaks
         // We need to force delete them without calling release_children
         // (which could access already-deleted objects)
@@ -107,10 +111,6 @@ namespace swive {
 
 
     void VM::push(Value val) {
-        if (stack_.size() >= config_.max_stack_size) {
-            throw std::runtime_error("Stack overflow");
-        }
-
         // Handle RC for object values
         if (val.is_object() && val.ref_type() == RefType::Strong) {
             RC::retain(val.as_object());
@@ -124,9 +124,6 @@ namespace swive {
     void VM::push_new(Object* obj) {
         // Push a newly allocated object (rc:0 at creation)
         // Retain to give ownership to stack
-        if (stack_.size() >= config_.max_stack_size) {
-            throw std::runtime_error("Stack overflow");
-        }
         if (obj) {
             RC::retain(obj);
             stats_.retain_count++;
@@ -224,7 +221,7 @@ namespace swive {
     }
 
     bool VM::is_builtin_type_name(const std::string& name) const {
-        return name == "Int" || name == "Float" || name == "Bool" || name == "String";
+        return name == "Int" || name == "Float" || name == "Bool" || name == "String" || name == "Set";
     }
 
     void VM::remove_from_objects_list(Object* obj) {
@@ -293,7 +290,7 @@ namespace swive {
             func = static_cast<FunctionObject*>(method_obj);
         }
 
-        if (!func || !func->chunk) return;
+        if (!func || func->body == kInvalidBody) return;
 
         // Save current execution state
         const Assembly* saved_chunk = chunk_;
@@ -314,15 +311,14 @@ namespace swive {
                 0,                      // return_address (not used)
                 chunk_,                 // saved chunk
                 saved_body,             // saved body index
-                "deinit",              // function name
+                func,                   // callee (name for debugging)
                 closure,                // closure (if any)
                 false                   // is_initializer
             );
 
-            // Switch to deinit's chunk
-            chunk_ = func->chunk.get();
-            current_body_idx_ = entry_body_index(*chunk_);
-            set_active_body(current_body_idx_);
+            // Switch to deinit's body
+            current_body_idx_ = func->body;
+            enter_body(current_body_idx_);
             ip_ = 0;
 
             // Execute deinit bytecode until OP_RETURN
@@ -336,8 +332,9 @@ namespace swive {
 
                 // Execute the OPCODE with proper RC handling
                 switch (op) {
-                    case OpCode::OP_CONSTANT: {
-                        Value val = read_constant();
+                    case OpCode::OP_CONSTANT:
+                    case OpCode::OP_CONSTANT_LONG: {
+                        Value val = op == OpCode::OP_CONSTANT ? read_constant() : read_constant_long();
                         // Retain for stack if object
                         if (val.is_object() && val.ref_type() == RefType::Strong && val.as_object()) {
                             RC::retain(val.as_object());
@@ -345,8 +342,9 @@ namespace swive {
                         stack_.push_back(val);
                         break;
                     }
-                    case OpCode::OP_STRING: {
-                        const std::string& str = read_string();
+                    case OpCode::OP_STRING:
+                    case OpCode::OP_STRING_LONG: {
+                        const std::string& str = op == OpCode::OP_STRING ? read_string() : read_string_long();
                         auto* obj = allocate_object<StringObject>(str);
                         push_new(obj);  // Use push_new for proper RC
                         break;
@@ -398,6 +396,17 @@ namespace swive {
                         }
                         break;
                     }
+                    case OpCode::OP_POP_N: {
+                        uint16_t count = read_short();
+                        for (uint16_t i = 0; i < count; ++i) {
+                            Value val = stack_.back();
+                            stack_.pop_back();
+                            if (val.is_object() && val.ref_type() == RefType::Strong && val.as_object()) {
+                                RC::release(this, val.as_object());
+                            }
+                        }
+                        break;
+                    }
                     case OpCode::OP_NIL:
                         stack_.push_back(Value::null());
                         break;
@@ -443,12 +452,16 @@ namespace swive {
     // NOTE: interpret() is moved to ss_runner.hpp since it depends on Compiler components
 
     Value VM::execute(const Assembly& chunk) {
+        // Cache keys are prototype addresses, which a different Assembly may reuse
+        release_function_cache();
         chunk_ = &chunk;
+        program_ = &chunk;
+        load_type_table(chunk);
         current_body_idx_ = entry_body_index(chunk);
-        set_active_body(current_body_idx_);
         ip_ = 0;
         stack_.clear();
         call_frames_.clear();
+        enter_body(current_body_idx_);
         auto ensure_builtin = [&](const std::string& name) {
             if (has_global(name)) {
                 return;
@@ -463,7 +476,7 @@ namespace swive {
                 std::move(labels),
                 std::move(defaults),
                 std::move(has_defaults),
-                nullptr,
+                kInvalidBody,
                 false);
             set_global_new(name, func);  // Transfer ownership
         };
@@ -471,11 +484,12 @@ namespace swive {
         ensure_builtin("Float");
         ensure_builtin("Bool");
         ensure_builtin("String");
+        ensure_builtin("Set");
         Value result = run();
         return result;
     }
 
-    Value VM::run()
+    Value VM::run(size_t stop_depth)
     {
         while(true)
         {
@@ -526,14 +540,17 @@ namespace swive {
                 }
                 close_upvalues(stack_.data() + frame.stack_base);
                 // Pop all locals and arguments (releases their refcounts)
-                size_t callee_index = frame.stack_base - 1;
-                while (stack_.size() > callee_index) {
+                size_t frame_start = frame.frame_start();
+                while (stack_.size() > frame_start) {
                     discard();
                 }
                 chunk_ = frame.chunk;
                 ip_ = frame.return_address;
                 current_body_idx_ = frame.body_index;
                 set_active_body(current_body_idx_);
+                if (call_frames_.size() == stop_depth) {
+                    return result;  // Back to the native caller of call_value()
+                }
                 // pop()에서 ownership을 이전받았으므로 retain 없이 스택에 추가
                 // initializer는 위에서 이미 retain했고, non-initializer는 pop()에서 ownership 이전됨
                 stack_.push_back(result);
@@ -571,7 +588,7 @@ namespace swive {
                     auto* ec = static_cast<EnumCaseObject*>(top.as_object());
                     if (ec->enum_type && ec->enum_type->name == "$Expected") {
                         pop();
-                        if (ec->case_name == "value" && !ec->associated_values.empty()) {
+                        if (ec->case_name() == "value" && !ec->associated_values.empty()) {
                             push(ec->associated_values[0]);
                         } else {
                             push(Value::null());
@@ -582,6 +599,9 @@ namespace swive {
             }
             case OpCode::OP_HALT:
                 return stack_.empty() ? Value::null() : pop();
+            default:
+                // Every other opcode is fully handled by its table handler
+                break;
             }
         }
     }
@@ -624,6 +644,56 @@ namespace swive {
         current_body_ = &chunk_->method_bodies[idx];
     }
 
+    void VM::reuse_caller_frame() {
+        CallFrame callee = call_frames_.back();
+        CallFrame& caller = call_frames_[call_frames_.size() - 2];
+        // Initializers return self and mutating methods write self back on
+        // return, so those frames have to stay.
+        if (caller.is_initializer || caller.is_mutating || callee.is_initializer || callee.is_mutating) {
+            return;
+        }
+
+        // Drop the caller's callee slot, arguments and locals, then slide the
+        // new callee and its arguments down into their place.
+        const size_t dest = caller.frame_start();
+        const size_t src = callee.frame_start();
+        close_upvalues(stack_.data() + caller.stack_base);
+        for (size_t i = dest; i < src; ++i) {
+            Value val = stack_[i];
+            stack_[i] = Value::null();
+            if (val.is_object() && val.ref_type() == RefType::Strong && val.as_object()) {
+                RC::release(this, val.as_object());
+                stats_.release_count++;
+                record_rc_operation();
+            }
+        }
+        stack_.erase(stack_.begin() + dest, stack_.begin() + src);
+
+        callee.stack_base -= src - dest;
+        callee.return_address = caller.return_address;
+        callee.chunk = caller.chunk;
+        callee.body_index = caller.body_index;
+        call_frames_.pop_back();
+        call_frames_.back() = callee;
+    }
+
+    // Headroom beyond max_stack_depth for values the VM pushes inside a
+    // single instruction (receivers, accessor calls, call_value arguments).
+    static constexpr size_t kStackSlack = 32;
+
+    void VM::enter_body(body_idx idx) {
+        set_active_body(idx);
+        if (current_body_) {
+            ensure_stack_headroom(current_body_->max_stack_depth);
+        }
+    }
+
+    void VM::ensure_stack_headroom(size_t slots) const {
+        if (stack_.headroom() < slots + kStackSlack) {
+            throw std::runtime_error("Stack overflow");
+        }
+    }
+
     uint8_t VM::read_byte() {
         return active_bytecode()[ip_++];
     }
@@ -634,13 +704,25 @@ namespace swive {
         return static_cast<uint16_t>((high << 8) | low);
     }
 
+    uint32_t VM::read_long() {
+        uint32_t high = read_byte();
+        return (high << 16) | read_short();
+    }
+
     Value VM::read_constant() {
-        uint16_t idx = read_short();
+        return constant_at(read_short());
+    }
+
+    Value VM::read_constant_long() {
+        return constant_at(read_long());
+    }
+
+    Value VM::constant_at(uint32_t idx) const {
         const auto& pool = chunk_->global_constant_pool;
         if (idx >= pool.size()) {
             std::string func_info = "(top-level)";
             if (!call_frames_.empty()) {
-                func_info = call_frames_.back().function_name;
+                func_info = call_frames_.back().function_name();
             }
             std::string msg = "Constant index out of range: idx=" + std::to_string(idx)
                 + " pool_size=" + std::to_string(pool.size())
@@ -655,7 +737,14 @@ namespace swive {
     }
 
     const std::string& VM::read_string() {
-        uint16_t idx = read_short();
+        return string_at(read_short());
+    }
+
+    const std::string& VM::read_string_long() {
+        return string_at(read_long());
+    }
+
+    const std::string& VM::string_at(uint32_t idx) const {
         if (idx >= chunk_->string_table.size()) {
             std::string msg = "String constant index out of range: idx=" + std::to_string(idx)
                 + " table_size=" + std::to_string(chunk_->string_table.size())
@@ -665,6 +754,14 @@ namespace swive {
         return chunk_->string_table[idx];
     }
 
+    uint16_t VM::read_type_id() {
+        uint16_t idx = read_short();
+        if (idx >= program_type_ids_.size()) {
+            throw std::runtime_error("Type index out of range: idx=" + std::to_string(idx));
+        }
+        return program_type_ids_[idx];
+    }
+
     uint32_t VM::read_signature_param_count(signature_idx offset) const {
         if (!chunk_) {
             throw std::runtime_error("No active chunk for signature read.");
@@ -691,67 +788,6 @@ namespace swive {
         return param_count;
     }
 
-    const MethodDef* VM::find_method_def_by_name(const std::string& name,
-                                                 bool is_static,
-                                                 uint32_t param_count) const {
-        if (!chunk_) {
-            return nullptr;
-        }
-        if (chunk_->signature_blob.empty()) {
-            return nullptr;
-        }
-        for (const auto& method : chunk_->method_definitions) {
-            if (method.name >= chunk_->string_table.size()) {
-                continue;
-            }
-            if (chunk_->string_table[method.name] != name) {
-                continue;
-            }
-            bool method_static = (method.flags & static_cast<uint32_t>(MethodFlags::Static)) != 0;
-            if (method_static != is_static) {
-                continue;
-            }
-            if (read_signature_param_count(method.signature) == param_count) {
-                return &method;
-            }
-        }
-        return nullptr;
-    }
-
-    const MethodDef* VM::find_method_def_for_type(const TypeDef& type_def,
-                                                  const std::string& name,
-                                                  bool is_static,
-                                                  uint32_t param_count) const {
-        if (!chunk_) {
-            return nullptr;
-        }
-        if (chunk_->signature_blob.empty()) {
-            return nullptr;
-        }
-        size_t start = type_def.method_list.start;
-        size_t end = start + type_def.method_list.count;
-        if (end > chunk_->method_definitions.size()) {
-            return nullptr;
-        }
-        for (size_t i = start; i < end; ++i) {
-            const auto& method = chunk_->method_definitions[i];
-            if (method.name >= chunk_->string_table.size()) {
-                continue;
-            }
-            if (chunk_->string_table[method.name] != name) {
-                continue;
-            }
-            bool method_static = (method.flags & static_cast<uint32_t>(MethodFlags::Static)) != 0;
-            if (method_static != is_static) {
-                continue;
-            }
-            if (read_signature_param_count(method.signature) == param_count) {
-                return &method;
-            }
-        }
-        return nullptr;
-    }
-
     const PropertyDef* VM::find_property_def_for_type(const TypeDef& type_def,
                                                       const std::string& name,
                                                       bool is_static) const {
@@ -812,7 +848,9 @@ namespace swive {
         if (!chunk_ || idx >= chunk_->method_definitions.size()) {
             return nullptr;
         }
-        return &chunk_->method_definitions[idx];
+        // Rows without a body fall back to the accessor the type object holds
+        const MethodDef& method = chunk_->method_definitions[idx];
+        return method.body_ptr < chunk_->method_bodies.size() ? &method : nullptr;
     }
 
     bool VM::invoke_method_def(const MethodDef& method_def,
@@ -834,24 +872,35 @@ namespace swive {
             method_def.body_ptr >= chunk_->method_bodies.size()) {
             throw std::runtime_error("Method body not found.");
         }
-        std::string method_name = (method_def.name < chunk_->string_table.size())
-            ? chunk_->string_table[method_def.name]
-            : std::string("method");
-        call_frames_.emplace_back(
+        CallFrame& frame = call_frames_.emplace_back(
             callee_index + 1,
             ip_,
             chunk_,
             current_body_idx_,
-            method_name,
+            nullptr,
             nullptr,
             is_initializer,
             is_mutating,
             receiver_index);
-        set_active_body(method_def.body_ptr);
+        frame.method_name = method_def.name;
+        enter_body(method_def.body_ptr);
         ip_ = 0;
         return true;
     }
 
+    std::string CallFrame::function_name() const {
+        if (function) {
+            return function->name;
+        }
+        if (prototype) {
+            return prototype->name;
+        }
+        if (chunk && method_name < chunk->string_table.size()) {
+            return chunk->string_table[method_name];
+        }
+        return "method";
+    }
+
     size_t VM::current_stack_base() const {
         if (call_frames_.empty()) {
             return 0;
@@ -866,79 +915,178 @@ namespace swive {
     }
 
     const TypeDef* VM::resolve_type_def(const std::string& name) const {
-        if (!chunk_) {
+        auto it = program_type_defs_.find(name);
+        if (!program_ || it == program_type_defs_.end()) {
             return nullptr;
         }
-        for (const auto& def : chunk_->type_definitions) {
-            if (def.name < chunk_->string_table.size() && chunk_->string_table[def.name] == name) {
-                return &def;
-            }
-        }
-        return nullptr;
+        return &program_->type_definitions[it->second];
     }
 
-    bool VM::matches_type(const Value& value, const std::string& type_name) const {
-        if (type_name == "Int") {
-            return value.is_int();
-        }
-        if (type_name == "Float") {
-            return value.is_float();
-        }
-        if (type_name == "Bool") {
-            return value.is_bool();
+    uint16_t VM::intern_type(const std::string& name) {
+        auto it = runtime_type_ids_.find(name);
+        if (it != runtime_type_ids_.end()) {
+            return it->second;
         }
-        if (type_name == "String") {
-            return value.is_object() && value.as_object() &&
-                value.as_object()->type == ObjectType::String;
+        if (runtime_types_.size() >= std::numeric_limits<uint16_t>::max()) {
+            throw std::runtime_error("Too many runtime types.");
+        }
+        static const std::unordered_map<std::string, BuiltinTypeKind> builtin_kinds = {
+            {"Int", BuiltinTypeKind::Int},
+            {"Float", BuiltinTypeKind::Float},
+            {"Bool", BuiltinTypeKind::Bool},
+            {"String", BuiltinTypeKind::String},
+            {"Array", BuiltinTypeKind::Array},
+            {"Dictionary", BuiltinTypeKind::Dictionary},
+            {"Set", BuiltinTypeKind::Set},
+            {"Range", BuiltinTypeKind::Range},
+            {"Void", BuiltinTypeKind::Void},
+            {"Any", BuiltinTypeKind::Any},
+        };
+        RuntimeType type;
+        type.name = name;
+        auto builtin = builtin_kinds.find(name);
+        if (builtin != builtin_kinds.end()) {
+            type.builtin = builtin->second;
+        }
+        uint16_t id = static_cast<uint16_t>(runtime_types_.size());
+        runtime_types_.push_back(std::move(type));
+        runtime_type_ids_.emplace(name, id);
+        return id;
+    }
+
+    void VM::load_type_table(const Assembly& program) {
+        program_type_ids_.clear();
+        program_type_ids_.reserve(program.type_definitions.size());
+        program_type_defs_.clear();
+        for (size_t i = 0; i < program.type_definitions.size(); ++i) {
+            string_idx name = program.type_definitions[i].name;
+            if (name >= program.string_table.size()) {
+                throw std::runtime_error("Type name index out of range.");
+            }
+            program_type_ids_.push_back(intern_type(program.string_table[name]));
+            program_type_defs_.emplace(program.string_table[name], static_cast<type_idx>(i));  // First row wins
         }
-        if (type_name == "Array") {
-            return value.is_object() && value.as_object() &&
-                value.as_object()->type == ObjectType::List;
+
+        auto set_bit = [](std::vector<uint64_t>& bits, uint16_t id) {
+            if (bits.size() <= id / 64u) {
+                bits.resize(id / 64u + 1, 0);
+            }
+            bits[id / 64u] |= uint64_t{1} << (id % 64u);
+        };
+
+        // Declared conformances (a protocol's entries are the protocols it inherits)
+        for (size_t i = 0; i < program.type_definitions.size(); ++i) {
+            auto& conformances = runtime_types_[program_type_ids_[i]].conformances;
+            for (type_idx iface : program.type_definitions[i].interfaces) {
+                if (iface < program_type_ids_.size()) {
+                    set_bit(conformances, program_type_ids_[iface]);
+                }
+            }
         }
-        if (type_name == "Dictionary") {
-            return value.is_object() && value.as_object() &&
-                value.as_object()->type == ObjectType::Map;
+
+        // Close over protocol inheritance so every check is a single bit test
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (uint16_t type_id = 0; type_id < runtime_types_.size(); ++type_id) {
+                for (uint16_t protocol_id = 0; protocol_id < runtime_types_.size(); ++protocol_id) {
+                    if (protocol_id == type_id || !conforms_to(type_id, protocol_id)) {
+                        continue;
+                    }
+                    auto& bits = runtime_types_[type_id].conformances;
+                    const auto& inherited = runtime_types_[protocol_id].conformances;
+                    if (bits.size() < inherited.size()) {
+                        bits.resize(inherited.size(), 0);
+                    }
+                    for (size_t k = 0; k < inherited.size(); ++k) {
+                        if ((bits[k] | inherited[k]) != bits[k]) {
+                            bits[k] |= inherited[k];
+                            changed = true;
+                        }
+                    }
+                }
+            }
         }
-        if (type_name == "Void") {
-            return value.is_null();
+    }
+
+    bool VM::conforms_to(uint16_t type_id, uint16_t protocol_id) const {
+        const auto& bits = runtime_types_[type_id].conformances;
+        return protocol_id / 64u < bits.size() && (bits[protocol_id / 64u] >> (protocol_id % 64u)) & 1u;
+    }
+
+    void VM::inherit_type_info(ClassObject* subclass, ClassObject* superclass) {
+        subclass->display = superclass->display;
+        subclass->display.push_back(subclass->type_id);
+        auto& sub = runtime_types_[subclass->type_id];
+        sub.class_depth = static_cast<uint32_t>(subclass->display.size() - 1);
+        const auto& inherited = runtime_types_[superclass->type_id].conformances;
+        if (sub.conformances.size() < inherited.size()) {
+            sub.conformances.resize(inherited.size(), 0);
         }
-        if (type_name == "Any") {
-            return !value.is_null() && !value.is_undefined();
+        for (size_t k = 0; k < inherited.size(); ++k) {
+            sub.conformances[k] |= inherited[k];
         }
+    }
 
-        const TypeDef* type_def = resolve_type_def(type_name);
-        if (!type_def || !value.is_object() || !value.as_object()) {
+    bool VM::matches_type(const Value& value, uint16_t type_id) const {
+        const RuntimeType& target = runtime_types_[type_id];
+        auto object_is = [&](ObjectType type) {
+            return value.is_object() && value.as_object() && value.as_object()->type == type;
+        };
+        switch (target.builtin) {
+        case BuiltinTypeKind::Int: return value.is_int();
+        case BuiltinTypeKind::Float: return value.is_float();
+        case BuiltinTypeKind::Bool: return value.is_bool();
+        case BuiltinTypeKind::String: return object_is(ObjectType::String);
+        case BuiltinTypeKind::Array: return object_is(ObjectType::List);
+        case BuiltinTypeKind::Dictionary: return object_is(ObjectType::Map);
+        case BuiltinTypeKind::Set: return object_is(ObjectType::Set);
+        case BuiltinTypeKind::Range: return object_is(ObjectType::Range);
+        case BuiltinTypeKind::Void: return value.is_null();
+        case BuiltinTypeKind::Any: return !value.is_null() && !value.is_undefined();
+        case BuiltinTypeKind::None: break;
+        }
+
+        if (!value.is_object() || !value.as_object()) {
             return false;
         }
 
-        auto has_flag = [](uint32_t flags, TypeFlags flag) {
-            return (flags & static_cast<uint32_t>(flag)) != 0;
-        };
-
+        uint16_t value_type = 0;
         Object* obj = value.as_object();
-        if (has_flag(type_def->flags, TypeFlags::Class) && obj->type == ObjectType::Instance) {
-            auto* inst = static_cast<InstanceObject*>(obj);
-            ClassObject* klass = inst->klass;
-            while (klass) {
-                if (klass->name == type_name) {
-                    return true;
-                }
-                klass = klass->superclass;
+        switch (obj->type) {
+        case ObjectType::Instance: {
+            const ClassObject* klass = static_cast<InstanceObject*>(obj)->klass;
+            if (!klass) {
+                return false;
             }
-            return false;
+            // Superclass test: the target sits at a fixed depth in every subclass's display
+            if (target.class_depth < klass->display.size()) {
+                return klass->display[target.class_depth] == type_id;
+            }
+            value_type = klass->type_id;
+            break;
         }
-
-        if (has_flag(type_def->flags, TypeFlags::Struct) && obj->type == ObjectType::StructInstance) {
+        case ObjectType::StructInstance: {
             auto* struct_inst = static_cast<StructInstanceObject*>(obj);
-            return struct_inst->struct_type && struct_inst->struct_type->name == type_name;
+            if (!struct_inst->struct_type) {
+                return false;
+            }
+            value_type = struct_inst->struct_type->type_id;
+            break;
         }
-
-        if (has_flag(type_def->flags, TypeFlags::Enum) && obj->type == ObjectType::EnumCase) {
+        case ObjectType::EnumCase: {
             auto* enum_case = static_cast<EnumCaseObject*>(obj);
-            return enum_case->enum_type && enum_case->enum_type->name == type_name;
+            if (!enum_case->enum_type) {
+                return false;
+            }
+            value_type = enum_case->enum_type->type_id;
+            break;
+        }
+        default:
+            return false;
         }
 
-        return false;
+        return value_type == type_id || conforms_to(value_type, type_id);
     }
 
     Value VM::get_property(const Value& object, const std::string& name) {
@@ -956,26 +1104,79 @@ namespace swive {
             auto* arr = static_cast<ListObject*>(obj);
 
             if (name == "count") {
-                return Value::from_int(static_cast<int64_t>(arr->elements.size()));
+                return Value::from_int(static_cast<int64_t>(arr->size()));
             }
 
             if (name == "isEmpty") {
-                return Value::from_bool(arr->elements.empty());
+                return Value::from_bool(arr->empty());
             }
 
-            if (name == "append") {
-                auto* method = allocate_object<BuiltinMethodObject>(obj, "append");
+            if (name == "append" || name == "map" || name == "filter" || name == "reduce" ||
+                name == "sorted" || name == "contains" || name == "firstIndex" ||
+                name == "removeAll" || name == "reserveCapacity" ||
+                name == "sum" || name == "min" || name == "max" || name == "dot" ||
+                name == "adding" || name == "subtracting" || name == "multiplied" || name == "divided") {
+                auto* method = allocate_object<BuiltinMethodObject>(obj, name);
                 return Value::from_object(method);
             }
 
             throw std::runtime_error("Unknown array property: " + name);
         }
 
+        // Set properties/methods
+        if (obj->type == ObjectType::Set) {
+            auto* set = static_cast<SetObject*>(obj);
+
+            if (name == "count") {
+                return Value::from_int(static_cast<int64_t>(set->elements().size()));
+            }
+
+            if (name == "isEmpty") {
+                return Value::from_bool(set->elements().empty());
+            }
+
+            if (name == "insert" || name == "remove" || name == "removeAll" || name == "contains" ||
+                name == "union" || name == "intersection" || name == "subtracting") {
+                auto* method = allocate_object<BuiltinMethodObject>(obj, name);
+                return Value::from_object(method);
+            }
+
+            throw std::runtime_error("Unknown set property: " + name);
+        }
+
+        // Range properties/methods
+        if (obj->type == ObjectType::Range) {
+            auto* range = static_cast<RangeObject*>(obj);
+
+            if (name == "lowerBound") {
+                return Value::from_int(range->lower);
+            }
+
+            if (name == "upperBound") {
+                return Value::from_int(range->upper);
+            }
+
+            if (name == "count") {
+                return Value::from_int(range->count());
+            }
+
+            if (name == "isEmpty") {
+                return Value::from_bool(range->count() == 0);
+            }
+
+            if (name == "contains") {
+                auto* method = allocate_object<BuiltinMethodObject>(obj, name);
+                return Value::from_object(method);
+            }
+
+            throw std::runtime_error("Unknown range property: " + name);
+        }
+
         // Map object properties
         if (obj->type == ObjectType::Map) {
             auto* map = static_cast<MapObject*>(obj);
-            auto it = map->entries.find(name);
-            if (it == map->entries.end()) {
+            auto it = map->entries().find(name);
+            if (it == map->entries().end()) {
                 return Value::null();
             }
             return it->second;
@@ -1192,7 +1393,7 @@ namespace swive {
                     return Value::from_object(bound);
                 }
             }
-            throw std::runtime_error("Enum case '" + enum_case->case_name + "' has no property or method named '" + name + "'");
+            throw std::runtime_error("Enum case '" + enum_case->case_name() + "' has no property or method named '" + name + "'");
         }
 
         // Tuple label access
@@ -1208,6 +1409,494 @@ namespace swive {
         throw std::runtime_error("Property access supported only on arrays, maps, and instances.");
     }
 
+    SetObject* VM::make_set_from(const Value& source) {
+        auto* set = allocate_object<SetObject>();
+        if (source.is_null()) {
+            return set;
+        }
+        if (!source.is_object() || !source.as_object()) {
+            throw std::runtime_error("Set() requires an array or set argument.");
+        }
+        Object* obj = source.as_object();
+        if (obj->type == ObjectType::List) {
+            auto* list = static_cast<ListObject*>(obj);
+            set->reserve(list->size());
+            for (size_t i = 0; i < list->size(); ++i) {
+                set->insert(*this, list->at(i));
+            }
+            return set;
+        }
+        if (obj->type == ObjectType::Set) {
+            auto* other = static_cast<SetObject*>(obj);
+            set->reserve(other->elements().size());
+            for (const auto& elem : other->elements()) {
+                set->insert(*this, elem);
+            }
+            return set;
+        }
+        throw std::runtime_error("Set() requires an array or set argument.");
+    }
+
+    void VM::call_builtin_method(BuiltinMethodObject* method, size_t callee_index, uint16_t arg_count) {
+        Object* target = method->target;
+        const std::string& name = method->method_name;
+        // Result holds an owned reference; it is moved onto the stack after cleanup.
+        Value result = Value::null();
+
+        auto own = [](Value value) {
+            if (value.is_object() && value.ref_type() == RefType::Strong && value.as_object()) {
+                RC::retain(value.as_object());
+            }
+            return value;
+        };
+        auto expect_args = [&](uint16_t expected) {
+            if (arg_count != expected) {
+                throw std::runtime_error(name + "() requires exactly " + std::to_string(expected) +
+                                         (expected == 1 ? " argument." : " arguments."));
+            }
+        };
+
+        if (target->type == ObjectType::List) {
+            auto* arr = static_cast<ListObject*>(target);
+            auto arg = [&](uint16_t i) { return stack_[callee_index + 1 + i]; };
+            // Calls a closure argument and reports whether it returned a truthy value
+            auto test = [&](const Value& predicate, const Value& elem) {
+                Value ret = call_value(predicate, std::span<const Value>(&elem, 1));
+                bool truthy = is_truthy(ret);
+                if (ret.is_object() && ret.ref_type() == RefType::Strong && ret.as_object()) {
+                    RC::release(this, ret.as_object());
+                }
+                return truthy;
+            };
+
+            if (name == "append") {
+                expect_args(1);
+                arr->append(*this, own(peek(0)));
+            } else if (name == "map" || name == "filter") {
+                expect_args(1);
+                Value fn = arg(0);
+                auto* out = allocate_object<ListObject>();
+                RC::retain(out);
+                result = Value::from_object(out);
+                if (name == "map") {
+                    out->reserve(arr->size());
+                }
+                // Index loop: the closure may mutate the source array
+                for (size_t i = 0; i < arr->size(); ++i) {
+                    Value elem = arr->at(i);
+                    if (name == "map") {
+                        out->push(call_value(fn, std::span<const Value>(&elem, 1)));
+                    } else if (test(fn, elem)) {
+                        out->push(own(elem));
+                    }
+                }
+                record_allocation_delta(*out, out->memory_size());
+            } else if (name == "reduce") {
+                expect_args(2);
+                Value fn = arg(1);
+                Value acc = own(arg(0));
+                for (size_t i = 0; i < arr->size(); ++i) {
+                    Value pair[2] = { acc, arr->at(i) };
+                    Value next = call_value(fn, pair);
+                    if (acc.is_object() && acc.ref_type() == RefType::Strong && acc.as_object()) {
+                        RC::release(this, acc.as_object());
+                    }
+                    acc = next;
+                }
+                result = acc;
+            } else if (name == "sorted") {
+                if (arg_count > 1) {
+                    expect_args(1);
+                }
+                // Copy of the receiver's buffer (retains the boxed elements)
+                auto* out = arr->share(*this);
+                RC::retain(out);
+                result = Value::from_object(out);
+                out->make_unique(*this);
+                if (arg_count == 1) {
+                    // by: areInIncreasingOrder(a, b) -> Bool
+                    Value fn = arg(0);
+                    out->box();
+                    auto& elements = out->buffer->elements;
+                    std::stable_sort(elements.begin(), elements.end(),
+                        [&](const Value& a, const Value& b) {
+                            Value pair[2] = { a, b };
+                            Value ret = call_value(fn, pair);
+                            bool less = is_truthy(ret);
+                            if (ret.is_object() && ret.ref_type() == RefType::Strong && ret.as_object()) {
+                                RC::release(this, ret.as_object());
+                            }
+                            return less;
+                        });
+                } else {
+                    sort_list(out);
+                }
+                record_allocation_delta(*out, out->memory_size());
+            } else if (name == "contains" || name == "firstIndex") {
+                // contains(x) / firstIndex(of: x), or the where: form when given a closure
+                expect_args(1);
+                Value needle = arg(0);
+                bool by_predicate = is_callable(needle);
+                std::optional<size_t> found;
+                if (!by_predicate && arr->storage() == ListStorage::Int && needle.is_int()) {
+                    const auto& ints = arr->buffer->ints;
+                    auto it = std::find(ints.begin(), ints.end(), needle.as_int());
+                    if (it != ints.end()) {
+                        found = static_cast<size_t>(it - ints.begin());
+                    }
+                } else {
+                    for (size_t i = 0; i < arr->size(); ++i) {
+                        if (by_predicate ? test(needle, arr->at(i)) : arr->at(i).equals(needle)) {
+                            found = i;
+                            break;
+                        }
+                    }
+                }
+                if (name == "contains") {
+                    result = Value::from_bool(found.has_value());
+                } else if (found) {
+                    result = Value::from_int(static_cast<Int>(*found));
+                }
+            } else if (name == "removeAll") {
+                if (arg_count > 1) {
+                    expect_args(1);
+                }
+                // Decide first, then compact: the predicate may touch the array
+                std::vector<bool> remove(arr->size(), arg_count == 0);
+                if (arg_count == 1) {
+                    Value predicate = arg(0);
+                    for (size_t i = 0; i < remove.size() && i < arr->size(); ++i) {
+                        remove[i] = test(predicate, arr->at(i));
+                    }
+                }
+                arr->make_unique(*this);
+                ListBuffer& buf = *arr->buffer;
+                size_t kept = 0;
+                for (size_t i = 0; i < arr->size(); ++i) {
+                    if (i < remove.size() && remove[i]) {
+                        Value elem = arr->at(i);
+                        if (elem.is_object() && elem.ref_type() == RefType::Strong && elem.as_object()) {
+                            RC::release(this, elem.as_object());
+                        }
+                        continue;
+                    }
+                    switch (buf.storage) {
+                        case ListStorage::Int:   buf.ints[kept] = buf.ints[i]; break;
+                        case ListStorage::Float: buf.floats[kept] = buf.floats[i]; break;
+                        default:                 buf.elements[kept] = buf.elements[i]; break;
+                    }
+                    ++kept;
+                }
+                arr->truncate(kept);
+                record_allocation_delta(*arr, arr->memory_size());
+            } else if (name == "reserveCapacity") {
+                expect_args(1);
+                if (!arg(0).is_int() || arg(0).as_int() < 0) {
+                    throw std::runtime_error("reserveCapacity() requires a non-negative Int.");
+                }
+                arr->make_unique(*this);
+                arr->reserve(static_cast<size_t>(arg(0).as_int()));
+                record_allocation_delta(*arr, arr->memory_size());
+            } else if (name == "sum" || name == "min" || name == "max") {
+                expect_args(0);
+                result = numeric_reduce(arr, name);
+            } else if (name == "dot" || name == "adding" || name == "subtracting" ||
+                       name == "multiplied" || name == "divided") {
+                expect_args(1);
+                result = numeric_elementwise(arr, name, arg(0));
+            } else {
+                throw std::runtime_error("Unknown built-in method: " + name);
+            }
+        } else if (target->type == ObjectType::Set) {
+            auto* set = static_cast<SetObject*>(target);
+            if (name == "insert") {
+                expect_args(1);
+                result = Value::from_bool(set->insert(*this, peek(0)));
+            } else if (name == "remove") {
+                expect_args(1);
+                Value removed;
+                if (set->remove(*this, peek(0), &removed)) {
+                    result = removed;  // Ownership moved out of the set
+                }
+            } else if (name == "removeAll") {
+                expect_args(0);
+                set->remove_all(*this);
+            } else if (name == "contains") {
+                expect_args(1);
+                result = Value::from_bool(set->contains(peek(0)));
+            } else if (name == "union" || name == "intersection" || name == "subtracting") {
+                expect_args(1);
+                Value other_val = peek(0);
+                SetObject* other = nullptr;
+                bool owns_other = false;
+                if (other_val.is_object() && other_val.as_object() &&
+                    other_val.as_object()->type == ObjectType::Set) {
+                    other = static_cast<SetObject*>(other_val.as_object());
+                } else {
+                    // Accept any array as the other operand
+                    other = make_set_from(other_val);
+                    RC::retain(other);
+                    owns_other = true;
+                }
+
+                auto* out = allocate_object<SetObject>();
+                RC::retain(out);
+                if (name == "union") {
+                    out->reserve(set->elements().size() + other->elements().size());
+                    for (const auto& elem : set->elements()) out->insert(*this, elem);
+                    for (const auto& elem : other->elements()) out->insert(*this, elem);
+                } else if (name == "intersection") {
+                    const SetObject* small = set->elements().size() <= other->elements().size() ? set : other;
+                    const SetObject* large = small == set ? other : set;
+                    for (const auto& elem : small->elements()) {
+                        if (large->contains(elem)) out->insert(*this, elem);
+                    }
+                } else {
+                    for (const auto& elem : set->elements()) {
+                        if (!other->contains(elem)) out->insert(*this, elem);
+                    }
+                }
+                if (owns_other) {
+                    RC::release(this, other);
+                }
+                result = Value::from_object(out);
+            } else {
+                throw std::runtime_error("Unknown built-in method: " + name);
+            }
+        } else if (target->type == ObjectType::Range) {
+            auto* range = static_cast<RangeObject*>(target);
+            if (name == "contains") {
+                expect_args(1);
+                Value needle = peek(0);
+                result = Value::from_bool(needle.is_int() && range->contains(needle.as_int()));
+            } else {
+                throw std::runtime_error("Unknown built-in method: " + name);
+            }
+        } else {
+            throw std::runtime_error("Unknown built-in method: " + name);
+        }
+
+        while (stack_.size() > callee_index) {
+            discard();
+        }
+        stack_.push_back(result);  // Transfer ownership
+    }
+
+    bool VM::is_callable(const Value& value) const {
+        if (!value.is_object() || !value.as_object()) {
+            return false;
+        }
+        ObjectType type = value.as_object()->type;
+        return type == ObjectType::Closure || type == ObjectType::Function ||
+               type == ObjectType::BoundMethod || type == ObjectType::BuiltinMethod;
+    }
+
+    void VM::sort_list(ListObject* list) {
+        // Packed arrays sort their raw buffers directly
+        if (list->storage() == ListStorage::Int) {
+            std::sort(list->buffer->ints.begin(), list->buffer->ints.end());
+            return;
+        }
+        if (list->storage() == ListStorage::Float) {
+            std::stable_sort(list->buffer->floats.begin(), list->buffer->floats.end());
+            return;
+        }
+
+        auto& elements = list->buffer->elements;
+        bool all_number = true;
+        bool all_string = true;
+        for (const auto& elem : elements) {
+            all_number = all_number && elem.is_number();
+            all_string = all_string && elem.is_object() && elem.as_object() &&
+                elem.as_object()->type == ObjectType::String;
+        }
+        if (all_number) {
+            auto numeric = [](const Value& v) {
+                return v.is_int() ? static_cast<Float>(v.as_int()) : v.as_float();
+            };
+            std::stable_sort(elements.begin(), elements.end(),
+                [&](const Value& a, const Value& b) { return numeric(a) < numeric(b); });
+            return;
+        }
+        if (all_string) {
+            std::stable_sort(elements.begin(), elements.end(),
+                [](const Value& a, const Value& b) {
+                    return static_cast<StringObject*>(a.as_object())->data <
+                           static_cast<StringObject*>(b.as_object())->data;
+                });
+            return;
+        }
+        throw std::runtime_error("sorted() without by: requires Int, Float or String elements.");
+    }
+
+    namespace {
+        // Bulk kernels over packed buffers. Plain counted loops over contiguous
+        // data so the optimizer can vectorize them; Float sums keep four
+        // independent accumulators since FP addition is not reassociated.
+        template<typename T>
+        T packed_sum(const std::vector<T>& data) {
+            T acc[4] = { 0, 0, 0, 0 };
+            size_t n = data.size();
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                acc[0] += data[i];
+                acc[1] += data[i + 1];
+                acc[2] += data[i + 2];
+                acc[3] += data[i + 3];
+            }
+            for (; i < n; ++i) {
+                acc[0] += data[i];
+            }
+            return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+        }
+
+        template<typename T>
+        T packed_dot(const std::vector<T>& a, const std::vector<T>& b) {
+            T acc[4] = { 0, 0, 0, 0 };
+            size_t n = a.size();
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                acc[0] += a[i] * b[i];
+                acc[1] += a[i + 1] * b[i + 1];
+                acc[2] += a[i + 2] * b[i + 2];
+                acc[3] += a[i + 3] * b[i + 3];
+            }
+            for (; i < n; ++i) {
+                acc[0] += a[i] * b[i];
+            }
+            return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+        }
+
+        template<typename T, typename Op>
+        void packed_apply(std::vector<T>& out, const std::vector<T>& a, const std::vector<T>* b, T scalar, Op op) {
+            size_t n = a.size();
+            out.resize(n);
+            T* dst = out.data();
+            const T* lhs = a.data();
+            if (b) {
+                const T* rhs = b->data();
+                for (size_t i = 0; i < n; ++i) dst[i] = op(lhs[i], rhs[i]);
+            } else {
+                for (size_t i = 0; i < n; ++i) dst[i] = op(lhs[i], scalar);
+            }
+        }
+
+        // Packed form of list for the numeric kernels. Packed lists are read in
+        // place; a boxed list whose elements are all numbers is gathered into
+        // scratch (Int when every element is an Int, Float otherwise).
+        // Returns nullptr when an element is not a number.
+        const ListBuffer* numeric_buffer(const ListObject* list, ListBuffer& scratch) {
+            if (list->is_packed()) {
+                return list->buffer;
+            }
+            const auto& elements = list->buffer->elements;
+            bool all_int = true;
+            for (const Value& v : elements) {
+                if (!v.is_number()) {
+                    return nullptr;
+                }
+                all_int = all_int && v.is_int();
+            }
+            scratch.storage = all_int ? ListStorage::Int : ListStorage::Float;
+            for (const Value& v : elements) {
+                if (all_int) scratch.ints.push_back(v.as_int());
+                else scratch.floats.push_back(v.is_int() ? static_cast<Float>(v.as_int()) : v.as_float());
+            }
+            return &scratch;
+        }
+    } // namespace
+
+    Value VM::numeric_reduce(ListObject* list, const std::string& op) {
+        ListBuffer scratch;
+        const ListBuffer* data = numeric_buffer(list, scratch);
+        if (!data) {
+            throw std::runtime_error(op + "() requires an array of Int or Float.");
+        }
+        if (list->empty()) {
+            return op == "sum" ? Value::from_int(0) : Value::null();
+        }
+        if (data->storage == ListStorage::Int) {
+            const auto& ints = data->ints;
+            if (op == "sum") return Value::from_int(packed_sum(ints));
+            return Value::from_int(op == "min" ? *std::min_element(ints.begin(), ints.end())
+                                               : *std::max_element(ints.begin(), ints.end()));
+        }
+        const auto& floats = data->floats;
+        if (op == "sum") return Value::from_float(packed_sum(floats));
+        return Value::from_float(op == "min" ? *std::min_element(floats.begin(), floats.end())
+                                             : *std::max_element(floats.begin(), floats.end()));
+    }
+
+    Value VM::numeric_elementwise(ListObject* list, const std::string& op, const Value& operand) {
+        ListBuffer scratch;
+        const ListBuffer* lhs_data = numeric_buffer(list, scratch);
+        if (!lhs_data) {
+            throw std::runtime_error(op + "() requires an array of Int or Float.");
+        }
+        // Operand is a scalar (constant arithmetic) or an array of the same count
+        ListBuffer other_scratch;
+        const ListBuffer* other = nullptr;
+        if (operand.is_object() && operand.as_object() && operand.as_object()->type == ObjectType::List) {
+            auto* other_list = static_cast<ListObject*>(operand.as_object());
+            if (other_list->size() != list->size()) {
+                throw std::runtime_error(op + "() requires arrays of equal count.");
+            }
+            other = numeric_buffer(other_list, other_scratch);
+            if (!other) {
+                throw std::runtime_error(op + "() requires an array of Int or Float.");
+            }
+        } else if (!operand.is_number()) {
+            throw std::runtime_error(op + "() requires a number or a numeric array.");
+        } else if (op == "dot") {
+            throw std::runtime_error("dot() requires a numeric array.");
+        }
+
+        // Int op Int stays Int (except division by zero); anything involving Float is Float
+        bool use_int = lhs_data->storage != ListStorage::Float &&
+            (other ? other->storage != ListStorage::Float : operand.is_int());
+        if (op == "divided" && use_int) {
+            bool has_zero = other ? std::find(other->ints.begin(), other->ints.end(), 0) != other->ints.end()
+                                  : operand.as_int() == 0;
+            if (has_zero) {
+                throw std::runtime_error("Division by zero");
+            }
+        }
+
+        auto as_floats = [](const ListBuffer* b) {
+            if (b->storage == ListStorage::Float) return b->floats;
+            return std::vector<Float>(b->ints.begin(), b->ints.end());
+        };
+
+        if (op == "dot") {
+            if (use_int) return Value::from_int(packed_dot(lhs_data->ints, other->ints));
+            return Value::from_float(packed_dot(as_floats(lhs_data), as_floats(other)));
+        }
+
+        auto* out = allocate_object<ListObject>();
+        RC::retain(out);
+        if (use_int) {
+            out->buffer->storage = ListStorage::Int;
+            const std::vector<Int>* rhs = other ? &other->ints : nullptr;
+            Int scalar = other ? 0 : operand.as_int();
+            if (op == "adding") packed_apply(out->buffer->ints, lhs_data->ints, rhs, scalar, std::plus<Int>{});
+            else if (op == "subtracting") packed_apply(out->buffer->ints, lhs_data->ints, rhs, scalar, std::minus<Int>{});
+            else if (op == "multiplied") packed_apply(out->buffer->ints, lhs_data->ints, rhs, scalar, std::multiplies<Int>{});
+            else packed_apply(out->buffer->ints, lhs_data->ints, rhs, scalar, std::divides<Int>{});
+        } else {
+            out->buffer->storage = ListStorage::Float;
+            std::vector<Float> lhs = as_floats(lhs_data);
+            std::vector<Float> rhs_data = other ? as_floats(other) : std::vector<Float>{};
+            const std::vector<Float>* rhs = other ? &rhs_data : nullptr;
+            Float scalar = other ? 0.0 : (operand.is_int() ? static_cast<Float>(operand.as_int()) : operand.as_float());
+            if (op == "adding") packed_apply(out->buffer->floats, lhs, rhs, scalar, std::plus<Float>{});
+            else if (op == "subtracting") packed_apply(out->buffer->floats, lhs, rhs, scalar, std::minus<Float>{});
+            else if (op == "multiplied") packed_apply(out->buffer->floats, lhs, rhs, scalar, std::multiplies<Float>{});
+            else packed_apply(out->buffer->floats, lhs, rhs, scalar, std::divides<Float>{});
+        }
+        record_allocation_delta(*out, out->memory_size());
+        return Value::from_object(out);
+    }
+
     std::optional<Value> VM::call_operator_overload(const Value& left, const Value& right, const std::string& name) {
         if (!left.is_object() || !left.as_object()) {
             return std::nullopt;
@@ -1278,6 +1967,32 @@ namespace swive {
         return false;
     }
 
+    bool VM::has_method(const Value& value, const std::string& name) const {
+        if (!value.is_object() || !value.as_object()) {
+            return false;
+        }
+        Object* obj = value.as_object();
+        if (obj->type == ObjectType::Instance) {
+            Value method;
+            auto* inst = static_cast<InstanceObject*>(obj);
+            return inst->klass && find_method_on_class(inst->klass, name, method);
+        }
+        if (obj->type == ObjectType::StructInstance) {
+            auto* inst = static_cast<StructInstanceObject*>(obj);
+            return inst->struct_type && inst->struct_type->methods.count(name) > 0;
+        }
+        return false;
+    }
+
+    void VM::push_range(bool inclusive) {
+        Value upper = pop();
+        Value lower = pop();
+        if (!lower.is_int() || !upper.is_int()) {
+            throw std::runtime_error("Range bounds must be Int.");
+        }
+        push_new(allocate_object<RangeObject>(lower.as_int(), upper.as_int(), inclusive));
+    }
+
     void VM::build_param_defaults(const FunctionPrototype& proto,
                                   std::vector<Value>& defaults,
                                   std::vector<bool>& has_defaults) {
@@ -1295,8 +2010,9 @@ namespace swive {
 
             Value value = def.value;
             if (def.string_value.has_value()) {
-                // Newly allocated object already has rc:1, no extra retain needed
+                // Newly allocated object starts at rc:0; the defaults list owns it
                 auto* str_obj = allocate_object<StringObject>(*def.string_value);
+                RC::retain(str_obj);
                 value = Value::from_object(str_obj);
             } else if (value.is_object() && value.ref_type() == RefType::Strong && value.as_object()) {
                 // For shared objects from prototype, retain to keep alive
@@ -1306,6 +2022,57 @@ namespace swive {
         }
     }
 
+    FunctionObject* VM::function_for_prototype(const FunctionPrototype& proto) {
+        auto it = function_cache_.find(&proto);
+        if (it != function_cache_.end()) {
+            return it->second;
+        }
+
+        std::vector<Value> defaults;
+        std::vector<bool> has_defaults;
+        build_param_defaults(proto, defaults, has_defaults);
+        auto* func = allocate_object<FunctionObject>(
+            proto.name,
+            proto.params,
+            proto.param_labels,
+            std::move(defaults),
+            std::move(has_defaults),
+            proto.body,
+            proto.is_initializer,
+            proto.is_override);
+        RC::retain(func);  // Owned by the cache
+        function_cache_.emplace(&proto, func);
+        return func;
+    }
+
+    ClosureObject* VM::closure_for_prototype(const FunctionPrototype& proto) {
+        auto it = closure_cache_.find(&proto);
+        if (it != closure_cache_.end()) {
+            return it->second;
+        }
+
+        // ClosureObject constructor retains func
+        auto* closure = allocate_object<ClosureObject>(function_for_prototype(proto));
+        RC::retain(closure);  // Owned by the cache
+        closure_cache_.emplace(&proto, closure);
+        return closure;
+    }
+
+    void VM::release_function_cache() {
+        for (auto& [proto, closure] : closure_cache_) {
+            if (!closure->rc.is_dead) {
+                RC::release(this, closure);
+            }
+        }
+        closure_cache_.clear();
+        for (auto& [proto, func] : function_cache_) {
+            if (!func->rc.is_dead) {
+                RC::release(this, func);
+            }
+        }
+        function_cache_.clear();
+    }
+
     void VM::apply_positional_defaults(uint16_t& arg_count,
                                        FunctionObject* func,
                                        bool has_receiver) {
@@ -1475,7 +2242,7 @@ namespace swive {
             return;  // Not a callable
         }
         
-        if (!func || !func->chunk || func->params.size() != 2) {
+        if (!func || func->body == kInvalidBody || func->params.size() != 2) {
             return;  // Invalid observer function
         }
         
@@ -1485,167 +2252,29 @@ namespace swive {
     }
 
     Value VM::execute_function(FunctionObject* func, ClosureObject* closure, const std::vector<Value>& args) {
-        if (!func || !func->chunk) {
+        if (!func || func->body == kInvalidBody) {
             throw std::runtime_error("Invalid function to execute");
         }
-        
-        // Save current execution state
-        const Assembly* saved_chunk = chunk_;
-        size_t saved_ip = ip_;
-        body_idx saved_body = current_body_idx_;
-        const MethodBody* saved_body_ptr = current_body_;
-        
-        // Push function and arguments onto stack
-        if (closure) {
-            push(Value::from_object(closure));
-        } else {
-            push(Value::from_object(func));
+        Value callee = closure ? Value::from_object(closure) : Value::from_object(func);
+        return call_value(callee, args);
+    }
+
+    Value VM::call_value(const Value& callee, std::span<const Value> args) {
+        if (args.size() > std::numeric_limits<uint16_t>::max()) {
+            throw std::runtime_error("Too many arguments.");
         }
-        
+        size_t depth = call_frames_.size();
+        ensure_stack_headroom(args.size() + 1);
+        push(callee);
         for (const auto& arg : args) {
             push(arg);
         }
-        
-        // Calculate callee index
-        size_t callee_index = stack_.size() - args.size() - 1;
-        
-        // Create call frame
-        call_frames_.emplace_back(callee_index + 1, saved_ip, saved_chunk, saved_body, func->name, closure, false);
-        
-        // Execute the function
-        chunk_ = func->chunk.get();
-        current_body_idx_ = entry_body_index(*chunk_);
-        set_active_body(current_body_idx_);
-        ip_ = 0;
-        
-        Value result = Value::null();
-        
-        try {
-            // Execute until OP_RETURN
-            while (ip_ < active_bytecode().size()) {
-                OpCode op = static_cast<OpCode>(read_byte());
-                
-                if (op == OpCode::OP_RETURN) {
-                    // Function is returning
-                    result = pop();  // Get return value
-                    
-                    // Clean up call frame
-                    CallFrame& frame = call_frames_.back();
-                    
-                    // Close upvalues
-                    if (stack_.size() > frame.stack_base) {
-                        close_upvalues(&stack_[frame.stack_base]);
-                    }
-                    
-                    // Restore execution state
-                    chunk_ = frame.chunk;
-                    ip_ = frame.return_address;
-                    current_body_idx_ = frame.body_index;
-                    set_active_body(current_body_idx_);
-                    
-                    // Pop call frame
-                    call_frames_.pop_back();
-                    
-                    // Clean up stack (remove callee and args)
-                    while (stack_.size() > callee_index) {
-                        pop();
-                    }
-                    
-                    return result;
-                }
-                
-                // Handle other opcodes by executing them inline
-                // We need to step back because read_byte() already consumed the OPCODE
-                ip_--;
-                
-                // Execute this one instruction
-                switch (static_cast<OpCode>(active_bytecode()[ip_])) {
-                    case OpCode::OP_READ_LINE: {
-                        ip_++;
-                        std::string line;
-                        if (!std::getline(std::cin, line)) {
-                            push(Value::null());
-                            break;
-                        }
-                        auto* obj = allocate_object<StringObject>(std::move(line));
-                        push(Value::from_object(obj));
-                        break;
-                    }
-                    case OpCode::OP_PRINT: {
-                        ip_++;  // consume OPCODE
-                        Value val = pop();
-                        write_output(val.to_string() + "\n");
-                        break;
-                    }
-                    case OpCode::OP_POP:
-                        ip_++;
-                        pop();
-                        break;
-                    case OpCode::OP_GET_LOCAL: {
-                        ip_++;
-                        uint16_t slot = read_short();
-                        CallFrame& frame = call_frames_.back();
-                        push(stack_[frame.stack_base + slot]);
-                        break;
-                    }
-                    case OpCode::OP_GET_PROPERTY: {
-                        ip_++;
-                        const std::string& name = read_string();
-                        Value obj = pop();
-                        push(get_property(obj, name));
-                        break;
-                    }
-                    case OpCode::OP_NIL:
-                        ip_++;
-                        push(Value::null());
-                        break;
-                    case OpCode::OP_CONSTANT:
-                        ip_++;
-                        push(read_constant());
-                        break;
-                    case OpCode::OP_STRING: {
-                        ip_++;
-                        const std::string& str = read_string();
-                        auto* obj = allocate_object<StringObject>(str);
-                        push(Value::from_object(obj));
-                        break;
-                    }
-                    case OpCode::OP_TRUE:
-                        ip_++;
-                        push(Value::from_bool(true));
-                        break;
-                    case OpCode::OP_FALSE:
-                        ip_++;
-                        push(Value::from_bool(false));
-                        break;
-                    default:
-                        // For other opcodes, we need to handle them
-                        // This is a simplified version - ideally we'd refactor run() to handle one OPCODE at a time
-                        throw std::runtime_error("Unsupported opcode in nested function execution");
-                }
-            }
-            
-        } catch (...) {
-            // Restore state on error
-            chunk_ = saved_chunk;
-            ip_ = saved_ip;
-            current_body_idx_ = saved_body;
-            current_body_ = saved_body_ptr;
-            
-            // Pop call frame if still there
-            if (!call_frames_.empty() && call_frames_.back().function_name == func->name) {
-                call_frames_.pop_back();
-            }
-            
-            // Clean up stack
-            while (stack_.size() > callee_index) {
-                pop();
-            }
-            
-            throw;
+        // Same call path as OP_CALL; frames return to the current ip_
+        OpCodeHandler<OpCode::OP_CALL>::invoke(*this, static_cast<uint16_t>(args.size()));
+        if (call_frames_.size() == depth) {
+            return pop();  // Native or constructor call completed in place
         }
-        
-        return result;
+        return run(depth);
     }
 
 } // namespace swive
@@ -11,9 +11,12 @@
 
 #pragma once
 #include <limits>
+#include <algorithm>
 #include <array>
 #include <functional>
 #include <unordered_map>
+#include <span>
+#include <memory>
 #include "ss_core.hpp"
 #include "ss_value.hpp"
 #include "ss_chunk.hpp"
@@ -32,16 +35,150 @@ class DebugController;
         }
     };
     // Forward declarations
-    class CallFrame;
     class ClosureObject;
     class FunctionObject;
     class UpvalueObject;
     class InstanceObject;
 
+    // Call Frame for function calls. Plain data so pushing a frame never
+    // allocates; the callee's name is derived on demand (debugger, errors).
+    class CallFrame {
+    public:
+        static constexpr uint32_t kNoMethodName = std::numeric_limits<uint32_t>::max();
+
+        size_t stack_base;      // Base of this frame's stack
+        size_t return_address;  // Where to return after call
+        const Assembly* chunk;
+        body_idx body_index;
+        uint32_t method_name;   // String table index in chunk (method bodies without a FunctionObject)
+        const FunctionObject* function; // Callee, if called through a function object
+        const FunctionPrototype* prototype; // Callee of OP_CALL_DIRECT (no function object)
+        ClosureObject* closure; // Current closure for upvalue access (nullptr for plain functions)
+        size_t receiver_index;  // Stack index of the receiver (for mutating methods)
+        bool is_initializer;
+        bool is_mutating;       // True if this is a mutating struct method
+        bool has_callee_slot;   // False for OP_CALL_DIRECT: arguments start the frame
+
+        CallFrame() = default;
+        CallFrame(size_t base,
+                  size_t ret_addr,
+                  const Assembly* call_chunk,
+                  body_idx call_body,
+                  const FunctionObject* callee,
+                  ClosureObject* c,
+                  bool initializer,
+                  bool mutating = false,
+                  size_t recv_idx = 0)
+            : stack_base(base),
+              return_address(ret_addr),
+              chunk(call_chunk),
+              body_index(call_body),
+              method_name(kNoMethodName),
+              function(callee),
+              prototype(nullptr),
+              closure(c),
+              receiver_index(recv_idx),
+              is_initializer(initializer),
+              is_mutating(mutating),
+              has_callee_slot(true) {
+        }
+
+        // First stack slot owned by the frame; everything from here up is
+        // released when it returns.
+        size_t frame_start() const { return has_callee_slot ? stack_base - 1 : stack_base; }
+
+        std::string function_name() const;
+    };
+
+    // Call frames live in one array allocated up front; exceeding its
+    // capacity is a script stack overflow rather than a reallocation.
+    class CallFrameStack {
+    public:
+        explicit CallFrameStack(size_t capacity)
+            : frames_(std::make_unique<CallFrame[]>(capacity)), capacity_(capacity) {}
+
+        template<typename... Args>
+        CallFrame& emplace_back(Args&&... args) {
+            if (size_ == capacity_) {
+                throw std::runtime_error("Stack overflow: call depth exceeds " + std::to_string(capacity_));
+            }
+            CallFrame& frame = frames_[size_++];
+            frame = CallFrame(std::forward<Args>(args)...);
+            return frame;
+        }
+        void pop_back() { --size_; }
+        void clear() { size_ = 0; }
+
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        CallFrame& back() { return frames_[size_ - 1]; }
+        const CallFrame& back() const { return frames_[size_ - 1]; }
+        CallFrame& operator[](size_t index) { return frames_[index]; }
+        const CallFrame& operator[](size_t index) const { return frames_[index]; }
+
+    private:
+        std::unique_ptr<CallFrame[]> frames_;
+        size_t capacity_;
+        size_t size_{0};
+    };
+
+    // Value stack allocated once at max_stack_size. Slots never move, so
+    // push/pop are unchecked; overflow is checked once per call against
+    // the callee's MethodBody::max_stack_depth (see VM::enter_body).
+    class ValueStack {
+    public:
+        explicit ValueStack(size_t capacity)
+            : slots_(std::make_unique<Value[]>(capacity)), top_(slots_.get()), capacity_(capacity) {}
+
+        void push_back(const Value& value) {
+            SS_ASSERT(top_ < slots_.get() + capacity_, "value stack overflow");
+            *top_++ = value;
+        }
+        void pop_back() { --top_; }
+        void clear() { top_ = slots_.get(); }
+        // Only shrinks; growing goes through push_back.
+        void resize(size_t count) { top_ = slots_.get() + count; }
+
+        Value* insert(Value* pos, const Value& value) {
+            SS_ASSERT(top_ < slots_.get() + capacity_, "value stack overflow");
+            std::move_backward(pos, top_, top_ + 1);
+            ++top_;
+            *pos = value;
+            return pos;
+        }
+        Value* erase(Value* pos) {
+            return erase(pos, pos + 1);
+        }
+        Value* erase(Value* first, Value* last) {
+            top_ = std::move(last, top_, first);
+            return first;
+        }
+
+        size_t size() const { return static_cast<size_t>(top_ - slots_.get()); }
+        size_t capacity() const { return capacity_; }
+        size_t headroom() const { return capacity_ - size(); }
+        bool empty() const { return top_ == slots_.get(); }
+        Value& back() { return top_[-1]; }
+        const Value& back() const { return top_[-1]; }
+        Value& operator[](size_t index) { return slots_[index]; }
+        const Value& operator[](size_t index) const { return slots_[index]; }
+        Value* data() { return slots_.get(); }
+        const Value* data() const { return slots_.get(); }
+        Value* begin() { return slots_.get(); }
+        Value* end() { return top_; }
+        const Value* begin() const { return slots_.get(); }
+        const Value* end() const { return top_; }
+
+    private:
+        std::unique_ptr<Value[]> slots_;
+        Value* top_;
+        size_t capacity_;
+    };
+
     // VM Configuration
     struct VMConfig {
-        size_t initial_stack_size = 256;
         size_t max_stack_size = 65536;
+        size_t max_call_depth = 8192;
         bool enable_debug = false;
     };
 
@@ -58,9 +195,10 @@ class DebugController;
         Object* objects_head_{ nullptr };  // Linked list of all objects
 
         // Execution state
-        std::vector<Value> stack_;
-        std::vector<CallFrame> call_frames_;
+        ValueStack stack_;
+        CallFrameStack call_frames_;
         const Assembly* chunk_{ nullptr };
+        const Assembly* program_{ nullptr };  // Assembly passed to execute(); OP_CALL_DIRECT indexes its prototypes
         size_t ip_{ 0 };
         body_idx current_body_idx_{ std::numeric_limits<body_idx>::max() };
         const MethodBody* current_body_{ nullptr };
@@ -69,6 +207,29 @@ class DebugController;
         // Global scope
         std::unordered_map<std::string, Value> globals_;
 
+        // Per-prototype function cache. FunctionObjects are immutable once built, so every
+        // OP_FUNCTION/OP_CLOSURE for a prototype shares one (and its parameter metadata);
+        // closures without upvalues are shared outright. Each entry holds one reference.
+        std::unordered_map<const FunctionPrototype*, FunctionObject*> function_cache_;
+        std::unordered_map<const FunctionPrototype*, ClosureObject*> closure_cache_;
+
+        // Runtime type table for OP_TYPE_CHECK and the casts. Ids are interned by name
+        // for the life of the VM; program_type_ids_ maps the executing program's TypeDef
+        // indices (the opcode operands) onto them.
+        enum class BuiltinTypeKind : uint8_t {
+            None, Int, Float, Bool, String, Array, Dictionary, Set, Range, Void, Any
+        };
+        struct RuntimeType {
+            std::string name;
+            BuiltinTypeKind builtin{BuiltinTypeKind::None};
+            uint32_t class_depth{std::numeric_limits<uint32_t>::max()};  // Index in ClassObject::display
+            std::vector<uint64_t> conformances;  // Bit per protocol type id, inherited protocols included
+        };
+        std::vector<RuntimeType> runtime_types_;
+        std::unordered_map<std::string, uint16_t> runtime_type_ids_;
+        std::vector<uint16_t> program_type_ids_;
+        std::unordered_map<std::string, type_idx> program_type_defs_;  // Program TypeDef index by name
+
         // Statistics
         MemoryStats stats_;
 
@@ -116,6 +277,7 @@ class DebugController;
         bool has_global(const std::string& name) const;
 
         bool is_builtin_type_name(const std::string& name) const;
+        SetObject* make_set_from(const Value& source);  // Set() initializer (rc:0 result)
 
         // Debug support
         void attach_debugger(DebugController* controller) { debug_controller_ = controller; }
@@ -132,8 +294,8 @@ class DebugController;
         }
 
         // Read-only accessors for debug inspection
-        const std::vector<CallFrame>& call_frames() const { return call_frames_; }
-        const std::vector<Value>& stack() const { return stack_; }
+        const CallFrameStack& call_frames() const { return call_frames_; }
+        const ValueStack& stack() const { return stack_; }
         size_t current_ip() const { return ip_; }
         body_idx current_body_index() const { return current_body_idx_; }
         const MethodBody* current_method_body() const { return current_body_; }
@@ -186,17 +348,16 @@ class DebugController;
                 throw std::runtime_error(std::string(error_prefix) + ": callee must be a function/closure.");
             }
 
-            if (!func || !func->chunk) {
+            if (!func || func->body == kInvalidBody) {
                 throw std::runtime_error(std::string(error_prefix) + ": function has no body.");
             }
             if (func->params.size() != expected_param_count) {
                 throw std::runtime_error(std::string(error_prefix) + ": incorrect parameter count.");
             }
 
-            vm.call_frames_.emplace_back(base_slot, vm.ip_, vm.chunk_, vm.current_body_idx_, func->name, closure, is_initializer);
-            vm.chunk_ = func->chunk.get();
-            vm.current_body_idx_ = vm.entry_body_index(*vm.chunk_);
-            vm.set_active_body(vm.current_body_idx_);
+            vm.call_frames_.emplace_back(base_slot, vm.ip_, vm.chunk_, vm.current_body_idx_, func, closure, is_initializer);
+            vm.current_body_idx_ = func->body;
+            vm.enter_body(vm.current_body_idx_);
             vm.ip_ = 0;
             return true;
         }
@@ -241,22 +402,26 @@ class DebugController;
         }
 
     private:
-        Value run();
+        // Dispatch loop. Nested callers pass the frame depth to stop at; the
+        // returning frame's result is handed back instead of being pushed.
+        Value run(size_t stop_depth = std::numeric_limits<size_t>::max());
         uint8_t read_byte();
         uint16_t read_short();
+        uint32_t read_long();  // 24-bit operand of the long literal loads
         Value read_constant();
+        Value read_constant_long();
+        Value constant_at(uint32_t idx) const;
         const std::string& read_string();
+        const std::string& read_string_long();
+        const std::string& string_at(uint32_t idx) const;
+        uint16_t read_type_id();  // Program TypeDef index operand -> runtime type id
         const std::vector<uint8_t>& active_bytecode() const;
         body_idx entry_body_index(const Assembly& chunk) const;
         void set_active_body(body_idx idx);
+        void reuse_caller_frame();      // OP_TAIL_CALL: callee frame replaces its caller's
+        void enter_body(body_idx idx);  // set_active_body + per-call stack headroom check
+        void ensure_stack_headroom(size_t slots) const;
         uint32_t read_signature_param_count(signature_idx offset) const;
-        const MethodDef* find_method_def_by_name(const std::string& name,
-                                                 bool is_static,
-                                                 uint32_t param_count) const;
-        const MethodDef* find_method_def_for_type(const TypeDef& type_def,
-                                                  const std::string& name,
-                                                  bool is_static,
-                                                  uint32_t param_count) const;
         const PropertyDef* find_property_def_for_type(const TypeDef& type_def,
                                                       const std::string& name,
                                                       bool is_static) const;
@@ -274,13 +439,28 @@ class DebugController;
         size_t current_stack_base() const;
         bool is_truthy(const Value& value) const;
         const TypeDef* resolve_type_def(const std::string& name) const;
-        bool matches_type(const Value& value, const std::string& type_name) const;
+        uint16_t intern_type(const std::string& name);
+        void load_type_table(const Assembly& program);
+        bool conforms_to(uint16_t type_id, uint16_t protocol_id) const;
+        bool matches_type(const Value& value, uint16_t type_id) const;
+        void inherit_type_info(ClassObject* subclass, ClassObject* superclass);
         Value get_property(const Value& object, const std::string& name);
+        void call_builtin_method(BuiltinMethodObject* method, size_t callee_index, uint16_t arg_count);
+        bool is_callable(const Value& value) const;
+        void sort_list(ListObject* list);  // Default ordering for sorted()
+        // Packed numeric array kernels (sum/min/max, dot and element-wise arithmetic)
+        Value numeric_reduce(ListObject* list, const std::string& op);
+        Value numeric_elementwise(ListObject* list, const std::string& op, const Value& operand);
         bool find_method_on_class(ClassObject* klass, const std::string& name, Value& out_method) const;
+        bool has_method(const Value& value, const std::string& name) const;
+        void push_range(bool inclusive);  // [lower, upper] -> RangeObject
         std::optional<Value> call_operator_overload(const Value& left, const Value& right, const std::string& name);
         void build_param_defaults(const FunctionPrototype& proto,
                                   std::vector<Value>& defaults,
                                   std::vector<bool>& has_defaults);
+        FunctionObject* function_for_prototype(const FunctionPrototype& proto);
+        ClosureObject* closure_for_prototype(const FunctionPrototype& proto);  // Zero-upvalue prototypes only
+        void release_function_cache();
         void apply_positional_defaults(uint16_t& arg_count,
                                        FunctionObject* func,
                                        bool has_receiver);
@@ -298,40 +478,8 @@ class DebugController;
         
         // Execute a function synchronously (for nested calls like observers)
         Value execute_function(FunctionObject* func, ClosureObject* closure, const std::vector<Value>& args);
-    };
-
-    // Call Frame for function calls
-    class CallFrame {
-    public:
-        size_t stack_base;      // Base of this frame's stack
-        size_t return_address;  // Where to return after call
-        const Assembly* chunk;
-        body_idx body_index;
-        std::string function_name;
-        ClosureObject* closure; // Current closure for upvalue access (nullptr for plain functions)
-        bool is_initializer;
-        bool is_mutating;       // True if this is a mutating struct method
-        size_t receiver_index;  // Stack index of the receiver (for mutating methods)
-
-        CallFrame(size_t base,
-                  size_t ret_addr,
-                  const Assembly* call_chunk,
-                  body_idx call_body,
-                  std::string name,
-                  ClosureObject* c,
-                  bool initializer,
-                  bool mutating = false,
-                  size_t recv_idx = 0)
-            : stack_base(base),
-              return_address(ret_addr),
-              chunk(call_chunk),
-              body_index(call_body),
-              function_name(std::move(name)),
-              closure(c),
-              is_initializer(initializer),
-              is_mutating(mutating),
-              receiver_index(recv_idx) {
-        }
+        // Re-entrant call of any callable; returns the result with ownership.
+        Value call_value(const Value& callee, std::span<const Value> args);
     };
 
     // Template implementation
@@ -25,6 +25,16 @@ namespace swive {
         }
     };
 
+    template<>
+    struct OpCodeHandler<OpCode::OP_JUMP_IF_TRUE> {
+        static void execute(VM& vm) {
+            uint16_t offset = vm.read_short();
+            if (vm.is_truthy(vm.peek(0))) {
+                vm.ip_ += offset;
+            }
+        }
+    };
+
     template<>
     struct OpCodeHandler<OpCode::OP_LOOP> {
         static void execute(VM& vm) {
@@ -33,8 +43,108 @@ namespace swive {
         }
     };
 
-    OPCODE_DEFAULT(OpCode::OP_RANGE_INCLUSIVE)
-	OPCODE_DEFAULT(OpCode::OP_RANGE_EXCLUSIVE)
+    OPCODE(OpCode::OP_SWITCH_TABLE)
+    {
+        OP_BODY {
+            const auto& code = vm.active_bytecode();
+            uint8_t mode = vm.read_byte();
+            uint16_t count = vm.read_short();
+            uint16_t target = vm.read_short();  // default
+            size_t entries = vm.ip_ + ((mode & SWITCH_DENSE) ? 8 : 0);
+            size_t entry_size = switch_table_entry_size(mode);
+            size_t end = entries + count * entry_size;
+            auto target_at = [&](size_t entry) {
+                size_t at = entries + entry * entry_size + entry_size - 2;
+                return static_cast<uint16_t>((code[at] << 8) | code[at + 1]);
+            };
+
+            Value subject = vm.peek(0);
+            Object* obj = subject.is_object() ? subject.as_object() : nullptr;
+            uint8_t kind = mode & SWITCH_KIND_MASK;
+            if (kind == SWITCH_STRING) {
+                if (obj && obj->type == ObjectType::String) {
+                    const std::string& text = static_cast<StringObject*>(obj)->data;
+                    uint32_t hash = switch_string_hash(text);
+                    // First entry whose hash is not below the subject's, then walk collisions
+                    size_t lo = 0, hi = count;
+                    while (lo < hi) {
+                        size_t mid = (lo + hi) / 2;
+                        size_t at = entries + mid * entry_size;
+                        uint32_t key = (uint32_t(code[at]) << 24) | (uint32_t(code[at + 1]) << 16) |
+                                       (uint32_t(code[at + 2]) << 8) | code[at + 3];
+                        if (key < hash) lo = mid + 1; else hi = mid;
+                    }
+                    for (; lo < count; ++lo) {
+                        size_t at = entries + lo * entry_size;
+                        uint32_t key = (uint32_t(code[at]) << 24) | (uint32_t(code[at + 1]) << 16) |
+                                       (uint32_t(code[at + 2]) << 8) | code[at + 3];
+                        if (key != hash) break;
+                        uint16_t str_idx = static_cast<uint16_t>((code[at + 4] << 8) | code[at + 5]);
+                        if (str_idx < vm.chunk_->string_table.size() && vm.chunk_->string_table[str_idx] == text) {
+                            target = target_at(lo);
+                            break;
+                        }
+                    }
+                }
+            }
+            else {
+                std::optional<Int> key;
+                if (kind == SWITCH_ENUM) {
+                    if (obj && obj->type == ObjectType::EnumCase) {
+                        key = static_cast<EnumCaseObject*>(obj)->discriminant;
+                    }
+                }
+                else if (subject.is_int()) {
+                    key = subject.as_int();
+                }
+                else if (subject.is_float() && subject.as_float() > -9.2e18 && subject.as_float() < 9.2e18) {
+                    // OP_EQUAL treats a Float nearly equal to an Int as equal
+                    Float f = subject.as_float();
+                    Int nearest = static_cast<Int>(f < 0 ? f - 0.5 : f + 0.5);
+                    if (Value::from_int(nearest).equals(subject)) {
+                        key = nearest;
+                    }
+                }
+
+                if (key && (mode & SWITCH_DENSE)) {
+                    int64_t low = switch_table_key(code, vm.ip_);
+                    uint64_t slot = static_cast<uint64_t>(*key) - static_cast<uint64_t>(low);
+                    if (*key >= low && slot < count) {
+                        target = target_at(static_cast<size_t>(slot));
+                    }
+                }
+                else if (key) {
+                    size_t lo = 0, hi = count;
+                    while (lo < hi) {
+                        size_t mid = (lo + hi) / 2;
+                        int64_t entry_key = switch_table_key(code, entries + mid * entry_size);
+                        if (entry_key == *key) {
+                            target = target_at(mid);
+                            break;
+                        }
+                        if (entry_key < *key) lo = mid + 1; else hi = mid;
+                    }
+                }
+            }
+
+            vm.discard();
+            vm.ip_ = end + target;
+        }
+    };
+
+    OPCODE(OpCode::OP_RANGE_INCLUSIVE)
+    {
+        OP_BODY {
+            vm.push_range(true);
+        }
+    };
+
+    OPCODE(OpCode::OP_RANGE_EXCLUSIVE)
+    {
+        OP_BODY {
+            vm.push_range(false);
+        }
+    };
 
 	template<>
     struct OpCodeHandler<OpCode::OP_FUNCTION> {
@@ -44,19 +154,7 @@ namespace swive {
                 throw std::runtime_error("Function index out of range.");
             }
             const auto& proto = vm.chunk_->function_prototypes[index];
-            std::vector<Value> defaults;
-            std::vector<bool> has_defaults;
-            vm.build_param_defaults(proto, defaults, has_defaults);
-            auto* func = vm.allocate_object<FunctionObject>(
-                proto.name,
-                proto.params,
-                proto.param_labels,
-                std::move(defaults),
-                std::move(has_defaults),
-                proto.chunk,
-                proto.is_initializer,
-                proto.is_override);
-            vm.push_new(func);  // Transfer ownership
+            vm.push(Value::from_object(vm.function_for_prototype(proto)));
 		}
 	};
 
@@ -681,7 +779,7 @@ namespace swive {
             case ObjectType::Map: {
                 vm.pop();
                 auto* dict = static_cast<MapObject*>(o);
-                dict->entries[name] = value;
+                dict->insert(vm, name, value);
                 vm.push(value);
                 return;
             }
@@ -731,22 +829,14 @@ namespace swive {
             }
 
             const auto& proto = vm.chunk_->function_prototypes[index];
-            std::vector<Value> defaults;
-            std::vector<bool> has_defaults;
-            vm.build_param_defaults(proto, defaults, has_defaults);
-
-            auto* func = vm.allocate_object<FunctionObject>(
-                proto.name,
-                proto.params,
-                proto.param_labels,
-                std::move(defaults),
-                std::move(has_defaults),
-                proto.chunk,
-                proto.is_initializer,
-                proto.is_override);
-
-            // ClosureObject constructor retains func, so we pass ownership
-            auto* closure = vm.allocate_object<ClosureObject>(func);
+            if (proto.upvalues.empty()) {
+                // Nothing captured: every evaluation can share one closure
+                vm.push(Value::from_object(vm.closure_for_prototype(proto)));
+                return;
+            }
+
+            // ClosureObject constructor retains the shared func
+            auto* closure = vm.allocate_object<ClosureObject>(vm.function_for_prototype(proto));
             closure->upvalues.resize(proto.upvalues.size(), nullptr);
 
             ClosureObject* enclosing_closure = vm.call_frames_.empty() ? nullptr : vm.call_frames_.back().closure;
@@ -842,6 +932,9 @@ namespace swive {
             }
             const std::string& name = vm.chunk_->string_table[name_idx];
             auto* klass = vm.allocate_object<ClassObject>(name);
+            klass->type_id = vm.intern_type(name);
+            klass->display.assign(1, klass->type_id);
+            vm.runtime_types_[klass->type_id].class_depth = 0;
             vm.push_new(klass);  // Transfer ownership
         }
 	};
@@ -1057,23 +1150,7 @@ namespace swive {
             }
 
             const auto& proto = vm.chunk_->function_prototypes[fn_idx];
-
-            std::vector<Value> defaults;
-            std::vector<bool>  has_defaults;
-            vm.build_param_defaults(proto, defaults, has_defaults);
-
-            auto* func = vm.allocate_object<FunctionObject>(
-                proto.name,
-                proto.params,
-                proto.param_labels,
-                std::move(defaults),
-                std::move(has_defaults),
-                proto.chunk,
-                /*is_initializer*/ false,
-                /*is_override*/    false
-            );
-
-            auto* closure = vm.allocate_object<ClosureObject>(func);
+            auto* closure = vm.allocate_object<ClosureObject>(vm.function_for_prototype(proto));
             // Retain for storage (allocate starts at rc:0)
             RC::retain(closure);
             return closure;
@@ -1179,20 +1256,7 @@ namespace swive {
             Value will_set_observer = Value::null();
             if (will_set_idx != 0xFFFF && will_set_idx < vm.chunk_->function_prototypes.size()) {
                 const auto& will_set_proto = vm.chunk_->function_prototypes[will_set_idx];
-                std::vector<Value> will_set_defaults;
-                std::vector<bool> will_set_has_defaults;
-                vm.build_param_defaults(will_set_proto, will_set_defaults, will_set_has_defaults);
-                auto* will_set_func = vm.allocate_object<FunctionObject>(
-                    will_set_proto.name,
-                    will_set_proto.params,
-                    will_set_proto.param_labels,
-                    std::move(will_set_defaults),
-                    std::move(will_set_has_defaults),
-                    will_set_proto.chunk,
-                    false,
-                    false
-                );
-                auto* will_set_closure = vm.allocate_object<ClosureObject>(will_set_func);
+                auto* will_set_closure = vm.allocate_object<ClosureObject>(vm.function_for_prototype(will_set_proto));
                 RC::retain(will_set_closure);  // Retain for storage
                 will_set_observer = Value::from_object(will_set_closure);
             }
@@ -1201,20 +1265,7 @@ namespace swive {
             Value did_set_observer = Value::null();
             if (did_set_idx != 0xFFFF && did_set_idx < vm.chunk_->function_prototypes.size()) {
                 const auto& did_set_proto = vm.chunk_->function_prototypes[did_set_idx];
-                std::vector<Value> did_set_defaults;
-                std::vector<bool> did_set_has_defaults;
-                vm.build_param_defaults(did_set_proto, did_set_defaults, did_set_has_defaults);
-                auto* did_set_func = vm.allocate_object<FunctionObject>(
-                    did_set_proto.name,
-                    did_set_proto.params,
-                    did_set_proto.param_labels,
-                    std::move(did_set_defaults),
-                    std::move(did_set_has_defaults),
-                    did_set_proto.chunk,
-                    false,
-                    false
-                );
-                auto* did_set_closure = vm.allocate_object<ClosureObject>(did_set_func);
+                auto* did_set_closure = vm.allocate_object<ClosureObject>(vm.function_for_prototype(did_set_proto));
                 RC::retain(did_set_closure);  // Retain for storage
                 did_set_observer = Value::from_object(did_set_closure);
             }
@@ -1265,6 +1316,7 @@ namespace swive {
             auto* subclass = static_cast<ClassObject*>(subclass_val.as_object());
             auto* superclass = static_cast<ClassObject*>(superclass_val.as_object());
             subclass->superclass = superclass;
+            vm.inherit_type_info(subclass, superclass);
             // Remove superclass from stack with proper RC
             // Release the superclass reference before erasing
             if (superclass_val.is_object() && superclass_val.ref_type() == RefType::Strong && superclass_val.as_object()) {
@@ -1302,18 +1354,22 @@ namespace swive {
         OP_BODY {
             uint16_t count = vm.read_short();
             auto* arr = vm.allocate_object<ListObject>();
-            arr->elements.reserve(count);
             // Pop elements in reverse order (last pushed first)
             std::vector<Value> temp(count);
             for (int i = count - 1; i >= 0; --i) {
                 temp[i] = vm.pop();
             }
+            // Homogeneous Int/Float literals get packed storage
+            if (count > 0 && temp[0].is_number()) {
+                arr->buffer->storage = temp[0].is_int() ? ListStorage::Int : ListStorage::Float;
+            }
+            arr->reserve(count);
             for (const auto& v : temp) {
                 // Retain for storage in list (pop released the stack's reference)
                 if (v.is_object() && v.ref_type() == RefType::Strong && v.as_object()) {
                     RC::retain(v.as_object());
                 }
-                arr->elements.push_back(v);
+                arr->push(v);
             }
             vm.push_new(arr);  // Transfer ownership
 		}
@@ -1336,11 +1392,8 @@ namespace swive {
                     throw std::runtime_error("Dictionary key must be a string.");
                 }
                 auto* str_key = static_cast<StringObject*>(k.as_object());
-                // Retain value for storage (pop released the stack's reference)
-                if (v.is_object() && v.ref_type() == RefType::Strong && v.as_object()) {
-                    RC::retain(v.as_object());
-                }
-                dict->entries[str_key->data] = v;
+                // insert() retains the value for storage (pop released the stack's reference)
+                dict->insert(vm, str_key->data, v);
             }
             vm.push_new(dict);  // Transfer ownership
         }
@@ -1362,10 +1415,10 @@ namespace swive {
                     throw std::runtime_error("List subscript must be a number.");
                 }
                 int idx = static_cast<int>(index.as_int());
-                if (idx < 0 || idx >= static_cast<int>(list->elements.size())) {
+                if (idx < 0 || idx >= static_cast<int>(list->size())) {
                     throw std::runtime_error("List subscript out of range.");
                 }
-                vm.push(list->elements[idx]);
+                vm.push(list->at(idx));
                 return;
             }
             case ObjectType::Map: {
@@ -1374,15 +1427,31 @@ namespace swive {
                     throw std::runtime_error("Dictionary subscript must be a string.");
                 }
                 auto* str_key = static_cast<StringObject*>(index.as_object());
-                auto it = dict->entries.find(str_key->data);
-                if (it == dict->entries.end()) {
+                auto it = dict->entries().find(str_key->data);
+                if (it == dict->entries().end()) {
                     vm.push(Value::null());
+                    return;
                 }
                 vm.push(it->second);
                 return;
             }
+            case ObjectType::Set: {
+                // Ordinal access into dense storage
+                auto* set = static_cast<SetObject*>(obj);
+                if (!index.is_int()) {
+                    throw std::runtime_error("Set subscript must be an int position.");
+                }
+                Int idx = index.as_int();
+                if (idx < 0 || idx >= static_cast<Int>(set->elements().size())) {
+                    throw std::runtime_error("Set subscript out of range.");
+                }
+                vm.push(set->elements()[static_cast<size_t>(idx)]);
+                return;
+            }
+            default:
+                break;
             }
-            throw std::runtime_error("Subscript access only supported on arrays and dictionaries.");
+            throw std::runtime_error("Subscript access only supported on arrays, sets and dictionaries.");
 		}
     };
 
@@ -1403,19 +1472,12 @@ namespace swive {
                     throw std::runtime_error("List subscript must be a int.");
                 }
                 int idx = static_cast<int>(index.as_int());
-                if (idx < 0 || idx >= static_cast<int>(list->elements.size())) {
+                if (idx < 0 || idx >= static_cast<int>(list->size())) {
                     throw std::runtime_error("List subscript out of range.");
                 }
-                // Release old value before assignment
-                Value& old_val = list->elements[idx];
-                if (old_val.is_object() && old_val.ref_type() == RefType::Strong && old_val.as_object()) {
-                    RC::release(&vm, old_val.as_object());
-                }
-                // Retain new value (value was popped, so it's been released, need to retain for storage)
-                if (value.is_object() && value.ref_type() == RefType::Strong && value.as_object()) {
-                    RC::retain(value.as_object());
-                }
-                old_val = value;
+                // Unshares a copy-on-write buffer, then releases the old value and
+                // retains the new one (boxes on type mismatch)
+                list->assign(vm, static_cast<size_t>(idx), value);
                 vm.push(value);
                 return;
             }
@@ -1425,26 +1487,320 @@ namespace swive {
                     throw std::runtime_error("Dictionary subscript must be a string.");
                 }
                 auto* str_key = static_cast<StringObject*>(index.as_object());
-                // Release old value if exists
-                auto it = dict->entries.find(str_key->data);
-                if (it != dict->entries.end()) {
-                    if (it->second.is_object() && it->second.ref_type() == RefType::Strong && it->second.as_object()) {
-                        RC::release(&vm, it->second.as_object());
-                    }
-                }
-                // Retain new value (value was popped, so need to retain for storage)
-                if (value.is_object() && value.ref_type() == RefType::Strong && value.as_object()) {
-                    RC::retain(value.as_object());
-                }
-                dict->entries[str_key->data] = value;
+                // Unshares a copy-on-write buffer, retains value and releases the old one
+                dict->insert(vm, str_key->data, value);
                 vm.push(value);
                 return;
             }
+            case ObjectType::Set:
+                throw std::runtime_error("Sets do not support subscript assignment; use insert() instead.");
+            default:
+                break;
             }
 			throw std::runtime_error("Subscript assignment only supported on arrays and dictionaries.");
         }
 	};
 
+    OPCODE(OpCode::OP_SET_LITERAL)
+    {
+        OP_BODY {
+            uint16_t count = vm.read_short();
+            auto* set = vm.allocate_object<SetObject>();
+            set->reserve(count);
+            // Elements are inserted in source order straight from the stack
+            size_t first = vm.stack_.size() - count;
+            for (size_t i = first; i < vm.stack_.size(); ++i) {
+                set->insert(vm, vm.stack_[i]);  // insert() retains stored elements
+            }
+            for (uint16_t i = 0; i < count; ++i) {
+                vm.discard();
+            }
+            vm.push_new(set);  // Transfer ownership
+        }
+    };
+
+    OPCODE(OpCode::OP_CONTAINS)
+    {
+        OP_BODY {
+            Value needle = vm.peek(0);
+            Value collection = vm.peek(1);
+            if (!collection.is_object() || !collection.as_object()) {
+                throw std::runtime_error("contains() called on non-collection.");
+            }
+            bool found = false;
+            Object* obj = collection.as_object();
+            switch (obj->type) {
+            case ObjectType::Set:
+                found = static_cast<SetObject*>(obj)->contains(needle);
+                break;
+            case ObjectType::Range:
+                found = needle.is_int() && static_cast<RangeObject*>(obj)->contains(needle.as_int());
+                break;
+            case ObjectType::List: {
+                auto* list = static_cast<ListObject*>(obj);
+                bool by_predicate = vm.is_callable(needle);  // contains(where:) passed positionally
+                if (!by_predicate && list->storage() == ListStorage::Int && needle.is_int()) {
+                    const auto& ints = list->buffer->ints;
+                    found = std::find(ints.begin(), ints.end(), needle.as_int()) != ints.end();
+                    break;
+                }
+                for (size_t i = 0; i < list->size() && !found; ++i) {
+                    if (!by_predicate) {
+                        found = list->at(i).equals(needle);
+                        continue;
+                    }
+                    Value elem = list->at(i);
+                    Value ret = vm.call_value(needle, std::span<const Value>(&elem, 1));
+                    found = vm.is_truthy(ret);
+                    if (ret.is_object() && ret.ref_type() == RefType::Strong && ret.as_object()) {
+                        RC::release(&vm, ret.as_object());
+                    }
+                }
+                break;
+            }
+            case ObjectType::Map: {
+                if (!needle.is_object() || !needle.as_object() || needle.as_object()->type != ObjectType::String) {
+                    throw std::runtime_error("Dictionary key must be a string.");
+                }
+                auto* dict = static_cast<MapObject*>(obj);
+                found = dict->entries().count(static_cast<StringObject*>(needle.as_object())->data) > 0;
+                break;
+            }
+            default:
+                throw std::runtime_error("contains() only supported on arrays, sets, dictionaries and ranges.");
+            }
+            vm.discard();
+            vm.discard();
+            vm.push(Value::from_bool(found));
+        }
+    };
+
+    OPCODE(OpCode::OP_ITER_INIT)
+    {
+        OP_BODY {
+            Value iterable = vm.peek(0);
+            if (!iterable.is_object() || !iterable.as_object()) {
+                throw std::runtime_error("for-in requires a sequence.");
+            }
+            Object* obj = iterable.as_object();
+            switch (obj->type) {
+            case ObjectType::List:
+            case ObjectType::Set:
+            case ObjectType::Map:
+                // Iterate a snapshot: the loop body may mutate the collection,
+                // which then copies the shared buffer instead of growing this one
+                if (iterable.ref_type() == RefType::Strong &&
+                    obj->rc.strong_count.load(std::memory_order_relaxed) > 1) {
+                    Object* snapshot = share_collection(vm, obj);
+                    vm.discard();
+                    vm.push_new(snapshot);
+                }
+                return;
+            case ObjectType::Range:
+            case ObjectType::String:
+                // Natives are stepped in place by OP_FOR_ARRAY_NEXT
+                return;
+            case ObjectType::Instance:
+            case ObjectType::StructInstance: {
+                if (vm.has_method(iterable, "makeIterator")) {
+                    // Replace the sequence with makeIterator(); the frame returns
+                    // to the next instruction with the iterator in the same slot.
+                    Value make_iterator = vm.get_property(iterable, "makeIterator");
+                    vm.discard();  // Bound method keeps the receiver alive
+                    vm.push(make_iterator);
+                    OpCodeHandler<OpCode::OP_CALL>::invoke(vm, 0);
+                    return;
+                }
+                if (vm.has_method(iterable, "next")) {
+                    return;  // Already an iterator
+                }
+                break;
+            }
+            default:
+                break;
+            }
+            throw std::runtime_error(std::string("Value of type '") + object_type_name(obj->type) +
+                                     "' does not conform to Sequence.");
+        }
+    };
+
+    // Stack layout at [slot]: the iterator, an Int cursor, then the loop
+    // variable, which each step overwrites in place. Arrays are stepped before
+    // anything else is looked at; the other natives encode their position in
+    // the cursor, so stepping allocates nothing beyond the produced element.
+    // Script iterators call next() through a normal frame that returns to this
+    // same instruction (cursor 1 = result pending).
+    OPCODE(OpCode::OP_FOR_ARRAY_NEXT)
+    {
+        OP_BODY {
+            size_t op_start = vm.ip_ - 1;
+            uint16_t slot = vm.read_short();
+            uint16_t exit_offset = vm.read_short();
+            size_t iter_index = vm.current_stack_base() + slot;
+            if (iter_index + 2 >= vm.stack_.size()) {
+                throw std::runtime_error("Iterator slot out of range.");
+            }
+            Object* obj = vm.stack_[iter_index].as_object();
+            Int cursor = vm.stack_[iter_index + 1].as_int();
+            auto advance = [&](Int next_cursor) {
+                vm.stack_[iter_index + 1] = Value::from_int(next_cursor);
+            };
+            // Stores an element the slot takes its own reference to
+            auto store = [&](Value element) {
+                if (element.is_object() && element.ref_type() == RefType::Strong && element.as_object()) {
+                    RC::retain(element.as_object());
+                }
+                Value& variable = vm.stack_[iter_index + 2];
+                if (variable.is_object() && variable.ref_type() == RefType::Strong && variable.as_object()) {
+                    RC::release(&vm, variable.as_object());
+                }
+                variable = element;
+            };
+
+            if (obj->type == ObjectType::List) {
+                auto* list = static_cast<ListObject*>(obj);
+                if (cursor < static_cast<Int>(list->size())) {
+                    advance(cursor + 1);
+                    store(list->at(static_cast<size_t>(cursor)));
+                } else {
+                    vm.ip_ += exit_offset;
+                }
+                return;
+            }
+
+            switch (obj->type) {
+            case ObjectType::Range: {
+                auto* range = static_cast<RangeObject*>(obj);
+                Int value = range->lower + cursor;
+                if (value < range->end()) {
+                    advance(cursor + 1);
+                    store(Value::from_int(value));
+                    return;
+                }
+                break;
+            }
+            case ObjectType::Set: {
+                const auto& elements = static_cast<SetObject*>(obj)->elements();
+                if (cursor < static_cast<Int>(elements.size())) {
+                    advance(cursor + 1);
+                    store(elements[static_cast<size_t>(cursor)]);
+                    return;
+                }
+                break;
+            }
+            case ObjectType::Map: {
+                // Cursor packs (bucket << 32 | position within bucket)
+                const auto& entries = static_cast<MapObject*>(obj)->entries();
+                size_t bucket = static_cast<size_t>(static_cast<uint64_t>(cursor) >> 32);
+                size_t position = static_cast<size_t>(cursor & 0xFFFFFFFF);
+                for (; bucket < entries.bucket_count(); ++bucket, position = 0) {
+                    auto it = entries.begin(bucket);
+                    auto end = entries.end(bucket);
+                    for (size_t i = 0; i < position && it != end; ++i) {
+                        ++it;
+                    }
+                    if (it == end) {
+                        continue;
+                    }
+                    advance(static_cast<Int>((static_cast<uint64_t>(bucket) << 32) | (position + 1)));
+                    auto* key = vm.allocate_object<StringObject>(it->first);
+                    RC::retain(key);
+                    Value value = it->second;
+                    if (value.is_object() && value.ref_type() == RefType::Strong && value.as_object()) {
+                        RC::retain(value.as_object());
+                    }
+                    auto* pair = vm.allocate_object<TupleObject>(
+                        std::vector<Value>{ Value::from_object(key), value },
+                        std::vector<std::optional<std::string>>{ "key", "value" });
+                    store(Value::from_object(pair));
+                    return;
+                }
+                break;
+            }
+            case ObjectType::String: {
+                // Cursor is a byte offset; each step yields one UTF-8 code point
+                const auto& data = static_cast<StringObject*>(obj)->data;
+                size_t offset = static_cast<size_t>(cursor);
+                if (offset < data.size()) {
+                    unsigned char lead = static_cast<unsigned char>(data[offset]);
+                    size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 1;
+                    length = std::min(length, data.size() - offset);
+                    advance(static_cast<Int>(offset + length));
+                    store(Value::from_object(vm.allocate_object<StringObject>(data.substr(offset, length))));
+                    return;
+                }
+                break;
+            }
+            case ObjectType::Instance:
+            case ObjectType::StructInstance: {
+                if (cursor == 1) {
+                    // Resumed after next() returned; nil ends the loop
+                    advance(0);
+                    Value next = vm.pop();
+                    if (!next.is_null()) {
+                        store(next);
+                        if (next.is_object() && next.ref_type() == RefType::Strong && next.as_object()) {
+                            RC::release(&vm, next.as_object());  // The popped reference
+                        }
+                        return;
+                    }
+                    break;
+                }
+                advance(1);
+                vm.push(vm.get_property(vm.stack_[iter_index], "next"));
+                vm.ip_ = op_start;
+                OpCodeHandler<OpCode::OP_CALL>::invoke(vm, 0);
+                return;
+            }
+            default:
+                throw std::runtime_error("for-in requires a sequence.");
+            }
+            vm.ip_ += exit_offset;
+        }
+    };
+
+    // Stack layout at [slot]: the next counter value, the end bound, then the
+    // loop variable. Int bounds take the fast path; anything else steps like
+    // OP_LESS/OP_LESS_EQUAL and OP_ADD would on numbers.
+    OPCODE(OpCode::OP_FOR_RANGE_NEXT)
+    {
+        OP_BODY {
+            uint16_t slot = vm.read_short();
+            bool inclusive = vm.read_byte() != 0;
+            uint16_t exit_offset = vm.read_short();
+            size_t index = vm.current_stack_base() + slot;
+            if (index + 2 >= vm.stack_.size()) {
+                throw std::runtime_error("Range loop slot out of range.");
+            }
+            Value& next = vm.stack_[index];
+            const Value& end = vm.stack_[index + 1];
+            Value& variable = vm.stack_[index + 2];
+
+            if (next.is_int() && end.is_int()) {
+                Int value = next.as_int();
+                if (inclusive ? value <= end.as_int() : value < end.as_int()) {
+                    variable = next;
+                    next = Value::from_int(value + 1);
+                } else {
+                    vm.ip_ += exit_offset;
+                }
+                return;
+            }
+
+            if (!next.is_number() || !end.is_number()) {
+                throw std::runtime_error("Range bounds must be numbers.");
+            }
+            Float value = next.is_int() ? static_cast<Float>(next.as_int()) : next.as_float();
+            Float bound = end.is_int() ? static_cast<Float>(end.as_int()) : end.as_float();
+            if (inclusive ? value <= bound : value < bound) {
+                variable = next;
+                next = next.is_int() ? Value::from_int(next.as_int() + 1) : Value::from_float(value + 1.0);
+            } else {
+                vm.ip_ += exit_offset;
+            }
+        }
+    };
+
     OPCODE(OpCode::OP_TUPLE)
     {
         OP_BODY
@@ -1536,6 +1892,7 @@ namespace swive {
             }
             const std::string& name = vm.chunk_->string_table[name_idx];
             auto* struct_type = vm.allocate_object<StructObject>(name);
+            struct_type->type_id = vm.intern_type(name);
             vm.push_new(struct_type);  // Transfer ownership
         }
     };
@@ -1596,6 +1953,16 @@ namespace swive {
                 vm.discard();  // Discard original
                 vm.push_new(copy);  // Transfer ownership
             }
+            else if (val.is_object() && val.as_object() && val.ref_type() == RefType::Strong &&
+                     is_value_collection(val.as_object()->type) &&
+                     val.as_object()->rc.strong_count.load(std::memory_order_relaxed) > 1) {
+                // Arrays, dictionaries and sets are values: share the element buffer
+                // and let the first mutation copy it. A temporary only the stack
+                // holds (rc == 1) is handed over as-is.
+                Object* copy = share_collection(vm, val.as_object());
+                vm.discard();
+                vm.push_new(copy);
+            }
             else {
                 // Not a struct instance, just leave on stack (no-op)
                 // No need to pop and re-push the same value
@@ -1616,6 +1983,7 @@ namespace swive {
             }
             const std::string& name = vm.chunk_->string_table[name_idx];
             auto* enum_type = vm.allocate_object<EnumObject>(name);
+            enum_type->type_id = vm.intern_type(name);
             vm.push_new(enum_type);  // Transfer ownership
         }
     };
@@ -1627,6 +1995,7 @@ namespace swive {
             // Define an enum case
                     // Stack: [enum_object, raw_value]
             uint16_t case_name_idx = vm.read_short();
+            uint16_t discriminant = vm.read_short();
             uint8_t associated_count = vm.read_byte();
 
             if (vm.stack_.size() < 2) {
@@ -1647,27 +2016,31 @@ namespace swive {
             auto* enum_type = static_cast<EnumObject*>(enum_val.as_object());
             const std::string& case_name = vm.chunk_->string_table[case_name_idx];
 
-            // Create enum case instance
-            auto* case_obj = vm.allocate_object<EnumCaseObject>(enum_type, case_name);
-
-            // Retain the enum type for the case's lifetime
-            RC::retain(enum_type);
-
-            case_obj->raw_value = raw_value;
-            case_obj->associated_labels.reserve(associated_count);
+            auto info = std::make_shared<EnumCaseInfo>();
+            info->name = case_name;
+            info->discriminant = discriminant;
+            info->associated_labels.reserve(associated_count);
             for (uint8_t i = 0; i < associated_count; ++i) {
                 uint16_t label_idx = vm.read_short();
                 if (label_idx == std::numeric_limits<uint16_t>::max()) {
-                    case_obj->associated_labels.emplace_back("");
+                    info->associated_labels.emplace_back("");
                 }
                 else if (label_idx < vm.chunk_->string_table.size()) {
-                    case_obj->associated_labels.emplace_back(vm.chunk_->string_table[label_idx]);
+                    info->associated_labels.emplace_back(vm.chunk_->string_table[label_idx]);
                 }
                 else {
                     throw std::runtime_error("Associated value label index out of range.");
                 }
             }
 
+            // Create enum case instance
+            auto* case_obj = vm.allocate_object<EnumCaseObject>(enum_type, std::move(info));
+
+            // Retain the enum type for the case's lifetime
+            RC::retain(enum_type);
+
+            case_obj->raw_value = raw_value;
+
             // Store in enum's cases map (retain for map ownership)
             RC::retain(case_obj);
             enum_type->cases[case_name] = Value::from_object(case_obj);
@@ -1678,14 +2051,15 @@ namespace swive {
     {
         OP_BODY
         {
-            const std::string& case_name = vm.read_string();
-            Value value = vm.pop();
+            uint16_t discriminant = vm.read_short();
+            Value value = vm.peek(0);
             bool matches = false;
             if (value.is_object() && value.as_object() &&
                 value.as_object()->type == ObjectType::EnumCase) {
                 auto* enum_case = static_cast<EnumCaseObject*>(value.as_object());
-                matches = enum_case->case_name == case_name;
+                matches = enum_case->discriminant == discriminant;
             }
+            vm.discard();
             vm.push(Value::from_bool(matches));
         }
     };
@@ -1753,14 +2127,10 @@ namespace swive {
         OP_BODY
         {
             // is operator: value is Type
-            uint16_t type_name_idx = vm.read_short();
-            if (type_name_idx >= vm.chunk_->string_table.size()) {
-                throw std::runtime_error("Type name index out of range.");
-            }
-            const std::string& type_name = vm.chunk_->string_table[type_name_idx];
-            Value value = vm.pop();
-
-            vm.push(Value::from_bool(vm.matches_type(value, type_name)));
+            uint16_t type_id = vm.read_type_id();
+            bool result = vm.matches_type(vm.peek(0), type_id);
+            vm.discard();
+            vm.push(Value::from_bool(result));
         }
     };
 
@@ -1768,16 +2138,8 @@ namespace swive {
     {
         OP_BODY
         {
-            // as operator: basic cast (for now, just verify type matches)
-            uint16_t type_name_idx = vm.read_short();
-            if (type_name_idx >= vm.chunk_->string_table.size()) {
-                throw std::runtime_error("Type name index out of range.");
-            }
-            const std::string& type_name = vm.chunk_->string_table[type_name_idx];
-            Value value = vm.peek(0);  // Keep value on stack
-
-            // For now, basic cast just passes through
-            // In a full implementation, this would validate the cast
+            // as operator: upcasts are checked statically, so the value passes through
+            vm.read_type_id();
         }
     };
 
@@ -1786,19 +2148,9 @@ namespace swive {
         OP_BODY
         {
             // as? operator: optional cast (returns nil if fails)
-            uint16_t type_name_idx = vm.read_short();
-            if (type_name_idx >= vm.chunk_->string_table.size()) {
-                throw std::runtime_error("Type name index out of range.");
-            }
-            const std::string& type_name = vm.chunk_->string_table[type_name_idx];
-            Value value = vm.pop();
-
-            bool is_valid = vm.matches_type(value, type_name);
-
-            if (is_valid) {
-                vm.push(value);
-            }
-            else {
+            uint16_t type_id = vm.read_type_id();
+            if (!vm.matches_type(vm.peek(0), type_id)) {
+                vm.discard();
                 vm.push(Value::null());
             }
         }
@@ -1809,17 +2161,9 @@ namespace swive {
         OP_BODY
         {
             // as! operator: forced cast (throws if fails)
-            uint16_t type_name_idx = vm.read_short();
-            if (type_name_idx >= vm.chunk_->string_table.size()) {
-                throw std::runtime_error("Type name index out of range.");
-            }
-            const std::string& type_name = vm.chunk_->string_table[type_name_idx];
-            Value value = vm.peek(0);
-
-            bool is_valid = vm.matches_type(value, type_name);
-
-            if (!is_valid) {
-                throw std::runtime_error("Forced cast (as!) failed: value is not of type '" + type_name + "'");
+            uint16_t type_id = vm.read_type_id();
+            if (!vm.matches_type(vm.peek(0), type_id)) {
+                throw std::runtime_error("Forced cast (as!) failed: value is not of type '" + vm.runtime_types_[type_id].name + "'");
             }
             // Value stays on stack
         }
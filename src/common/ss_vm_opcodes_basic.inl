@@ -146,6 +146,9 @@ namespace swive {
                 }
                 throw std::runtime_error("Bool() failed: unsupported input type.");
             }
+            if (name == "Set") {
+                return Value::from_object(vm.make_set_from(input));
+            }
             throw std::runtime_error("Unknown builtin conversion: " + name);
         }
     } // namespace
@@ -166,6 +169,22 @@ namespace swive {
         }
     };
 
+    template<>
+    struct OpCodeHandler<OpCode::OP_CONSTANT_LONG> {
+        static void execute(VM& vm) {
+            vm.push(vm.read_constant_long());
+        }
+    };
+
+    template<>
+    struct OpCodeHandler<OpCode::OP_STRING_LONG> {
+        static void execute(VM& vm) {
+            const std::string& str = vm.read_string_long();
+            Object* str_obj = vm.allocate_object<StringObject>(str);
+            vm.push_new(str_obj);  // Transfer ownership
+        }
+    };
+
     template<>
     struct OpCodeHandler<OpCode::OP_NIL> {
         static void execute(VM& vm) {
@@ -215,13 +234,42 @@ namespace swive {
         }
     };
 
+    OPCODE(OpCode::OP_PICK)
+    {
+        OP_BODY
+        {
+            uint16_t depth = vm.read_short();
+            vm.push(vm.peek(depth));
+        }
+    };
+
+    OPCODE(OpCode::OP_POP_UNDER)
+    {
+        OP_BODY
+        {
+            uint16_t count = vm.read_short();
+            Value top = vm.pop();  // Ownership moves back onto the stack below
+            for (uint16_t i = 0; i < count; ++i) {
+                vm.discard();
+            }
+            vm.stack_.push_back(top);
+        }
+    };
+
     OPCODE(OpCode::OP_CALL)
     {
         OP_BODY
+        {
+            invoke(vm, vm.read_short());
+        }
+
+        // Calls the callee sitting below arg_count arguments on the stack.
+        // Frames return to vm.ip_; opcodes that need to resume themselves
+        // (e.g. OP_FOR_ARRAY_NEXT) rewind ip_ before calling in.
+        static void invoke(VM& vm, uint16_t arg_count)
         {
 			VM* self = &vm;
-            uint16_t arg_count = vm.read_short();
-            if (vm.stack_.size() < arg_count + 1) {
+            if (vm.stack_.size() < arg_count + 1u) {
                 throw std::runtime_error("Not enough values for function call.");
             }
             size_t callee_index = vm.stack_.size() - arg_count - 1;
@@ -237,7 +285,7 @@ namespace swive {
             // EnumCase call -> create instance with associated values
             if (obj->type == ObjectType::EnumCase) {
                 auto* template_case = static_cast<EnumCaseObject*>(obj);
-                size_t expected = template_case->associated_labels.size();
+                size_t expected = template_case->associated_labels().size();
                 if (arg_count != expected) {
                     throw std::runtime_error("Incorrect argument count for enum case.");
                 }
@@ -245,14 +293,13 @@ namespace swive {
                 // Create a new enum case instance with associated values
                 auto* new_case = vm.allocate_object<EnumCaseObject>(
                     template_case->enum_type,
-                    template_case->case_name
-                );
+                    template_case->info);
 
                 // Retain the enum type for the case's lifetime
                 RC::retain(template_case->enum_type);
 
                 new_case->raw_value = template_case->raw_value;
-                new_case->associated_labels = template_case->associated_labels;
+                new_case->associated_values.reserve(expected);
 
                 // Collect associated values from arguments
                 // Transfer ownership from stack to associated_values (no extra retain needed)
@@ -373,8 +420,8 @@ namespace swive {
                         init_func = static_cast<ClosureObject*>(init_obj)->function;
                     }
 
-                    if (!init_func || !init_func->chunk) {
-                        throw std::runtime_error("Native init has no chunk");
+                    if (!init_func || init_func->body == kInvalidBody) {
+                        throw std::runtime_error("Native init has no body");
                     }
 
                     // Replace callee (class) with nil placeholder for return value slot
@@ -391,15 +438,14 @@ namespace swive {
                         vm.ip_,            // return_address
                         vm.chunk_,         // saved chunk
                         vm.current_body_idx_, // saved body index
-                        init_func->name,   // function name
+                        init_func,         // callee (name for debugging)
                         nullptr,           // closure (none for native wrapper)
                         false              // is_initializer - false for native classes
                     );
 
-                    // Switch to the init function's chunk
-                    vm.chunk_ = init_func->chunk.get();
-                    vm.current_body_idx_ = vm.entry_body_index(*vm.chunk_);
-                    vm.set_active_body(vm.current_body_idx_);
+                    // Switch to the init function's body
+                    vm.current_body_idx_ = init_func->body;
+                    vm.enter_body(vm.current_body_idx_);
                     vm.ip_ = 0;
 
                     return;  // Continue execution in the init wrapper
@@ -457,46 +503,18 @@ namespace swive {
 
             // Built-in method call handling
             if (obj->type == ObjectType::BuiltinMethod) {
-                auto* method = static_cast<BuiltinMethodObject*>(obj);
-
-                if (method->method_name == "append") {
-                    if (arg_count != 1) {
-                        throw std::runtime_error("append() requires exactly 1 argument.");
-                    }
-
-                    if (method->target->type != ObjectType::List) {
-                        throw std::runtime_error("append() can only be called on arrays.");
-                    }
-
-                    auto* arr = static_cast<ListObject*>(method->target);
-                    Value arg = vm.peek(0);
-
-                    // Add element to array (retain for the array)
-                    if (arg.is_object() && arg.ref_type() == RefType::Strong && arg.as_object()) {
-                        RC::retain(arg.as_object());
-                    }
-                    arr->elements.push_back(arg);
-
-                    // Clean up stack (discard values)
-                    while (vm.stack_.size() > callee_index) {
-                        vm.discard();
-                    }
-
-                    // append returns nil
-                    vm.push(Value::null());
-                    return;
-                }
-
-                throw std::runtime_error("Unknown built-in method: " + method->method_name);
+                vm.call_builtin_method(static_cast<BuiltinMethodObject*>(obj), callee_index, arg_count);
+                return;
             }
 
             if (obj->type == ObjectType::Function) {
                 auto* func = static_cast<FunctionObject*>(obj);
-                if (!func->chunk && vm.is_builtin_type_name(func->name)) {
-                    if (arg_count != 1) {
+                if (func->body == kInvalidBody && vm.is_builtin_type_name(func->name)) {
+                    bool empty_set_init = arg_count == 0 && func->name == "Set";
+                    if (arg_count != 1 && !empty_set_init) {
                         throw std::runtime_error(func->name + "() requires exactly 1 argument.");
                     }
-                    Value input = vm.stack_[callee_index + 1];
+                    Value input = empty_set_init ? Value::null() : vm.stack_[callee_index + 1];
                     Value result = convert_builtin(vm, func->name, input);
                     while (vm.stack_.size() > callee_index) {
                         vm.discard();
@@ -556,40 +574,12 @@ namespace swive {
 
                 vm.apply_positional_defaults(arg_count, func, has_receiver);
 
-                uint32_t param_count = has_receiver ? static_cast<uint32_t>(arg_count - 1) : arg_count;
-                const TypeDef* type_def = nullptr;
-                if (bound->receiver->type == ObjectType::Instance) {
-                    auto* inst = static_cast<InstanceObject*>(bound->receiver);
-                    if (inst->klass) {
-                        type_def = vm.resolve_type_def(inst->klass->name);
-                    }
-                } else if (bound->receiver->type == ObjectType::StructInstance) {
-                    auto* inst = static_cast<StructInstanceObject*>(bound->receiver);
-                    if (inst->struct_type) {
-                        type_def = vm.resolve_type_def(inst->struct_type->name);
-                    }
-                } else if (bound->receiver->type == ObjectType::EnumCase) {
-                    auto* inst = static_cast<EnumCaseObject*>(bound->receiver);
-                    if (inst->enum_type) {
-                        type_def = vm.resolve_type_def(inst->enum_type->name);
-                    }
-                }
-
-                if (type_def) {
-                    const MethodDef* method_def = vm.find_method_def_for_type(*type_def, func->name, false, param_count);
-                    if (method_def) {
-                        vm.invoke_method_def(*method_def, callee_index, arg_count, true, func->is_initializer, is_mutating_call, receiver_stack_index);
-                        return;
-                    }
-                }
-
-                if (!func->chunk) {
+                if (func->body == kInvalidBody) {
                     throw std::runtime_error("Function has no body.");
                 }
-                vm.call_frames_.emplace_back(callee_index + 1, vm.ip_, vm.chunk_, vm.current_body_idx_, func->name, closure, func->is_initializer, is_mutating_call, receiver_stack_index);
-                vm.chunk_ = func->chunk.get();
-                vm.current_body_idx_ = vm.entry_body_index(*vm.chunk_);
-                vm.set_active_body(vm.current_body_idx_);
+                vm.call_frames_.emplace_back(callee_index + 1, vm.ip_, vm.chunk_, vm.current_body_idx_, func, closure, func->is_initializer, is_mutating_call, receiver_stack_index);
+                vm.current_body_idx_ = func->body;
+                vm.enter_body(vm.current_body_idx_);
                 vm.ip_ = 0;
                 return;
             }
@@ -610,26 +600,16 @@ namespace swive {
 
             vm.apply_positional_defaults(arg_count, func, has_receiver);
 
-            uint32_t param_count = has_receiver ? static_cast<uint32_t>(arg_count - 1) : arg_count;
-            const MethodDef* method_def = vm.find_method_def_by_name(func->name, true, param_count);
-            if (!method_def) {
-                method_def = vm.find_method_def_by_name(func->name, false, param_count);
-            }
-            if (method_def) {
-                vm.invoke_method_def(*method_def, callee_index, arg_count, has_receiver, func->is_initializer);
-                return;
-            }
-
+            // The function names its own module body, so no metadata lookup is needed
             if (arg_count != func->params.size()) {
                 throw std::runtime_error("Incorrect argument count.");
             }
-            if (!func->chunk) {
+            if (func->body == kInvalidBody) {
                 throw std::runtime_error("Function has no body.");
             }
-            vm.call_frames_.emplace_back(callee_index + 1, vm.ip_, vm.chunk_, vm.current_body_idx_, func->name, closure, func->is_initializer);
-            vm.chunk_ = func->chunk.get();
-            vm.current_body_idx_ = vm.entry_body_index(*vm.chunk_);
-            vm.set_active_body(vm.current_body_idx_);
+            vm.call_frames_.emplace_back(callee_index + 1, vm.ip_, vm.chunk_, vm.current_body_idx_, func, closure, func->is_initializer);
+            vm.current_body_idx_ = func->body;
+            vm.enter_body(vm.current_body_idx_);
             vm.ip_ = 0;
         }
     };
@@ -638,8 +618,13 @@ namespace swive {
     {
         OP_BODY
         {
-			VM* self = &vm;
             uint16_t arg_count = vm.read_short();
+            invoke(vm, arg_count, read_arg_names(vm, arg_count));
+        }
+
+        // Reads arg_count name operands (0xFFFF = positional).
+        static std::vector<std::optional<std::string>> read_arg_names(VM& vm, uint16_t arg_count)
+        {
             std::vector<std::optional<std::string>> arg_names;
             arg_names.reserve(arg_count);
             for (uint16_t i = 0; i < arg_count; ++i) {
@@ -653,8 +638,13 @@ namespace swive {
                 }
                 arg_names.emplace_back(vm.chunk_->string_table[name_idx]);
             }
+            return arg_names;
+        }
 
-            if (vm.stack_.size() < arg_count + 1) {
+        static void invoke(VM& vm, uint16_t arg_count, const std::vector<std::optional<std::string>>& arg_names)
+        {
+			VM* self = &vm;
+            if (vm.stack_.size() < arg_count + 1u) {
                 throw std::runtime_error("Not enough values for function call.");
             }
             size_t callee_index = vm.stack_.size() - arg_count - 1;
@@ -670,11 +660,12 @@ namespace swive {
             // EnumCase call -> create instance with associated values
             if (obj->type == ObjectType::EnumCase) {
                 auto* template_case = static_cast<EnumCaseObject*>(obj);
-                size_t expected = template_case->associated_labels.size();
+                size_t expected = template_case->associated_labels().size();
                 if (arg_count != expected) {
                     throw std::runtime_error("Incorrect argument count for enum case.");
                 }
 
+                const auto& labels = template_case->associated_labels();
                 std::vector<Value> ordered_args(expected);
                 std::vector<bool> filled(expected, false);
                 size_t next_pos = 0;
@@ -685,8 +676,7 @@ namespace swive {
                         const std::string& name = arg_names[i].value();
                         bool found = false;
                         for (size_t j = 0; j < expected; ++j) {
-                            if (!template_case->associated_labels[j].empty() &&
-                                template_case->associated_labels[j] == name) {
+                            if (!labels[j].empty() && labels[j] == name) {
                                 target = j;
                                 found = true;
                                 break;
@@ -720,13 +710,13 @@ namespace swive {
 
                 auto* new_case = vm.allocate_object<EnumCaseObject>(
                     template_case->enum_type,
-                    template_case->case_name);
+                    template_case->info);
 
                 // Retain the enum type for the case's lifetime
                 RC::retain(template_case->enum_type);
 
                 new_case->raw_value = template_case->raw_value;
-                new_case->associated_labels = template_case->associated_labels;
+                new_case->associated_values.reserve(expected);
 
                 for (const auto& arg : ordered_args) {
                     if (arg.is_object() && arg.ref_type() == RefType::Strong && arg.as_object()) {
@@ -865,8 +855,8 @@ namespace swive {
                         init_func = static_cast<ClosureObject*>(init_obj)->function;
                     }
 
-                    if (!init_func || !init_func->chunk) {
-                        throw std::runtime_error("Native init has no chunk");
+                    if (!init_func || init_func->body == kInvalidBody) {
+                        throw std::runtime_error("Native init has no body");
                     }
 
                     // Replace callee (class) with nil placeholder for return value slot
@@ -883,15 +873,14 @@ namespace swive {
                         vm.ip_,            // return_address
                         vm.chunk_,         // saved chunk
                         vm.current_body_idx_, // saved body index
-                        init_func->name,   // function name
+                        init_func,         // callee (name for debugging)
                         nullptr,           // closure (none for native wrapper)
                         false              // is_initializer - false for native classes
                     );
 
-                    // Switch to the init function's chunk
-                    vm.chunk_ = init_func->chunk.get();
-                    vm.current_body_idx_ = vm.entry_body_index(*vm.chunk_);
-                    vm.set_active_body(vm.current_body_idx_);
+                    // Switch to the init function's body
+                    vm.current_body_idx_ = init_func->body;
+                    vm.enter_body(vm.current_body_idx_);
                     vm.ip_ = 0;
 
                     return;  // Continue execution in the init wrapper
@@ -943,43 +932,18 @@ namespace swive {
 
             // Built-in method call handling
             if (obj->type == ObjectType::BuiltinMethod) {
-                auto* method = static_cast<BuiltinMethodObject*>(obj);
-
-                if (method->method_name == "append") {
-                    if (arg_count != 1) {
-                        throw std::runtime_error("append() requires exactly 1 argument.");
-                    }
-
-                    if (method->target->type != ObjectType::List) {
-                        throw std::runtime_error("append() can only be called on arrays.");
-                    }
-
-                    auto* arr = static_cast<ListObject*>(method->target);
-                    Value arg = vm.peek(0);
-
-                    if (arg.is_object() && arg.ref_type() == RefType::Strong && arg.as_object()) {
-                        RC::retain(arg.as_object());
-                    }
-                    arr->elements.push_back(arg);
-
-                    while (vm.stack_.size() > callee_index) {
-                        vm.pop();
-                    }
-
-                    vm.push(Value::null());
-                    return;
-                }
-
-                throw std::runtime_error("Unknown built-in method: " + method->method_name);
+                vm.call_builtin_method(static_cast<BuiltinMethodObject*>(obj), callee_index, arg_count);
+                return;
             }
 
             if (obj->type == ObjectType::Function) {
                 auto* func = static_cast<FunctionObject*>(obj);
-                if (!func->chunk && vm.is_builtin_type_name(func->name)) {
-                    if (arg_count != 1) {
+                if (func->body == kInvalidBody && vm.is_builtin_type_name(func->name)) {
+                    bool empty_set_init = arg_count == 0 && func->name == "Set";
+                    if (arg_count != 1 && !empty_set_init) {
                         throw std::runtime_error(func->name + "() requires exactly 1 argument.");
                     }
-                    Value input = vm.stack_[callee_index + 1];
+                    Value input = empty_set_init ? Value::null() : vm.stack_[callee_index + 1];
                     Value result = convert_builtin(vm, func->name, input);
                     while (vm.stack_.size() > callee_index) {
                         vm.discard();
@@ -1030,59 +994,145 @@ namespace swive {
 
             vm.apply_named_arguments(callee_index, arg_count, func, has_receiver, arg_names);
 
-            uint32_t param_count = has_receiver ? static_cast<uint32_t>(arg_count - 1) : arg_count;
-            const MethodDef* method_def = nullptr;
-            if (has_receiver && arg_count > 0) {
-                Value receiver_val = vm.stack_[callee_index + 1];
-                if (receiver_val.is_object() && receiver_val.as_object()) {
-                    Object* receiver_obj = receiver_val.as_object();
-                    const TypeDef* type_def = nullptr;
-                    if (receiver_obj->type == ObjectType::Instance) {
-                        auto* inst = static_cast<InstanceObject*>(receiver_obj);
-                        if (inst->klass) {
-                            type_def = vm.resolve_type_def(inst->klass->name);
-                        }
-                    } else if (receiver_obj->type == ObjectType::StructInstance) {
-                        auto* inst = static_cast<StructInstanceObject*>(receiver_obj);
-                        if (inst->struct_type) {
-                            type_def = vm.resolve_type_def(inst->struct_type->name);
-                        }
-                    } else if (receiver_obj->type == ObjectType::EnumCase) {
-                        auto* inst = static_cast<EnumCaseObject*>(receiver_obj);
-                        if (inst->enum_type) {
-                            type_def = vm.resolve_type_def(inst->enum_type->name);
-                        }
-                    }
-                    if (type_def) {
-                        method_def = vm.find_method_def_for_type(*type_def, func->name, false, param_count);
-                    }
-                }
+            if (arg_count != func->params.size()) {
+                throw std::runtime_error("Incorrect argument count.");
             }
-            if (!method_def) {
-                method_def = vm.find_method_def_by_name(func->name, true, param_count);
-                if (!method_def) {
-                    method_def = vm.find_method_def_by_name(func->name, false, param_count);
-                }
+            if (func->body == kInvalidBody) {
+                throw std::runtime_error("Function has no body.");
             }
-            if (method_def) {
-                vm.invoke_method_def(*method_def, callee_index, arg_count, has_receiver, func->is_initializer);
-                return;
+            vm.call_frames_.emplace_back(callee_index + 1, vm.ip_, vm.chunk_, vm.current_body_idx_, func, closure, func->is_initializer);
+            vm.current_body_idx_ = func->body;
+            vm.enter_body(vm.current_body_idx_);
+            vm.ip_ = 0;
+        }
+    };
+
+    OPCODE(OpCode::OP_TAIL_CALL)
+    {
+        OP_BODY
+        {
+            uint16_t arg_count = vm.read_short();
+            size_t depth = vm.call_frames_.size();
+
+            // Operands mirror OP_CALL_NAMED; all-positional calls skip the
+            // name resolution and go through OP_CALL.
+            const uint8_t* names = vm.active_bytecode().data() + vm.ip_;
+            bool has_named = false;
+            for (uint16_t i = 0; i < arg_count && !has_named; ++i) {
+                has_named = names[i * 2] != 0xFF || names[i * 2 + 1] != 0xFF;
+            }
+            if (has_named) {
+                OpCodeHandler<OpCode::OP_CALL_NAMED>::invoke(
+                    vm, arg_count, OpCodeHandler<OpCode::OP_CALL_NAMED>::read_arg_names(vm, arg_count));
+            } else {
+                vm.ip_ += static_cast<size_t>(arg_count) * 2;
+                OpCodeHandler<OpCode::OP_CALL>::invoke(vm, arg_count);
             }
 
-            if (arg_count != func->params.size()) {
-                throw std::runtime_error("Incorrect argument count.");
+            // A script frame was entered: it takes over the caller's frame, so
+            // its OP_RETURN goes straight back to our caller. Native calls and
+            // constructors completed in place and fall through to OP_RETURN.
+            if (depth > 0 && vm.call_frames_.size() == depth + 1) {
+                vm.reuse_caller_frame();
             }
-            if (!func->chunk) {
+        }
+    };
+
+    OPCODE(OpCode::OP_CALL_DIRECT)
+    {
+        OP_BODY
+        {
+            uint16_t index = vm.read_short();
+            uint16_t arg_count = vm.read_short();
+
+            // The compiler resolved the callee to a top-level function and
+            // bound its arguments, so there is no callee value to inspect:
+            // the frame starts at the first argument.
+            const Assembly* program = vm.program_;
+            if (!program || index >= program->function_prototypes.size()) {
+                throw std::runtime_error("Function index out of range.");
+            }
+            const FunctionPrototype& proto = program->function_prototypes[index];
+            if (proto.body == kInvalidBody) {
                 throw std::runtime_error("Function has no body.");
             }
-            vm.call_frames_.emplace_back(callee_index + 1, vm.ip_, vm.chunk_, vm.current_body_idx_, func->name, closure, func->is_initializer);
-            vm.chunk_ = func->chunk.get();
-            vm.current_body_idx_ = vm.entry_body_index(*vm.chunk_);
-            vm.set_active_body(vm.current_body_idx_);
+            if (arg_count != proto.params.size() || vm.stack_.size() < arg_count) {
+                throw std::runtime_error("Incorrect argument count.");
+            }
+
+            CallFrame& frame = vm.call_frames_.emplace_back(
+                vm.stack_.size() - arg_count, vm.ip_, vm.chunk_, vm.current_body_idx_, nullptr, nullptr, false);
+            frame.prototype = &proto;
+            frame.has_callee_slot = false;
+            vm.current_body_idx_ = proto.body;
+            vm.enter_body(vm.current_body_idx_);
             vm.ip_ = 0;
         }
     };
 
+    OPCODE(OpCode::OP_CALL_METHOD_DIRECT)
+    {
+        OP_BODY
+        {
+            invoke(vm, false);
+        }
+
+        // The compiler resolved the method to one prototype for receivers of
+        // the operand type (exactly that class when exact). The receiver is
+        // the first frame slot, as for a bound method call. Any other
+        // receiver is looked up by name and called through OP_CALL.
+        static void invoke(VM& vm, bool exact)
+        {
+            const std::string& name = vm.read_string();
+            uint16_t index = vm.read_short();
+            uint16_t arg_count = vm.read_short();
+            uint16_t type_id = vm.read_type_id();
+            if (vm.stack_.size() < arg_count + 1u) {
+                throw std::runtime_error("Not enough values for function call.");
+            }
+            size_t receiver_index = vm.stack_.size() - arg_count - 1;
+            Value receiver = vm.stack_[receiver_index];
+
+            bool resolved = false;
+            if (receiver.is_object() && receiver.as_object() && receiver.as_object()->type == ObjectType::Instance) {
+                const ClassObject* klass = static_cast<InstanceObject*>(receiver.as_object())->klass;
+                resolved = klass && (exact ? klass->type_id == type_id : vm.matches_type(receiver, type_id));
+            }
+            const Assembly* program = vm.program_;
+            if (resolved && program && index < program->function_prototypes.size()) {
+                const FunctionPrototype& proto = program->function_prototypes[index];
+                if (proto.body != kInvalidBody && proto.params.size() == arg_count + 1u) {
+                    CallFrame& frame = vm.call_frames_.emplace_back(
+                        receiver_index, vm.ip_, vm.chunk_, vm.current_body_idx_, nullptr, nullptr, false);
+                    frame.prototype = &proto;
+                    frame.has_callee_slot = false;
+                    vm.current_body_idx_ = proto.body;
+                    vm.enter_body(vm.current_body_idx_);
+                    vm.ip_ = 0;
+                    return;
+                }
+            }
+
+            Value method = vm.get_property(receiver, name);
+            if (method.is_object() && method.ref_type() == RefType::Strong && method.as_object()) {
+                RC::retain(method.as_object());
+            }
+            vm.stack_[receiver_index] = method;
+            if (receiver.is_object() && receiver.ref_type() == RefType::Strong && receiver.as_object()) {
+                RC::release(&vm, receiver.as_object());
+            }
+            OpCodeHandler<OpCode::OP_CALL>::invoke(vm, arg_count);
+        }
+    };
+
+    OPCODE(OpCode::OP_CALL_METHOD_GUARDED)
+    {
+        OP_BODY
+        {
+            OpCodeHandler<OpCode::OP_CALL_METHOD_DIRECT>::invoke(vm, true);
+        }
+    };
+
     OPCODE_DEFAULT(OpCode::OP_RETURN);
     OPCODE_DEFAULT(OpCode::OP_READ_LINE);
 	OPCODE_DEFAULT(OpCode::OP_PRINT);
@@ -1096,7 +1146,7 @@ namespace swive {
 				auto* ec = static_cast<EnumCaseObject*>(top.as_object());
 				if (ec->enum_type && ec->enum_type->name == "$Expected") {
 					vm.pop();
-					if (ec->case_name == "value" && !ec->associated_values.empty()) {
+					if (ec->case_name() == "value" && !ec->associated_values.empty()) {
 						vm.push(ec->associated_values[0]);
 					} else {
 						// .error case → push nil so OP_JUMP_IF_NIL takes the else branch
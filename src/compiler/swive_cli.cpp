@@ -44,13 +44,16 @@ Commands:
   build <project.ssproject>   Compile project to .ssasm
       -c, --config <type>     Build configuration (Debug|Release) [default: Debug]
       -o, --output <path>     Output file path [default: bin/<config>/<project>.ssasm]
+      --keep-reflection       Keep symbols reachable only through reflection (Release)
+      --stats                 Print bytecode optimizer statistics
 
   run <file.ssasm>            Execute compiled bytecode
       --stats                 Print VM statistics after execution
 
   exec <project.ssproject>    Compile and run in one step
       -c, --config <type>     Build configuration (Debug|Release) [default: Debug]
-      --stats                 Print VM statistics after execution
+      --keep-reflection       Keep symbols reachable only through reflection (Release)
+      --stats                 Print optimizer and VM statistics
 
   version                     Show version information
   help                        Show this help message
@@ -71,7 +74,9 @@ void print_version() {
 // ============== Build ==============
 int compile_project(const std::filesystem::path& project_path,
                     const std::string& build_type,
-                    const std::filesystem::path& output_path) {
+                    const std::filesystem::path& output_path,
+                    bool keep_reflection,
+                    bool print_stats) {
     SSProject project;
     std::string err;
     if (!LoadSSProject(project_path, project, err)) {
@@ -103,8 +108,23 @@ int compile_project(const std::filesystem::path& project_path,
     compiler.set_module_resolver(&resolver);
     compiler.set_source_file(project.entry_file.string());
     compiler.set_emit_debug_info(build_type == "Debug");
+    compiler.set_inline_functions(build_type == "Release");
+    compiler.set_optimize_bytecode(build_type == "Release");
+    compiler.set_scalar_replacement(build_type == "Release");
+    compiler.set_devirtualize(build_type == "Release");
+    compiler.set_tree_shaking(build_type == "Release");
+    compiler.set_keep_reflection_symbols(keep_reflection);
 
     Assembly chunk = compiler.compile(program);
+    if (print_stats && build_type == "Release") {
+        compiler.escape_stats().print(std::cout);
+        compiler.devirtualization_stats().print(std::cout);
+        compiler.specialization_stats().print(std::cout);
+        compiler.ir_stats().print(std::cout);
+        compiler.peephole_stats().print(std::cout);
+        compiler.module_link_stats().print(std::cout);
+        compiler.tree_shake_stats().print(std::cout);
+    }
 
     // Validate
     for (const auto& v : chunk.constant_pool()) {
@@ -145,6 +165,8 @@ int cmd_build(int argc, char* argv[]) {
     std::filesystem::path project_path = argv[0];
     std::string build_type = "Debug";
     std::filesystem::path output_path;
+    bool keep_reflection = false;
+    bool print_stats = false;
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -152,6 +174,10 @@ int cmd_build(int argc, char* argv[]) {
             build_type = argv[++i];
         } else if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
             output_path = argv[++i];
+        } else if (arg == "--keep-reflection") {
+            keep_reflection = true;
+        } else if (arg == "--stats") {
+            print_stats = true;
         }
     }
 
@@ -171,7 +197,7 @@ int cmd_build(int argc, char* argv[]) {
     }
 
     try {
-        return compile_project(project_path, build_type, output_path);
+        return compile_project(project_path, build_type, output_path, keep_reflection, print_stats);
     } catch (const std::exception& e) {
         std::cerr << "Error: Compilation failed: " << e.what() << "\n";
         return 1;
@@ -245,12 +271,15 @@ int cmd_exec(int argc, char* argv[]) {
 
     std::filesystem::path project_path = argv[0];
     std::string build_type = "Debug";
+    bool keep_reflection = false;
     bool print_stats = false;
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if ((arg == "-c" || arg == "--config") && i + 1 < argc) {
             build_type = argv[++i];
+        } else if (arg == "--keep-reflection") {
+            keep_reflection = true;
         } else if (arg == "--stats") {
             print_stats = true;
         }
@@ -270,7 +299,7 @@ int cmd_exec(int argc, char* argv[]) {
                                         project_path.filename().replace_extension(".ssasm");
 
     try {
-        int build_result = compile_project(project_path, build_type, output_path);
+        int build_result = compile_project(project_path, build_type, output_path, keep_reflection, print_stats);
         if (build_result != 0) {
             return build_result;
         }